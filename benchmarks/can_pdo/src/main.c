@@ -0,0 +1,124 @@
+#include "can_pdo.h"
+#include "database.h"
+#include "process_pdo.h"
+#include "setup_database.h"
+
+#include <zephyr/device.h>
+#include <zephyr/drivers/can.h>
+#include <zephyr/kernel.h>
+
+#if defined(CONFIG_ARCH_POSIX)
+#include <posix_board_if.h>
+#endif
+
+/*
+ * Carga de barramento dos PDOs da aplicacao com o controlador em loopback.
+ * Cada cenario altera os dados de processo a 1 kHz por CONFIG_BENCH_SECONDS e
+ * gera uma linha JSON: quadros por segundo (ciclo x mudanca), mudancas
+ * seguradas pelo inhibit e carga da ultima janela de 1 s. O PDO recebido de
+ * volta no grupo do vizinho confere o caminho de recepcao.
+ */
+
+struct bench_scenario {
+  const char *name;
+  void (*step)(uint32_t ms);
+};
+
+static void bench_idle(uint32_t ms);
+static void bench_noise(uint32_t ms);
+static void bench_ramp(uint32_t ms);
+static void bench_step(uint32_t ms);
+
+static const struct bench_scenario g_scenarios[] = {
+    {"idle", bench_idle},         // So envio ciclico
+    {"noise", bench_noise},       // Ruido dentro do deadband
+    {"ramp", bench_ramp},         // Rampa: limitado pelo inhibit
+    {"step", bench_step},         // Degraus de IQC a cada 50 ms
+};
+
+static void bench_idle(uint32_t ms) {
+  ARG_UNUSED(ms);
+}
+
+static void bench_noise(uint32_t ms) {
+  db_acc_set_s16(ACC_LEVEL_FACTORY, GROUP_PROC_VAR, PROC_VAR_SENSOR_TEMPER, 2000 + (ms % 7) - 3);
+  db_acc_set_s16(ACC_LEVEL_FACTORY, GROUP_PROC_VAR, PROC_VAR_SENSOR_HUMID, 5000 + (ms % 21) - 10);
+}
+
+static void bench_ramp(uint32_t ms) {
+  db_acc_set_s16(ACC_LEVEL_FACTORY, GROUP_PROC_VAR, PROC_VAR_SENSOR_TEMPER, ms % 10000);
+}
+
+static void bench_step(uint32_t ms) {
+  db_acc_set_u8(ACC_LEVEL_FACTORY, GROUP_PROC_VAR, PROC_VAR_MDB_IQC, (ms / 50) % 100);
+}
+
+static void bench_run(const struct bench_scenario *scenario) {
+  struct can_pdo_stats tx_start;
+  struct can_pdo_stats rx_start;
+  struct can_pdo_stats tx;
+  struct can_pdo_stats rx;
+  uint32_t duration_ms = CONFIG_BENCH_SECONDS * 1000;
+  int16_t temper = 0;
+  int16_t peer_temper = -1;
+  uint32_t load;
+
+  can_pdo_get_stats(&tx_start, &rx_start);
+
+  for (uint32_t ms = 0; ms < duration_ms; ms++) {
+    scenario->step(ms);
+    k_sleep(K_MSEC(1));
+  }
+
+  load = can_pdo_bus_load_permille();
+  can_pdo_get_stats(&tx, &rx);
+
+  // Espera o ultimo quadro voltar pelo loopback
+  k_sleep(K_MSEC(200));
+  db_acc_get_s16(ACC_LEVEL_FACTORY, GROUP_PROC_VAR, PROC_VAR_SENSOR_TEMPER, &temper);
+  db_acc_get_s16(ACC_LEVEL_FACTORY, GROUP_PEER_VAR, PEER_VAR_SENSOR_TEMPER, &peer_temper);
+
+  printk("{\"scenario\":\"%s\",\"seconds\":%u,\"tx_fps\":%u,\"cyclic\":%u,\"cos\":%u,"
+         "\"inhibited\":%u,\"rx_frames\":%u,\"errors\":%u,\"load_permille\":%u,"
+         "\"loopback_ok\":%s}\n",
+         scenario->name, CONFIG_BENCH_SECONDS,
+         (tx.frames - tx_start.frames) / CONFIG_BENCH_SECONDS, tx.cyclic - tx_start.cyclic,
+         tx.cos - tx_start.cos, tx.inhibited - tx_start.inhibited, rx.frames - rx_start.frames,
+         (tx.errors - tx_start.errors) + (rx.errors - rx_start.errors), load,
+         (temper == peer_temper) ? "true" : "false");
+}
+
+int main(void) {
+  const struct device *can_dev = DEVICE_DT_GET(DT_CHOSEN(zephyr_canbus));
+  int ret;
+
+  if (!device_is_ready(can_dev)) {
+    printk("CAN not ready\n");
+    return -ENODEV;
+  }
+
+  setup_database_init();
+
+  ret = can_set_mode(can_dev, CAN_MODE_FD);
+  if (ret == 0) {
+    ret = can_start(can_dev);
+  }
+
+  if ((ret != 0) || (process_pdo_init() != 0)) {
+    printk("CAN setup failed: %d\n", ret);
+    return ret;
+  }
+
+  printk("{\"board\":\"%s\",\"node\":%u,\"tick_ms\":%u,\"seconds\":%u}\n", CONFIG_BOARD,
+         CONFIG_APP_PDO_NODE_ID, CONFIG_APP_PDO_TICK_MS, CONFIG_BENCH_SECONDS);
+
+  for (size_t i = 0; i < ARRAY_SIZE(g_scenarios); i++) {
+    bench_run(&g_scenarios[i]);
+  }
+
+#if defined(CONFIG_ARCH_POSIX)
+  posix_exit(0);
+#endif
+
+  return 0;
+}
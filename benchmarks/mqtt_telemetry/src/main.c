@@ -0,0 +1,359 @@
+#include <string.h>
+#include "database.h"
+#include "mqtt_telemetry.h"
+#include "setup_database.h"
+
+#include <zephyr/kernel.h>
+#include <zephyr/net/mqtt.h>
+#include <zephyr/net/socket.h>
+#include <zephyr/sys/byteorder.h>
+
+#if defined(CONFIG_ARCH_POSIX)
+#include <posix_board_if.h>
+#endif
+
+/*
+ * Banda da telemetria contra um broker local. Cada cenario altera os dados de
+ * processo a 1 kHz por CONFIG_BENCH_SECONDS e gera uma linha JSON: mudancas
+ * feitas na base, itens e registros publicados, bytes por segundo e uso do
+ * spool. Com o broker parado o mesmo teste mostra o spool enchendo e o
+ * descarte dos registros mais antigos. Escritas de volta podem ser enviadas
+ * com tools/mqtt_telemetry.py e mosquitto_pub no topico bench/set.
+ *
+ * Com o broker no ar um segundo cliente (sonda) assina bench/tele e fecha o
+ * laco: um valor gravado na base tem que voltar decodificado, uma escrita
+ * publicada em bench/set tem que chegar na base e uma escrita para um did
+ * inexistente tem que ser recusada. Qualquer falha encerra com codigo 1.
+ */
+
+#define BENCH_PROBE_TEMPER     (4321)
+#define BENCH_PROBE_PEER       (-1234)
+#define BENCH_PROBE_BUF_SIZE   (CONFIG_APP_MQTT_PAYLOAD_SIZE)
+#define BENCH_PROBE_SUBACK_MS  (2000)
+
+struct bench_scenario {
+  const char *name;
+  uint32_t (*step)(uint32_t ms);   // Retorna as mudancas feitas
+};
+
+static uint32_t bench_idle(uint32_t ms);
+static uint32_t bench_slow(uint32_t ms);
+static uint32_t bench_fast(uint32_t ms);
+
+static const struct bench_scenario g_scenarios[] = {
+    {"idle", bench_idle},         // So o retrato inicial
+    {"slow", bench_slow},         // Uma variavel a 10 Hz
+    {"fast", bench_fast},         // Tres variaveis a 1 kHz
+};
+
+static const struct mqtt_telemetry_config g_config = {
+    .host = CONFIG_BENCH_BROKER,
+    .port = CONFIG_BENCH_BROKER_PORT,
+    .client_id = "linum-bench",
+    .pub_topic = "bench/tele",
+    .sub_topic = "bench/set",
+    .qos = 1,
+};
+
+static struct mqtt_client g_probe;
+static struct sockaddr_storage g_probe_broker;
+static uint8_t g_probe_rx[256];
+static uint8_t g_probe_tx[256];
+static uint8_t g_probe_payload[BENCH_PROBE_BUF_SIZE];
+static bool g_probe_connected;
+static bool g_probe_subscribed;
+static bool g_probe_temper_seen;
+static int16_t g_probe_temper;
+static uint32_t g_probe_records;
+
+static uint32_t bench_idle(uint32_t ms) {
+  ARG_UNUSED(ms);
+  return 0;
+}
+
+static uint32_t bench_slow(uint32_t ms) {
+  if ((ms % 100) != 0) {
+    return 0;
+  }
+
+  db_acc_set_s16(ACC_LEVEL_FACTORY, GROUP_PROC_VAR, PROC_VAR_SENSOR_TEMPER, 2000 + (ms / 100));
+  return 1;
+}
+
+static uint32_t bench_fast(uint32_t ms) {
+  db_acc_set_s16(ACC_LEVEL_FACTORY, GROUP_PROC_VAR, PROC_VAR_SENSOR_TEMPER, ms % 10000);
+  db_acc_set_s16(ACC_LEVEL_FACTORY, GROUP_PROC_VAR, PROC_VAR_SENSOR_HUMID, 5000 + (ms % 97));
+  db_acc_set_u32(ACC_LEVEL_FACTORY, GROUP_PROC_VAR, PROC_VAR_UPTIME, ms);
+  return 3;
+}
+
+// Decodifica um registro publicado e guarda o ultimo valor da temperatura
+static void bench_probe_decode(const uint8_t *data, size_t len) {
+  const uint16_t temper = MQTT_TELEMETRY_DID(GROUP_PROC_VAR, PROC_VAR_SENSOR_TEMPER);
+  size_t pos = MQTT_TELEMETRY_HEADER_LEN;
+  uint16_t count;
+  uint16_t did;
+  uint8_t vlen;
+
+  if ((len < MQTT_TELEMETRY_HEADER_LEN) || (data[0] != MQTT_TELEMETRY_VERSION)) {
+    return;
+  }
+
+  count = sys_get_le16(&data[8]);
+  for (uint16_t i = 0; i < count; i++) {
+    if ((len - pos) < MQTT_TELEMETRY_ITEM_LEN) {
+      return;
+    }
+
+    did = sys_get_le16(&data[pos]);
+    vlen = data[pos + 2];
+    pos += MQTT_TELEMETRY_ITEM_LEN;
+    if ((len - pos) < vlen) {
+      return;
+    }
+
+    if ((did == temper) && (vlen == sizeof(g_probe_temper))) {
+      memcpy(&g_probe_temper, &data[pos], vlen);
+      g_probe_temper_seen = true;
+    }
+    pos += vlen;
+  }
+
+  g_probe_records++;
+}
+
+static void bench_probe_evt(struct mqtt_client *client, const struct mqtt_evt *evt) {
+  size_t len;
+
+  switch (evt->type) {
+  case MQTT_EVT_CONNACK:
+    g_probe_connected = (evt->result == 0);
+    break;
+
+  case MQTT_EVT_DISCONNECT:
+    g_probe_connected = false;
+    break;
+
+  case MQTT_EVT_SUBACK:
+    g_probe_subscribed = (evt->result == 0);
+    break;
+
+  case MQTT_EVT_PUBLISH:
+    len = evt->param.publish.message.payload.len;
+    if ((len <= sizeof(g_probe_payload)) &&
+        (mqtt_readall_publish_payload(client, g_probe_payload, len) == 0)) {
+      bench_probe_decode(g_probe_payload, len);
+    }
+    break;
+
+  default:
+    break;
+  }
+}
+
+// Processa o que a sonda receber durante ms
+static void bench_probe_pump(uint32_t ms) {
+  struct zsock_pollfd fds = {.fd = g_probe.transport.tcp.sock, .events = ZSOCK_POLLIN};
+  int64_t deadline = k_uptime_get() + ms;
+  int64_t left;
+
+  while ((left = deadline - k_uptime_get()) > 0) {
+    if ((zsock_poll(&fds, 1, MIN(left, 100)) > 0) && (mqtt_input(&g_probe) != 0)) {
+      break;
+    }
+    mqtt_live(&g_probe);
+  }
+}
+
+static int bench_probe_connect(void) {
+  struct sockaddr_in *broker = (struct sockaddr_in *)&g_probe_broker;
+  struct mqtt_topic topic = {
+      .topic = {.utf8 = (const uint8_t *)g_config.pub_topic, .size = strlen(g_config.pub_topic)},
+      .qos = MQTT_QOS_0_AT_MOST_ONCE,
+  };
+  struct mqtt_subscription_list subs = {.list = &topic, .list_count = 1, .message_id = 1};
+  int64_t deadline;
+  int ret;
+
+  broker->sin_family = AF_INET;
+  broker->sin_port = htons(CONFIG_BENCH_BROKER_PORT);
+  if (zsock_inet_pton(AF_INET, CONFIG_BENCH_BROKER, &broker->sin_addr) != 1) {
+    return -EINVAL;
+  }
+
+  mqtt_client_init(&g_probe);
+  g_probe.broker = &g_probe_broker;
+  g_probe.evt_cb = bench_probe_evt;
+  g_probe.client_id.utf8 = (const uint8_t *)"linum-bench-probe";
+  g_probe.client_id.size = strlen("linum-bench-probe");
+  g_probe.protocol_version = MQTT_VERSION_3_1_1;
+  g_probe.rx_buf = g_probe_rx;
+  g_probe.rx_buf_size = sizeof(g_probe_rx);
+  g_probe.tx_buf = g_probe_tx;
+  g_probe.tx_buf_size = sizeof(g_probe_tx);
+  g_probe.transport.type = MQTT_TRANSPORT_NON_SECURE;
+
+  ret = mqtt_connect(&g_probe);
+  if (ret != 0) {
+    return ret;
+  }
+
+  deadline = k_uptime_get() + BENCH_PROBE_SUBACK_MS;
+  while (!g_probe_connected && (k_uptime_get() < deadline)) {
+    bench_probe_pump(100);
+  }
+
+  if (g_probe_connected) {
+    mqtt_subscribe(&g_probe, &subs);
+    while (!g_probe_subscribed && (k_uptime_get() < deadline)) {
+      bench_probe_pump(100);
+    }
+  }
+
+  if (!g_probe_subscribed) {
+    mqtt_abort(&g_probe);
+    return -ETIMEDOUT;
+  }
+
+  return 0;
+}
+
+// Registro de escrita com um unico item s16
+static int bench_probe_write(uint16_t did, int16_t value) {
+  uint8_t record[MQTT_TELEMETRY_HEADER_LEN + MQTT_TELEMETRY_ITEM_LEN + sizeof(value)] = {0};
+  struct mqtt_publish_param param = {0};
+
+  record[0] = MQTT_TELEMETRY_VERSION;
+  sys_put_le16(1, &record[8]);
+  sys_put_le16(did, &record[MQTT_TELEMETRY_HEADER_LEN]);
+  record[MQTT_TELEMETRY_HEADER_LEN + 2] = sizeof(value);
+  memcpy(&record[MQTT_TELEMETRY_HEADER_LEN + MQTT_TELEMETRY_ITEM_LEN], &value, sizeof(value));
+
+  param.message.topic.topic.utf8 = (const uint8_t *)g_config.sub_topic;
+  param.message.topic.topic.size = strlen(g_config.sub_topic);
+  param.message.topic.qos = MQTT_QOS_0_AT_MOST_ONCE;
+  param.message.payload.data = record;
+  param.message.payload.len = sizeof(record);
+  param.message_id = 2;
+
+  return mqtt_publish(&g_probe, &param);
+}
+
+// Laco completo pelo broker; retorna 0 quando tudo confere
+static int bench_loopback(void) {
+  struct mqtt_telemetry_stats start;
+  struct mqtt_telemetry_stats end;
+  uint32_t wait_ms = 3 * CONFIG_APP_MQTT_WINDOW_MS;
+  int16_t peer = 0;
+  bool decoded;
+  bool written;
+  bool rejected;
+  int ret;
+
+  ret = bench_probe_connect();
+  if (ret != 0) {
+    printk("{\"check\":\"loopback\",\"error\":%d}\n", ret);
+    return ret;
+  }
+
+  // Base -> broker: o valor gravado volta decodificado
+  g_probe_temper_seen = false;
+  db_acc_set_s16(ACC_LEVEL_FACTORY, GROUP_PROC_VAR, PROC_VAR_SENSOR_TEMPER, BENCH_PROBE_TEMPER);
+  bench_probe_pump(wait_ms);
+  decoded = g_probe_temper_seen && (g_probe_temper == BENCH_PROBE_TEMPER);
+
+  // Broker -> base: a escrita em bench/set chega no parametro
+  mqtt_telemetry_get_stats(&start);
+  bench_probe_write(MQTT_TELEMETRY_DID(GROUP_PEER_VAR, PEER_VAR_SENSOR_TEMPER), BENCH_PROBE_PEER);
+  bench_probe_pump(wait_ms);
+  db_acc_get_s16(ACC_LEVEL_FACTORY, GROUP_PEER_VAR, PEER_VAR_SENSOR_TEMPER, &peer);
+  mqtt_telemetry_get_stats(&end);
+  written = (peer == BENCH_PROBE_PEER) && (end.writes == start.writes + 1);
+
+  // did inexistente: recusado sem tocar a base
+  start = end;
+  bench_probe_write(MQTT_TELEMETRY_DID(0xFF, 0xFF), BENCH_PROBE_PEER);
+  bench_probe_pump(wait_ms);
+  mqtt_telemetry_get_stats(&end);
+  rejected = (end.write_errors == start.write_errors + 1) && (end.writes == start.writes);
+
+  mqtt_abort(&g_probe);
+
+  printk("{\"check\":\"loopback\",\"records\":%u,\"decoded\":%s,\"written\":%s,"
+         "\"rejected\":%s}\n",
+         g_probe_records, decoded ? "true" : "false", written ? "true" : "false",
+         rejected ? "true" : "false");
+
+  return (decoded && written && rejected) ? 0 : -EIO;
+}
+
+static void bench_run(const struct bench_scenario *scenario) {
+  struct mqtt_telemetry_stats start;
+  struct mqtt_telemetry_stats end;
+  uint32_t duration_ms = CONFIG_BENCH_SECONDS * 1000;
+  uint32_t changes = 0;
+
+  mqtt_telemetry_get_stats(&start);
+
+  for (uint32_t ms = 0; ms < duration_ms; ms++) {
+    changes += scenario->step(ms);
+    k_sleep(K_MSEC(1));
+  }
+
+  // Ultima janela e PUBACKs pendentes
+  k_sleep(K_MSEC(2 * CONFIG_APP_MQTT_WINDOW_MS));
+  mqtt_telemetry_get_stats(&end);
+
+  printk("{\"scenario\":\"%s\",\"seconds\":%u,\"changes\":%u,\"windows\":%u,\"items\":%u,"
+         "\"published\":%u,\"bytes_per_s\":%u,\"spooled\":%u,\"spool_peak\":%u,\"dropped\":%u,"
+         "\"writes\":%u,\"connected\":%s}\n",
+         scenario->name, CONFIG_BENCH_SECONDS, changes, end.windows - start.windows,
+         end.items - start.items, end.published - start.published,
+         (end.bytes - start.bytes) / CONFIG_BENCH_SECONDS, end.spooled, end.spool_peak,
+         end.dropped - start.dropped, end.writes - start.writes,
+         end.connected ? "true" : "false");
+}
+
+int main(void) {
+  struct mqtt_telemetry_stats stats;
+  int ret;
+
+  setup_database_init();
+
+  mqtt_telemetry_add_group(GROUP_PROC_VAR);
+  mqtt_telemetry_add_group(GROUP_PEER_VAR);
+  mqtt_telemetry_add_group(GROUP_SYS_OTA_CONF);
+
+  ret = mqtt_telemetry_init(&g_config);
+  if (ret != 0) {
+    printk("Telemetry init failed: %d\n", ret);
+    return ret;
+  }
+
+  // Sem broker os cenarios rodam assim mesmo e medem o spool
+  for (int i = 0; i < 50; i++) {
+    mqtt_telemetry_get_stats(&stats);
+    if (stats.connected) {
+      break;
+    }
+    k_sleep(K_MSEC(100));
+  }
+
+  printk("{\"board\":\"%s\",\"broker\":\"%s:%u\",\"window_ms\":%u,\"spool\":%u,\"connected\":%s}\n",
+         CONFIG_BOARD, CONFIG_BENCH_BROKER, CONFIG_BENCH_BROKER_PORT, CONFIG_APP_MQTT_WINDOW_MS,
+         CONFIG_APP_MQTT_SPOOL_SIZE, stats.connected ? "true" : "false");
+
+  for (size_t i = 0; i < ARRAY_SIZE(g_scenarios); i++) {
+    bench_run(&g_scenarios[i]);
+  }
+
+  // Sem broker nao ha laco para conferir
+  mqtt_telemetry_get_stats(&stats);
+  ret = stats.connected ? bench_loopback() : 0;
+
+#if defined(CONFIG_ARCH_POSIX)
+  posix_exit((ret == 0) ? 0 : 1);
+#endif
+
+  return ret;
+}
@@ -0,0 +1,25 @@
+#ifndef _BENCH_CLOCK_H
+#define _BENCH_CLOCK_H
+
+#include <stdint.h>
+
+/*
+ * No native_sim o tempo do kernel e simulado e nao avanca enquanto o codigo
+ * executa; o relogio do host mede o custo real do render. Na placa usa o
+ * contador de ciclos.
+ */
+#if defined(CONFIG_ARCH_POSIX)
+uint64_t bench_host_time_us(void);
+
+static inline uint64_t bench_clock_us(void) {
+  return bench_host_time_us();
+}
+#else
+#include <zephyr/kernel.h>
+
+static inline uint64_t bench_clock_us(void) {
+  return k_cyc_to_us_floor64(k_cycle_get_64());
+}
+#endif
+
+#endif  // _BENCH_CLOCK_H
@@ -0,0 +1,11 @@
+// Compilado no contexto do host (runner do native_simulator)
+#include <stdint.h>
+#include <time.h>
+
+uint64_t bench_host_time_us(void) {
+  struct timespec ts;
+
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+
+  return ((uint64_t)ts.tv_sec * 1000000U) + (ts.tv_nsec / 1000U);
+}
@@ -0,0 +1,246 @@
+#include "bench_clock.h"
+#include "database.h"
+#include "db_bind.h"
+#include "setup_database.h"
+#include "ui_screens.h"
+
+#include <lv_demos.h>
+#include <lvgl.h>
+#include <lvgl_mem.h>
+#include <string.h>
+#include <zephyr/device.h>
+#include <zephyr/drivers/display.h>
+#include <zephyr/kernel.h>
+#include <zephyr/sys/mem_stats.h>
+
+#if defined(CONFIG_ARCH_POSIX)
+#include <posix_board_if.h>
+#endif
+
+/*
+ * Benchmark de render sem hardware: cada cena roda um numero fixo de quadros
+ * e gera uma linha JSON por cena em stdout (tempo de quadro, flush e pico de
+ * memoria do LVGL). Filtrar com: ./zephyr.exe | grep '^{'
+ */
+
+// LV_NO_TIMER_READY (nenhum timer ativo) seria um sono sem fim
+#define BENCH_TIMER_SLEEP_MAX_MS (10)
+
+struct bench_frame {
+  uint64_t refr_start;
+  uint64_t flush_start;
+  uint32_t flush_us;            // Flush + espera pelo buffer livre no quadro
+  bool rendered;                // Timer de refresh sem area invalida nao conta
+};
+
+struct bench_result {
+  uint32_t frames;
+  uint64_t frame_us_total;
+  uint32_t frame_us_max;
+  uint64_t render_us_total;
+  uint32_t render_us_max;
+  uint64_t flush_us_total;
+  uint32_t flush_us_max;
+  size_t mem_peak;              // Maximo amostrado na cena (fim de render e de quadro)
+};
+
+struct bench_scene {
+  const char *name;
+  void (*create)(lv_obj_t *screen);
+  void (*step)(uint32_t frame);   // NULL: redesenha a tela inteira a cada quadro
+  void (*close)(void);
+  bool animated;                  // Quadros gerados pelos timers do LVGL
+};
+
+static struct bench_frame g_frame;
+static struct bench_result g_result;
+
+static void bench_status_step(uint32_t frame);
+static void bench_display_cb(lv_event_t *event);
+static void bench_mem_sample(void);
+static void bench_run_scene(const struct bench_scene *scene);
+
+#if defined(CONFIG_LV_USE_DEMO_WIDGETS)
+static void bench_demo_widgets(lv_obj_t *screen) {
+  ARG_UNUSED(screen);
+  lv_demo_widgets();
+}
+#endif
+
+#if defined(CONFIG_LV_USE_DEMO_STRESS)
+static void bench_demo_stress(lv_obj_t *screen) {
+  ARG_UNUSED(screen);
+  lv_demo_stress();
+}
+#endif
+
+#if defined(CONFIG_LV_USE_DEMO_BENCHMARK)
+static void bench_demo_benchmark(lv_obj_t *screen) {
+  ARG_UNUSED(screen);
+  lv_demo_benchmark();
+}
+#endif
+
+// Ordem fixa para comparar execucoes; o benchmark do LVGL nao tem close e fica por ultimo
+static const struct bench_scene g_scenes[] = {
+    {"status", ui_screen_status_create, NULL, NULL, false},
+    {"status_update", ui_screen_status_create, bench_status_step, NULL, false},
+#if defined(CONFIG_LV_USE_DEMO_WIDGETS)
+    {"demo_widgets", bench_demo_widgets, NULL, lv_demo_widgets_close, false},
+#endif
+#if defined(CONFIG_LV_USE_DEMO_STRESS)
+    {"demo_stress", bench_demo_stress, NULL, lv_demo_stress_close, true},
+#endif
+#if defined(CONFIG_LV_USE_DEMO_BENCHMARK)
+    {"demo_benchmark", bench_demo_benchmark, NULL, NULL, true},
+#endif
+};
+
+// Atualizacao tipica da tela de status: poucos valores mudam por quadro
+static void bench_status_step(uint32_t frame) {
+  db_acc_set_u32(ACC_LEVEL_FACTORY, GROUP_PROC_VAR, PROC_VAR_UPTIME, frame);
+  db_acc_set_s16(ACC_LEVEL_FACTORY, GROUP_PROC_VAR, PROC_VAR_SENSOR_TEMPER, 2000 + (frame % 500));
+  db_bind_refresh(false);
+}
+
+/*
+ * O lvgl_mem.h nao zera o pico do heap: o pico por cena e o maior uso visto
+ * ao fim do render (camadas e buffers de desenho ainda alocados) e de cada
+ * quadro. O pico desde o boot sai a parte, como peak_total.
+ */
+static void bench_mem_sample(void) {
+  struct sys_memory_stats mem;
+
+  lvgl_heap_stats(&mem);
+  g_result.mem_peak = MAX(g_result.mem_peak, mem.allocated_bytes);
+}
+
+static void bench_display_cb(lv_event_t *event) {
+  uint64_t now = bench_clock_us();
+  uint32_t frame_us;
+  uint32_t render_us;
+
+  switch (lv_event_get_code(event)) {
+  case LV_EVENT_REFR_START:
+    g_frame.refr_start = now;
+    g_frame.flush_us = 0;
+    g_frame.rendered = false;
+    break;
+  case LV_EVENT_RENDER_START:
+    g_frame.rendered = true;
+    break;
+  case LV_EVENT_RENDER_READY:
+    bench_mem_sample();
+    break;
+  case LV_EVENT_FLUSH_START:
+  case LV_EVENT_FLUSH_WAIT_START:
+    g_frame.flush_start = now;
+    break;
+  case LV_EVENT_FLUSH_FINISH:
+  case LV_EVENT_FLUSH_WAIT_FINISH:
+    g_frame.flush_us += now - g_frame.flush_start;
+    break;
+  case LV_EVENT_REFR_READY:
+    if (!g_frame.rendered) {
+      break;
+    }
+
+    frame_us = now - g_frame.refr_start;
+    render_us = (frame_us > g_frame.flush_us) ? frame_us - g_frame.flush_us : 0;
+
+    g_result.frames++;
+    g_result.frame_us_total += frame_us;
+    g_result.frame_us_max = MAX(g_result.frame_us_max, frame_us);
+    g_result.render_us_total += render_us;
+    g_result.render_us_max = MAX(g_result.render_us_max, render_us);
+    g_result.flush_us_total += g_frame.flush_us;
+    g_result.flush_us_max = MAX(g_result.flush_us_max, g_frame.flush_us);
+    bench_mem_sample();
+    break;
+  default:
+    break;
+  }
+}
+
+static void bench_run_scene(const struct bench_scene *scene) {
+  struct sys_memory_stats mem;
+  lv_obj_t *screen = lv_screen_active();
+  uint32_t frame = 0;
+  uint32_t refreshes = 0;
+
+  lv_obj_clean(screen);
+  scene->create(screen);
+
+  // Aquecimento: layout inicial e caches de glifos fora da medida
+  lv_refr_now(NULL);
+
+  memset(&g_result, 0, sizeof(g_result));
+  bench_mem_sample();
+
+  // Cena parada (sem nada a redesenhar) nao pode travar o benchmark
+  while ((g_result.frames < CONFIG_BENCH_FRAMES) && (refreshes++ < (CONFIG_BENCH_FRAMES * 100))) {
+    if (scene->animated) {
+      k_sleep(K_MSEC(MIN(lv_timer_handler(), BENCH_TIMER_SLEEP_MAX_MS)));
+      continue;
+    }
+
+    if (scene->step) {
+      scene->step(frame++);
+    } else {
+      lv_obj_invalidate(screen);
+    }
+
+    lv_refr_now(NULL);
+  }
+
+  lvgl_heap_stats(&mem);
+
+  printk("{\"scene\":\"%s\",\"frames\":%u,"
+         "\"frame_us\":{\"avg\":%u,\"max\":%u},"
+         "\"render_us\":{\"avg\":%u,\"max\":%u},"
+         "\"flush_us\":{\"avg\":%u,\"max\":%u},"
+         "\"mem\":{\"used\":%zu,\"peak\":%zu,\"peak_total\":%zu}}\n",
+         scene->name, g_result.frames,
+         (uint32_t)(g_result.frame_us_total / MAX(g_result.frames, 1)), g_result.frame_us_max,
+         (uint32_t)(g_result.render_us_total / MAX(g_result.frames, 1)), g_result.render_us_max,
+         (uint32_t)(g_result.flush_us_total / MAX(g_result.frames, 1)), g_result.flush_us_max,
+         mem.allocated_bytes, MAX(g_result.mem_peak, mem.allocated_bytes),
+         mem.max_allocated_bytes);
+
+  if (scene->close) {
+    scene->close();
+  }
+}
+
+int main(void) {
+  const struct device *display_dev = DEVICE_DT_GET(DT_CHOSEN(zephyr_display));
+  lv_display_t *display = lv_display_get_default();
+  struct display_capabilities caps;
+
+  if (!device_is_ready(display_dev) || !display) {
+    printk("Display not ready\n");
+    return -ENODEV;
+  }
+
+  setup_database_init();
+  db_bind_init();
+
+  lv_display_add_event_cb(display, bench_display_cb, LV_EVENT_ALL, NULL);
+  display_get_capabilities(display_dev, &caps);
+  display_blanking_off(display_dev);
+
+  printk("{\"board\":\"%s\",\"width\":%u,\"height\":%u,\"vdb_percent\":%u,"
+         "\"double_vdb\":%s,\"frames\":%u}\n",
+         CONFIG_BOARD, caps.x_resolution, caps.y_resolution, CONFIG_LV_Z_VDB_SIZE,
+         IS_ENABLED(CONFIG_LV_Z_DOUBLE_VDB) ? "true" : "false", CONFIG_BENCH_FRAMES);
+
+  for (size_t i = 0; i < ARRAY_SIZE(g_scenes); i++) {
+    bench_run_scene(&g_scenes[i]);
+  }
+
+#if defined(CONFIG_ARCH_POSIX)
+  posix_exit(0);
+#endif
+
+  return 0;
+}
@@ -60,6 +60,7 @@ enum variable_field
   VAR_FIELD_PWD,
   VAR_FIELD_ENCRY,
   VAR_FIELD_HIDDEN,
+  VAR_FIELD_READ_ONLY,
   VAR_FIELD_MAX,
 };
 
@@ -0,0 +1,47 @@
+#ifndef _APP_DMA_H
+#define _APP_DMA_H
+
+/* C++ detection */
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <zephyr/kernel.h>
+#include <zephyr/sys/mem_stats.h>
+
+#ifdef CONFIG_DCACHE_LINE_SIZE
+#define APP_DMA_ALIGN CONFIG_DCACHE_LINE_SIZE
+#else
+#define APP_DMA_ALIGN 32
+#endif
+
+// Sentido da transferencia, visto do periferico
+enum app_dma_dir {
+  APP_DMA_TO_DEVICE,            // CPU escreve, periferico le (TX)
+  APP_DMA_FROM_DEVICE,          // Periferico escreve, CPU le (RX)
+  APP_DMA_BIDIRECTIONAL,
+};
+
+/*
+ * Buffers para DMA (SDMMC, Ethernet, LTDC/DMA2D). Inicio alinhado e tamanho
+ * arredondado para a linha de cache: nenhum buffer divide linha com outro
+ * dado, entao invalidar nunca descarta escritas da CPU fora do buffer.
+ */
+void *app_dma_alloc(size_t size);
+void app_dma_free(void *buf);
+bool app_dma_is_safe(const void *buf, size_t size);
+int app_dma_get_stats(struct sys_memory_stats *stats);
+
+// Antes de entregar o buffer ao periferico / depois de recebe-lo de volta.
+// size e o do buffer inteiro, em linhas de cache (-EINVAL se nao for)
+int app_dma_sync_for_device(void *buf, size_t size, enum app_dma_dir dir);
+int app_dma_sync_for_cpu(void *buf, size_t size, enum app_dma_dir dir);
+
+/* C++ detection */
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* _APP_DMA_H */
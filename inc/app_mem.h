@@ -0,0 +1,38 @@
+#ifndef _APP_MEM_H
+#define _APP_MEM_H
+
+/* C++ detection */
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+enum app_mem_heap_id {
+  APP_MEM_HEAP_SYSTEM,          // k_malloc (CONFIG_HEAP_MEM_POOL_SIZE)
+  APP_MEM_HEAP_LIBC,            // malloc (CONFIG_COMMON_LIBC_MALLOC_ARENA_SIZE)
+  APP_MEM_HEAP_USER,            // user_heap do app_sdram
+  APP_MEM_HEAP_DMA,             // app_dma
+  APP_MEM_HEAP_LVGL,            // Pool do LVGL na SDRAM
+  APP_MEM_HEAP_COUNT,
+};
+
+struct app_mem_heap_info {
+  const char *name;
+  size_t size;
+  size_t used;
+  size_t peak;
+  bool available;
+};
+
+int app_mem_init(void);
+int app_mem_get_heap(enum app_mem_heap_id id, struct app_mem_heap_info *info);
+
+/* C++ detection */
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* _APP_MEM_H */
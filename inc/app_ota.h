@@ -0,0 +1,51 @@
+#ifndef _APP_OTA_H
+#define _APP_OTA_H
+
+/* C++ detection */
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stddef.h>
+#include <stdint.h>
+
+/*
+ * PARAM_CNFG_OTA_STATUS: estado no byte alto e progresso (0..100 %) no baixo.
+ * Estados >= APP_OTA_ERR_SIZE indicam a falha da ultima tentativa.
+ */
+#define APP_OTA_STATUS(state, percent) ((uint16_t)(((state) << 8) | ((percent) & 0xFF)))
+#define APP_OTA_STATUS_STATE(status)   ((enum app_ota_state)((status) >> 8))
+#define APP_OTA_STATUS_PERCENT(status) ((uint8_t)((status) & 0xFF))
+
+enum app_ota_state {
+  APP_OTA_IDLE = 0,
+  APP_OTA_ERASING,
+  APP_OTA_RECEIVING,
+  APP_OTA_VERIFYING,
+  APP_OTA_PENDING,              // Imagem valida, troca no proximo boot
+  APP_OTA_ERR_SIZE = 0x10,
+  APP_OTA_ERR_FLASH,
+  APP_OTA_ERR_HASH,
+  APP_OTA_ERR_SOURCE,           // Falha de leitura (SD) ou transferencia
+  APP_OTA_ABORTED,
+};
+
+enum app_ota_source {
+  APP_OTA_SRC_ISOTP,
+  APP_OTA_SRC_SDCARD,
+};
+
+int app_ota_begin(enum app_ota_source source, size_t size);
+int app_ota_write(const void *data, size_t len);
+int app_ota_finish(void);
+int app_ota_confirm(void);
+void app_ota_abort(void);
+int app_ota_from_sdcard(const char *path);
+uint16_t app_ota_get_status(void);
+
+/* C++ detection */
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* _APP_OTA_H */
@@ -6,6 +6,33 @@
 extern "C" {
 #endif
 
+#include <stddef.h>
+#include <stdint.h>
+#include <zephyr/kernel.h>
+#include <zephyr/sys/mem_stats.h>
+
+// Pools de blocos de tamanho fixo na SDRAM (tamanhos no Kconfig)
+enum app_pool_id {
+  APP_POOL_NET,
+  APP_POOL_COUNT,
+};
+
+struct app_pool_stats {
+  const char *name;
+  size_t block_size;
+  uint32_t block_count;
+  uint32_t used;
+  uint32_t max_used;
+  uint32_t failures;
+};
+
+void *app_pool_alloc(enum app_pool_id id);
+void app_pool_free(enum app_pool_id id, void *block);
+int app_pool_get_stats(enum app_pool_id id, struct app_pool_stats *stats);
+void *app_heap_alloc(size_t size);
+void app_heap_free(void *ptr);
+int app_heap_get_stats(struct sys_memory_stats *stats);
+
 int sdram_test(void);
 
 /* C++ detection */
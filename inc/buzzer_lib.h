@@ -6,10 +6,20 @@
 extern "C" {
 #endif
 
+// Tipo para notificacoes de buzzer
+typedef enum {
+  RINGTONE_TOUCH_PRESSED,
+  RINGTONE_ALARM1,
+  RINGTONE_ALARM2,
+} ringtone_notification_type_t;
+
 int buzzer_init(void);
 int buzzer_set_percent(int percent);
 int buzzer_test(int test_cycles);
 int buzzer_ringotne_test(void);
+int buzzer_play_notification(ringtone_notification_type_t type);
+int buzzer_cancel_notification(ringtone_notification_type_t type);
+int Buzzer_PlayCustom(const char *rtttl_string);
 
 /* C++ detection */
 #ifdef __cplusplus
@@ -10,9 +10,34 @@ extern "C" {
 #include <stdio.h>
 #include <string.h>
 
+// Contadores do cache de paginas
+struct eeprom_lib_stats {
+  uint32_t hits;
+  uint32_t misses;
+  uint32_t page_flushes;
+  uint32_t evictions;
+  uint32_t bus_reads;
+  uint32_t bus_writes;
+  uint64_t bus_time_us;
+};
+
+// Chaves do armazenamento com nivelamento de desgaste (valores atualizados com frequencia)
+#define EEPROM_KV_VALVE_COUNT 8
+
+enum eeprom_kv_key {
+  EEPROM_KV_RUN_HOURS,
+  EEPROM_KV_ALARM_MEM_MASK,
+  EEPROM_KV_VALVE_CYCLES,
+  EEPROM_KV_KEY_MAX = EEPROM_KV_VALVE_CYCLES + EEPROM_KV_VALVE_COUNT,
+};
+
 int eeprom_lib_init(void);
 int eeprom_lib_write(size_t offset, const void *buf, size_t buflen);
 int eeprom_lib_read(size_t offset, void *buf, size_t buflen);
+int eeprom_lib_sync(void);
+int eeprom_lib_get_stats(struct eeprom_lib_stats *stats);
+int eeprom_kv_write(enum eeprom_kv_key key, const void *value, uint8_t length);
+int eeprom_kv_read(enum eeprom_kv_key key, void *value, uint8_t length);
 int eeprom_test(void);
 
 /* C++ detection */
@@ -8,17 +8,67 @@ extern "C" {
 
 #include <stddef.h>
 #include <stdint.h>
+#include <zephyr/kernel.h>
 
-#define ISOTP_MAX_DATA_LEN 128
-#define ISOTP_NUM_BUFFERS 20
+#define ISOTP_MAX_DATA_LEN CONFIG_APP_ISOTP_TX_MAX_LEN
+
+// Filas de envio, atendidas em ordem: diagnostico antes de telemetria
+enum isotp_conn_prio {
+  ISOTP_CONN_PRIO_URGENT = 0,
+  ISOTP_CONN_PRIO_NORMAL,
+  ISOTP_CONN_PRIO_BULK,
+  ISOTP_CONN_PRIO_COUNT
+};
+
+#define ISOTP_NUM_BUFFERS (CONFIG_APP_ISOTP_LANE_DEPTH * ISOTP_CONN_PRIO_COUNT)
+
+// Flow control padrao de isotp_conn_transmit/add_message: endereco de envio - 0x100
+#define ISOTP_CONN_FC_ADDR(addr) ((addr) - 0x100)
+
+// Fim de um envio: error e o codigo do isotp (ISOTP_N_OK) apos as tentativas
+typedef void (*isotp_conn_tx_cb_t)(int error, uint32_t addr, void *user_data);
+
+#define ISOTP_CONN_ANY_SERVICE (-1)
+
+struct net_buf;
+
+/*
+ * Mensagem completa recebida, como cadeia de net_buf (buf->frags) sem copia.
+ * Valida so durante a chamada; use net_buf_ref() para guardar.
+ */
+typedef void (*isotp_conn_rx_handler_t)(uint32_t rx_addr, struct net_buf *buf, void *user_data);
+
+struct isotp_conn_rx_stats {
+  uint32_t messages;
+  uint64_t bytes;
+  uint32_t errors;              // Mensagens abortadas pelo isotp
+  uint32_t unhandled;           // Sem handler para o endereco/servico
+};
+
+struct isotp_conn_lane_stats {
+  uint32_t depth;               // Mensagens aguardando na fila
+  uint32_t max_depth;
+  uint32_t sent;
+  uint32_t failed;              // Desistiu apos CONFIG_APP_ISOTP_TX_RETRIES
+  uint32_t retries;
+  uint32_t rejected;            // Fila cheia ate o timeout do chamador
+  uint32_t latency_us_last;     // Enfileiramento ate o fim do envio
+  uint32_t latency_us_max;
+};
 
 int isotp_conn_init(void);
 int isotp_conn_bind(uint32_t rx_addr, uint32_t tx_addr);
-void isotp_conn_unbind(void);
+int isotp_conn_unbind(uint32_t rx_addr);
+int isotp_conn_send(uint32_t addr, uint32_t fc_addr, const uint8_t *data, size_t len,
+                    enum isotp_conn_prio prio, k_timeout_t timeout, isotp_conn_tx_cb_t cb,
+                    void *user_data);
 int isotp_conn_transmit(uint32_t addr, const uint8_t *data, size_t len);
 int isotp_conn_add_message(uint32_t addr, const uint8_t *data, size_t len);
-int isotp_conn_process_send(void);
-int isotp_conn_receive(uint8_t data[], size_t max_len);
+int isotp_conn_rx_register(uint32_t rx_addr, int16_t service, isotp_conn_rx_handler_t handler,
+                           void *user_data);
+int isotp_conn_rx_unregister(uint32_t rx_addr, int16_t service);
+int isotp_conn_get_rx_stats(struct isotp_conn_rx_stats *stats);
+int isotp_conn_get_stats(enum isotp_conn_prio prio, struct isotp_conn_lane_stats *stats);
 
 /* C++ detection */
 #ifdef __cplusplus
@@ -6,10 +6,39 @@
 extern "C" {
 #endif
 
+#include <stdint.h>
+
+// Executado na thread da interface, onde e seguro chamar o LVGL
+typedef void (*lcd_ui_handler_t)(void *user_data, int32_t value);
+
+struct lcd_ui_msg {
+  lcd_ui_handler_t handler;
+  void *user_data;
+  int32_t value;
+  uint32_t cycles;              // Momento do post (latencia ate a tela)
+};
+
+struct lcd_ui_stats {
+  uint32_t frames;
+  uint32_t frame_us_last;
+  uint32_t frame_us_max;
+  uint64_t frame_us_total;
+  uint32_t input_latency_us_last; // Evento de entrada ate o fim do render
+  uint32_t input_latency_us_max;
+  uint32_t update_latency_us_max; // lcd_ui_post ate o fim do render
+  uint32_t posted;
+  uint32_t dropped;               // Fila cheia
+};
+
 int lcd_init(void);
 int lcd_bklight_set_percent(int percent);
+int lcd_bklight_fade_to(int percent, uint32_t duration_ms);
+int lcd_bklight_get_percent(void);
+void lcd_bklight_activity(void);
 int lcd_bklight_test(int test_cycles);
-int lcd_lvgl_demo(void);
+int lcd_ui_start(void);
+int lcd_ui_post(lcd_ui_handler_t handler, void *user_data, int32_t value);
+int lcd_ui_get_stats(struct lcd_ui_stats *stats);
 
 /* C++ detection */
 #ifdef __cplusplus
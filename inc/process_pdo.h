@@ -0,0 +1,19 @@
+#ifndef _PROCESS_PDO_H
+#define _PROCESS_PDO_H
+
+/* C++ detection */
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define PROCESS_PDO_TX1_ID(node)  (0x180 + (node))
+#define PROCESS_PDO_TX2_ID(node)  (0x280 + (node))
+
+int process_pdo_init(void);
+
+/* C++ detection */
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* _PROCESS_PDO_H */
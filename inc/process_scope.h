@@ -0,0 +1,16 @@
+#ifndef _PROCESS_SCOPE_H
+#define _PROCESS_SCOPE_H
+
+/* C++ detection */
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+int process_scope_init(void);
+
+/* C++ detection */
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* _PROCESS_SCOPE_H */
@@ -0,0 +1,16 @@
+#ifndef _PROCESS_TELEMETRY_H
+#define _PROCESS_TELEMETRY_H
+
+/* C++ detection */
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+int process_telemetry_init(void);
+
+/* C++ detection */
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* _PROCESS_TELEMETRY_H */
@@ -0,0 +1,16 @@
+#ifndef _PROCESS_TREND_H
+#define _PROCESS_TREND_H
+
+/* C++ detection */
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+int process_trend_init(void);
+
+/* C++ detection */
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* _PROCESS_TREND_H */
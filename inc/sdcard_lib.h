@@ -7,9 +7,26 @@ extern "C" {
 #endif
 
 #include <stdbool.h>
+#include <stdint.h>
+
+struct data_logger_stats;
+struct file_io;
+struct file_io_request;
+
+// Tipos de registro do logger continuo
+enum sdcard_log_type {
+    SDCARD_LOG_PROC_VAR = 1,
+    SDCARD_LOG_EVENT,
+};
 
 int sdcard_init(void);
 int sdcard_test(void);
+int sdcard_deinit(void);
+int sdcard_logger_init(void);
+int sdcard_log_write(enum sdcard_log_type type, const void *data, uint16_t length);
+int sdcard_log_get_stats(struct data_logger_stats *stats);
+int sdcard_io_submit(struct file_io_request *request);
+struct file_io *sdcard_io_get(void);
 
 /* C++ detection */
 #ifdef __cplusplus
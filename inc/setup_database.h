@@ -67,6 +67,13 @@ struct db_sys_proc
   int16_t humidity;
 };
 
+struct db_peer_proc
+{
+  uint8_t mdb_iqc;
+  int16_t temper;
+  int16_t humidity;
+};
+
 struct db_sys_conf
 {
   conf_mdb_rtu_t modbus;
@@ -93,6 +100,8 @@ typedef enum
   GROUP_SYS_CONF = 0,
   GROUP_SYS_OTA_CONF,
   GROUP_PROC_VAR,
+  GROUP_MEM_STATS,
+  GROUP_PEER_VAR,
 } db_sys_group_e;
 
 typedef enum
@@ -128,6 +137,31 @@ typedef enum
   PROC_VAR_SENSOR_HUMID,
 }sys_proc_var_index_e;
 
+// Valores do controlador vizinho, recebidos por PDO (process_pdo)
+enum db_peer_var_param_id
+{
+  PEER_VAR_MDB_IQC = 0,
+  PEER_VAR_SENSOR_TEMPER,
+  PEER_VAR_SENSOR_HUMID,
+};
+
+// Somente leitura, atualizados pelo app_mem
+enum db_mem_stats_param_id
+{
+  MEM_STATS_SYS_HEAP_USED = 0,
+  MEM_STATS_SYS_HEAP_PEAK,
+  MEM_STATS_LIBC_USED,
+  MEM_STATS_LIBC_PEAK,
+  MEM_STATS_USER_HEAP_USED,
+  MEM_STATS_USER_HEAP_PEAK,
+  MEM_STATS_DMA_USED,
+  MEM_STATS_DMA_PEAK,
+  MEM_STATS_LVGL_USED,
+  MEM_STATS_LVGL_PEAK,
+  MEM_STATS_STACK_WORST_PCT,
+  MEM_STATS_POOL_FAILURES,
+};
+
 int setup_database_init(void);
 
 /* C++ detection */
@@ -0,0 +1,26 @@
+#ifndef _UDS_SERVER_H
+#define _UDS_SERVER_H
+
+/* C++ detection */
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stdint.h>
+
+/*
+ * Acesso a base de parametros no estilo UDS (ISO 14229) sobre ISO-TP.
+ * DID = (grupo << 8) | parametro; valores numericos em big endian e strings
+ * com o tamanho fixo da variavel. Niveis do SecurityAccess seguem
+ * enum access_level (requestSeed = 2 * nivel - 1).
+ */
+#define UDS_DID(group, param) ((uint16_t)(((group) << 8) | ((param) & 0xFF)))
+
+int uds_server_init(void);
+
+/* C++ detection */
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* _UDS_SERVER_H */
@@ -0,0 +1,22 @@
+#ifndef _UI_SCREENS_H
+#define _UI_SCREENS_H
+
+/* C++ detection */
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <lvgl.h>
+
+// Telas da aplicacao; chamadas na thread da interface (ou no benchmark)
+void ui_screen_status_create(lv_obj_t *screen);
+void ui_screen_trend_create(lv_obj_t *screen, uint16_t points);
+void ui_screen_trend_load(const int32_t *values, uint16_t count);
+void ui_screen_trend_push(int32_t value);
+
+/* C++ detection */
+#ifdef __cplusplus
+}
+#endif
+
+#endif  // _UI_SCREENS_H
@@ -0,0 +1,137 @@
+#include "asset_store.h"
+
+#include <lvgl.h>
+#include <string.h>
+
+/*
+ * Driver lv_fs sobre o asset store: imagens (.bin) e fontes (lv_binfont_create)
+ * sao lidas sob demanda atraves do cache de blocos, sem copia integral em RAM.
+ * Usado apenas na thread da interface, como o restante do LVGL.
+ */
+
+struct asset_lvgl_file {
+  struct asset asset;
+  uint32_t position;
+  bool used;
+};
+
+static lv_fs_drv_t g_drv;
+static struct asset_lvgl_file g_files[CONFIG_APP_ASSETS_LVGL_FILES];
+
+static void *asset_lvgl_open(lv_fs_drv_t *drv, const char *path, lv_fs_mode_t mode);
+static lv_fs_res_t asset_lvgl_close(lv_fs_drv_t *drv, void *file_p);
+static lv_fs_res_t asset_lvgl_read(lv_fs_drv_t *drv, void *file_p, void *buf, uint32_t btr,
+                                   uint32_t *br);
+static lv_fs_res_t asset_lvgl_seek(lv_fs_drv_t *drv, void *file_p, uint32_t pos,
+                                   lv_fs_whence_t whence);
+static lv_fs_res_t asset_lvgl_tell(lv_fs_drv_t *drv, void *file_p, uint32_t *pos_p);
+
+int asset_lvgl_init(void) {
+  lv_fs_drv_init(&g_drv);
+
+  g_drv.letter = CONFIG_APP_ASSETS_LVGL_LETTER[0];
+  g_drv.cache_size = 0;         // O asset store ja tem cache proprio
+  g_drv.open_cb = asset_lvgl_open;
+  g_drv.close_cb = asset_lvgl_close;
+  g_drv.read_cb = asset_lvgl_read;
+  g_drv.seek_cb = asset_lvgl_seek;
+  g_drv.tell_cb = asset_lvgl_tell;
+
+  lv_fs_drv_register(&g_drv);
+
+  return 0;
+}
+
+static void *asset_lvgl_open(lv_fs_drv_t *drv, const char *path, lv_fs_mode_t mode) {
+  struct asset asset;
+
+  ARG_UNUSED(drv);
+
+  if (mode & LV_FS_MODE_WR) {
+    return NULL;
+  }
+
+  if (*path == '/') {
+    path++;
+  }
+
+  if (asset_find(path, &asset) != 0) {
+    return NULL;
+  }
+
+  for (int i = 0; i < ARRAY_SIZE(g_files); i++) {
+    if (!g_files[i].used) {
+      g_files[i].asset = asset;
+      g_files[i].position = 0;
+      g_files[i].used = true;
+      return &g_files[i];
+    }
+  }
+
+  return NULL;
+}
+
+static lv_fs_res_t asset_lvgl_close(lv_fs_drv_t *drv, void *file_p) {
+  struct asset_lvgl_file *file = file_p;
+
+  ARG_UNUSED(drv);
+
+  file->used = false;
+
+  return LV_FS_RES_OK;
+}
+
+static lv_fs_res_t asset_lvgl_read(lv_fs_drv_t *drv, void *file_p, void *buf, uint32_t btr,
+                                   uint32_t *br) {
+  struct asset_lvgl_file *file = file_p;
+  int ret;
+
+  ARG_UNUSED(drv);
+
+  ret = asset_read(&file->asset, file->position, buf, btr);
+  if (ret < 0) {
+    *br = 0;
+    return LV_FS_RES_HW_ERR;
+  }
+
+  file->position += ret;
+  *br = ret;
+
+  return LV_FS_RES_OK;
+}
+
+static lv_fs_res_t asset_lvgl_seek(lv_fs_drv_t *drv, void *file_p, uint32_t pos,
+                                   lv_fs_whence_t whence) {
+  struct asset_lvgl_file *file = file_p;
+  uint32_t size = asset_size(&file->asset);
+
+  ARG_UNUSED(drv);
+
+  switch (whence) {
+  case LV_FS_SEEK_SET:
+    file->position = pos;
+    break;
+  case LV_FS_SEEK_CUR:
+    file->position += pos;
+    break;
+  case LV_FS_SEEK_END:
+    file->position = size + pos;
+    break;
+  default:
+    return LV_FS_RES_INV_PARAM;
+  }
+
+  file->position = MIN(file->position, size);
+
+  return LV_FS_RES_OK;
+}
+
+static lv_fs_res_t asset_lvgl_tell(lv_fs_drv_t *drv, void *file_p, uint32_t *pos_p) {
+  struct asset_lvgl_file *file = file_p;
+
+  ARG_UNUSED(drv);
+
+  *pos_p = file->position;
+
+  return LV_FS_RES_OK;
+}
@@ -0,0 +1,323 @@
+#include "asset_store.h"
+
+#include <string.h>
+#include <zephyr/device.h>
+#include <zephyr/devicetree.h>
+#include <zephyr/drivers/flash.h>
+#include <zephyr/logging/log.h>
+#include <zephyr/shell/shell.h>
+#include <zephyr/sys/crc.h>
+
+LOG_MODULE_REGISTER(asset_store, CONFIG_LOG_DEFAULT_LEVEL);
+
+#define ASSET_FLASH_NODE    DT_INST(0, st_stm32_qspi_nor)
+#define ASSET_BLOCK_SIZE    CONFIG_APP_ASSETS_CACHE_BLOCK_SIZE
+#define ASSET_BLOCK_COUNT   CONFIG_APP_ASSETS_CACHE_BLOCKS
+#define ASSET_VERIFY_CHUNK  (256)
+
+// Com a QSPI mapeada em memoria (XIP) a leitura e um memcpy, sem passar pelo driver
+#if defined(CONFIG_STM32_MEMMAP) && DT_NODE_EXISTS(ASSET_FLASH_NODE)
+#define ASSET_MAP_BASE      DT_REG_ADDR(ASSET_FLASH_NODE)
+#endif
+
+struct asset_cache_block {
+  uint32_t tag;                 // Numero do bloco na imagem
+  uint32_t last_use;
+  bool valid;
+};
+
+static const struct device *g_flash = DEVICE_DT_GET_OR_NULL(ASSET_FLASH_NODE);
+
+// Cache em SRAM interna: blocos quentes (glifos, cabecalhos, linhas de imagem)
+static uint8_t __aligned(4) g_cache_data[ASSET_BLOCK_COUNT][ASSET_BLOCK_SIZE];
+static struct asset_cache_block g_cache[ASSET_BLOCK_COUNT];
+static uint32_t g_use_counter;
+
+static struct asset_store_entry g_entries[ASSET_STORE_MAX_ENTRIES];
+static uint16_t g_count;
+static bool g_ready;
+static struct asset_store_stats g_stats;
+static K_MUTEX_DEFINE(g_lock);
+
+static int asset_flash_read(uint32_t offset, void *buf, size_t len);
+static const uint8_t *asset_cache_get(uint32_t block);
+static int asset_shell_cmd_ls(const struct shell *shell, size_t argc, char **argv);
+static int asset_shell_cmd_stats(const struct shell *shell, size_t argc, char **argv);
+
+SHELL_STATIC_SUBCMD_SET_CREATE(
+    asset, SHELL_CMD(ls, NULL, "list assets in external flash", asset_shell_cmd_ls),
+    SHELL_CMD(stats, NULL, "asset cache statistics", asset_shell_cmd_stats),
+    SHELL_SUBCMD_SET_END);
+
+SHELL_CMD_REGISTER(asset, &asset, "asset store commands", NULL);
+
+static int asset_flash_read(uint32_t offset, void *buf, size_t len) {
+  uint32_t start = k_cycle_get_32();
+  int ret = 0;
+
+  if ((offset + len) > CONFIG_APP_ASSETS_SIZE) {
+    return -EINVAL;
+  }
+
+#ifdef ASSET_MAP_BASE
+  memcpy(buf, (const void *)(ASSET_MAP_BASE + CONFIG_APP_ASSETS_FLASH_OFFSET + offset), len);
+#else
+  ret = flash_read(g_flash, CONFIG_APP_ASSETS_FLASH_OFFSET + offset, buf, len);
+#endif
+
+  g_stats.flash_us += k_cyc_to_us_floor32(k_cycle_get_32() - start);
+
+  return ret;
+}
+
+// Chamado com g_lock: bloco presente ou trazido da flash no lugar do menos usado
+static const uint8_t *asset_cache_get(uint32_t block) {
+  struct asset_cache_block *victim = &g_cache[0];
+  uint32_t offset = block * ASSET_BLOCK_SIZE;
+  size_t len;
+  int i;
+
+  for (i = 0; i < ASSET_BLOCK_COUNT; i++) {
+    if (g_cache[i].valid && (g_cache[i].tag == block)) {
+      g_cache[i].last_use = ++g_use_counter;
+      g_stats.hits++;
+      return g_cache_data[i];
+    }
+
+    if (!g_cache[i].valid) {
+      victim = &g_cache[i];
+    } else if (victim->valid && (g_cache[i].last_use < victim->last_use)) {
+      victim = &g_cache[i];
+    }
+  }
+
+  i = victim - g_cache;
+  if (victim->valid) {
+    g_stats.evictions++;
+  }
+
+  victim->valid = false;
+  len = MIN(ASSET_BLOCK_SIZE, CONFIG_APP_ASSETS_SIZE - offset);
+  if (asset_flash_read(offset, g_cache_data[i], len) != 0) {
+    return NULL;
+  }
+
+  g_stats.misses++;
+  victim->tag = block;
+  victim->last_use = ++g_use_counter;
+  victim->valid = true;
+
+  return g_cache_data[i];
+}
+
+// Chamado da thread da interface e do teste da flash externa: tudo sob g_lock
+int asset_store_init(void) {
+  struct asset_store_header header;
+  int ret = 0;
+
+  k_mutex_lock(&g_lock, K_FOREVER);
+
+  if (g_ready) {
+    goto unlock;
+  }
+
+  if (!g_flash || !device_is_ready(g_flash)) {
+    LOG_ERR("External flash not ready");
+    ret = -ENODEV;
+    goto unlock;
+  }
+
+  ret = asset_flash_read(0, &header, sizeof(header));
+  if (ret != 0) {
+    goto unlock;
+  }
+
+  if ((header.magic != ASSET_STORE_MAGIC) || (header.count > ASSET_STORE_MAX_ENTRIES)) {
+    LOG_ERR("No asset image at offset 0x%x", CONFIG_APP_ASSETS_FLASH_OFFSET);
+    ret = -ENOENT;
+    goto unlock;
+  }
+
+  // O cache le blocos alinhados: imagem empacotada com outro bloco nao serve
+  if (header.block_size != ASSET_BLOCK_SIZE) {
+    LOG_ERR("Asset image packed with %u byte blocks, expected %u", header.block_size,
+            ASSET_BLOCK_SIZE);
+    ret = -EINVAL;
+    goto unlock;
+  }
+
+  ret = asset_flash_read(sizeof(header), g_entries, header.count * sizeof(g_entries[0]));
+  if (ret != 0) {
+    goto unlock;
+  }
+
+  if (crc32_ieee((const uint8_t *)g_entries, header.count * sizeof(g_entries[0])) != header.crc) {
+    LOG_ERR("Asset directory corrupted");
+    ret = -EBADMSG;
+    goto unlock;
+  }
+
+  g_count = header.count;
+  g_ready = true;
+  LOG_INF("%d assets in external flash", g_count);
+
+unlock:
+  k_mutex_unlock(&g_lock);
+
+  return ret;
+}
+
+int asset_find(const char *name, struct asset *asset) {
+  if (!name || !asset) {
+    return -EINVAL;
+  }
+
+  k_mutex_lock(&g_lock, K_FOREVER);
+
+  if (!g_ready) {
+    k_mutex_unlock(&g_lock);
+    return -ENODEV;
+  }
+
+  // O diretorio nao muda depois do init: a entrada pode ser usada sem o lock
+  for (int i = 0; i < g_count; i++) {
+    if (strncmp(g_entries[i].name, name, ASSET_STORE_NAME_LEN) == 0) {
+      asset->entry = &g_entries[i];
+      k_mutex_unlock(&g_lock);
+      return 0;
+    }
+  }
+
+  k_mutex_unlock(&g_lock);
+
+  return -ENOENT;
+}
+
+size_t asset_size(const struct asset *asset) {
+  return (asset && asset->entry) ? asset->entry->size : 0;
+}
+
+/**
+ * @brief Le parte de um asset atraves do cache
+ *
+ * @return Bytes lidos (menor que len no fim do asset) ou erro negativo
+ */
+int asset_read(const struct asset *asset, size_t offset, void *buf, size_t len) {
+  const uint8_t *block;
+  uint8_t *dst = buf;
+  uint32_t position;
+  size_t chunk;
+  size_t done = 0;
+
+  if (!asset || !asset->entry || (!buf && len)) {
+    return -EINVAL;
+  }
+
+  if (offset >= asset->entry->size) {
+    return 0;
+  }
+
+  len = MIN(len, asset->entry->size - offset);
+  position = asset->entry->offset + offset;
+
+  k_mutex_lock(&g_lock, K_FOREVER);
+
+  while (done < len) {
+    block = asset_cache_get(position / ASSET_BLOCK_SIZE);
+    if (!block) {
+      k_mutex_unlock(&g_lock);
+      return -EIO;
+    }
+
+    chunk = MIN(len - done, ASSET_BLOCK_SIZE - (position % ASSET_BLOCK_SIZE));
+    memcpy(&dst[done], &block[position % ASSET_BLOCK_SIZE], chunk);
+    done += chunk;
+    position += chunk;
+  }
+
+  k_mutex_unlock(&g_lock);
+
+  return done;
+}
+
+// Confere o crc lendo direto da flash, sem poluir o cache
+int asset_verify(const struct asset *asset) {
+  uint8_t chunk[ASSET_VERIFY_CHUNK];
+  uint32_t crc = 0;
+  size_t done = 0;
+  size_t len;
+  int ret;
+
+  if (!asset || !asset->entry) {
+    return -EINVAL;
+  }
+
+  while (done < asset->entry->size) {
+    len = MIN(sizeof(chunk), asset->entry->size - done);
+    k_mutex_lock(&g_lock, K_FOREVER);
+    ret = asset_flash_read(asset->entry->offset + done, chunk, len);
+    k_mutex_unlock(&g_lock);
+    if (ret != 0) {
+      return ret;
+    }
+    crc = crc32_ieee_update(crc, chunk, len);
+    done += len;
+  }
+
+  return (crc == asset->entry->crc) ? 0 : -EBADMSG;
+}
+
+int asset_store_get_stats(struct asset_store_stats *stats) {
+  if (!stats) {
+    return -EINVAL;
+  }
+
+  k_mutex_lock(&g_lock, K_FOREVER);
+  *stats = g_stats;
+  k_mutex_unlock(&g_lock);
+
+  return 0;
+}
+
+static int asset_shell_cmd_ls(const struct shell *shell, size_t argc, char **argv) {
+  struct asset asset;
+  bool ready;
+
+  ARG_UNUSED(argc);
+  ARG_UNUSED(argv);
+
+  k_mutex_lock(&g_lock, K_FOREVER);
+  ready = g_ready;
+  k_mutex_unlock(&g_lock);
+
+  if (!ready) {
+    shell_print(shell, "Asset store not mounted");
+    return 0;
+  }
+
+  for (int i = 0; i < g_count; i++) {
+    asset.entry = &g_entries[i];
+    shell_print(shell, "%-24.24s %8u 0x%08x %s", g_entries[i].name, g_entries[i].size,
+                g_entries[i].offset, (asset_verify(&asset) == 0) ? "ok" : "BAD CRC");
+  }
+
+  return 0;
+}
+
+static int asset_shell_cmd_stats(const struct shell *shell, size_t argc, char **argv) {
+  struct asset_store_stats stats;
+  uint32_t total;
+
+  ARG_UNUSED(argc);
+  ARG_UNUSED(argv);
+
+  asset_store_get_stats(&stats);
+  total = stats.hits + stats.misses;
+
+  shell_print(shell, "cache: %u x %u bytes", ASSET_BLOCK_COUNT, ASSET_BLOCK_SIZE);
+  shell_print(shell, "hits: %u misses: %u (%u%% hit) evictions: %u", stats.hits, stats.misses,
+              total ? (stats.hits * 100) / total : 0, stats.evictions);
+  shell_print(shell, "flash time: %u us", stats.flash_us);
+
+  return 0;
+}
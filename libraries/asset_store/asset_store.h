@@ -0,0 +1,65 @@
+#ifndef _ASSET_STORE_H
+#define _ASSET_STORE_H
+
+/* C++ detection */
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <zephyr/kernel.h>
+
+#define ASSET_STORE_MAGIC         (0x31545341) // "AST1"
+#define ASSET_STORE_NAME_LEN      (24)
+#define ASSET_STORE_MAX_ENTRIES   (64)
+
+/*
+ * Imagem gerada por tools/pack_assets.py e gravada na flash QSPI:
+ *   header | entradas[count] | dados (alinhados ao bloco do cache)
+ * O crc do header cobre as entradas; o de cada entrada cobre os dados.
+ */
+struct asset_store_header {
+  uint32_t magic;
+  uint16_t count;
+  uint16_t block_size;          // Alinhamento usado pelo empacotador
+  uint32_t crc;
+} __packed;
+
+struct asset_store_entry {
+  char name[ASSET_STORE_NAME_LEN];
+  uint32_t offset;              // Relativo ao inicio da imagem
+  uint32_t size;
+  uint32_t crc;
+} __packed;
+
+struct asset {
+  const struct asset_store_entry *entry;
+};
+
+struct asset_store_stats {
+  uint32_t hits;                // Leituras atendidas pelo cache
+  uint32_t misses;              // Blocos trazidos da flash
+  uint32_t evictions;
+  uint32_t flash_us;            // Tempo total lendo a flash
+};
+
+int asset_store_init(void);
+int asset_find(const char *name, struct asset *asset);
+int asset_read(const struct asset *asset, size_t offset, void *buf, size_t len);
+size_t asset_size(const struct asset *asset);
+int asset_verify(const struct asset *asset);
+int asset_store_get_stats(struct asset_store_stats *stats);
+
+#ifdef CONFIG_LVGL
+// Registra a letra CONFIG_APP_ASSETS_LVGL_LETTER no lv_fs (ex.: "A:logo.bin")
+int asset_lvgl_init(void);
+#endif
+
+/* C++ detection */
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* _ASSET_STORE_H */
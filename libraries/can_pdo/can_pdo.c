@@ -0,0 +1,524 @@
+#include "can_pdo.h"
+
+#include <math.h>
+#include <string.h>
+#include <zephyr/drivers/can.h>
+#include <zephyr/kernel.h>
+#include <zephyr/logging/log.h>
+#include <zephyr/shell/shell.h>
+
+LOG_MODULE_REGISTER(can_pdo, CONFIG_LOG_DEFAULT_LEVEL);
+
+/*
+ * Troca ciclica de dados de processo no estilo dos PDOs do CANopen: quadros
+ * com valores empacotados, sem protocolo de transporte. Uma unica thread envia
+ * por tempo de ciclo ou mudanca de estado e grava na base os PDOs recebidos.
+ * A mudanca e detectada pelo contador de alteracoes da base, sem ler os
+ * valores enquanto nada muda.
+ */
+
+#define CAN_PDO_STACK_MEM_ATTRIBUTES Z_GENERIC_SECTION(.app_stack)
+#define CAN_PDO_LOAD_WINDOW_MS       (1000)
+
+// Taxas do barramento para a estimativa de carga
+#define CAN_PDO_NODE                 DT_CHOSEN(zephyr_canbus)
+#if DT_NODE_EXISTS(CAN_PDO_NODE)
+#define CAN_PDO_BITRATE              DT_PROP_OR(CAN_PDO_NODE, bitrate, 500000)
+#define CAN_PDO_BITRATE_DATA         DT_PROP_OR(CAN_PDO_NODE, bitrate_data, 2000000)
+#else
+#define CAN_PDO_BITRATE              (500000)
+#define CAN_PDO_BITRATE_DATA         (2000000)
+#endif
+
+struct can_pdo_load {
+  int64_t window_start;
+  uint64_t window_ns;           // Tempo de barramento ocupado na janela atual
+  uint32_t permille;            // Ultima janela completa
+  uint32_t peak_permille;
+};
+
+static const struct device *g_can_dev;
+static sys_slist_t g_tx_list = SYS_SLIST_STATIC_INIT(&g_tx_list);
+static sys_slist_t g_rx_list = SYS_SLIST_STATIC_INIT(&g_rx_list);
+static struct db_raw_item g_items[CONFIG_APP_PDO_MAX_MAPS];
+static uint8_t __aligned(8) g_values[CONFIG_APP_PDO_MAX_MAPS][CAN_PDO_VALUE_MAX];
+static struct can_pdo_load g_load;
+static atomic_t g_tx_errors;
+static uint32_t g_last_seq;
+static bool g_started;
+static struct k_thread g_thread;
+static K_MUTEX_DEFINE(g_lock);
+
+CAN_MSGQ_DEFINE(g_rx_msgq, CONFIG_APP_PDO_RX_QUEUE);
+Z_KERNEL_STACK_DEFINE_IN(g_stack, CONFIG_APP_PDO_STACK_SIZE, CAN_PDO_STACK_MEM_ATTRIBUTES);
+
+static void can_pdo_thread(void *p1, void *p2, void *p3);
+static void can_pdo_sum(sys_slist_t *list, struct can_pdo_stats *total);
+static int can_pdo_shell_cmd_stats(const struct shell *shell, size_t argc, char **argv);
+
+SHELL_STATIC_SUBCMD_SET_CREATE(
+    pdo, SHELL_CMD(stats, NULL, "process data objects and bus load", can_pdo_shell_cmd_stats),
+    SHELL_SUBCMD_SET_END);
+
+SHELL_CMD_REGISTER(pdo, &pdo, "CAN process data commands", NULL);
+
+// Valor numerico do parametro para comparar com o deadband
+static double can_pdo_value(const struct db_param *param, const void *raw) {
+  switch (param->config.info.type) {
+  case eBOL:
+  case eU08:
+    return *(const uint8_t *)raw;
+  case eS08:
+    return *(const int8_t *)raw;
+  case eU16:
+    return *(const uint16_t *)raw;
+  case eS16:
+    return *(const int16_t *)raw;
+  case eU32:
+    return *(const uint32_t *)raw;
+  case eS32:
+    return *(const int32_t *)raw;
+  case eF32:
+    return *(const float *)raw;
+#if defined(TYPEDEF_ENABLE_VAR_B64)
+  case eU64:
+    return *(const uint64_t *)raw;
+  case eS64:
+    return *(const int64_t *)raw;
+  case eF64:
+    return *(const double *)raw;
+#endif
+  default:
+    return 0;
+  }
+}
+
+/*
+ * Tempo de barramento de um quadro com id de 11 bits, com o pior caso de bit
+ * stuffing. No CAN FD com BRS a fase de dados (DLC, dados e CRC) usa a taxa
+ * de dados.
+ */
+static uint32_t can_pdo_frame_ns(const struct can_frame *frame) {
+  uint32_t len = can_dlc_to_bytes(frame->dlc);
+  uint32_t arb_bits;
+  uint32_t data_bits;
+  uint32_t crc_bits;
+
+  if (!(frame->flags & CAN_FRAME_FDF)) {
+    arb_bits = 47 + (8 * len) + ((34 + (8 * len) - 1) / 4);
+    return (arb_bits * 1000000000ULL) / CAN_PDO_BITRATE;
+  }
+
+  crc_bits = (len > 16) ? 21 : 17;
+  arb_bits = 30 + (17 / 4);
+  data_bits = 1 + 4 + (8 * len) + 4 + crc_bits + (crc_bits / 4) + ((5 + (8 * len)) / 4);
+
+  if (!(frame->flags & CAN_FRAME_BRS)) {
+    return ((arb_bits + data_bits) * 1000000000ULL) / CAN_PDO_BITRATE;
+  }
+
+  return ((arb_bits * 1000000000ULL) / CAN_PDO_BITRATE) +
+         ((data_bits * 1000000000ULL) / CAN_PDO_BITRATE_DATA);
+}
+
+// Chamado na thread: janela fixa de 1 s para a carga
+static void can_pdo_account(const struct can_frame *frame, int64_t now) {
+  uint64_t elapsed_ms = now - g_load.window_start;
+
+  if (elapsed_ms >= CAN_PDO_LOAD_WINDOW_MS) {
+    g_load.permille = (g_load.window_ns / 1000) / elapsed_ms;
+    g_load.peak_permille = MAX(g_load.peak_permille, g_load.permille);
+    g_load.window_ns = 0;
+    g_load.window_start = now;
+  }
+
+  if (frame) {
+    g_load.window_ns += can_pdo_frame_ns(frame);
+  }
+}
+
+static void can_pdo_tx_done(const struct device *dev, int error, void *user_data) {
+  ARG_UNUSED(dev);
+  ARG_UNUSED(user_data);
+
+  if (error != 0) {
+    atomic_inc(&g_tx_errors);
+  }
+}
+
+static int can_pdo_resolve(struct can_pdo *pdo) {
+  struct db_group *group;
+  struct can_pdo_map *map;
+  int ret;
+
+  if (!pdo || !pdo->maps || (pdo->map_count == 0) || (pdo->map_count > CONFIG_APP_PDO_MAX_MAPS)) {
+    return -EINVAL;
+  }
+
+  if (pdo->len > (pdo->fd ? CANFD_MAX_DLEN : CAN_MAX_DLEN)) {
+    return -EINVAL;
+  }
+
+  for (int i = 0; i < pdo->map_count; i++) {
+    map = &pdo->maps[i];
+    ret = db_get_var_config(&group, &map->param, map->group_id, map->param_id);
+    if (ret != 0) {
+      return ret;
+    }
+
+    if ((map->param->config.info.type == eSTR) ||
+        (map->param->config.var_size > CAN_PDO_VALUE_MAX) ||
+        ((map->offset + map->param->config.var_size) > pdo->len)) {
+      LOG_ERR("%s: param %d/%d does not fit", pdo->name, map->group_id, map->param_id);
+      return -EINVAL;
+    }
+  }
+
+  return 0;
+}
+
+/**
+ * @brief Registra um PDO de envio
+ *
+ * Os parametros sao resolvidos aqui: o grupo precisa existir na base.
+ */
+int can_pdo_tx_add(struct can_pdo *pdo) {
+  int ret;
+
+  ret = can_pdo_resolve(pdo);
+  if (ret != 0) {
+    return ret;
+  }
+
+  k_mutex_lock(&g_lock, K_FOREVER);
+  memset(&pdo->stats, 0, sizeof(pdo->stats));
+  pdo->last_tx = k_uptime_get() - pdo->inhibit_ms;
+  pdo->next_cycle = k_uptime_get();
+  pdo->pending = pdo->cos;      // Primeiro quadro sai logo
+  sys_slist_append(&g_tx_list, &pdo->node);
+  k_mutex_unlock(&g_lock);
+
+  return 0;
+}
+
+/**
+ * @brief Registra um PDO de recepcao; os valores vao direto para a base
+ *
+ * Requer can_pdo_init() antes, para instalar o filtro no controlador.
+ */
+int can_pdo_rx_add(struct can_pdo *pdo) {
+  struct can_filter filter = {
+      .flags = 0,
+      .mask = CAN_STD_ID_MASK,
+  };
+  int ret;
+
+  if (!g_can_dev) {
+    return -ENODEV;
+  }
+
+  ret = can_pdo_resolve(pdo);
+  if (ret != 0) {
+    return ret;
+  }
+
+  filter.id = pdo->can_id;
+  ret = can_add_rx_filter_msgq(g_can_dev, &g_rx_msgq, &filter);
+  if (ret < 0) {
+    return ret;
+  }
+
+  k_mutex_lock(&g_lock, K_FOREVER);
+  memset(&pdo->stats, 0, sizeof(pdo->stats));
+  sys_slist_append(&g_rx_list, &pdo->node);
+  k_mutex_unlock(&g_lock);
+
+  return 0;
+}
+
+// Le todos os valores do PDO sob um unico lock da base (retrato consistente)
+static int can_pdo_read(struct can_pdo *pdo) {
+  for (int i = 0; i < pdo->map_count; i++) {
+    g_items[i].param = pdo->maps[i].param;
+    g_items[i].data = g_values[i];
+    g_items[i].len = pdo->maps[i].param->config.var_size;
+  }
+
+  return db_param_get_raw_batch(pdo->access, g_items, pdo->map_count);
+}
+
+// Chamado apos can_pdo_read: algum valor saiu do deadband desde o ultimo envio?
+static bool can_pdo_changed(const struct can_pdo *pdo) {
+  const struct can_pdo_map *map;
+  double delta;
+
+  for (int i = 0; i < pdo->map_count; i++) {
+    map = &pdo->maps[i];
+    if (memcmp(map->last, g_values[i], map->param->config.var_size) == 0) {
+      continue;
+    }
+
+    if (map->deadband <= 0.0f) {
+      return true;
+    }
+
+    delta = can_pdo_value(map->param, g_values[i]) - can_pdo_value(map->param, map->last);
+    if (fabs(delta) >= map->deadband) {
+      return true;
+    }
+  }
+
+  return false;
+}
+
+// Chamado apos can_pdo_read: empacota e envia sem esperar o fim da transmissao
+static int can_pdo_send(struct can_pdo *pdo, int64_t now) {
+  struct can_frame frame = {0};
+  struct can_pdo_map *map;
+  int ret;
+
+  frame.id = pdo->can_id;
+  frame.dlc = can_bytes_to_dlc(pdo->len);
+  if (pdo->fd) {
+    frame.flags = CAN_FRAME_FDF | CAN_FRAME_BRS;
+  }
+
+  for (int i = 0; i < pdo->map_count; i++) {
+    map = &pdo->maps[i];
+    memcpy(&frame.data[map->offset], g_values[i], map->param->config.var_size);
+  }
+
+  ret = can_send(g_can_dev, &frame, K_NO_WAIT, can_pdo_tx_done, pdo);
+  if (ret != 0) {
+    pdo->stats.errors++;
+    return ret;
+  }
+
+  for (int i = 0; i < pdo->map_count; i++) {
+    memcpy(pdo->maps[i].last, g_values[i], pdo->maps[i].param->config.var_size);
+  }
+
+  pdo->stats.frames++;
+  pdo->last_tx = now;
+  pdo->next_cycle = now + pdo->cycle_ms;
+  pdo->pending = false;
+  can_pdo_account(&frame, now);
+
+  return 0;
+}
+
+// Envio por ciclo ou mudanca; retorna o tempo ate o proximo evento deste PDO
+static int64_t can_pdo_tx_service(struct can_pdo *pdo, bool db_changed, int64_t now) {
+  bool cyclic = (pdo->cycle_ms > 0) && (now >= pdo->next_cycle);
+  bool inhibited = (now - pdo->last_tx) < pdo->inhibit_ms;
+  bool fresh = false;
+  int64_t next = INT64_MAX;
+
+  if (pdo->cos && db_changed && !pdo->pending) {
+    fresh = (can_pdo_read(pdo) >= 0);
+    if (fresh && can_pdo_changed(pdo)) {
+      pdo->pending = true;
+      if (inhibited) {
+        pdo->stats.inhibited++;
+      }
+    }
+  }
+
+  if ((cyclic || pdo->pending) && !inhibited && (fresh || (can_pdo_read(pdo) >= 0))) {
+    if (can_pdo_send(pdo, now) == 0) {
+      if (cyclic) {
+        pdo->stats.cyclic++;
+      } else {
+        pdo->stats.cos++;
+      }
+    }
+  }
+
+  if (pdo->pending) {
+    next = pdo->last_tx + pdo->inhibit_ms;
+  }
+
+  if (pdo->cycle_ms > 0) {
+    next = MIN(next, pdo->next_cycle);
+  }
+
+  return next;
+}
+
+static void can_pdo_rx_process(const struct can_frame *frame, int64_t now) {
+  struct can_pdo_map *map;
+  struct can_pdo *pdo;
+  uint8_t len = can_dlc_to_bytes(frame->dlc);
+  int ret;
+
+  can_pdo_account(frame, now);
+
+  SYS_SLIST_FOR_EACH_CONTAINER(&g_rx_list, pdo, node) {
+    if (pdo->can_id != frame->id) {
+      continue;
+    }
+
+    if (len < pdo->len) {
+      pdo->stats.errors++;
+      return;
+    }
+
+    // Copia para area alinhada: float/u32 podem cair fora de alinhamento no quadro
+    for (int i = 0; i < pdo->map_count; i++) {
+      map = &pdo->maps[i];
+      memcpy(map->last, &frame->data[map->offset], map->param->config.var_size);
+      g_items[i].param = map->param;
+      g_items[i].data = map->last;
+      g_items[i].len = map->param->config.var_size;
+    }
+
+    ret = db_param_set_raw_batch(pdo->access, g_items, pdo->map_count);
+    if (ret < 0) {
+      pdo->stats.errors++;
+    } else {
+      pdo->stats.frames++;
+    }
+    return;
+  }
+}
+
+static void can_pdo_thread(void *p1, void *p2, void *p3) {
+  struct can_frame frame;
+  struct can_pdo *pdo;
+  int64_t now;
+  int64_t next;
+  uint32_t seq;
+  int64_t wait_ms = 0;
+
+  ARG_UNUSED(p1);
+  ARG_UNUSED(p2);
+  ARG_UNUSED(p3);
+
+  while (true) {
+    // Recepcao acorda a thread; sem quadros, espera o proximo envio
+    if (k_msgq_get(&g_rx_msgq, &frame, K_MSEC(wait_ms)) == 0) {
+      k_mutex_lock(&g_lock, K_FOREVER);
+      can_pdo_rx_process(&frame, k_uptime_get());
+      k_mutex_unlock(&g_lock);
+    }
+
+    k_mutex_lock(&g_lock, K_FOREVER);
+
+    now = k_uptime_get();
+    seq = db_get_change_seq();
+    next = now + CONFIG_APP_PDO_TICK_MS;
+
+    SYS_SLIST_FOR_EACH_CONTAINER(&g_tx_list, pdo, node) {
+      next = MIN(next, can_pdo_tx_service(pdo, seq != g_last_seq, now));
+    }
+
+    g_last_seq = seq;
+    can_pdo_account(NULL, now);
+
+    k_mutex_unlock(&g_lock);
+
+    wait_ms = MAX(next - k_uptime_get(), 0);
+  }
+}
+
+/**
+ * @brief Inicia o servico de PDOs
+ *
+ * O controlador deve estar configurado e iniciado (ver isotp_conn_init).
+ */
+int can_pdo_init(const struct device *can_dev) {
+  if (g_started) {
+    return 0;
+  }
+
+  if (!can_dev || !device_is_ready(can_dev)) {
+    return -ENODEV;
+  }
+
+  g_can_dev = can_dev;
+  g_last_seq = db_get_change_seq();
+  g_load.window_start = k_uptime_get();
+
+  k_thread_create(&g_thread, g_stack, K_KERNEL_STACK_SIZEOF(g_stack), can_pdo_thread, NULL, NULL,
+                  NULL, CONFIG_APP_PDO_PRIORITY, 0, K_NO_WAIT);
+  k_thread_name_set(&g_thread, "can_pdo");
+  g_started = true;
+
+  return 0;
+}
+
+/**
+ * @brief Carga do barramento na ultima janela de 1 s, em milesimos
+ *
+ * Conta os quadros enviados e os PDOs recebidos por este no.
+ */
+uint32_t can_pdo_bus_load_permille(void) {
+  uint32_t permille;
+
+  k_mutex_lock(&g_lock, K_FOREVER);
+  permille = g_load.permille;
+  k_mutex_unlock(&g_lock);
+
+  return permille;
+}
+
+static void can_pdo_sum(sys_slist_t *list, struct can_pdo_stats *total) {
+  struct can_pdo *pdo;
+
+  memset(total, 0, sizeof(*total));
+
+  SYS_SLIST_FOR_EACH_CONTAINER(list, pdo, node) {
+    total->frames += pdo->stats.frames;
+    total->cyclic += pdo->stats.cyclic;
+    total->cos += pdo->stats.cos;
+    total->inhibited += pdo->stats.inhibited;
+    total->errors += pdo->stats.errors;
+  }
+}
+
+// Totais de todos os PDOs de envio e de recepcao
+int can_pdo_get_stats(struct can_pdo_stats *tx, struct can_pdo_stats *rx) {
+  if (!tx || !rx) {
+    return -EINVAL;
+  }
+
+  k_mutex_lock(&g_lock, K_FOREVER);
+  can_pdo_sum(&g_tx_list, tx);
+  can_pdo_sum(&g_rx_list, rx);
+  tx->errors += atomic_get(&g_tx_errors);
+  k_mutex_unlock(&g_lock);
+
+  return 0;
+}
+
+static int can_pdo_shell_cmd_stats(const struct shell *shell, size_t argc, char **argv) {
+  struct can_pdo *pdo;
+
+  ARG_UNUSED(argc);
+  ARG_UNUSED(argv);
+
+  k_mutex_lock(&g_lock, K_FOREVER);
+
+  shell_print(shell, "%-12s %5s %6s %8s %8s %8s %6s %6s", "pdo", "id", "cycle", "frames",
+              "cyclic", "cos", "inhib", "errors");
+
+  SYS_SLIST_FOR_EACH_CONTAINER(&g_tx_list, pdo, node) {
+    shell_print(shell, "%-12s %5x %6u %8u %8u %8u %6u %6u", pdo->name, pdo->can_id,
+                pdo->cycle_ms, pdo->stats.frames, pdo->stats.cyclic, pdo->stats.cos,
+                pdo->stats.inhibited, pdo->stats.errors);
+  }
+
+  SYS_SLIST_FOR_EACH_CONTAINER(&g_rx_list, pdo, node) {
+    shell_print(shell, "%-12s %5x %6s %8u %8s %8s %6s %6u", pdo->name, pdo->can_id, "rx",
+                pdo->stats.frames, "-", "-", "-", pdo->stats.errors);
+  }
+
+  shell_print(shell, "bus load: %u.%u%% (peak %u.%u%%) at %u/%u bit/s, tx errors: %u",
+              g_load.permille / 10, g_load.permille % 10, g_load.peak_permille / 10,
+              g_load.peak_permille % 10, CAN_PDO_BITRATE, CAN_PDO_BITRATE_DATA,
+              (uint32_t)atomic_get(&g_tx_errors));
+
+  k_mutex_unlock(&g_lock);
+
+  return 0;
+}
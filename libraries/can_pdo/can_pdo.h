@@ -0,0 +1,94 @@
+#ifndef _CAN_PDO_H
+#define _CAN_PDO_H
+
+/* C++ detection */
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <zephyr/device.h>
+#include <zephyr/sys/slist.h>
+#include "database.h"
+
+#define CAN_PDO_VALUE_MAX  (8)      // Maior parametro mapeavel (u64/double)
+
+/*
+ * Mapeamento de um parametro dentro do quadro: offset em bytes, little endian
+ * (como no CANopen) e com o tamanho do parametro. deadband e a menor variacao,
+ * na unidade do parametro, que dispara envio por mudanca (0 = qualquer).
+ */
+struct can_pdo_map {
+  db_group_id_t group_id;
+  db_param_id_t param_id;
+  uint8_t offset;
+  float deadband;
+  struct db_param *param;            // Resolvido no registro
+  uint8_t last[CAN_PDO_VALUE_MAX] __aligned(8); // Ultimo valor enviado/recebido
+};
+
+#define CAN_PDO_MAP(_group, _param, _offset, _deadband)                        \
+  {                                                                            \
+    .group_id = _group, .param_id = _param, .offset = _offset,                 \
+    .deadband = _deadband,                                                     \
+  }
+
+struct can_pdo_stats {
+  uint32_t frames;
+  uint32_t cyclic;              // Envios por tempo de ciclo
+  uint32_t cos;                 // Envios por mudanca de estado
+  uint32_t inhibited;           // Mudancas adiadas pelo inhibit
+  uint32_t errors;
+};
+
+/*
+ * PDO de envio ou de recepcao. Envio: cycle_ms = 0 desliga o envio ciclico,
+ * cos liga o envio por mudanca, respeitando inhibit_ms entre dois quadros.
+ * Recepcao: os valores sao gravados na base com o nivel access.
+ * A memoria pertence a quem chama (normalmente uma tabela estatica).
+ */
+struct can_pdo {
+  const char *name;
+  uint32_t can_id;
+  uint8_t len;                  // Bytes do quadro: ate 8, ou 64 com fd
+  bool fd;
+  uint16_t cycle_ms;
+  uint16_t inhibit_ms;
+  bool cos;
+  enum access_level access;
+  struct can_pdo_map *maps;
+  uint8_t map_count;
+  // Estado interno
+  int64_t last_tx;
+  int64_t next_cycle;
+  bool pending;                 // Mudanca aguardando o fim do inhibit
+  struct can_pdo_stats stats;
+  sys_snode_t node;
+};
+
+#define CAN_PDO_TX(_name, _id, _len, _cycle_ms, _inhibit_ms, _cos, _maps)      \
+  {                                                                            \
+    .name = _name, .can_id = _id, .len = _len, .cycle_ms = _cycle_ms,          \
+    .inhibit_ms = _inhibit_ms, .cos = _cos, .access = ACC_LEVEL_FACTORY,       \
+    .maps = _maps, .map_count = ARRAY_SIZE(_maps),                             \
+  }
+
+#define CAN_PDO_RX(_name, _id, _len, _access, _maps)                           \
+  {                                                                            \
+    .name = _name, .can_id = _id, .len = _len, .access = _access,              \
+    .maps = _maps, .map_count = ARRAY_SIZE(_maps),                             \
+  }
+
+int can_pdo_init(const struct device *can_dev);
+int can_pdo_tx_add(struct can_pdo *pdo);
+int can_pdo_rx_add(struct can_pdo *pdo);
+uint32_t can_pdo_bus_load_permille(void);
+int can_pdo_get_stats(struct can_pdo_stats *tx, struct can_pdo_stats *rx);
+
+/* C++ detection */
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* _CAN_PDO_H */
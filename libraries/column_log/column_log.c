@@ -0,0 +1,719 @@
+#include "column_log.h"
+
+#include <string.h>
+#include <zephyr/logging/log.h>
+#include <zephyr/sys/crc.h>
+
+LOG_MODULE_REGISTER(column_log, CONFIG_LOG_DEFAULT_LEVEL);
+
+#define COLUMN_LOG_VARINT_MAX (5)
+
+static uint32_t zigzag_encode(int32_t value);
+static int32_t zigzag_decode(uint32_t value);
+static size_t varint_size(uint32_t value);
+static size_t varint_encode(uint8_t *dest, uint32_t value);
+static int varint_decode(const uint8_t **src, const uint8_t *end, uint32_t *value);
+static void column_log_request(struct file_io_request *request, enum file_io_op op,
+                               struct fs_file_t *file, void *buffer, size_t length,
+                               off_t offset);
+static int column_log_io_wait(struct file_io *io, struct file_io_request *request,
+                              struct k_poll_signal *signal);
+static int column_log_open_file(struct file_io *io, struct file_io_request *request,
+                                struct k_poll_signal *signal, struct fs_file_t *file,
+                                const char *path, fs_mode_t flags);
+static int column_log_file_size(struct file_io *io, struct file_io_request *request,
+                                struct k_poll_signal *signal, const char *path, off_t *size);
+static int column_log_read_at(struct file_io *io, struct file_io_request *request,
+                              struct k_poll_signal *signal, struct fs_file_t *file, off_t offset,
+                              void *buf, size_t len);
+static int column_log_writer_io(struct column_log_writer *writer, enum file_io_op op,
+                                struct fs_file_t *file, void *buffer, size_t length,
+                                off_t offset);
+static void column_log_reader_close_files(struct column_log_reader *reader);
+static int column_log_recover(struct column_log_writer *writer, off_t data_size,
+                              off_t index_size);
+static void column_log_block_done(struct file_io_request *request, void *user_data);
+static int column_log_wait_block(struct column_log_writer *writer, k_timeout_t timeout);
+static size_t column_log_sample_size(struct column_log_writer *writer, uint32_t timestamp,
+                                     const int32_t *values);
+static int column_log_write_block(struct column_log_writer *writer, k_timeout_t timeout);
+static int column_log_load_block(struct column_log_reader *reader, uint32_t block,
+                                 struct column_log_block_header *header);
+static int column_log_decode_column(const uint8_t *start, const uint8_t *end, uint16_t count,
+                                    bool delta_only, uint32_t *out);
+
+static uint32_t zigzag_encode(int32_t value) {
+  return ((uint32_t)value << 1) ^ (uint32_t)(value >> 31);
+}
+
+static int32_t zigzag_decode(uint32_t value) {
+  return (int32_t)((value >> 1) ^ (~(value & 1) + 1));
+}
+
+static size_t varint_size(uint32_t value) {
+  size_t size = 1;
+
+  while (value >= 0x80) {
+    value >>= 7;
+    size++;
+  }
+
+  return size;
+}
+
+static size_t varint_encode(uint8_t *dest, uint32_t value) {
+  size_t size = 0;
+
+  while (value >= 0x80) {
+    dest[size++] = (uint8_t)(value | 0x80);
+    value >>= 7;
+  }
+  dest[size++] = (uint8_t)value;
+
+  return size;
+}
+
+static int varint_decode(const uint8_t **src, const uint8_t *end, uint32_t *value) {
+  const uint8_t *p = *src;
+  uint32_t result = 0;
+
+  for (int shift = 0; shift < (7 * COLUMN_LOG_VARINT_MAX); shift += 7) {
+    if (p >= end) {
+      return -EBADMSG;
+    }
+    result |= (uint32_t)(*p & 0x7F) << shift;
+    if ((*p++ & 0x80) == 0) {
+      *src = p;
+      *value = result;
+      return 0;
+    }
+  }
+
+  return -EBADMSG;
+}
+
+static void column_log_request(struct file_io_request *request, enum file_io_op op,
+                               struct fs_file_t *file, void *buffer, size_t length,
+                               off_t offset) {
+  memset(request, 0, sizeof(*request));
+  request->op = op;
+  request->file = file;
+  request->buffer = buffer;
+  request->length = length;
+  request->offset = offset;
+}
+
+// Executa o pedido na thread de I/O e espera o resultado
+static int column_log_io_wait(struct file_io *io, struct file_io_request *request,
+                              struct k_poll_signal *signal) {
+  struct k_poll_event event =
+      K_POLL_EVENT_INITIALIZER(K_POLL_TYPE_SIGNAL, K_POLL_MODE_NOTIFY_ONLY, signal);
+  unsigned int signaled;
+  int result;
+  int ret;
+
+  request->signal = signal;
+  ret = file_io_submit(io, request);
+  if (ret != 0) {
+    return ret;
+  }
+
+  k_poll(&event, 1, K_FOREVER);
+  k_poll_signal_check(signal, &signaled, &result);
+
+  return result;
+}
+
+static int column_log_open_file(struct file_io *io, struct file_io_request *request,
+                                struct k_poll_signal *signal, struct fs_file_t *file,
+                                const char *path, fs_mode_t flags) {
+  column_log_request(request, FILE_IO_OPEN, file, NULL, 0, -1);
+  request->path = path;
+  request->flags = flags;
+
+  return column_log_io_wait(io, request, signal);
+}
+
+static int column_log_file_size(struct file_io *io, struct file_io_request *request,
+                                struct k_poll_signal *signal, const char *path, off_t *size) {
+  struct fs_dirent entry;
+  int ret;
+
+  column_log_request(request, FILE_IO_STAT, NULL, &entry, 0, -1);
+  request->path = path;
+
+  ret = column_log_io_wait(io, request, signal);
+  if (ret == 0) {
+    *size = entry.size;
+  }
+
+  return ret;
+}
+
+static int column_log_read_at(struct file_io *io, struct file_io_request *request,
+                              struct k_poll_signal *signal, struct fs_file_t *file, off_t offset,
+                              void *buf, size_t len) {
+  int ret;
+
+  column_log_request(request, FILE_IO_READ, file, buf, len, offset);
+
+  ret = column_log_io_wait(io, request, signal);
+  if (ret < 0) {
+    return ret;
+  }
+
+  return (ret == (int)len) ? 0 : -EIO;
+}
+
+// Pedido sincrono do escritor (abertura, recuperacao, sync e fechamento)
+static int column_log_writer_io(struct column_log_writer *writer, enum file_io_op op,
+                                struct fs_file_t *file, void *buffer, size_t length,
+                                off_t offset) {
+  column_log_request(&writer->request, op, file, buffer, length, offset);
+
+  return column_log_io_wait(writer->io, &writer->request, &writer->signal);
+}
+
+static void column_log_reader_close_files(struct column_log_reader *reader) {
+  column_log_request(&reader->request, FILE_IO_CLOSE, &reader->index_file, NULL, 0, -1);
+  column_log_io_wait(reader->io, &reader->request, &reader->signal);
+  column_log_request(&reader->request, FILE_IO_CLOSE, &reader->data_file, NULL, 0, -1);
+  column_log_io_wait(reader->io, &reader->request, &reader->signal);
+}
+
+/*
+ * Descarta o bloco final incompleto e recria as entradas do indice que faltam
+ * (queda de energia entre a escrita do bloco e a do indice) a partir dos
+ * headers dos blocos. O indice so cresce por APPEND, entao e cortado antes.
+ * O header do ultimo bloco da o timestamp a partir do qual a gravacao segue.
+ */
+static int column_log_recover(struct column_log_writer *writer, off_t data_size,
+                              off_t index_size) {
+  struct column_log_block_header header;
+  struct column_log_index_entry entry;
+  uint32_t index_count;
+  uint32_t block;
+  int ret;
+
+  writer->sequence = data_size / COLUMN_LOG_BLOCK_SIZE;
+  index_count = MIN(index_size / sizeof(entry), writer->sequence);
+
+  ret = column_log_writer_io(writer, FILE_IO_TRUNCATE, &writer->data_file, NULL,
+                             (size_t)writer->sequence * COLUMN_LOG_BLOCK_SIZE, -1);
+  if (ret == 0) {
+    ret = column_log_writer_io(writer, FILE_IO_TRUNCATE, &writer->index_file, NULL,
+                               index_count * sizeof(entry), -1);
+  }
+
+  if ((ret != 0) || (writer->sequence == 0)) {
+    return ret;
+  }
+
+  for (block = MIN(index_count, writer->sequence - 1); block < writer->sequence; block++) {
+    ret = column_log_read_at(writer->io, &writer->request, &writer->signal, &writer->data_file,
+                             (off_t)block * COLUMN_LOG_BLOCK_SIZE, &header, sizeof(header));
+    if (ret != 0) {
+      return ret;
+    }
+    writer->last_timestamp = header.t_max;
+
+    if (block < index_count) {
+      continue;
+    }
+
+    entry.t_min = header.t_min;
+    entry.t_max = header.t_max;
+    entry.block = block;
+
+    ret = column_log_writer_io(writer, FILE_IO_APPEND, &writer->index_file, &entry,
+                               sizeof(entry), -1);
+    if (ret != sizeof(entry)) {
+      return (ret < 0) ? ret : -EIO;
+    }
+  }
+
+  return 0;
+}
+
+int column_log_writer_open(struct column_log_writer *writer, struct file_io *io,
+                           const char *data_path, const char *index_path, uint8_t column_count) {
+  off_t data_size = 0;
+  off_t index_size = 0;
+  int ret;
+
+  if (!writer || !io || !data_path || !index_path || (column_count == 0) ||
+      (column_count > COLUMN_LOG_MAX_COLUMNS)) {
+    return -EINVAL;
+  }
+
+  memset(writer, 0, offsetof(struct column_log_writer, timestamps));
+  writer->io = io;
+  writer->column_count = column_count;
+  k_poll_signal_init(&writer->signal);
+
+  ret = column_log_open_file(io, &writer->request, &writer->signal, &writer->data_file,
+                             data_path, FS_O_CREATE | FS_O_RDWR);
+  if (ret != 0) {
+    LOG_ERR("Failed to open %s (%d)", data_path, ret);
+    return ret;
+  }
+
+  ret = column_log_open_file(io, &writer->request, &writer->signal, &writer->index_file,
+                             index_path, FS_O_CREATE | FS_O_RDWR);
+  if (ret != 0) {
+    LOG_ERR("Failed to open %s (%d)", index_path, ret);
+    column_log_writer_io(writer, FILE_IO_CLOSE, &writer->data_file, NULL, 0, -1);
+    return ret;
+  }
+
+  ret = column_log_file_size(io, &writer->request, &writer->signal, data_path, &data_size);
+  if (ret == 0) {
+    ret = column_log_file_size(io, &writer->request, &writer->signal, index_path, &index_size);
+  }
+
+  if (ret == 0) {
+    ret = column_log_recover(writer, data_size, index_size);
+  }
+
+  if (ret != 0) {
+    LOG_ERR("Failed to resume %s (%d)", data_path, ret);
+    column_log_writer_io(writer, FILE_IO_CLOSE, &writer->index_file, NULL, 0, -1);
+    column_log_writer_io(writer, FILE_IO_CLOSE, &writer->data_file, NULL, 0, -1);
+    return ret;
+  }
+
+  writer->open = true;
+
+  return 0;
+}
+
+/*
+ * Encadeamento na thread de I/O: bloco, entrada do indice e sync dos dois
+ * arquivos (o tamanho no diretorio acompanha cada bloco). A primeira falha
+ * encerra a cadeia e vai para o sinal.
+ */
+static void column_log_block_done(struct file_io_request *request, void *user_data) {
+  struct column_log_writer *writer = user_data;
+  int result = request->result;
+
+  if (result >= 0) {
+    if ((request->op == FILE_IO_APPEND) && (request->file == &writer->data_file)) {
+      result = (result == COLUMN_LOG_BLOCK_SIZE) ? 0 : -EIO;
+      column_log_request(request, FILE_IO_APPEND, &writer->index_file, &writer->entry,
+                         sizeof(writer->entry), -1);
+    } else if (request->op == FILE_IO_APPEND) {
+      result = (result == sizeof(writer->entry)) ? 0 : -EIO;
+      column_log_request(request, FILE_IO_SYNC, &writer->data_file, NULL, 0, -1);
+    } else if (request->file == &writer->data_file) {
+      column_log_request(request, FILE_IO_SYNC, &writer->index_file, NULL, 0, -1);
+    } else {
+      k_poll_signal_raise(&writer->signal, 0);
+      return;
+    }
+  }
+
+  if (result == 0) {
+    request->callback = column_log_block_done;
+    request->user_data = writer;
+    result = file_io_submit(writer->io, request);
+    if (result == 0) {
+      return;
+    }
+  }
+
+  k_poll_signal_raise(&writer->signal, result);
+}
+
+// Espera o bloco em voo; uma falha fica registrada ate a reabertura
+static int column_log_wait_block(struct column_log_writer *writer, k_timeout_t timeout) {
+  struct k_poll_event event =
+      K_POLL_EVENT_INITIALIZER(K_POLL_TYPE_SIGNAL, K_POLL_MODE_NOTIFY_ONLY, &writer->signal);
+  unsigned int signaled;
+  int result;
+
+  if (!writer->busy) {
+    return writer->error;
+  }
+
+  if (k_poll(&event, 1, timeout) != 0) {
+    return -EBUSY;
+  }
+
+  k_poll_signal_check(&writer->signal, &signaled, &result);
+  writer->busy = false;
+
+  if (result != 0) {
+    LOG_ERR("Failed to write block %u (%d)", writer->entry.block, result);
+    writer->error = result;
+  }
+
+  return writer->error;
+}
+
+// Bytes que a amostra ocupa no bloco em preenchimento
+static size_t column_log_sample_size(struct column_log_writer *writer, uint32_t timestamp,
+                                     const int32_t *values) {
+  uint16_t n = writer->sample_count;
+  size_t size;
+  int32_t previous;
+
+  size = varint_size((n > 0) ? (timestamp - writer->last_timestamp) : 0);
+
+  for (uint8_t c = 0; c < writer->column_count; c++) {
+    previous = (n > 0) ? writer->values[c][n - 1] : 0;
+    size += varint_size(zigzag_encode((int32_t)((uint32_t)values[c] - (uint32_t)previous)));
+  }
+
+  return size;
+}
+
+/*
+ * Codifica as amostras em writer->block e entrega o bloco ao servico de I/O.
+ * O buffer do bloco so e reutilizado depois que o anterior terminou: espera
+ * ate timeout por ele (-EBUSY se ainda estiver em voo).
+ */
+static int column_log_write_block(struct column_log_writer *writer, k_timeout_t timeout) {
+  struct column_log_block_header header = {0};
+  uint8_t *p = &writer->block[sizeof(header)];
+  uint32_t previous;
+  uint16_t end;
+  int ret;
+
+  ret = column_log_wait_block(writer, timeout);
+  if ((ret != 0) || (writer->sample_count == 0)) {
+    return ret;
+  }
+
+  memset(writer->block, 0, sizeof(writer->block));
+
+  header.magic = COLUMN_LOG_MAGIC;
+  header.sequence = writer->sequence;
+  header.t_min = writer->timestamps[0];
+  header.t_max = writer->timestamps[writer->sample_count - 1];
+  header.sample_count = writer->sample_count;
+  header.column_count = writer->column_count;
+
+  header.column_offset[0] = sizeof(header);
+  previous = header.t_min;
+  for (uint16_t i = 0; i < writer->sample_count; i++) {
+    p += varint_encode(p, writer->timestamps[i] - previous);
+    previous = writer->timestamps[i];
+  }
+
+  for (uint8_t c = 0; c < writer->column_count; c++) {
+    header.column_offset[c + 1] = p - writer->block;
+    previous = 0;
+    for (uint16_t i = 0; i < writer->sample_count; i++) {
+      p += varint_encode(p, zigzag_encode((int32_t)((uint32_t)writer->values[c][i] - previous)));
+      previous = (uint32_t)writer->values[c][i];
+    }
+  }
+
+  end = p - writer->block;
+  header.column_offset[writer->column_count + 1] = end;
+  header.crc = crc32_ieee(&writer->block[sizeof(header)], end - sizeof(header));
+  memcpy(writer->block, &header, sizeof(header));
+
+  writer->entry.t_min = header.t_min;
+  writer->entry.t_max = header.t_max;
+  writer->entry.block = writer->sequence;
+
+  column_log_request(&writer->request, FILE_IO_APPEND, &writer->data_file, writer->block,
+                     COLUMN_LOG_BLOCK_SIZE, -1);
+  writer->request.callback = column_log_block_done;
+  writer->request.user_data = writer;
+  k_poll_signal_reset(&writer->signal);
+
+  // Fila cheia: as amostras continuam no escritor para a proxima tentativa
+  ret = file_io_submit(writer->io, &writer->request);
+  if (ret != 0) {
+    return ret;
+  }
+
+  writer->busy = true;
+  writer->sequence++;
+  writer->sample_count = 0;
+  writer->encoded_size = 0;
+
+  return 0;
+}
+
+/*
+ * Timestamps devem ser nao decrescentes, inclusive em relacao ao que ja esta
+ * no arquivo. Nao bloqueia: com o bloco cheio e o anterior ainda no cartao
+ * retorna -EBUSY e a amostra nao e aceita.
+ */
+int column_log_append(struct column_log_writer *writer, uint32_t timestamp, const int32_t *values) {
+  uint16_t n;
+  size_t size;
+  int ret;
+
+  if (!writer || !writer->open || !values) {
+    return -EINVAL;
+  }
+
+  if (writer->error != 0) {
+    return writer->error;
+  }
+
+  if (timestamp < writer->last_timestamp) {
+    return -EINVAL;
+  }
+
+  size = column_log_sample_size(writer, timestamp, values);
+
+  if ((writer->sample_count >= COLUMN_LOG_MAX_SAMPLES) ||
+      (sizeof(struct column_log_block_header) + writer->encoded_size + size >
+       COLUMN_LOG_BLOCK_SIZE)) {
+    ret = column_log_write_block(writer, K_NO_WAIT);
+    if (ret != 0) {
+      return ret;
+    }
+    size = column_log_sample_size(writer, timestamp, values);
+  }
+
+  n = writer->sample_count++;
+  writer->timestamps[n] = timestamp;
+  for (uint8_t c = 0; c < writer->column_count; c++) {
+    writer->values[c][n] = values[c];
+  }
+  writer->encoded_size += size;
+  writer->last_timestamp = timestamp;
+
+  return 0;
+}
+
+// Grava o bloco parcial e espera que ele (e o sync) chegue ao cartao
+int column_log_writer_flush(struct column_log_writer *writer) {
+  int ret;
+
+  if (!writer || !writer->open) {
+    return -EINVAL;
+  }
+
+  ret = column_log_write_block(writer, K_FOREVER);
+  if (ret == 0) {
+    ret = column_log_wait_block(writer, K_FOREVER);
+  }
+
+  return ret;
+}
+
+int column_log_writer_close(struct column_log_writer *writer) {
+  int ret;
+
+  if (!writer || !writer->open) {
+    return -EINVAL;
+  }
+
+  ret = column_log_writer_flush(writer);
+
+  // Mesmo com falha o bloco em voo terminou: os arquivos podem ser fechados
+  column_log_wait_block(writer, K_FOREVER);
+  column_log_writer_io(writer, FILE_IO_CLOSE, &writer->index_file, NULL, 0, -1);
+  column_log_writer_io(writer, FILE_IO_CLOSE, &writer->data_file, NULL, 0, -1);
+  writer->open = false;
+
+  return ret;
+}
+
+int column_log_reader_open(struct column_log_reader *reader, struct file_io *io,
+                           const char *data_path, const char *index_path) {
+  off_t index_size;
+  int ret;
+
+  if (!reader || !io || !data_path || !index_path) {
+    return -EINVAL;
+  }
+
+  reader->open = false;
+  reader->io = io;
+  k_poll_signal_init(&reader->signal);
+
+  ret = column_log_open_file(io, &reader->request, &reader->signal, &reader->data_file,
+                             data_path, FS_O_READ);
+  if (ret != 0) {
+    return ret;
+  }
+
+  ret = column_log_open_file(io, &reader->request, &reader->signal, &reader->index_file,
+                             index_path, FS_O_READ);
+  if (ret != 0) {
+    column_log_request(&reader->request, FILE_IO_CLOSE, &reader->data_file, NULL, 0, -1);
+    column_log_io_wait(io, &reader->request, &reader->signal);
+    return ret;
+  }
+
+  ret = column_log_file_size(io, &reader->request, &reader->signal, index_path, &index_size);
+  if (ret != 0) {
+    column_log_reader_close_files(reader);
+    return ret;
+  }
+
+  reader->block_count = index_size / sizeof(struct column_log_index_entry);
+  reader->open = true;
+
+  return 0;
+}
+
+static int column_log_load_block(struct column_log_reader *reader, uint32_t block,
+                                 struct column_log_block_header *header) {
+  uint16_t end;
+  int ret;
+
+  ret = column_log_read_at(reader->io, &reader->request, &reader->signal, &reader->data_file,
+                           (off_t)block * COLUMN_LOG_BLOCK_SIZE, reader->block,
+                           COLUMN_LOG_BLOCK_SIZE);
+  if (ret != 0) {
+    return ret;
+  }
+
+  memcpy(header, reader->block, sizeof(*header));
+
+  if ((header->magic != COLUMN_LOG_MAGIC) || (header->column_count == 0) ||
+      (header->column_count > COLUMN_LOG_MAX_COLUMNS) ||
+      (header->sample_count > COLUMN_LOG_MAX_SAMPLES)) {
+    return -EBADMSG;
+  }
+
+  for (uint8_t c = 0; c <= header->column_count; c++) {
+    if ((header->column_offset[c] < sizeof(*header)) ||
+        (header->column_offset[c] > header->column_offset[c + 1])) {
+      return -EBADMSG;
+    }
+  }
+
+  end = header->column_offset[header->column_count + 1];
+  if ((end > COLUMN_LOG_BLOCK_SIZE) ||
+      (crc32_ieee(&reader->block[sizeof(*header)], end - sizeof(*header)) != header->crc)) {
+    return -EBADMSG;
+  }
+
+  return 0;
+}
+
+// Reconstroi uma coluna: delta_only soma os deltas (timestamps), senao zigzag
+static int column_log_decode_column(const uint8_t *start, const uint8_t *end, uint16_t count,
+                                    bool delta_only, uint32_t *out) {
+  uint32_t previous = 0;
+  uint32_t raw;
+  int ret;
+
+  for (uint16_t i = 0; i < count; i++) {
+    ret = varint_decode(&start, end, &raw);
+    if (ret != 0) {
+      return ret;
+    }
+    previous += delta_only ? raw : (uint32_t)zigzag_decode(raw);
+    out[i] = previous;
+  }
+
+  return 0;
+}
+
+// Entrega as amostras de [t_start, t_end]; retorna quantas foram entregues.
+// O indice e pesquisado por busca binaria e so as colunas pedidas sao decodificadas.
+int column_log_read_range(struct column_log_reader *reader, uint32_t t_start, uint32_t t_end,
+                          uint32_t column_mask, column_log_sample_cb_t callback, void *user_data) {
+  struct column_log_block_header header;
+  struct column_log_index_entry entry;
+  int32_t row[COLUMN_LOG_MAX_COLUMNS] = {0};
+  uint32_t low = 0;
+  uint32_t high;
+  uint32_t mid;
+  int delivered = 0;
+  int ret;
+
+  if (!reader || !reader->open || !callback || (t_end < t_start)) {
+    return -EINVAL;
+  }
+
+  // Primeiro bloco com t_max >= t_start
+  high = reader->block_count;
+  while (low < high) {
+    mid = low + (high - low) / 2;
+    ret = column_log_read_at(reader->io, &reader->request, &reader->signal, &reader->index_file,
+                             (off_t)mid * sizeof(entry), &entry, sizeof(entry));
+    if (ret != 0) {
+      return ret;
+    }
+    if (entry.t_max < t_start) {
+      low = mid + 1;
+    } else {
+      high = mid;
+    }
+  }
+
+  for (uint32_t i = low; i < reader->block_count; i++) {
+    ret = column_log_read_at(reader->io, &reader->request, &reader->signal, &reader->index_file,
+                             (off_t)i * sizeof(entry), &entry, sizeof(entry));
+    if (ret != 0) {
+      return ret;
+    }
+
+    if (entry.t_min > t_end) {
+      break;
+    }
+
+    ret = column_log_load_block(reader, entry.block, &header);
+    if (ret != 0) {
+      LOG_WRN("Skipping block %u (%d)", entry.block, ret);
+      continue;
+    }
+
+    ret = column_log_decode_column(&reader->block[header.column_offset[0]],
+                                   &reader->block[header.column_offset[1]],
+                                   header.sample_count, true, reader->timestamps);
+    for (uint16_t s = 0; (ret == 0) && (s < header.sample_count); s++) {
+      reader->timestamps[s] += header.t_min;
+    }
+
+    for (uint8_t c = 0; (ret == 0) && (c < header.column_count); c++) {
+      if (column_mask & BIT(c)) {
+        ret = column_log_decode_column(&reader->block[header.column_offset[c + 1]],
+                                       &reader->block[header.column_offset[c + 2]],
+                                       header.sample_count, false,
+                                       (uint32_t *)reader->values[c]);
+      }
+    }
+
+    if (ret != 0) {
+      LOG_WRN("Corrupted block %u (%d)", entry.block, ret);
+      continue;
+    }
+
+    for (uint16_t s = 0; s < header.sample_count; s++) {
+      if (reader->timestamps[s] < t_start) {
+        continue;
+      }
+      if (reader->timestamps[s] > t_end) {
+        return delivered;
+      }
+
+      for (uint8_t c = 0; c < header.column_count; c++) {
+        if (column_mask & BIT(c)) {
+          row[c] = reader->values[c][s];
+        }
+      }
+
+      delivered++;
+      if (callback(reader->timestamps[s], row, column_mask & BIT_MASK(header.column_count),
+                   user_data) != 0) {
+        return delivered;
+      }
+    }
+  }
+
+  return delivered;
+}
+
+int column_log_reader_close(struct column_log_reader *reader) {
+  if (!reader || !reader->open) {
+    return -EINVAL;
+  }
+
+  column_log_reader_close_files(reader);
+  reader->open = false;
+
+  return 0;
+}
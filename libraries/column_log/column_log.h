@@ -0,0 +1,108 @@
+#ifndef _COLUMN_LOG_H
+#define _COLUMN_LOG_H
+
+/* C++ detection */
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <zephyr/fs/fs.h>
+#include <zephyr/kernel.h>
+#include "file_io.h"
+
+// Blocos de tamanho fixo (multiplo de setor), gravados sempre inteiros
+#define COLUMN_LOG_BLOCK_SIZE   (4096)
+#define COLUMN_LOG_MAX_COLUMNS  (8)
+#define COLUMN_LOG_MAX_SAMPLES  (256)
+#define COLUMN_LOG_MAGIC        (0x31424C43) // "CLB1"
+
+/*
+ * Layout do bloco:
+ *   header | coluna de timestamps | coluna 0 | ... | coluna N-1 | zeros
+ * Timestamps: varint do delta em relacao a amostra anterior (a primeira em
+ * relacao a t_min). Valores: varint zigzag do primeiro valor e depois dos
+ * deltas. column_offset[i] aponta o inicio da coluna i (0 = timestamps) e
+ * column_offset[column_count + 1] o fim dos dados, coberto pelo crc.
+ */
+struct column_log_block_header {
+  uint32_t magic;
+  uint32_t sequence;
+  uint32_t t_min;
+  uint32_t t_max;
+  uint16_t sample_count;
+  uint8_t column_count;
+  uint8_t reserved;
+  uint16_t column_offset[COLUMN_LOG_MAX_COLUMNS + 2];
+  uint32_t crc;
+} __packed;
+
+// Entrada do indice esparso: um por bloco, em ordem de tempo
+struct column_log_index_entry {
+  uint32_t t_min;
+  uint32_t t_max;
+  uint32_t block;
+} __packed;
+
+/*
+ * Todo acesso ao cartao passa pelo servico de I/O (file_io). A abertura e a
+ * leitura esperam o resultado; a gravacao de um bloco cheio nao: o bloco vai
+ * para a fila (dados, indice e sync encadeados) e o proximo so espera se o
+ * anterior ainda estiver em voo.
+ */
+struct column_log_writer {
+  struct file_io *io;
+  struct fs_file_t data_file;
+  struct fs_file_t index_file;
+  struct file_io_request request;       // Um pedido em voo por vez
+  struct k_poll_signal signal;          // Fim do bloco em voo (ou de um pedido sincrono)
+  struct column_log_index_entry entry;  // Entrada do bloco em voo
+  bool open;
+  bool busy;                            // Bloco em voo no servico de I/O
+  int error;                            // Falha de gravacao: reabrir para recuperar
+  uint8_t column_count;
+  uint32_t sequence;
+  uint16_t sample_count;
+  size_t encoded_size;
+  uint32_t last_timestamp;              // Ultima amostra (inclusive de blocos ja gravados)
+  uint32_t timestamps[COLUMN_LOG_MAX_SAMPLES];
+  int32_t values[COLUMN_LOG_MAX_COLUMNS][COLUMN_LOG_MAX_SAMPLES];
+  uint8_t block[COLUMN_LOG_BLOCK_SIZE];
+};
+
+struct column_log_reader {
+  struct file_io *io;
+  struct fs_file_t data_file;
+  struct fs_file_t index_file;
+  struct file_io_request request;
+  struct k_poll_signal signal;
+  bool open;
+  uint32_t block_count;
+  uint32_t timestamps[COLUMN_LOG_MAX_SAMPLES];
+  int32_t values[COLUMN_LOG_MAX_COLUMNS][COLUMN_LOG_MAX_SAMPLES];
+  uint8_t block[COLUMN_LOG_BLOCK_SIZE];
+};
+
+// Chamado para cada amostra no intervalo; so as colunas de column_mask sao validas
+typedef int (*column_log_sample_cb_t)(uint32_t timestamp, const int32_t *values,
+                                      uint32_t column_mask, void *user_data);
+
+int column_log_writer_open(struct column_log_writer *writer, struct file_io *io,
+                           const char *data_path, const char *index_path, uint8_t column_count);
+int column_log_append(struct column_log_writer *writer, uint32_t timestamp, const int32_t *values);
+int column_log_writer_flush(struct column_log_writer *writer);
+int column_log_writer_close(struct column_log_writer *writer);
+
+int column_log_reader_open(struct column_log_reader *reader, struct file_io *io,
+                           const char *data_path, const char *index_path);
+int column_log_read_range(struct column_log_reader *reader, uint32_t t_start, uint32_t t_end,
+                          uint32_t column_mask, column_log_sample_cb_t callback, void *user_data);
+int column_log_reader_close(struct column_log_reader *reader);
+
+/* C++ detection */
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* _COLUMN_LOG_H */
@@ -0,0 +1,361 @@
+#include "data_logger.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <zephyr/logging/log.h>
+
+LOG_MODULE_REGISTER(data_logger, CONFIG_LOG_DEFAULT_LEVEL);
+
+static uint8_t *data_logger_buffer_data(struct data_logger *logger, uint8_t index);
+static void data_logger_seal(struct data_logger *logger);
+static uint32_t data_logger_last_index(const char *directory);
+static int data_logger_open_next(struct data_logger *logger);
+static void data_logger_write_buffer(struct data_logger *logger, uint8_t index);
+static void data_logger_thread(void *p1, void *p2, void *p3);
+
+static uint8_t *data_logger_buffer_data(struct data_logger *logger, uint8_t index) {
+  return &logger->config.storage[index * logger->config.buffer_size];
+}
+
+// Fecha o buffer em preenchimento e entrega ao escritor. Completa ate o fim do
+// setor para que toda escrita no cartao seja alinhada. Chamada com lock.
+static void data_logger_seal(struct data_logger *logger) {
+  struct data_logger_buffer *buffer = &logger->buffers[logger->fill_index];
+  uint8_t *data = data_logger_buffer_data(logger, logger->fill_index);
+  size_t padded;
+
+  if ((buffer->state != DATA_LOGGER_BUF_FILLING) || (buffer->used == 0)) {
+    return;
+  }
+
+  padded = ROUND_UP(buffer->used, DATA_LOGGER_SECTOR_SIZE);
+  memset(&data[buffer->used], DATA_LOGGER_TYPE_PAD, padded - buffer->used);
+  buffer->used = padded;
+  buffer->state = DATA_LOGGER_BUF_FULL;
+
+  logger->fill_index = (logger->fill_index + 1) % logger->config.buffer_count;
+  k_sem_give(&logger->full_sem);
+}
+
+// Maior indice de arquivo "Lnnnnnnn.BIN" ja existente no diretorio
+static uint32_t data_logger_last_index(const char *directory) {
+  struct fs_dirent entry;
+  struct fs_dir_t dir;
+  uint32_t last = 0;
+  unsigned long index;
+  char *end;
+
+  fs_dir_t_init(&dir);
+  if (fs_opendir(&dir, directory) != 0) {
+    return 0;
+  }
+
+  while ((fs_readdir(&dir, &entry) == 0) && (entry.name[0] != '\0')) {
+    if ((entry.type != FS_DIR_ENTRY_FILE) || (entry.name[0] != 'L')) {
+      continue;
+    }
+
+    index = strtoul(&entry.name[1], &end, 10);
+    if ((end != &entry.name[1]) && (strcmp(end, ".BIN") == 0) && (index > last)) {
+      last = index;
+    }
+  }
+
+  fs_closedir(&dir);
+
+  return last;
+}
+
+/*
+ * Abre o proximo arquivo. Nao ha pre-alocacao: no FAT, fs_truncate para
+ * aumentar o arquivo preenche com zeros, o que grava file_size bytes no
+ * escritor a cada rotacao. Os clusters sao alocados conforme o arquivo cresce
+ * (uma escrita da FAT por cluster) e o tamanho no diretorio so e atualizado
+ * no fs_sync/fs_close: apos uma queda de energia perde-se o que foi gravado
+ * desde a ultima descarga (flush_interval_ms).
+ */
+static int data_logger_open_next(struct data_logger *logger) {
+  char path[DATA_LOGGER_PATH_MAX];
+  int ret;
+
+  if (logger->file_open) {
+    fs_close(&logger->file);
+    logger->file_open = false;
+  }
+
+  logger->file_index++;
+  snprintf(path, sizeof(path), "%s/L%07u.BIN", logger->config.directory,
+           logger->file_index);
+
+  fs_file_t_init(&logger->file);
+  ret = fs_open(&logger->file, path, FS_O_CREATE | FS_O_RDWR);
+  if (ret != 0) {
+    LOG_ERR("Failed to open %s (%d)", path, ret);
+    return ret;
+  }
+
+  logger->file_open = true;
+  logger->file_offset = 0;
+  logger->stats.files++;
+  LOG_INF("Logging to %s", path);
+
+  return 0;
+}
+
+static void data_logger_write_buffer(struct data_logger *logger, uint8_t index) {
+  struct data_logger_buffer *buffer = &logger->buffers[index];
+  size_t length = buffer->used;
+  uint32_t start = k_uptime_get_32();
+  uint32_t elapsed;
+  k_spinlock_key_t key;
+  ssize_t written = -EIO;
+  int ret = 0;
+
+  if (!logger->file_open ||
+      (logger->file_offset + length > logger->config.file_size)) {
+    ret = data_logger_open_next(logger);
+  }
+
+  if ((ret == 0) && logger->config.prepare) {
+    ret = logger->config.prepare(data_logger_buffer_data(logger, index), length);
+  }
+
+  if (ret == 0) {
+    written = fs_write(&logger->file, data_logger_buffer_data(logger, index), length);
+  }
+
+  elapsed = k_uptime_get_32() - start;
+
+  key = k_spin_lock(&logger->lock);
+
+  if (written == (ssize_t)length) {
+    logger->file_offset += length;
+    logger->stats.bytes_written += length;
+    logger->stats.buffers_written++;
+    if (elapsed > logger->stats.max_write_ms) {
+      logger->stats.max_write_ms = elapsed;
+    }
+  } else {
+    // Arquivo sera reaberto no proximo buffer
+    logger->stats.write_errors++;
+    logger->stats.dropped += buffer->records;
+  }
+
+  buffer->used = 0;
+  buffer->records = 0;
+  buffer->state = DATA_LOGGER_BUF_FREE;
+
+  k_spin_unlock(&logger->lock, key);
+
+  if ((written != (ssize_t)length) && logger->file_open) {
+    LOG_ERR("Write failed (%d)", (int)written);
+    fs_close(&logger->file);
+    logger->file_open = false;
+  }
+}
+
+// Escritor de baixa prioridade: unico dono do arquivo
+static void data_logger_thread(void *p1, void *p2, void *p3) {
+  struct data_logger *logger = p1;
+  k_timeout_t timeout = K_FOREVER;
+  k_spinlock_key_t key;
+  bool sync = false;
+
+  ARG_UNUSED(p2);
+  ARG_UNUSED(p3);
+
+  if (logger->config.flush_interval_ms > 0) {
+    timeout = K_MSEC(logger->config.flush_interval_ms);
+  }
+
+  while (1) {
+    if (k_sem_take(&logger->full_sem, timeout) != 0) {
+      // Sem buffers cheios no intervalo: descarrega o parcial
+      key = k_spin_lock(&logger->lock);
+      data_logger_seal(logger);
+      k_spin_unlock(&logger->lock, key);
+
+      if (k_sem_take(&logger->full_sem, K_NO_WAIT) != 0) {
+        continue;
+      }
+      sync = true;
+    }
+
+    if (logger->buffers[logger->write_index].state == DATA_LOGGER_BUF_FULL) {
+      data_logger_write_buffer(logger, logger->write_index);
+      logger->write_index = (logger->write_index + 1) % logger->config.buffer_count;
+    }
+
+    if (sync && logger->file_open) {
+      fs_sync(&logger->file);
+      sync = false;
+    }
+
+    if (atomic_get(&logger->stop) &&
+        (logger->buffers[logger->write_index].state != DATA_LOGGER_BUF_FULL)) {
+      break;
+    }
+  }
+
+  if (logger->file_open) {
+    fs_close(&logger->file);
+    logger->file_open = false;
+  }
+}
+
+int data_logger_init(struct data_logger *logger, const struct data_logger_config *config) {
+  int ret;
+
+  if (!logger || !config || !config->directory || !config->storage ||
+      (config->buffer_count < 2) || (config->buffer_count > DATA_LOGGER_BUFFER_COUNT_MAX) ||
+      (config->buffer_size < DATA_LOGGER_SECTOR_SIZE) ||
+      (config->buffer_size % DATA_LOGGER_SECTOR_SIZE) ||
+      (config->file_size < config->buffer_size)) {
+    return -EINVAL;
+  }
+
+  memset(logger, 0, sizeof(struct data_logger));
+  logger->config = *config;
+
+  k_sem_init(&logger->full_sem, 0, config->buffer_count);
+
+  ret = fs_mkdir(config->directory);
+  if ((ret != 0) && (ret != -EEXIST)) {
+    LOG_ERR("Failed to create %s (%d)", config->directory, ret);
+    return ret;
+  }
+
+  // Continua a numeracao; o arquivo e aberto pelo escritor no primeiro buffer
+  logger->file_index = data_logger_last_index(config->directory);
+
+  k_thread_create(&logger->thread, logger->stack, K_KERNEL_STACK_SIZEOF(logger->stack),
+                  data_logger_thread, logger, NULL, NULL, DATA_LOGGER_THREAD_PRIORITY,
+                  0, K_NO_WAIT);
+  k_thread_name_set(&logger->thread, "data_logger");
+
+  logger->running = true;
+
+  return 0;
+}
+
+// Nunca bloqueia: sem buffer livre o registro e descartado e contado
+int data_logger_write(struct data_logger *logger, uint8_t type, const void *data, uint16_t length) {
+  struct data_logger_record_header header;
+  struct data_logger_buffer *buffer;
+  size_t total = sizeof(header) + length;
+  k_spinlock_key_t key;
+  uint8_t *dest;
+
+  if (!logger || (length && !data) || (type == DATA_LOGGER_TYPE_END) ||
+      (type == DATA_LOGGER_TYPE_PAD)) {
+    return -EINVAL;
+  }
+
+  header.type = type;
+  header.reserved = 0;
+  header.length = length;
+  header.timestamp = k_uptime_get_32();
+
+  key = k_spin_lock(&logger->lock);
+
+  if (!logger->running) {
+    k_spin_unlock(&logger->lock, key);
+    return -ENODEV;
+  }
+
+  if (total > logger->config.buffer_size) {
+    k_spin_unlock(&logger->lock, key);
+    return -EINVAL;
+  }
+
+  buffer = &logger->buffers[logger->fill_index];
+  if ((buffer->state == DATA_LOGGER_BUF_FILLING) &&
+      (buffer->used + total > logger->config.buffer_size)) {
+    data_logger_seal(logger);
+    buffer = &logger->buffers[logger->fill_index];
+  }
+
+  if (buffer->state == DATA_LOGGER_BUF_FULL) {
+    logger->stats.dropped++;
+    k_spin_unlock(&logger->lock, key);
+    return -ENOMEM;
+  }
+
+  dest = data_logger_buffer_data(logger, logger->fill_index) + buffer->used;
+  memcpy(dest, &header, sizeof(header));
+  if (length) {
+    memcpy(dest + sizeof(header), data, length);
+  }
+
+  buffer->state = DATA_LOGGER_BUF_FILLING;
+  buffer->used += total;
+  buffer->records++;
+  logger->stats.records++;
+
+  if (buffer->used == logger->config.buffer_size) {
+    data_logger_seal(logger);
+  }
+
+  k_spin_unlock(&logger->lock, key);
+
+  return 0;
+}
+
+// Entrega o buffer parcial ao escritor sem esperar a gravacao
+int data_logger_flush(struct data_logger *logger) {
+  k_spinlock_key_t key;
+
+  if (!logger) {
+    return -EINVAL;
+  }
+
+  key = k_spin_lock(&logger->lock);
+  data_logger_seal(logger);
+  k_spin_unlock(&logger->lock, key);
+
+  return 0;
+}
+
+int data_logger_get_stats(struct data_logger *logger, struct data_logger_stats *stats) {
+  k_spinlock_key_t key;
+
+  if (!logger || !stats) {
+    return -EINVAL;
+  }
+
+  key = k_spin_lock(&logger->lock);
+  *stats = logger->stats;
+  k_spin_unlock(&logger->lock, key);
+
+  return 0;
+}
+
+// Descarrega os buffers pendentes, fecha o arquivo e encerra o escritor
+int data_logger_deinit(struct data_logger *logger, k_timeout_t timeout) {
+  k_spinlock_key_t key;
+  int ret;
+
+  if (!logger) {
+    return -EINVAL;
+  }
+
+  key = k_spin_lock(&logger->lock);
+  if (!logger->running) {
+    k_spin_unlock(&logger->lock, key);
+    return -EALREADY;
+  }
+  logger->running = false;
+  data_logger_seal(logger);
+  k_spin_unlock(&logger->lock, key);
+
+  atomic_set(&logger->stop, 1);
+  k_sem_give(&logger->full_sem);
+
+  ret = k_thread_join(&logger->thread, timeout);
+  if (ret != 0) {
+    LOG_ERR("Writer did not stop (%d)", ret);
+  }
+
+  return ret;
+}
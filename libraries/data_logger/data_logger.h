@@ -0,0 +1,94 @@
+#ifndef _DATA_LOGGER_H
+#define _DATA_LOGGER_H
+
+/* C++ detection */
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <zephyr/fs/fs.h>
+#include <zephyr/kernel.h>
+
+#define DATA_LOGGER_SECTOR_SIZE      (512)
+#define DATA_LOGGER_BUFFER_COUNT_MAX (4)
+#define DATA_LOGGER_PATH_MAX         (64)
+#define DATA_LOGGER_STACK_SIZE       (2048)
+#define DATA_LOGGER_THREAD_PRIORITY  (K_LOWEST_APPLICATION_THREAD_PRIO)
+
+// Tipos reservados: 0x00 marca o fim dos dados (leitores de arquivos antigos,
+// pre-alocados com zeros) e 0xFF o preenchimento ate o fim do setor
+#define DATA_LOGGER_TYPE_END         (0x00)
+#define DATA_LOGGER_TYPE_PAD         (0xFF)
+
+// Cabecalho gravado antes de cada registro no arquivo
+struct data_logger_record_header {
+  uint8_t type;
+  uint8_t reserved;
+  uint16_t length;
+  uint32_t timestamp;
+} __packed;
+
+struct data_logger_config {
+  const char *directory;      // Diretorio dos arquivos (ex.: "/SD:/LOG" ou "/RAM:/LOG" no native_sim)
+  uint8_t *storage;           // buffer_count * buffer_size bytes (RAM ou SDRAM)
+  size_t buffer_size;         // Multiplo de DATA_LOGGER_SECTOR_SIZE (4-16 KB)
+  uint8_t buffer_count;       // 2 a DATA_LOGGER_BUFFER_COUNT_MAX
+  uint32_t file_size;         // Tamanho maximo de cada arquivo (rotacao)
+  uint32_t flush_interval_ms; // Descarga de buffer parcial sem novos dados (0 = apenas cheio)
+  int (*prepare)(void *data, size_t length); // Antes de cada gravacao (ex.: cache p/ DMA); opcional
+};
+
+struct data_logger_stats {
+  uint32_t records;           // Registros aceitos
+  uint32_t dropped;           // Registros descartados (sem buffer livre ou erro de escrita)
+  uint32_t bytes_written;     // Bytes gravados no cartao
+  uint32_t buffers_written;   // Buffers descarregados
+  uint32_t write_errors;      // Falhas de escrita/abertura
+  uint32_t files;             // Arquivos criados
+  uint32_t max_write_ms;      // Maior latencia de escrita de um buffer
+};
+
+enum data_logger_buffer_state {
+  DATA_LOGGER_BUF_FREE,
+  DATA_LOGGER_BUF_FILLING,
+  DATA_LOGGER_BUF_FULL,
+};
+
+struct data_logger_buffer {
+  enum data_logger_buffer_state state;
+  size_t used;
+  uint32_t records;
+};
+
+struct data_logger {
+  struct data_logger_config config;
+  struct k_spinlock lock;
+  struct data_logger_buffer buffers[DATA_LOGGER_BUFFER_COUNT_MAX];
+  uint8_t fill_index;
+  uint8_t write_index;
+  bool running;
+  atomic_t stop;
+  struct k_sem full_sem;
+  struct fs_file_t file;
+  bool file_open;
+  uint32_t file_index;
+  uint32_t file_offset;
+  struct data_logger_stats stats;
+  struct k_thread thread;
+  K_KERNEL_STACK_MEMBER(stack, DATA_LOGGER_STACK_SIZE);
+};
+
+int data_logger_init(struct data_logger *logger, const struct data_logger_config *config);
+int data_logger_write(struct data_logger *logger, uint8_t type, const void *data, uint16_t length);
+int data_logger_flush(struct data_logger *logger);
+int data_logger_get_stats(struct data_logger *logger, struct data_logger_stats *stats);
+int data_logger_deinit(struct data_logger *logger, k_timeout_t timeout);
+
+/* C++ detection */
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* _DATA_LOGGER_H */
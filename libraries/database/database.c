@@ -53,6 +53,9 @@ static uint16_t db_mount_param_msg(const struct db_param *param, char *buf,
                                    uint16_t buflen);
 static int db_parse_and_set_param(enum access_level access,
                                   struct db_param *param, char *buf);
+static int db_param_raw_check(enum access_level access,
+                              const struct db_param *param, const void *data,
+                              uint16_t len);
 
 static int db_shell_show_group(void *driver, db_group_id_t group_id);
 static int db_shell_cmd_show_info(const struct shell *shell, size_t argc,
@@ -72,6 +75,9 @@ static db_list_t g_database_list = {
     .task_list = SYS_SLIST_STATIC_INIT(&g_database_list.task_list),
 };
 
+// Incrementado a cada alteracao de valor (ver db_get_change_seq)
+static atomic_t g_db_change_seq;
+
 SHELL_STATIC_SUBCMD_SET_CREATE(
     db, SHELL_CMD(show, NULL, "database show status", db_shell_cmd_show_info),
     SHELL_CMD(set, NULL, "database set variable", db_shell_cmd_set_param),
@@ -326,6 +332,70 @@ static int db_parse_and_set_param(enum access_level access,
   return err;
 }
 
+// Chamado com o lock: mesmas regras dos setters tipados, sobre o valor cru
+static int db_param_raw_check(enum access_level access,
+                              const struct db_param *param, const void *data,
+                              uint16_t len) {
+  const struct db_param_config *cfg;
+
+  if (!param || !data || !param->var) {
+    return -EINVAL;
+  }
+
+  cfg = &param->config;
+
+  if ((access < cfg->info.access) ||
+      (cfg->info.field == VAR_FIELD_READ_ONLY)) {
+    return -EACCES;
+  }
+
+  if (cfg->info.type == eSTR) {
+    return (len < cfg->var_size) ? 0 : -EINVAL;
+  }
+
+  if (len != cfg->var_size) {
+    return -EINVAL;
+  }
+
+#define DB_RAW_IN_RANGE(_type, _range)                                         \
+  ((*(const _type *)data >= cfg->_range.min) &&                                \
+   (*(const _type *)data <= cfg->_range.max))
+
+  switch (cfg->info.type) {
+  case eBOL:
+  case eU08:
+    return DB_RAW_IN_RANGE(uint8_t, u8) ? 0 : -EINVAL;
+  case eS08:
+    return DB_RAW_IN_RANGE(int8_t, s8) ? 0 : -EINVAL;
+  case eU16:
+    return DB_RAW_IN_RANGE(uint16_t, u16) ? 0 : -EINVAL;
+  case eS16:
+    return DB_RAW_IN_RANGE(int16_t, s16) ? 0 : -EINVAL;
+  case eU32:
+    return DB_RAW_IN_RANGE(uint32_t, u32) ? 0 : -EINVAL;
+  case eS32:
+    return DB_RAW_IN_RANGE(int32_t, s32) ? 0 : -EINVAL;
+  case eF32:
+    return (!isnanf(*(const float *)data) && DB_RAW_IN_RANGE(float, f32))
+               ? 0
+               : -EINVAL;
+#if defined(TYPEDEF_ENABLE_VAR_B64)
+  case eU64:
+    return DB_RAW_IN_RANGE(uint64_t, u64) ? 0 : -EINVAL;
+  case eS64:
+    return DB_RAW_IN_RANGE(int64_t, s64) ? 0 : -EINVAL;
+  case eF64:
+    return (!isnan(*(const double *)data) && DB_RAW_IN_RANGE(double, f64))
+               ? 0
+               : -EINVAL;
+#endif
+  default:
+    return -EINVAL;
+  }
+
+#undef DB_RAW_IN_RANGE
+}
+
 static int db_shell_show_group(void *driver, db_group_id_t group_id) {
   uint16_t len;
   uint16_t index;
@@ -488,6 +558,38 @@ int db_group_remove(db_group_id_t group_id) {
   return err;
 }
 
+/**
+ * @brief Lista os grupos registrados, na ordem de registro
+ *
+ * Os ponteiros continuam validos enquanto o grupo nao for removido.
+ *
+ * @return Numero de grupos copiados para groups (no maximo max)
+ */
+int db_get_groups(struct db_group **groups, size_t max) {
+  int err;
+  size_t count = 0;
+  sys_snode_t *node;
+
+  if (!groups) {
+    return -EINVAL;
+  }
+
+  err = db_lock(&g_database_list, DB_LOCK_TIMEOUT_MS);
+  if (err) {
+    return err;
+  }
+
+  SYS_SLIST_FOR_EACH_NODE(&g_database_list.task_list, node) {
+    if (count >= max) {
+      break;
+    }
+    groups[count++] = CONTAINER_OF(node, struct db_group, node);
+  }
+
+  db_unlock(&g_database_list);
+  return count;
+}
+
 int db_group_load_default(db_group_id_t group_id, enum access_level access) {
   uint16_t index;
   uint16_t var_size;
@@ -533,6 +635,10 @@ int db_group_load_default(db_group_id_t group_id, enum access_level access) {
     }
   }
 
+  if (err == 0) {
+    atomic_inc(&g_db_change_seq);
+  }
+
   db_unlock(&g_database_list);
   return err;
 }
@@ -591,7 +697,8 @@ int db_param_set_str(enum access_level access, struct db_param *param,
     return err;
   }
 
-  if (access < param->config.info.access) {
+  if ((access < param->config.info.access) ||
+      (param->config.info.field == VAR_FIELD_READ_ONLY)) {
     err = -EACCES;
   } else if (param->config.info.type != eSTR) {
     err = -EINVAL;
@@ -600,6 +707,7 @@ int db_param_set_str(enum access_level access, struct db_param *param,
         buflen < param->config.var_size ? buflen : param->config.var_size - 1;
     memset(param->var, 0, param->config.var_size);
     memcpy(param->var, buf, len_to_copy);
+    atomic_inc(&g_db_change_seq);
   }
 
   db_unlock(&g_database_list);
@@ -640,7 +748,8 @@ int db_param_set_u8(enum access_level access, struct db_param *param,
     return err;
   }
 
-  if (access < param->config.info.access) {
+  if ((access < param->config.info.access) ||
+      (param->config.info.field == VAR_FIELD_READ_ONLY)) {
     err = -EACCES;
   } else if (sizeof(uint8_t) != param->config.var_size) {
     err = -EINVAL;
@@ -649,6 +758,7 @@ int db_param_set_u8(enum access_level access, struct db_param *param,
     if (*((uint8_t *)param->var) != value) {
       *((uint8_t *)param->var) = value;
       err = DB_UPDATED;
+      atomic_inc(&g_db_change_seq);
     }
   } else {
     err = -EINVAL;
@@ -693,7 +803,8 @@ int db_param_set_s8(enum access_level access, struct db_param *param,
     return err;
   }
 
-  if (access < param->config.info.access) {
+  if ((access < param->config.info.access) ||
+      (param->config.info.field == VAR_FIELD_READ_ONLY)) {
     err = -EACCES;
   } else if (sizeof(uint8_t) != param->config.var_size) {
     err = -EINVAL;
@@ -702,6 +813,7 @@ int db_param_set_s8(enum access_level access, struct db_param *param,
     if (*((int8_t *)param->var) != value) {
       *((int8_t *)param->var) = value;
       err = DB_UPDATED;
+      atomic_inc(&g_db_change_seq);
     }
   } else {
     err = -EINVAL;
@@ -746,7 +858,8 @@ int db_param_set_u16(enum access_level access, struct db_param *param,
     return err;
   }
 
-  if (access < param->config.info.access) {
+  if ((access < param->config.info.access) ||
+      (param->config.info.field == VAR_FIELD_READ_ONLY)) {
     err = -EACCES;
   } else if (sizeof(uint16_t) != param->config.var_size) {
     err = -EINVAL;
@@ -755,6 +868,7 @@ int db_param_set_u16(enum access_level access, struct db_param *param,
     if (*((uint16_t *)param->var) != value) {
       *((uint16_t *)param->var) = value;
       err = DB_UPDATED;
+      atomic_inc(&g_db_change_seq);
     }
   } else {
     err = -EINVAL;
@@ -799,7 +913,8 @@ int db_param_set_s16(enum access_level access, struct db_param *param,
     return err;
   }
 
-  if (access < param->config.info.access) {
+  if ((access < param->config.info.access) ||
+      (param->config.info.field == VAR_FIELD_READ_ONLY)) {
     err = -EACCES;
   } else if (sizeof(int16_t) != param->config.var_size) {
     err = -EINVAL;
@@ -808,6 +923,7 @@ int db_param_set_s16(enum access_level access, struct db_param *param,
     if (*((int16_t *)param->var) != value) {
       *((int16_t *)param->var) = value;
       err = DB_UPDATED;
+      atomic_inc(&g_db_change_seq);
     }
   } else {
     err = -EINVAL;
@@ -852,7 +968,8 @@ int db_param_set_u32(enum access_level access, struct db_param *param,
     return err;
   }
 
-  if (access < param->config.info.access) {
+  if ((access < param->config.info.access) ||
+      (param->config.info.field == VAR_FIELD_READ_ONLY)) {
     err = -EACCES;
   } else if (sizeof(uint32_t) != param->config.var_size) {
     err = -EINVAL;
@@ -861,6 +978,7 @@ int db_param_set_u32(enum access_level access, struct db_param *param,
     if (*((uint32_t *)param->var) != value) {
       *((uint32_t *)param->var) = value;
       err = DB_UPDATED;
+      atomic_inc(&g_db_change_seq);
     }
   } else {
     err = -EINVAL;
@@ -905,7 +1023,8 @@ int db_param_set_s32(enum access_level access, struct db_param *param,
     return err;
   }
 
-  if (access < param->config.info.access) {
+  if ((access < param->config.info.access) ||
+      (param->config.info.field == VAR_FIELD_READ_ONLY)) {
     err = -EACCES;
   } else if (sizeof(int32_t) != param->config.var_size) {
     err = -EINVAL;
@@ -914,6 +1033,7 @@ int db_param_set_s32(enum access_level access, struct db_param *param,
     if (*((int32_t *)param->var) != value) {
       *((int32_t *)param->var) = value;
       err = DB_UPDATED;
+      atomic_inc(&g_db_change_seq);
     }
   } else {
     err = -EINVAL;
@@ -958,7 +1078,8 @@ int db_param_set_float(enum access_level access, struct db_param *param,
     return err;
   }
 
-  if (access < param->config.info.access) {
+  if ((access < param->config.info.access) ||
+      (param->config.info.field == VAR_FIELD_READ_ONLY)) {
     err = -EACCES;
   } else if (sizeof(float) != param->config.var_size) {
     err = -EINVAL;
@@ -969,6 +1090,7 @@ int db_param_set_float(enum access_level access, struct db_param *param,
     if (*((float *)param->var) != value) {
       *((float *)param->var) = value;
       err = DB_UPDATED;
+      atomic_inc(&g_db_change_seq);
     }
   } else {
     err = -EINVAL;
@@ -1014,7 +1136,8 @@ int db_param_set_u64(enum access_level access, struct db_param *param,
     return err;
   }
 
-  if (access < param->config.info.access) {
+  if ((access < param->config.info.access) ||
+      (param->config.info.field == VAR_FIELD_READ_ONLY)) {
     err = -EACCES;
   } else if (sizeof(uint64_t) != param->config.var_size) {
     err = -EINVAL;
@@ -1023,6 +1146,7 @@ int db_param_set_u64(enum access_level access, struct db_param *param,
     if (*((uint64_t *)param->var) != value) {
       *((uint64_t *)param->var) = value;
       err = DB_UPDATED;
+      atomic_inc(&g_db_change_seq);
     }
   } else {
     err = -EINVAL;
@@ -1067,7 +1191,8 @@ int db_param_set_s64(enum access_level access, struct db_param *param,
     return err;
   }
 
-  if (access < param->config.info.access) {
+  if ((access < param->config.info.access) ||
+      (param->config.info.field == VAR_FIELD_READ_ONLY)) {
     err = -EACCES;
   } else if (sizeof(int64_t) != param->config.var_size) {
     err = -EINVAL;
@@ -1076,6 +1201,7 @@ int db_param_set_s64(enum access_level access, struct db_param *param,
     if (*((int64_t *)param->var) != value) {
       *((int64_t *)param->var) = value;
       err = DB_UPDATED;
+      atomic_inc(&g_db_change_seq);
     }
   } else {
     err = -EINVAL;
@@ -1120,7 +1246,8 @@ int db_param_set_double(enum access_level access, struct db_param *param,
     return err;
   }
 
-  if (access < param->config.info.access) {
+  if ((access < param->config.info.access) ||
+      (param->config.info.field == VAR_FIELD_READ_ONLY)) {
     err = -EACCES;
   } else if (sizeof(double) != param->config.var_size) {
     err = -EINVAL;
@@ -1131,6 +1258,7 @@ int db_param_set_double(enum access_level access, struct db_param *param,
     if (*((double *)param->var) != value) {
       *((double *)param->var) = value;
       err = DB_UPDATED;
+      atomic_inc(&g_db_change_seq);
     }
   } else {
     err = -EINVAL;
@@ -1168,6 +1296,143 @@ int db_param_get_double(enum access_level access, struct db_param *param,
 
 #endif
 
+/**
+ * @brief Contador de alteracoes do banco
+ *
+ * Permite a quem exibe os valores pular a releitura quando nada mudou.
+ */
+uint32_t db_get_change_seq(void) { return (uint32_t)atomic_get(&g_db_change_seq); }
+
+// Para donos de parametros somente leitura que escrevem direto na variavel
+void db_notify_change(void) { atomic_inc(&g_db_change_seq); }
+
+/**
+ * @brief Copia o valor bruto do parametro (var_size bytes) sob o lock
+ *
+ * @return Bytes copiados ou erro negativo
+ */
+int db_param_get_raw(enum access_level access, struct db_param *param, void *buf,
+                     uint16_t buflen) {
+  int err;
+  uint16_t len;
+
+  if (!param || !buf) {
+    return -EINVAL;
+  }
+
+  err = db_lock(&g_database_list, DB_LOCK_TIMEOUT_MS);
+  if (err) {
+    return err;
+  }
+
+  if (access < param->config.info.access) {
+    err = -EACCES;
+  } else {
+    len = MIN(buflen, param->config.var_size);
+    memcpy(buf, param->var, len);
+    err = len;
+  }
+
+  db_unlock(&g_database_list);
+  return err;
+}
+
+/**
+ * @brief Le varios parametros crus com uma unica tomada do lock
+ *
+ * Os valores formam um retrato consistente da base. items[i].result recebe os
+ * bytes copiados ou o erro do item.
+ *
+ * @return 0 ou o erro do primeiro item que falhou
+ */
+int db_param_get_raw_batch(enum access_level access,
+                           struct db_raw_item *items, size_t count) {
+  int err;
+  struct db_raw_item *item;
+
+  if (!items) {
+    return -EINVAL;
+  }
+
+  err = db_lock(&g_database_list, DB_LOCK_TIMEOUT_MS);
+  if (err) {
+    return err;
+  }
+
+  for (size_t i = 0; i < count; i++) {
+    item = &items[i];
+    if (!item->param || !item->data) {
+      item->result = -EINVAL;
+    } else if (access < item->param->config.info.access) {
+      item->result = -EACCES;
+    } else {
+      item->result = MIN(item->len, item->param->config.var_size);
+      memcpy(item->data, item->param->var, item->result);
+    }
+
+    if ((item->result < 0) && !err) {
+      err = item->result;
+    }
+  }
+
+  db_unlock(&g_database_list);
+  return err;
+}
+
+/**
+ * @brief Escreve varios parametros crus de forma atomica
+ *
+ * Todos os itens sao validados (acesso, tamanho e faixa) antes da primeira
+ * escrita; se algum falhar nenhum valor e alterado.
+ *
+ * @return 0, DB_UPDATED se algum valor mudou ou o erro do primeiro item invalido
+ */
+int db_param_set_raw_batch(enum access_level access,
+                           struct db_raw_item *items, size_t count) {
+  int err;
+  bool updated = false;
+  struct db_raw_item *item;
+
+  if (!items) {
+    return -EINVAL;
+  }
+
+  err = db_lock(&g_database_list, DB_LOCK_TIMEOUT_MS);
+  if (err) {
+    return err;
+  }
+
+  for (size_t i = 0; i < count; i++) {
+    items[i].result =
+        db_param_raw_check(access, items[i].param, items[i].data, items[i].len);
+    if ((items[i].result < 0) && !err) {
+      err = items[i].result;
+    }
+  }
+
+  for (size_t i = 0; (i < count) && !err; i++) {
+    item = &items[i];
+    if ((memcmp(item->param->var, item->data, item->len) == 0) &&
+        ((item->len == item->param->config.var_size) ||
+         (((uint8_t *)item->param->var)[item->len] == 0))) {
+      continue;
+    }
+
+    // String menor que a variavel: completa com zeros
+    memset(item->param->var, 0, item->param->config.var_size);
+    memcpy(item->param->var, item->data, item->len);
+    item->result = DB_UPDATED;
+    updated = true;
+  }
+
+  if (updated) {
+    atomic_inc(&g_db_change_seq);
+  }
+
+  db_unlock(&g_database_list);
+  return err ? err : (updated ? DB_UPDATED : 0);
+}
+
 int db_acc_set_str(enum access_level access, db_group_id_t group_id,
                    db_param_id_t param_id, char *buf, int buflen) {
   int err;
@@ -291,6 +291,19 @@ struct db_group
   sys_snode_t node;
 };
 
+/**
+ * @brief Item de leitura/escrita crua em lote (db_param_*_raw_batch).
+ *
+ * data tem o valor na ordem de bytes da CPU; strings sem o terminador.
+ * */
+struct db_raw_item
+{
+  struct db_param *param;
+  void *data;
+  uint16_t len;                 // Leitura: tamanho do buffer; escrita: bytes em data
+  int result;                   // Bytes lidos, 0/DB_UPDATED na escrita ou erro
+};
+
 typedef struct
 {
   sys_slist_t task_list;
@@ -309,7 +322,13 @@ int db_init( void );
 int db_group_add( struct db_group *group );
 int db_group_remove(db_group_id_t group_id);
 int db_group_load_default( db_group_id_t group_id, enum access_level access );
+int db_get_groups( struct db_group **groups, size_t max );
 int db_get_var_config( struct db_group **group, struct db_param **param, db_group_id_t group_id, db_param_id_t param_id);
+uint32_t db_get_change_seq( void );
+void db_notify_change( void );
+int db_param_get_raw(enum access_level access, struct db_param *param, void *buf, uint16_t buflen);
+int db_param_get_raw_batch(enum access_level access, struct db_raw_item *items, size_t count);
+int db_param_set_raw_batch(enum access_level access, struct db_raw_item *items, size_t count);
 
 int db_set_param_via_string(enum access_level access, db_group_id_t group_id, db_param_id_t param_id, char *buf);
 int db_param_set_str(enum access_level access, struct db_param *param, uint8_t *buf, uint16_t buflen);
@@ -0,0 +1,463 @@
+#include "db_bind.h"
+#include "string_format.h"
+
+#include <math.h>
+#include <stdio.h>
+#include <string.h>
+#include <zephyr/logging/log.h>
+
+LOG_MODULE_REGISTER(db_bind, CONFIG_LOG_DEFAULT_LEVEL);
+
+static sys_slist_t g_binds = SYS_SLIST_STATIC_INIT(&g_binds);
+static lv_timer_t *g_timer;
+static uint32_t g_last_seq;
+static bool g_pending;          // Algum widget nao pode ser atualizado (em edicao)
+
+static int64_t db_bind_pow10(uint8_t precision);
+static uint8_t db_bind_default_digits(enum variable_type type);
+static int db_bind_to_number(const struct db_param *param, const uint8_t *raw,
+                             uint8_t precision, int64_t *value);
+static int db_bind_range(const struct db_param *param, uint8_t precision, int64_t *min,
+                         int64_t *max);
+static void db_bind_format(const struct db_bind *bind, const uint8_t *raw, char *text,
+                           size_t len);
+static void db_bind_setup_input(struct db_bind *bind);
+static bool db_bind_resolve(struct db_bind *bind);
+static void db_bind_show(struct db_bind *bind, const uint8_t *raw);
+static void db_bind_update(struct db_bind *bind, bool force);
+static int db_bind_write(struct db_bind *bind, int64_t value);
+static void db_bind_value_cb(lv_event_t *event);
+static void db_bind_delete_cb(lv_event_t *event);
+static void db_bind_timer_cb(lv_timer_t *timer);
+static int db_bind_add(struct db_bind *bind, lv_obj_t *obj, enum db_bind_widget widget,
+                       db_group_id_t group_id, db_param_id_t param_id,
+                       const struct db_bind_fmt *fmt, enum access_level access);
+
+static int64_t db_bind_pow10(uint8_t precision) {
+  int64_t value = 1;
+
+  while (precision--) {
+    value *= 10;
+  }
+
+  return value;
+}
+
+static uint8_t db_bind_default_digits(enum variable_type type) {
+  switch (type) {
+  case eBOL: return VAR_NUN_DIG_BOL;
+  case eU08: return VAR_NUN_DIG_U08;
+  case eS08: return VAR_NUN_DIG_S08;
+  case eU16: return VAR_NUN_DIG_U16;
+  case eS16: return VAR_NUN_DIG_S16;
+  case eU32: return VAR_NUN_DIG_U32;
+  case eS32: return VAR_NUN_DIG_S32;
+  default: return 10;
+  }
+}
+
+// Valor numerico do parametro; floats sao escalados por 10^precision
+static int db_bind_to_number(const struct db_param *param, const uint8_t *raw,
+                             uint8_t precision, int64_t *value) {
+  union {
+    bool b;
+    uint8_t u8;
+    int8_t s8;
+    uint16_t u16;
+    int16_t s16;
+    uint32_t u32;
+    int32_t s32;
+    float f32;
+    double f64;
+    int64_t s64;
+    uint64_t u64;
+  } v;
+
+  memcpy(&v, raw, MIN(sizeof(v), (size_t)param->config.var_size));
+
+  switch (param->config.info.type) {
+  case eBOL: *value = v.b; break;
+  case eU08: *value = v.u8; break;
+  case eS08: *value = v.s8; break;
+  case eU16: *value = v.u16; break;
+  case eS16: *value = v.s16; break;
+  case eU32: *value = v.u32; break;
+  case eS32: *value = v.s32; break;
+  case eS64: *value = v.s64; break;
+  case eU64: *value = (int64_t)v.u64; break;
+  case eF32: *value = llroundf(v.f32 * (float)db_bind_pow10(precision)); break;
+  case eF64: *value = llround(v.f64 * (double)db_bind_pow10(precision)); break;
+  default: return -ENOTSUP;
+  }
+
+  return 0;
+}
+
+// Limites do db_param_config, na mesma escala de db_bind_to_number
+static int db_bind_range(const struct db_param *param, uint8_t precision, int64_t *min,
+                         int64_t *max) {
+  const struct db_param_config *config = &param->config;
+
+  switch (config->info.type) {
+  case eBOL:
+  case eU08: *min = config->u8.min; *max = config->u8.max; break;
+  case eS08: *min = config->s8.min; *max = config->s8.max; break;
+  case eU16: *min = config->u16.min; *max = config->u16.max; break;
+  case eS16: *min = config->s16.min; *max = config->s16.max; break;
+  case eU32: *min = config->u32.min; *max = config->u32.max; break;
+  case eS32: *min = config->s32.min; *max = config->s32.max; break;
+  case eS64: *min = config->s64.min; *max = config->s64.max; break;
+  case eU64: *min = 0; *max = (int64_t)MIN(config->u64.max, (uint64_t)INT64_MAX); break;
+  case eF32:
+    *min = llroundf(config->f32.min * (float)db_bind_pow10(precision));
+    *max = llroundf(config->f32.max * (float)db_bind_pow10(precision));
+    break;
+  default: return -ENOTSUP;
+  }
+
+  return 0;
+}
+
+static void db_bind_format(const struct db_bind *bind, const uint8_t *raw, char *text,
+                           size_t len) {
+  const struct db_bind_fmt *fmt = bind->fmt;
+  const struct db_param *param = bind->param;
+  generic_formatter_t mask;
+  float_formatter_t ffmt;
+  int_formatter_t ifmt;
+  char digits[24];
+  const char *result = NULL;
+  uint8_t total;
+  int64_t value;
+  uint64_t magnitude;
+
+  if ((param->config.info.type == eSTR) || (fmt->type == DB_BIND_FMT_TEXT)) {
+    if (fmt->type == DB_BIND_FMT_MASK) {
+      generic_fmt_init(&mask, fmt->mask);
+      generic_fmt_set_value(&mask, (const char *)raw);
+      result = generic_fmt_get_string(&mask);
+    } else {
+      snprintf(text, len, "%.*s%s", (int)MIN(len, DB_BIND_RAW_MAX), (const char *)raw,
+               fmt->suffix ? fmt->suffix : "");
+      return;
+    }
+  } else if (db_bind_to_number(param, raw, fmt->precision, &value) != 0) {
+    result = "?";
+  } else if (fmt->type == DB_BIND_FMT_MASK) {
+    // Mascaras hexa recebem os digitos em hexa; as demais, em decimal
+    if ((fmt->mask == FORMAT_HEXA_TYPE_1) || (fmt->mask == FORMAT_HEXA_TYPE_2)) {
+      snprintf(digits, sizeof(digits), "%08llX", (unsigned long long)value);
+    } else {
+      snprintf(digits, sizeof(digits), "%lld", (long long)value);
+    }
+    generic_fmt_init(&mask, fmt->mask);
+    generic_fmt_set_value(&mask, digits);
+    result = generic_fmt_get_string(&mask);
+  } else {
+    magnitude = (value < 0) ? (uint64_t)(-value) : (uint64_t)value;
+    total = fmt->digits ? fmt->digits : db_bind_default_digits(param->config.info.type);
+
+    if (fmt->precision == 0) {
+      snprintf(digits, sizeof(digits), "%llu", (unsigned long long)magnitude);
+      int_fmt_init(&ifmt, fmt->fill_zeros, true, total);
+      for (int i = 0; digits[i] != '\0'; i++) {
+        int_fmt_add_digit(&ifmt, digits[i]);
+      }
+      int_fmt_set_negative(&ifmt, value < 0);
+      result = int_fmt_get_string(&ifmt);
+    } else {
+      // Ponto fixo: ao menos um digito antes do ponto
+      snprintf(digits, sizeof(digits), "%0*llu", fmt->precision + 1,
+               (unsigned long long)magnitude);
+      float_fmt_init(&ffmt, fmt->fill_zeros, fmt->precision, true, total + 1);
+      for (int i = 0; digits[i] != '\0'; i++) {
+        float_fmt_add_char(&ffmt, digits[i]);
+      }
+      float_fmt_set_negative(&ffmt, value < 0);
+      result = float_fmt_get_string(&ffmt);
+    }
+  }
+
+  snprintf(text, len, "%s%s", result ? result : "", fmt->suffix ? fmt->suffix : "");
+}
+
+static void db_bind_setup_input(struct db_bind *bind) {
+  uint8_t precision = bind->fmt ? bind->fmt->precision : 0;
+  int64_t min;
+  int64_t max;
+  uint8_t digits;
+
+  if ((bind->widget == DB_BIND_LABEL) || (bind->widget == DB_BIND_SWITCH) ||
+      (db_bind_range(bind->param, precision, &min, &max) != 0)) {
+    return;
+  }
+
+  min = CLAMP(min, INT32_MIN, INT32_MAX);
+  max = CLAMP(max, INT32_MIN, INT32_MAX);
+
+  switch (bind->widget) {
+#if LV_USE_SPINBOX
+  case DB_BIND_SPINBOX:
+    digits = (bind->fmt && bind->fmt->digits) ? bind->fmt->digits
+                                               : db_bind_default_digits(bind->param->config.info.type);
+    digits = MIN(digits, LV_SPINBOX_MAX_DIGIT_COUNT);
+    lv_spinbox_set_range(bind->obj, (int32_t)min, (int32_t)max);
+    lv_spinbox_set_digit_format(bind->obj, digits, precision ? digits - precision : 0);
+    break;
+#endif
+#if LV_USE_SLIDER
+  case DB_BIND_SLIDER:
+    lv_slider_set_range(bind->obj, (int32_t)min, (int32_t)max);
+    break;
+#endif
+  default:
+    ARG_UNUSED(digits);
+    break;
+  }
+}
+
+static bool db_bind_resolve(struct db_bind *bind) {
+  struct db_group *group;
+
+  if (bind->param) {
+    return true;
+  }
+
+  if (db_get_var_config(&group, &bind->param, bind->group_id, bind->param_id) != 0) {
+    bind->param = NULL;
+    return false;
+  }
+
+  db_bind_setup_input(bind);
+  return true;
+}
+
+// Atualiza o widget; o LVGL so invalida a area quando o conteudo muda
+static void db_bind_show(struct db_bind *bind, const uint8_t *raw) {
+  char text[DB_BIND_TEXT_MAX];
+  uint8_t precision = bind->fmt ? bind->fmt->precision : 0;
+  int64_t value = 0;
+
+  if ((bind->widget != DB_BIND_LABEL) &&
+      (db_bind_to_number(bind->param, raw, precision, &value) != 0)) {
+    return;
+  }
+
+  switch (bind->widget) {
+  case DB_BIND_LABEL:
+    db_bind_format(bind, raw, text, sizeof(text));
+    if (strcmp(lv_label_get_text(bind->obj), text) != 0) {
+      lv_label_set_text(bind->obj, text);
+    }
+    break;
+#if LV_USE_SPINBOX
+  case DB_BIND_SPINBOX:
+    if (lv_spinbox_get_value(bind->obj) != value) {
+      lv_spinbox_set_value(bind->obj, (int32_t)value);
+    }
+    break;
+#endif
+#if LV_USE_SLIDER
+  case DB_BIND_SLIDER:
+    if (lv_slider_get_value(bind->obj) != value) {
+      lv_slider_set_value(bind->obj, (int32_t)value, LV_ANIM_OFF);
+    }
+    break;
+#endif
+  case DB_BIND_SWITCH:
+    if (lv_obj_has_state(bind->obj, LV_STATE_CHECKED) != (value != 0)) {
+      lv_obj_set_state(bind->obj, LV_STATE_CHECKED, value != 0);
+    }
+    break;
+  default:
+    break;
+  }
+}
+
+static void db_bind_update(struct db_bind *bind, bool force) {
+  uint8_t raw[DB_BIND_RAW_MAX] = {0};
+
+  if (!db_bind_resolve(bind)) {
+    g_pending = true;
+    return;
+  }
+
+  // Nao sobrescreve o que o usuario esta editando
+  if (lv_obj_has_state(bind->obj, LV_STATE_EDITED)) {
+    g_pending = true;
+    return;
+  }
+
+  if (db_param_get_raw(ACC_LEVEL_FACTORY, bind->param, raw, sizeof(raw)) < 0) {
+    g_pending = true;
+    return;
+  }
+
+  if (!force && bind->valid && (memcmp(raw, bind->raw, sizeof(raw)) == 0)) {
+    return;
+  }
+
+  memcpy(bind->raw, raw, sizeof(raw));
+  bind->valid = true;
+  db_bind_show(bind, raw);
+}
+
+static int db_bind_write(struct db_bind *bind, int64_t value) {
+  struct db_param *param = bind->param;
+  uint8_t precision = bind->fmt ? bind->fmt->precision : 0;
+  int64_t min;
+  int64_t max;
+
+  if (!param || (db_bind_range(param, precision, &min, &max) != 0)) {
+    return -ENOTSUP;
+  }
+
+  if ((value < min) || (value > max)) {
+    return -ERANGE;
+  }
+
+  switch (param->config.info.type) {
+  case eBOL:
+  case eU08: return db_param_set_u8(bind->access, param, (uint8_t)value);
+  case eS08: return db_param_set_s8(bind->access, param, (int8_t)value);
+  case eU16: return db_param_set_u16(bind->access, param, (uint16_t)value);
+  case eS16: return db_param_set_s16(bind->access, param, (int16_t)value);
+  case eU32: return db_param_set_u32(bind->access, param, (uint32_t)value);
+  case eS32: return db_param_set_s32(bind->access, param, (int32_t)value);
+  case eS64: return db_param_set_s64(bind->access, param, value);
+  case eU64: return db_param_set_u64(bind->access, param, (uint64_t)value);
+  case eF32:
+    return db_param_set_float(bind->access, param,
+                              (float)value / (float)db_bind_pow10(precision));
+  default:
+    return -ENOTSUP;
+  }
+}
+
+static void db_bind_value_cb(lv_event_t *event) {
+  struct db_bind *bind = lv_event_get_user_data(event);
+  int64_t value;
+  int err;
+
+  switch (bind->widget) {
+#if LV_USE_SPINBOX
+  case DB_BIND_SPINBOX: value = lv_spinbox_get_value(bind->obj); break;
+#endif
+#if LV_USE_SLIDER
+  case DB_BIND_SLIDER: value = lv_slider_get_value(bind->obj); break;
+#endif
+  case DB_BIND_SWITCH: value = lv_obj_has_state(bind->obj, LV_STATE_CHECKED); break;
+  default: return;
+  }
+
+  err = db_bind_write(bind, value);
+  if (err < 0) {
+    LOG_WRN("Param %d of group %d rejected %lld (%d)", bind->param_id, bind->group_id,
+            (long long)value, err);
+    // Volta o widget para o valor do banco
+    db_bind_update(bind, true);
+  }
+}
+
+// Objeto sendo apagado: so sai da lista, os callbacks morrem com ele
+static void db_bind_delete_cb(lv_event_t *event) {
+  struct db_bind *bind = lv_event_get_user_data(event);
+
+  sys_slist_find_and_remove(&g_binds, &bind->node);
+  bind->obj = NULL;
+}
+
+// Banco sem alteracoes: nenhuma leitura e nenhum redesenho
+static void db_bind_timer_cb(lv_timer_t *timer) {
+  ARG_UNUSED(timer);
+
+  db_bind_refresh(false);
+}
+
+static int db_bind_add(struct db_bind *bind, lv_obj_t *obj, enum db_bind_widget widget,
+                       db_group_id_t group_id, db_param_id_t param_id,
+                       const struct db_bind_fmt *fmt, enum access_level access) {
+  if (!bind || !obj) {
+    return -EINVAL;
+  }
+
+  memset(bind, 0, sizeof(*bind));
+  bind->obj = obj;
+  bind->widget = widget;
+  bind->group_id = group_id;
+  bind->param_id = param_id;
+  bind->fmt = fmt;
+  bind->access = access;
+
+  sys_slist_append(&g_binds, &bind->node);
+  lv_obj_add_event_cb(obj, db_bind_delete_cb, LV_EVENT_DELETE, bind);
+  if (widget != DB_BIND_LABEL) {
+    lv_obj_add_event_cb(obj, db_bind_value_cb, LV_EVENT_VALUE_CHANGED, bind);
+  }
+
+  db_bind_update(bind, true);
+
+  return 0;
+}
+
+int db_bind_init(void) {
+  if (g_timer) {
+    return -EALREADY;
+  }
+
+  g_last_seq = db_get_change_seq();
+  g_timer = lv_timer_create(db_bind_timer_cb, DB_BIND_REFRESH_MS, NULL);
+
+  return g_timer ? 0 : -ENOMEM;
+}
+
+int db_bind_label(struct db_bind *bind, lv_obj_t *label, db_group_id_t group_id,
+                  db_param_id_t param_id, const struct db_bind_fmt *fmt) {
+  if (!fmt) {
+    return -EINVAL;
+  }
+
+  return db_bind_add(bind, label, DB_BIND_LABEL, group_id, param_id, fmt, ACC_LEVEL_NONE);
+}
+
+int db_bind_input(struct db_bind *bind, lv_obj_t *obj, enum db_bind_widget widget,
+                  db_group_id_t group_id, db_param_id_t param_id,
+                  const struct db_bind_fmt *fmt, enum access_level access) {
+  if ((widget == DB_BIND_LABEL) || (widget > DB_BIND_SWITCH)) {
+    return -EINVAL;
+  }
+
+  return db_bind_add(bind, obj, widget, group_id, param_id, fmt, access);
+}
+
+void db_bind_unbind(struct db_bind *bind) {
+  if (!bind || !bind->obj) {
+    return;
+  }
+
+  sys_slist_find_and_remove(&g_binds, &bind->node);
+  lv_obj_remove_event_cb_with_user_data(bind->obj, NULL, bind);
+  bind->obj = NULL;
+}
+
+/**
+ * @brief Atualiza os widgets cujos parametros mudaram
+ *
+ * Chamado pelo timer do LVGL. Com o contador de alteracoes do banco parado,
+ * retorna sem ler nenhum parametro.
+ */
+void db_bind_refresh(bool force) {
+  struct db_bind *bind;
+  uint32_t seq = db_get_change_seq();
+
+  if (!force && !g_pending && (seq == g_last_seq)) {
+    return;
+  }
+
+  g_last_seq = seq;
+  g_pending = false;
+
+  SYS_SLIST_FOR_EACH_CONTAINER(&g_binds, bind, node) {
+    db_bind_update(bind, force);
+  }
+}
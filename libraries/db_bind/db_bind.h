@@ -0,0 +1,74 @@
+#ifndef _DB_BIND_H
+#define _DB_BIND_H
+
+/* C++ detection */
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <lvgl.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <zephyr/sys/slist.h>
+#include "database.h"
+#include "mask_format.h"
+
+#define DB_BIND_RAW_MAX     (64)   // Bytes comparados por parametro (strings maiores sao truncadas)
+#define DB_BIND_TEXT_MAX    (48)
+#define DB_BIND_REFRESH_MS  (100)
+
+enum db_bind_fmt_type {
+  DB_BIND_FMT_NUMBER,           // string_format: inteiro ou ponto fixo
+  DB_BIND_FMT_MASK,             // mask_format: IP, hexa, data...
+  DB_BIND_FMT_TEXT,             // Parametro eSTR sem formatacao
+};
+
+struct db_bind_fmt {
+  enum db_bind_fmt_type type;
+  uint8_t digits;               // NUMBER: digitos totais, 0 = conforme o tipo
+  uint8_t precision;            // NUMBER: casas decimais (inteiros lidos como ponto fixo)
+  bool fill_zeros;
+  format_type_t mask;           // MASK
+  const char *suffix;           // Unidade opcional
+};
+
+enum db_bind_widget {
+  DB_BIND_LABEL,
+  DB_BIND_SPINBOX,
+  DB_BIND_SLIDER,
+  DB_BIND_SWITCH,
+};
+
+/*
+ * Liga um widget a um parametro do banco. A memoria pertence a quem chama e
+ * deve viver ate o unbind (feito sozinho quando o objeto LVGL e apagado).
+ * Todas as funcoes devem ser chamadas na thread da interface.
+ */
+struct db_bind {
+  lv_obj_t *obj;
+  db_group_id_t group_id;
+  db_param_id_t param_id;
+  struct db_param *param;       // Resolvido sob demanda (grupo pode ainda nao existir)
+  enum db_bind_widget widget;
+  const struct db_bind_fmt *fmt;
+  enum access_level access;     // Nivel usado na escrita de volta
+  uint8_t raw[DB_BIND_RAW_MAX]; // Ultimo valor exibido
+  bool valid;
+  sys_snode_t node;
+};
+
+int db_bind_init(void);
+int db_bind_label(struct db_bind *bind, lv_obj_t *label, db_group_id_t group_id,
+                  db_param_id_t param_id, const struct db_bind_fmt *fmt);
+int db_bind_input(struct db_bind *bind, lv_obj_t *obj, enum db_bind_widget widget,
+                  db_group_id_t group_id, db_param_id_t param_id,
+                  const struct db_bind_fmt *fmt, enum access_level access);
+void db_bind_unbind(struct db_bind *bind);
+void db_bind_refresh(bool force);
+
+/* C++ detection */
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* _DB_BIND_H */
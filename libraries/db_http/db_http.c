@@ -0,0 +1,2012 @@
+#include "db_http.h"
+#include "json_stream.h"
+
+#include <errno.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+#include <mbedtls/sha1.h>
+#include <zephyr/kernel.h>
+#include <zephyr/logging/log.h>
+#include <zephyr/net/socket.h>
+#include <zephyr/shell/shell.h>
+#include <zephyr/sys/base64.h>
+#include <zephyr/sys/byteorder.h>
+
+LOG_MODULE_REGISTER(db_http, CONFIG_LOG_DEFAULT_LEVEL);
+
+/*
+ * Servidor HTTP da base. Uma thread aceita as conexoes e as coloca numa fila
+ * de CONFIG_APP_HTTP_BACKLOG posicoes; CONFIG_APP_HTTP_WORKERS threads
+ * atendem uma requisicao cada e, com a fila cheia, a conexao recebe 503 na
+ * hora. Os valores sao copiados da base em lotes (uma tomada do lock por
+ * lote) e o JSON e gerado depois, com o lock livre, direto no buffer que vai
+ * para o socket. Conexoes WebSocket passam para uma unica thread que le a
+ * base a cada CONFIG_APP_HTTP_WS_PERIOD_MS e envia as mudancas a todos os
+ * assinantes a partir da mesma leitura. Essa thread nunca bloqueia num
+ * assinante: envios e leituras sao nao bloqueantes, os quadros do cliente
+ * sao montados aos poucos e um assinante lento perde mensagens ou cai.
+ */
+
+#define DB_HTTP_STACK_MEM_ATTRIBUTES Z_GENERIC_SECTION(.app_stack)
+#define DB_HTTP_LISTEN_STACK_SIZE    (1024)
+#define DB_HTTP_HEAD_ROOM            (8)    // "fff\r\n" ou cabecalho WebSocket
+#define DB_HTTP_TAIL_ROOM            (8)    // "\r\n0\r\n\r\n"
+#define DB_HTTP_OUT_SIZE             (DB_HTTP_HEAD_ROOM + CONFIG_APP_HTTP_CHUNK_SIZE + DB_HTTP_TAIL_ROOM)
+#define DB_HTTP_VALUE_ALIGN          (8)
+#define DB_HTTP_MAX_GROUPS           (32)   // Bits da mascara de assinatura
+#define DB_HTTP_WS_KEY_MAX           (32)
+#define DB_HTTP_WS_GUID              "258EAFA5-E914-47DA-95CA-C5AB0DC85B11"
+
+#define DB_HTTP_WS_FIN               BIT(7)
+#define DB_HTTP_WS_MASKED            BIT(7)
+#define DB_HTTP_WS_OP_CONT           (0x0)
+#define DB_HTTP_WS_OP_TEXT           (0x1)
+#define DB_HTTP_WS_OP_CLOSE          (0x8)
+#define DB_HTTP_WS_OP_PING           (0x9)
+#define DB_HTTP_WS_OP_PONG           (0xA)
+#define DB_HTTP_WS_OP_CONTROL        BIT(3)
+#define DB_HTTP_WS_CTRL_MAX          (125)
+#define DB_HTTP_WS_HEAD_MAX          (2 + 8 + 4)
+#define DB_HTTP_WS_RX_SIZE           (DB_HTTP_WS_HEAD_MAX + DB_HTTP_WS_CTRL_MAX)
+
+// Sem token as escritas ficam desligadas; sem origem nao ha CORS
+#define DB_HTTP_WRITES_ENABLED       (sizeof(CONFIG_APP_HTTP_WRITE_TOKEN) > 1)
+#define DB_HTTP_CORS_ENABLED         (sizeof(CONFIG_APP_HTTP_CORS_ORIGIN) > 1)
+#define DB_HTTP_CORS_HEADERS                                                   \
+  "Access-Control-Allow-Origin: " CONFIG_APP_HTTP_CORS_ORIGIN "\r\n"           \
+  "Vary: Origin\r\n"                                                           \
+  "Access-Control-Allow-Headers: Content-Type, Authorization\r\n"
+#define DB_HTTP_CORS_METHODS_RW      "Access-Control-Allow-Methods: GET, PUT, POST, OPTIONS\r\n"
+#define DB_HTTP_CORS_METHODS_RO      "Access-Control-Allow-Methods: GET, OPTIONS\r\n"
+
+#define DB_HTTP_BUSY_RESPONSE                                                  \
+  "HTTP/1.1 503 Service Unavailable\r\nRetry-After: 1\r\n"                     \
+  "Content-Length: 0\r\nConnection: close\r\n\r\n"
+
+enum db_http_method {
+  DB_HTTP_GET = 0,
+  DB_HTTP_PUT,                  // PUT ou POST
+  DB_HTTP_OPTIONS,
+};
+
+struct db_http_request {
+  enum db_http_method method;
+  char *path;
+  char *query;                  // Depois do '?', NULL sem
+  char *body;                   // Terminado em '\0'
+  size_t body_len;
+  const char *ws_key;           // Sec-WebSocket-Key
+  const char *auth;             // Authorization
+  bool upgrade;                 // Upgrade: websocket
+};
+
+// Destino do json_stream: os dados ficam entre HEAD_ROOM e TAIL_ROOM de out
+struct db_http_sink {
+  int fd;
+  bool ws;
+  bool started;                 // WebSocket: proximos fragmentos sao continuacao
+  bool sent;                    // WebSocket: algum byte da mensagem ja saiu
+  int64_t deadline;             // WebSocket: limite para o resto da mensagem
+  uint32_t bytes;
+};
+
+struct db_http_conn {
+  int fd;
+  char req[CONFIG_APP_HTTP_REQUEST_SIZE + 1];
+  uint8_t out[DB_HTTP_OUT_SIZE];
+  struct db_raw_item raw[CONFIG_APP_HTTP_BATCH];
+  uint8_t __aligned(8) values[CONFIG_APP_HTTP_BATCH_SIZE];
+  struct k_thread thread;
+};
+
+enum db_http_json_kind {
+  DB_HTTP_JSON_STR = 0,
+  DB_HTTP_JSON_NUM,
+  DB_HTTP_JSON_TRUE,
+  DB_HTTP_JSON_FALSE,
+};
+
+struct db_http_json {
+  char *pos;
+  char *end;
+};
+
+struct db_http_token {
+  enum db_http_json_kind kind;
+  char *text;                   // STR: decodificada no lugar
+  char num[40];
+};
+
+struct db_http_ws_client {
+  int fd;
+  uint32_t groups;              // Bit por id de grupo
+  bool active;                  // Reservado pelo worker ate o 101 sair
+  bool full;                    // Proxima mensagem leva o retrato completo
+  uint8_t rx[DB_HTTP_WS_RX_SIZE]; // Quadro do cliente ainda incompleto
+  uint8_t rx_len;
+  uint64_t rx_skip;             // Bytes de dados do cliente ainda a descartar
+};
+
+struct db_http_ws_item {
+  struct db_param *param;
+  db_group_id_t group;
+  uint16_t offset;              // Posicao em g_ws_shadow e g_ws_values
+};
+
+static const char *const g_type_names[] = {
+    [eBOL] = "bool", [eU08] = "u8",  [eU16] = "u16", [eU32] = "u32", [eS08] = "s8",
+    [eS16] = "s16",  [eS32] = "s32", [eF32] = "f32", [eF64] = "f64", [eS64] = "s64",
+    [eU64] = "u64",  [eSTR] = "str", [eVOID] = "void",
+};
+
+static struct db_http_conn g_conns[CONFIG_APP_HTTP_WORKERS];
+static uint16_t g_port;
+
+static struct db_http_ws_client g_ws_clients[CONFIG_APP_HTTP_WS_CLIENTS];
+static struct db_http_ws_item g_ws_items[CONFIG_APP_HTTP_WS_MAX_PARAMS];
+static struct db_raw_item g_ws_raw[CONFIG_APP_HTTP_WS_MAX_PARAMS];
+static bool g_ws_changed[CONFIG_APP_HTTP_WS_MAX_PARAMS];
+static uint8_t __aligned(8) g_ws_shadow[CONFIG_APP_HTTP_WS_SHADOW_SIZE]; // Ultimo valor enviado
+static uint8_t __aligned(8) g_ws_values[CONFIG_APP_HTTP_WS_SHADOW_SIZE]; // Leitura do ciclo
+static uint8_t g_ws_out[DB_HTTP_OUT_SIZE];
+static uint16_t g_ws_count;
+static uint16_t g_ws_used;
+static uint32_t g_ws_groups;    // Grupos ja na tabela
+static uint32_t g_ws_last_seq;
+
+static struct db_http_stats g_stats;
+static bool g_started;
+static struct k_thread g_listen_thread;
+static struct k_thread g_ws_thread;
+static K_MUTEX_DEFINE(g_lock);
+
+K_MSGQ_DEFINE(db_http_conn_queue, sizeof(int), CONFIG_APP_HTTP_BACKLOG, 4);
+K_SEM_DEFINE(db_http_ws_wake, 0, 1);
+
+Z_KERNEL_STACK_DEFINE_IN(g_listen_stack, DB_HTTP_LISTEN_STACK_SIZE, DB_HTTP_STACK_MEM_ATTRIBUTES);
+Z_KERNEL_STACK_ARRAY_DEFINE_IN(g_worker_stacks, CONFIG_APP_HTTP_WORKERS, CONFIG_APP_HTTP_STACK_SIZE,
+                               DB_HTTP_STACK_MEM_ATTRIBUTES);
+Z_KERNEL_STACK_DEFINE_IN(g_ws_stack, CONFIG_APP_HTTP_STACK_SIZE, DB_HTTP_STACK_MEM_ATTRIBUTES);
+
+static int db_http_shell_cmd_stats(const struct shell *shell, size_t argc, char **argv);
+
+SHELL_STATIC_SUBCMD_SET_CREATE(
+    db_http, SHELL_CMD(stats, NULL, "HTTP server statistics", db_http_shell_cmd_stats),
+    SHELL_SUBCMD_SET_END);
+
+SHELL_CMD_REGISTER(http, &db_http, "HTTP database API commands", NULL);
+
+static void db_http_stats_add(uint32_t *counter, uint32_t value) {
+  k_mutex_lock(&g_lock, K_FOREVER);
+  *counter += value;
+  k_mutex_unlock(&g_lock);
+}
+
+static int db_http_send_all(int fd, const void *data, size_t len) {
+  const uint8_t *pos = data;
+  ssize_t ret;
+
+  while (len > 0) {
+    ret = zsock_send(fd, pos, len, 0);
+    if (ret < 0) {
+      return -errno;
+    }
+    pos += ret;
+    len -= ret;
+  }
+
+  return 0;
+}
+
+static int db_http_recv_all(int fd, void *data, size_t len) {
+  uint8_t *pos = data;
+  ssize_t ret;
+
+  while (len > 0) {
+    ret = zsock_recv(fd, pos, len, 0);
+    if (ret <= 0) {
+      return (ret == 0) ? -ECONNRESET : -errno;
+    }
+    pos += ret;
+    len -= ret;
+  }
+
+  return 0;
+}
+
+/*
+ * Envio a um assinante sem bloquear a thread WebSocket. Com o socket cheio
+ * antes do primeiro byte da mensagem nada sai e o retorno e -EAGAIN; depois
+ * dele o quadro tem que terminar ate deadline, senao o assinante cai.
+ */
+static int db_http_ws_send_nb(int fd, const uint8_t *data, size_t len, bool *sent,
+                              int64_t deadline) {
+  struct zsock_pollfd fds = {.fd = fd, .events = ZSOCK_POLLOUT};
+  ssize_t ret;
+
+  while (len > 0) {
+    ret = zsock_send(fd, data, len, ZSOCK_MSG_DONTWAIT);
+    if (ret > 0) {
+      *sent = true;
+      data += ret;
+      len -= ret;
+      continue;
+    }
+
+    if ((ret < 0) && (errno != EAGAIN) && (errno != EWOULDBLOCK)) {
+      return -errno;
+    }
+
+    if (!*sent) {
+      return -EAGAIN;
+    }
+
+    if (zsock_poll(&fds, 1, MAX(deadline - k_uptime_get(), 0)) <= 0) {
+      return -ETIMEDOUT;
+    }
+  }
+
+  return 0;
+}
+
+// Sem copia: o cabecalho do bloco vai no espaco reservado antes dos dados
+static int db_http_sink(void *ctx, uint8_t *data, size_t len, bool final) {
+  struct db_http_sink *sink = ctx;
+  char head[DB_HTTP_HEAD_ROOM];
+  uint8_t *start;
+  size_t total;
+  int hlen = 0;
+
+  if (sink->ws) {
+    hlen = (len < 126) ? 2 : 4;
+    start = data - hlen;
+    start[0] = (final ? DB_HTTP_WS_FIN : 0) |
+               (sink->started ? DB_HTTP_WS_OP_CONT : DB_HTTP_WS_OP_TEXT);
+    if (len < 126) {
+      start[1] = len;
+    } else {
+      start[1] = 126;
+      sys_put_be16(len, &start[2]);
+    }
+    total = hlen + len;
+  } else {
+    // Bloco vazio e o terminador: so o final pode ter len 0
+    if (len > 0) {
+      hlen = snprintf(head, sizeof(head), "%zx\r\n", len);
+    }
+    start = data - hlen;
+    memcpy(start, head, hlen);
+    total = hlen + len;
+
+    if (len > 0) {
+      memcpy(&start[total], "\r\n", 2);
+      total += 2;
+    }
+
+    if (final) {
+      memcpy(&start[total], "0\r\n\r\n", 5);
+      total += 5;
+    }
+  }
+
+  sink->started = true;
+  sink->bytes += len;
+
+  if (sink->ws) {
+    return db_http_ws_send_nb(sink->fd, start, total, &sink->sent, sink->deadline);
+  }
+
+  return db_http_send_all(sink->fd, start, total);
+}
+
+static const char *db_http_status_text(int status) {
+  switch (status) {
+  case 200:
+    return "OK";
+  case 204:
+    return "No Content";
+  case 400:
+    return "Bad Request";
+  case 401:
+    return "Unauthorized";
+  case 403:
+    return "Forbidden";
+  case 404:
+    return "Not Found";
+  case 405:
+    return "Method Not Allowed";
+  case 413:
+    return "Payload Too Large";
+  case 503:
+    return "Service Unavailable";
+  default:
+    return "Internal Server Error";
+  }
+}
+
+static int db_http_errno_status(int err) {
+  switch (err) {
+  case -ENOENT:
+    return 404;
+  case -EPERM:
+    return 401;
+  case -EACCES:
+    return 403;
+  case -EINVAL:
+  case -ERANGE:
+    return 400;
+  case -EMSGSIZE:
+  case -E2BIG:
+    return 413;
+  case -ENOTSUP:
+    return 405;
+  case -EBUSY:
+  case -ETIMEDOUT:
+    return 503;
+  default:
+    return 500;
+  }
+}
+
+static int db_http_send_head(struct db_http_conn *conn, int status, bool body) {
+  int len;
+
+  len = snprintf((char *)conn->out, sizeof(conn->out),
+                 "HTTP/1.1 %d %s\r\n"
+                 "%s%s%s"
+                 "Cache-Control: no-store\r\n"
+                 "Connection: close\r\n"
+                 "%s\r\n",
+                 status, db_http_status_text(status),
+                 DB_HTTP_CORS_ENABLED ? DB_HTTP_CORS_HEADERS : "",
+                 !DB_HTTP_CORS_ENABLED  ? ""
+                 : DB_HTTP_WRITES_ENABLED ? DB_HTTP_CORS_METHODS_RW
+                                          : DB_HTTP_CORS_METHODS_RO,
+                 (status == 401) ? "WWW-Authenticate: Bearer\r\n" : "",
+                 body ? "Content-Type: application/json\r\nTransfer-Encoding: chunked\r\n"
+                      : "Content-Length: 0\r\n");
+
+  if (status >= 400) {
+    db_http_stats_add(&g_stats.errors, 1);
+  }
+
+  return db_http_send_all(conn->fd, conn->out, MIN(len, (int)sizeof(conn->out) - 1));
+}
+
+static void db_http_body_start(struct db_http_conn *conn, struct json_stream *js,
+                               struct db_http_sink *sink) {
+  memset(sink, 0, sizeof(*sink));
+  sink->fd = conn->fd;
+  json_stream_init(js, &conn->out[DB_HTTP_HEAD_ROOM], CONFIG_APP_HTTP_CHUNK_SIZE, db_http_sink,
+                   sink);
+}
+
+static int db_http_body_end(struct json_stream *js, struct db_http_sink *sink) {
+  int ret = json_stream_end(js);
+
+  db_http_stats_add(&g_stats.bytes, sink->bytes);
+  return ret;
+}
+
+static int db_http_send_error(struct db_http_conn *conn, int err, const char *text) {
+  struct db_http_sink sink;
+  struct json_stream js;
+  int ret;
+
+  ret = db_http_send_head(conn, db_http_errno_status(err), true);
+  if (ret != 0) {
+    return ret;
+  }
+
+  db_http_body_start(conn, &js, &sink);
+  json_stream_obj_start(&js, NULL);
+  json_stream_str(&js, "error", text, SIZE_MAX);
+  json_stream_int(&js, "code", err);
+  json_stream_obj_end(&js);
+
+  return db_http_body_end(&js, &sink);
+}
+
+static bool db_http_param_visible(const struct db_param *param) {
+  return (param->config.info.type != eVOID) && (param->config.info.field != VAR_FIELD_PWD);
+}
+
+static struct db_group *db_http_find_group(db_group_id_t group_id) {
+  struct db_group *groups[DB_HTTP_MAX_GROUPS];
+  int count;
+
+  count = db_get_groups(groups, ARRAY_SIZE(groups));
+  for (int i = 0; i < count; i++) {
+    if (groups[i]->id == group_id) {
+      return groups[i];
+    }
+  }
+
+  return NULL;
+}
+
+// key: id em decimal ou o nome do parametro
+static struct db_param *db_http_find_param(const struct db_group *group, const char *key) {
+  struct db_param *param;
+  char *end;
+  unsigned long id;
+
+  id = strtoul(key, &end, 10);
+
+  for (uint16_t i = 0; i < group->count; i++) {
+    param = (struct db_param *)&group->params[i];
+
+    if (!db_http_param_visible(param)) {
+      continue;
+    }
+
+    if (((*key != '\0') && (*end == '\0')) ? (param->id == id) : (strcmp(param->name, key) == 0)) {
+      return param;
+    }
+  }
+
+  return NULL;
+}
+
+static void db_http_json_value(struct json_stream *js, const char *key,
+                               const struct db_param *param, const void *data) {
+  switch (param->config.info.type) {
+  case eBOL:
+    json_stream_bool(js, key, *(const uint8_t *)data != 0);
+    break;
+  case eU08:
+    json_stream_uint(js, key, *(const uint8_t *)data);
+    break;
+  case eU16:
+    json_stream_uint(js, key, *(const uint16_t *)data);
+    break;
+  case eU32:
+    json_stream_uint(js, key, *(const uint32_t *)data);
+    break;
+  case eS08:
+    json_stream_int(js, key, *(const int8_t *)data);
+    break;
+  case eS16:
+    json_stream_int(js, key, *(const int16_t *)data);
+    break;
+  case eS32:
+    json_stream_int(js, key, *(const int32_t *)data);
+    break;
+  case eF32:
+    json_stream_double(js, key, *(const float *)data, 7);
+    break;
+#if defined(TYPEDEF_ENABLE_VAR_B64)
+  case eF64:
+    json_stream_double(js, key, *(const double *)data, 15);
+    break;
+  case eS64:
+    json_stream_int(js, key, *(const int64_t *)data);
+    break;
+  case eU64:
+    json_stream_uint(js, key, *(const uint64_t *)data);
+    break;
+#endif
+  case eSTR:
+    json_stream_str(js, key, data, param->config.var_size);
+    break;
+  default:
+    json_stream_null(js, key);
+    break;
+  }
+}
+
+static void db_http_json_param(struct json_stream *js, const struct db_param *param,
+                               const void *value) {
+  enum variable_type type = param->config.info.type;
+  // Toda faixa numerica comeca com min e max do proprio tipo
+  const uint8_t *range = (const uint8_t *)&param->config.u8;
+  uint16_t size = typedef_get_size_variable(type);
+
+  json_stream_obj_start(js, NULL);
+  json_stream_uint(js, "id", param->id);
+  json_stream_str(js, "name", param->name, SIZE_MAX);
+  json_stream_str(js, "type", (type < ARRAY_SIZE(g_type_names)) ? g_type_names[type] : "", SIZE_MAX);
+  json_stream_uint(js, "access", param->config.info.access);
+  json_stream_bool(js, "ro", param->config.info.field == VAR_FIELD_READ_ONLY);
+
+  if (size > 0) {
+    db_http_json_value(js, "min", param, range);
+    db_http_json_value(js, "max", param, &range[size]);
+  } else if (type == eSTR) {
+    json_stream_uint(js, "max_len", param->config.var_size - 1);
+  }
+
+  db_http_json_value(js, "value", param, value);
+  json_stream_obj_end(js);
+}
+
+/*
+ * Parametros do grupo em lotes de ate CONFIG_APP_HTTP_BATCH itens: cada lote
+ * e um retrato consistente lido com uma tomada do lock, e o JSON e gerado com
+ * o lock livre. Sem acesso de leitura o parametro nao aparece.
+ */
+static int db_http_stream_group(struct db_http_conn *conn, struct json_stream *js,
+                                const struct db_group *group) {
+  struct db_param *param;
+  uint16_t next = 0;
+  uint16_t count;
+  size_t used;
+  size_t len;
+  int ret;
+
+  while ((next < group->count) && !js->err) {
+    count = 0;
+    used = 0;
+
+    for (; (next < group->count) && (count < ARRAY_SIZE(conn->raw)); next++) {
+      param = (struct db_param *)&group->params[next];
+      len = ROUND_UP(param->config.var_size, DB_HTTP_VALUE_ALIGN);
+
+      if (!db_http_param_visible(param) || (len > sizeof(conn->values))) {
+        continue;
+      }
+
+      if ((used + len) > sizeof(conn->values)) {
+        break;
+      }
+
+      conn->raw[count].param = param;
+      conn->raw[count].data = &conn->values[used];
+      conn->raw[count].len = param->config.var_size;
+      conn->raw[count].result = 0;
+      used += len;
+      count++;
+    }
+
+    if (count == 0) {
+      continue;
+    }
+
+    // Erros de item (acesso) ficam em result; timeout do lock interrompe
+    ret = db_param_get_raw_batch(CONFIG_APP_HTTP_READ_ACCESS, conn->raw, count);
+    if (ret == -ETIMEDOUT) {
+      return ret;
+    }
+
+    for (uint16_t i = 0; i < count; i++) {
+      if (conn->raw[i].result > 0) {
+        db_http_json_param(js, conn->raw[i].param, conn->raw[i].data);
+      }
+    }
+  }
+
+  return js->err;
+}
+
+static int db_http_get_groups(struct db_http_conn *conn) {
+  struct db_group *groups[DB_HTTP_MAX_GROUPS];
+  struct db_http_sink sink;
+  struct json_stream js;
+  int count;
+  int ret;
+
+  count = db_get_groups(groups, ARRAY_SIZE(groups));
+  if (count < 0) {
+    return db_http_send_error(conn, count, "database busy");
+  }
+
+  ret = db_http_send_head(conn, 200, true);
+  if (ret != 0) {
+    return ret;
+  }
+
+  db_http_body_start(conn, &js, &sink);
+  json_stream_arr_start(&js, NULL);
+
+  for (int i = 0; i < count; i++) {
+    json_stream_obj_start(&js, NULL);
+    json_stream_uint(&js, "id", groups[i]->id);
+    json_stream_str(&js, "name", groups[i]->name, SIZE_MAX);
+    json_stream_uint(&js, "count", groups[i]->count);
+    json_stream_obj_end(&js);
+  }
+
+  json_stream_arr_end(&js);
+
+  return db_http_body_end(&js, &sink);
+}
+
+static int db_http_get_group(struct db_http_conn *conn, const struct db_group *group) {
+  struct db_http_sink sink;
+  struct json_stream js;
+  int ret;
+
+  ret = db_http_send_head(conn, 200, true);
+  if (ret != 0) {
+    return ret;
+  }
+
+  db_http_body_start(conn, &js, &sink);
+  json_stream_obj_start(&js, NULL);
+  json_stream_uint(&js, "id", group->id);
+  json_stream_str(&js, "name", group->name, SIZE_MAX);
+  json_stream_arr_start(&js, "params");
+
+  ret = db_http_stream_group(conn, &js, group);
+  if (ret != 0) {
+    // Sem o bloco final o cliente ve a resposta incompleta
+    return ret;
+  }
+
+  json_stream_arr_end(&js);
+  json_stream_obj_end(&js);
+
+  return db_http_body_end(&js, &sink);
+}
+
+static int db_http_get_param(struct db_http_conn *conn, struct db_param *param) {
+  struct db_http_sink sink;
+  struct json_stream js;
+  int ret;
+
+  if (param->config.var_size > sizeof(conn->values)) {
+    return db_http_send_error(conn, -EMSGSIZE, "value too large");
+  }
+
+  // Leitura antes do cabecalho: o erro ainda vira status
+  ret = db_param_get_raw(CONFIG_APP_HTTP_READ_ACCESS, param, conn->values, sizeof(conn->values));
+  if (ret < 0) {
+    return db_http_send_error(conn, ret, "read failed");
+  }
+
+  ret = db_http_send_head(conn, 200, true);
+  if (ret != 0) {
+    return ret;
+  }
+
+  db_http_body_start(conn, &js, &sink);
+  db_http_json_param(&js, param, conn->values);
+
+  return db_http_body_end(&js, &sink);
+}
+
+static void db_http_json_skip(struct db_http_json *json) {
+  while ((json->pos < json->end) &&
+         ((*json->pos == ' ') || (*json->pos == '\t') || (*json->pos == '\r') ||
+          (*json->pos == '\n'))) {
+    json->pos++;
+  }
+}
+
+static bool db_http_json_expect(struct db_http_json *json, char c) {
+  db_http_json_skip(json);
+
+  if ((json->pos < json->end) && (*json->pos == c)) {
+    json->pos++;
+    return true;
+  }
+
+  return false;
+}
+
+static int db_http_json_hex4(const char *text, uint32_t *code) {
+  char c;
+
+  *code = 0;
+
+  for (int i = 0; i < 4; i++) {
+    c = text[i];
+    if ((c >= '0') && (c <= '9')) {
+      c -= '0';
+    } else if ((c >= 'a') && (c <= 'f')) {
+      c -= 'a' - 10;
+    } else if ((c >= 'A') && (c <= 'F')) {
+      c -= 'A' - 10;
+    } else {
+      return -EINVAL;
+    }
+    *code = (*code << 4) | c;
+  }
+
+  return 0;
+}
+
+// \uXXXX (ou um par de surrogates) em UTF-8; cabe no texto do escape
+static int db_http_json_unicode(struct db_http_json *json, char **out) {
+  uint32_t code;
+  uint32_t low;
+
+  if (((json->end - json->pos) < 4) || (db_http_json_hex4(json->pos, &code) != 0)) {
+    return -EINVAL;
+  }
+  json->pos += 4;
+
+  if ((code >= 0xD800) && (code <= 0xDBFF)) {
+    if (((json->end - json->pos) < 6) || (json->pos[0] != '\\') || (json->pos[1] != 'u') ||
+        (db_http_json_hex4(&json->pos[2], &low) != 0) || (low < 0xDC00) || (low > 0xDFFF)) {
+      return -EINVAL;
+    }
+    json->pos += 6;
+    code = 0x10000 + ((code - 0xD800) << 10) + (low - 0xDC00);
+  } else if (((code >= 0xDC00) && (code <= 0xDFFF)) || (code == 0)) {
+    // Surrogate solto; \u0000 cortaria a string no terminador
+    return -EINVAL;
+  }
+
+  if (code < 0x80) {
+    *(*out)++ = code;
+  } else if (code < 0x800) {
+    *(*out)++ = 0xC0 | (code >> 6);
+    *(*out)++ = 0x80 | (code & 0x3F);
+  } else if (code < 0x10000) {
+    *(*out)++ = 0xE0 | (code >> 12);
+    *(*out)++ = 0x80 | ((code >> 6) & 0x3F);
+    *(*out)++ = 0x80 | (code & 0x3F);
+  } else {
+    *(*out)++ = 0xF0 | (code >> 18);
+    *(*out)++ = 0x80 | ((code >> 12) & 0x3F);
+    *(*out)++ = 0x80 | ((code >> 6) & 0x3F);
+    *(*out)++ = 0x80 | (code & 0x3F);
+  }
+
+  return 0;
+}
+
+// Decodifica a string no lugar (o resultado nunca e maior que o texto)
+static int db_http_json_string(struct db_http_json *json, struct db_http_token *tok) {
+  char *out = ++json->pos;
+  char c;
+
+  tok->kind = DB_HTTP_JSON_STR;
+  tok->text = out;
+
+  while (json->pos < json->end) {
+    c = *json->pos++;
+
+    if (c == '"') {
+      *out = '\0';
+      return 0;
+    }
+
+    // Controles so entram escapados
+    if ((uint8_t)c < 0x20) {
+      return -EINVAL;
+    }
+
+    if (c != '\\') {
+      *out++ = c;
+      continue;
+    }
+
+    if (json->pos >= json->end) {
+      break;
+    }
+
+    c = *json->pos++;
+    switch (c) {
+    case 'n':
+      *out++ = '\n';
+      break;
+    case 'r':
+      *out++ = '\r';
+      break;
+    case 't':
+      *out++ = '\t';
+      break;
+    case 'b':
+      *out++ = '\b';
+      break;
+    case 'f':
+      *out++ = '\f';
+      break;
+    case 'u':
+      if (db_http_json_unicode(json, &out) != 0) {
+        return -EINVAL;
+      }
+      break;
+    case '"':
+    case '\\':
+    case '/':
+      *out++ = c;
+      break;
+    default:
+      return -EINVAL;
+    }
+  }
+
+  return -EINVAL;
+}
+
+static int db_http_json_scalar(struct db_http_json *json, struct db_http_token *tok) {
+  size_t len = 0;
+
+  db_http_json_skip(json);
+
+  if (json->pos >= json->end) {
+    return -EINVAL;
+  }
+
+  if (*json->pos == '"') {
+    return db_http_json_string(json, tok);
+  }
+
+  if (((json->end - json->pos) >= 4) && (strncmp(json->pos, "true", 4) == 0)) {
+    tok->kind = DB_HTTP_JSON_TRUE;
+    json->pos += 4;
+    return 0;
+  }
+
+  if (((json->end - json->pos) >= 5) && (strncmp(json->pos, "false", 5) == 0)) {
+    tok->kind = DB_HTTP_JSON_FALSE;
+    json->pos += 5;
+    return 0;
+  }
+
+  while ((json->pos < json->end) && (*json->pos != '\0') &&
+         (strchr("+-0123456789.eE", *json->pos) != NULL)) {
+    if (len >= (sizeof(tok->num) - 1)) {
+      return -EINVAL;
+    }
+    tok->num[len++] = *json->pos++;
+  }
+
+  tok->num[len] = '\0';
+  tok->kind = DB_HTTP_JSON_NUM;
+  tok->text = tok->num;
+
+  return (len > 0) ? 0 : -EINVAL;
+}
+
+#define DB_HTTP_STORE_INT(_type, _min, _max)                                   \
+  do {                                                                         \
+    if ((value < (_min)) || (value > (_max))) {                                \
+      return -ERANGE;                                                          \
+    }                                                                          \
+    *(_type *)dst = (_type)value;                                              \
+  } while (0)
+
+// Converte o valor JSON para a representacao crua do tipo (faixa checada na base)
+static int db_http_json_to_raw(const struct db_param *param, const struct db_http_token *tok,
+                               void *dst, uint16_t *len) {
+  enum variable_type type = param->config.info.type;
+  long long value;
+  char *end;
+
+  *len = param->config.var_size;
+
+  if (type == eSTR) {
+    if ((tok->kind != DB_HTTP_JSON_STR) || (strlen(tok->text) >= param->config.var_size)) {
+      return -EINVAL;
+    }
+    *len = strlen(tok->text);
+    memcpy(dst, tok->text, *len);
+    return 0;
+  }
+
+  if ((type == eBOL) && (tok->kind != DB_HTTP_JSON_NUM)) {
+    if (tok->kind == DB_HTTP_JSON_STR) {
+      return -EINVAL;
+    }
+    *(uint8_t *)dst = (tok->kind == DB_HTTP_JSON_TRUE);
+    return 0;
+  }
+
+  if (tok->kind != DB_HTTP_JSON_NUM) {
+    return -EINVAL;
+  }
+
+  errno = 0;
+
+  switch (type) {
+  case eF32:
+    *(float *)dst = strtof(tok->text, &end);
+    break;
+#if defined(TYPEDEF_ENABLE_VAR_B64)
+  case eF64:
+    *(double *)dst = strtod(tok->text, &end);
+    break;
+  case eU64:
+    if (tok->text[0] == '-') {
+      return -ERANGE;
+    }
+    *(uint64_t *)dst = strtoull(tok->text, &end, 10);
+    break;
+  case eS64:
+    *(int64_t *)dst = strtoll(tok->text, &end, 10);
+    break;
+#endif
+  default:
+    value = strtoll(tok->text, &end, 10);
+    if (*end != '\0') {
+      return -EINVAL;
+    }
+
+    switch (type) {
+    case eBOL:
+    case eU08:
+      DB_HTTP_STORE_INT(uint8_t, 0, UINT8_MAX);
+      break;
+    case eS08:
+      DB_HTTP_STORE_INT(int8_t, INT8_MIN, INT8_MAX);
+      break;
+    case eU16:
+      DB_HTTP_STORE_INT(uint16_t, 0, UINT16_MAX);
+      break;
+    case eS16:
+      DB_HTTP_STORE_INT(int16_t, INT16_MIN, INT16_MAX);
+      break;
+    case eU32:
+      DB_HTTP_STORE_INT(uint32_t, 0, UINT32_MAX);
+      break;
+    case eS32:
+      DB_HTTP_STORE_INT(int32_t, INT32_MIN, INT32_MAX);
+      break;
+    default:
+      return -EINVAL;
+    }
+    break;
+  }
+
+  if ((*end != '\0') || (errno == ERANGE)) {
+    return -ERANGE;
+  }
+
+  return 0;
+}
+
+#undef DB_HTTP_STORE_INT
+
+// Converte um valor para o proximo item do lote, alinhado em conn->values
+static int db_http_add_write(struct db_http_conn *conn, struct db_http_json *json,
+                             struct db_param *param, uint16_t *count, size_t *used) {
+  struct db_http_token tok;
+  struct db_raw_item *item;
+  size_t len = ROUND_UP(param->config.var_size, DB_HTTP_VALUE_ALIGN);
+  int ret;
+
+  if ((*count >= ARRAY_SIZE(conn->raw)) || ((*used + len) > sizeof(conn->values))) {
+    return -E2BIG;
+  }
+
+  ret = db_http_json_scalar(json, &tok);
+  if (ret != 0) {
+    return ret;
+  }
+
+  item = &conn->raw[*count];
+  item->param = param;
+  item->data = &conn->values[*used];
+  item->result = 0;
+
+  ret = db_http_json_to_raw(param, &tok, item->data, &item->len);
+  if (ret != 0) {
+    return ret;
+  }
+
+  (*count)++;
+  *used += len;
+
+  return 0;
+}
+
+/*
+ * Escrita de um parametro (valor puro) ou de varios do grupo (objeto com
+ * id ou nome como chave). O lote e gravado de uma vez: com qualquer item
+ * invalido nada muda. *bad recebe o parametro rejeitado.
+ */
+static int db_http_parse_write(struct db_http_conn *conn, struct db_http_request *req,
+                               const struct db_group *group, struct db_param *param,
+                               uint16_t *count, struct db_param **bad) {
+  struct db_http_json json = {.pos = req->body, .end = req->body + req->body_len};
+  struct db_http_token key;
+  size_t used = 0;
+  int ret;
+
+  *count = 0;
+
+  if (param) {
+    *bad = param;
+    ret = db_http_add_write(conn, &json, param, count, &used);
+  } else if (!db_http_json_expect(&json, '{')) {
+    ret = -EINVAL;
+  } else {
+    do {
+      ret = db_http_json_scalar(&json, &key);
+      if ((ret != 0) || (key.kind != DB_HTTP_JSON_STR) || !db_http_json_expect(&json, ':')) {
+        return -EINVAL;
+      }
+
+      param = db_http_find_param(group, key.text);
+      if (!param) {
+        return -ENOENT;
+      }
+
+      ret = db_http_add_write(conn, &json, param, count, &used);
+      *bad = (ret != 0) ? param : NULL;
+    } while ((ret == 0) && db_http_json_expect(&json, ','));
+
+    if ((ret == 0) && !db_http_json_expect(&json, '}')) {
+      ret = -EINVAL;
+    }
+  }
+
+  db_http_json_skip(&json);
+  if ((ret == 0) && ((json.pos != json.end) || (*count == 0))) {
+    ret = -EINVAL;
+  }
+
+  return ret;
+}
+
+static int db_http_put(struct db_http_conn *conn, struct db_http_request *req,
+                       const struct db_group *group, struct db_param *param) {
+  struct db_param *bad = NULL;
+  struct db_http_sink sink;
+  struct json_stream js;
+  bool updated;
+  uint16_t count;
+  int err;
+  int ret;
+
+  ret = db_http_parse_write(conn, req, group, param, &count, &bad);
+
+  if (ret == 0) {
+    ret = db_param_set_raw_batch(CONFIG_APP_HTTP_WRITE_ACCESS, conn->raw, count);
+    for (uint16_t i = 0; (ret < 0) && (i < count); i++) {
+      if (conn->raw[i].result < 0) {
+        bad = conn->raw[i].param;
+        break;
+      }
+    }
+  }
+
+  if (ret < 0) {
+    LOG_WRN("Write to group %u rejected: %d", group->id, ret);
+    err = ret;
+
+    ret = db_http_send_head(conn, db_http_errno_status(err), true);
+    if (ret != 0) {
+      return ret;
+    }
+
+    db_http_body_start(conn, &js, &sink);
+    json_stream_obj_start(&js, NULL);
+    json_stream_str(&js, "error", "write rejected", SIZE_MAX);
+    json_stream_int(&js, "code", err);
+    if (bad) {
+      json_stream_uint(&js, "id", bad->id);
+      json_stream_str(&js, "name", bad->name, SIZE_MAX);
+    }
+    json_stream_obj_end(&js);
+
+    return db_http_body_end(&js, &sink);
+  }
+
+  db_http_stats_add(&g_stats.writes, count);
+  updated = (ret == DB_UPDATED);
+
+  ret = db_http_send_head(conn, 200, true);
+  if (ret != 0) {
+    return ret;
+  }
+
+  db_http_body_start(conn, &js, &sink);
+  json_stream_obj_start(&js, NULL);
+  json_stream_bool(&js, "updated", updated);
+  json_stream_uint(&js, "count", count);
+  json_stream_obj_end(&js);
+
+  return db_http_body_end(&js, &sink);
+}
+
+static char *db_http_trim(char *text) {
+  char *end;
+
+  while ((*text == ' ') || (*text == '\t')) {
+    text++;
+  }
+
+  end = text + strlen(text);
+  while ((end > text) && ((end[-1] == ' ') || (end[-1] == '\t'))) {
+    *--end = '\0';
+  }
+
+  return text;
+}
+
+// Linha de requisicao e cabecalhos, que devem caber em CONFIG_APP_HTTP_REQUEST_SIZE
+static int db_http_parse_head(char *head, struct db_http_request *req) {
+  char *end;
+  char *line;
+  char *next;
+  char *value;
+  char *target;
+
+  memset(req, 0, sizeof(*req));
+
+  next = strstr(head, "\r\n");
+  if (next) {
+    *next = '\0';
+    next += 2;
+  }
+
+  // METODO alvo HTTP/1.x
+  target = strchr(head, ' ');
+  if (!target) {
+    return -EINVAL;
+  }
+  *target++ = '\0';
+
+  value = strchr(target, ' ');
+  if (!value || (strncmp(&value[1], "HTTP/1.", 7) != 0)) {
+    return -EINVAL;
+  }
+  *value = '\0';
+
+  if (strcmp(head, "GET") == 0) {
+    req->method = DB_HTTP_GET;
+  } else if ((strcmp(head, "PUT") == 0) || (strcmp(head, "POST") == 0)) {
+    req->method = DB_HTTP_PUT;
+  } else if (strcmp(head, "OPTIONS") == 0) {
+    req->method = DB_HTTP_OPTIONS;
+  } else {
+    return -ENOTSUP;
+  }
+
+  req->path = target;
+  req->query = strchr(target, '?');
+  if (req->query) {
+    *req->query++ = '\0';
+  }
+
+  while (next && (*next != '\0')) {
+    line = next;
+    next = strstr(line, "\r\n");
+    if (next) {
+      *next = '\0';
+      next += 2;
+    }
+
+    value = strchr(line, ':');
+    if (!value) {
+      continue;
+    }
+    *value++ = '\0';
+    value = db_http_trim(value);
+
+    if (strcasecmp(line, "Content-Length") == 0) {
+      req->body_len = strtoul(value, &end, 10);
+      if ((*value < '0') || (*value > '9') || (*end != '\0')) {
+        return -EINVAL;
+      }
+    } else if (strcasecmp(line, "Upgrade") == 0) {
+      req->upgrade = (strcasecmp(value, "websocket") == 0);
+    } else if (strcasecmp(line, "Sec-WebSocket-Key") == 0) {
+      req->ws_key = value;
+    } else if (strcasecmp(line, "Authorization") == 0) {
+      req->auth = value;
+    }
+  }
+
+  return 0;
+}
+
+static int db_http_read_request(struct db_http_conn *conn, struct db_http_request *req) {
+  size_t len = 0;
+  size_t room;
+  char *end = NULL;
+  ssize_t ret;
+
+  while (!end) {
+    if (len >= CONFIG_APP_HTTP_REQUEST_SIZE) {
+      return -EMSGSIZE;
+    }
+
+    ret = zsock_recv(conn->fd, &conn->req[len], CONFIG_APP_HTTP_REQUEST_SIZE - len, 0);
+    if (ret <= 0) {
+      return (ret == 0) ? -ECONNRESET : -errno;
+    }
+
+    len += ret;
+    conn->req[len] = '\0';
+    end = strstr(conn->req, "\r\n\r\n");
+  }
+
+  end[2] = '\0';
+  ret = db_http_parse_head(conn->req, req);
+  if (ret != 0) {
+    return ret;
+  }
+
+  // Corpo no mesmo buffer, logo depois dos cabecalhos
+  req->body = end + 4;
+  room = &conn->req[CONFIG_APP_HTTP_REQUEST_SIZE] - req->body;
+  if (req->body_len > room) {
+    return -EMSGSIZE;
+  }
+
+  len = &conn->req[len] - req->body;
+  if (len < req->body_len) {
+    ret = db_http_recv_all(conn->fd, &req->body[len], req->body_len - len);
+    if (ret != 0) {
+      return ret;
+    }
+  }
+
+  req->body[req->body_len] = '\0';
+
+  return 0;
+}
+
+// "groups=2,4" na query; sem ela, todos os grupos com id menor que 32
+static int db_http_parse_groups(const char *query, uint32_t *mask) {
+  struct db_group *groups[DB_HTTP_MAX_GROUPS];
+  const char *pos = query;
+  unsigned long id;
+  char *end;
+  int count;
+
+  *mask = 0;
+
+  while (pos && (strncmp(pos, "groups=", 7) != 0)) {
+    pos = strchr(pos, '&');
+    pos = pos ? (pos + 1) : NULL;
+  }
+
+  if (!pos) {
+    count = db_get_groups(groups, ARRAY_SIZE(groups));
+    for (int i = 0; i < count; i++) {
+      if (groups[i]->id < DB_HTTP_MAX_GROUPS) {
+        *mask |= BIT(groups[i]->id);
+      }
+    }
+    return (count < 0) ? count : 0;
+  }
+
+  pos += 7;
+  do {
+    id = strtoul(pos, &end, 10);
+    if ((end == pos) || (id >= DB_HTTP_MAX_GROUPS)) {
+      return -EINVAL;
+    }
+    *mask |= BIT(id);
+    pos = end + 1;
+  } while (*end == ',');
+
+  return ((*end == '\0') || (*end == '&')) ? 0 : -EINVAL;
+}
+
+static int db_http_ws_upgrade(struct db_http_conn *conn, struct db_http_request *req) {
+  struct db_http_ws_client *client = NULL;
+  char key[DB_HTTP_WS_KEY_MAX + sizeof(DB_HTTP_WS_GUID)];
+  uint8_t digest[20];
+  char accept[32];
+  size_t olen;
+  uint32_t groups;
+  int len;
+  int ret;
+
+  if ((req->method != DB_HTTP_GET) || !req->upgrade || !req->ws_key ||
+      (strlen(req->ws_key) > DB_HTTP_WS_KEY_MAX)) {
+    return db_http_send_error(conn, -EINVAL, "websocket upgrade required");
+  }
+
+  if (db_http_parse_groups(req->query, &groups) != 0) {
+    return db_http_send_error(conn, -EINVAL, "invalid groups");
+  }
+
+  // Sec-WebSocket-Accept = base64(sha1(chave + GUID))
+  len = snprintf(key, sizeof(key), "%s%s", req->ws_key, DB_HTTP_WS_GUID);
+  if ((mbedtls_sha1((const unsigned char *)key, len, digest) != 0) ||
+      (base64_encode((uint8_t *)accept, sizeof(accept), &olen, digest, sizeof(digest)) != 0)) {
+    return db_http_send_error(conn, -EIO, "handshake failed");
+  }
+
+  k_mutex_lock(&g_lock, K_FOREVER);
+  for (size_t i = 0; i < ARRAY_SIZE(g_ws_clients); i++) {
+    if (g_ws_clients[i].fd < 0) {
+      client = &g_ws_clients[i];
+      client->fd = conn->fd;
+      client->active = false;
+      break;
+    }
+  }
+  k_mutex_unlock(&g_lock);
+
+  if (!client) {
+    return db_http_send_error(conn, -EBUSY, "too many subscribers");
+  }
+
+  len = snprintf((char *)conn->out, sizeof(conn->out),
+                 "HTTP/1.1 101 Switching Protocols\r\n"
+                 "Upgrade: websocket\r\n"
+                 "Connection: Upgrade\r\n"
+                 "Sec-WebSocket-Accept: %s\r\n\r\n",
+                 accept);
+
+  ret = db_http_send_all(conn->fd, conn->out, len);
+
+  // A partir daqui o socket e da thread WebSocket
+  k_mutex_lock(&g_lock, K_FOREVER);
+  if (ret == 0) {
+    client->groups = groups;
+    client->full = true;
+    client->rx_len = 0;
+    client->rx_skip = 0;
+    client->active = true;
+  } else {
+    client->fd = -1;
+  }
+  k_mutex_unlock(&g_lock);
+
+  if (ret != 0) {
+    return ret;
+  }
+
+  k_sem_give(&db_http_ws_wake);
+
+  return 1;
+}
+
+// Comparacao em tempo constante: o tempo da resposta nao revela o prefixo certo
+static bool db_http_authorized(const struct db_http_request *req) {
+  const char *token = CONFIG_APP_HTTP_WRITE_TOKEN;
+  const size_t len = sizeof(CONFIG_APP_HTTP_WRITE_TOKEN) - 1;
+  const char *given;
+  uint8_t diff = 0;
+
+  if (!req->auth || (strncasecmp(req->auth, "Bearer ", 7) != 0)) {
+    return false;
+  }
+
+  given = &req->auth[7];
+  while (*given == ' ') {
+    given++;
+  }
+
+  if (strlen(given) != len) {
+    return false;
+  }
+
+  for (size_t i = 0; i < len; i++) {
+    diff |= given[i] ^ token[i];
+  }
+
+  return diff == 0;
+}
+
+// Retorna 1 quando o socket passou para a thread WebSocket
+static int db_http_route(struct db_http_conn *conn, struct db_http_request *req) {
+  struct db_group *group;
+  struct db_param *param = NULL;
+  unsigned long id;
+  char *pos;
+  char *end;
+
+  if (req->method == DB_HTTP_OPTIONS) {
+    return db_http_send_head(conn, 204, false);     // Preflight CORS
+  }
+
+  if (req->method == DB_HTTP_PUT) {
+    if (!DB_HTTP_WRITES_ENABLED) {
+      return db_http_send_error(conn, -EACCES, "writes disabled");
+    }
+    if (!db_http_authorized(req)) {
+      return db_http_send_error(conn, -EPERM, "unauthorized");
+    }
+  }
+
+  if (strcmp(req->path, "/api/ws") == 0) {
+    return db_http_ws_upgrade(conn, req);
+  }
+
+  if (strcmp(req->path, "/api/groups") == 0) {
+    if (req->method != DB_HTTP_GET) {
+      return db_http_send_error(conn, -ENOTSUP, "method not allowed");
+    }
+    return db_http_get_groups(conn);
+  }
+
+  if (strncmp(req->path, "/api/groups/", 12) != 0) {
+    return db_http_send_error(conn, -ENOENT, "not found");
+  }
+
+  // /api/groups/<g> ou /api/groups/<g>/<p>
+  pos = &req->path[12];
+  id = strtoul(pos, &end, 10);
+  if ((end == pos) || ((*end != '\0') && (*end != '/'))) {
+    return db_http_send_error(conn, -ENOENT, "not found");
+  }
+
+  group = db_http_find_group(id);
+  if (!group) {
+    return db_http_send_error(conn, -ENOENT, "group not found");
+  }
+
+  if (*end == '/') {
+    pos = end + 1;
+    param = ((*pos != '\0') && (pos[strspn(pos, "0123456789")] == '\0'))
+                ? db_http_find_param(group, pos)
+                : NULL;
+    if (!param) {
+      return db_http_send_error(conn, -ENOENT, "param not found");
+    }
+  }
+
+  if (req->method == DB_HTTP_PUT) {
+    return db_http_put(conn, req, group, param);
+  }
+
+  return param ? db_http_get_param(conn, param) : db_http_get_group(conn, group);
+}
+
+// Retorna true quando o socket continua aberto (WebSocket)
+static bool db_http_serve(struct db_http_conn *conn) {
+  struct db_http_request req;
+  int ret;
+
+  ret = db_http_read_request(conn, &req);
+  if ((ret == -EMSGSIZE) || (ret == -ENOTSUP) || (ret == -EINVAL)) {
+    db_http_send_error(conn, ret, "invalid request");
+    return false;
+  } else if (ret != 0) {
+    return false;             // Timeout ou conexao perdida
+  }
+
+  db_http_stats_add(&g_stats.requests, 1);
+
+  return db_http_route(conn, &req) == 1;
+}
+
+static void db_http_set_timeouts(int fd) {
+  struct zsock_timeval tv = {
+      .tv_sec = CONFIG_APP_HTTP_TIMEOUT_MS / 1000,
+      .tv_usec = (CONFIG_APP_HTTP_TIMEOUT_MS % 1000) * 1000,
+  };
+  int opt = 1;
+
+  zsock_setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, &tv, sizeof(tv));
+  zsock_setsockopt(fd, SOL_SOCKET, SO_SNDTIMEO, &tv, sizeof(tv));
+  zsock_setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &opt, sizeof(opt));
+}
+
+static void db_http_listen_thread(void *p1, void *p2, void *p3) {
+  struct sockaddr_in addr = {
+      .sin_family = AF_INET,
+      .sin_port = htons(g_port),
+  };
+  int opt = 1;
+  int client;
+  int fd;
+
+  ARG_UNUSED(p1);
+  ARG_UNUSED(p2);
+  ARG_UNUSED(p3);
+
+  fd = zsock_socket(AF_INET, SOCK_STREAM, IPPROTO_TCP);
+  if (fd < 0) {
+    LOG_ERR("Socket failed: %d", -errno);
+    return;
+  }
+
+  zsock_setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &opt, sizeof(opt));
+
+  if ((zsock_bind(fd, (struct sockaddr *)&addr, sizeof(addr)) < 0) ||
+      (zsock_listen(fd, CONFIG_APP_HTTP_BACKLOG) < 0)) {
+    LOG_ERR("Listen on port %u failed: %d", g_port, -errno);
+    zsock_close(fd);
+    return;
+  }
+
+  LOG_INF("Listening on port %u", g_port);
+
+  while (true) {
+    client = zsock_accept(fd, NULL, NULL);
+    if (client < 0) {
+      k_msleep(100);
+      continue;
+    }
+
+    db_http_set_timeouts(client);
+
+    // Workers ocupados e fila cheia: recusa sem ler a requisicao
+    if (k_msgq_put(&db_http_conn_queue, &client, K_NO_WAIT) != 0) {
+      db_http_send_all(client, DB_HTTP_BUSY_RESPONSE, sizeof(DB_HTTP_BUSY_RESPONSE) - 1);
+      zsock_close(client);
+      db_http_stats_add(&g_stats.busy, 1);
+    }
+  }
+}
+
+static void db_http_worker_thread(void *p1, void *p2, void *p3) {
+  struct db_http_conn *conn = p1;
+
+  ARG_UNUSED(p2);
+  ARG_UNUSED(p3);
+
+  while (true) {
+    k_msgq_get(&db_http_conn_queue, &conn->fd, K_FOREVER);
+
+    if (!db_http_serve(conn)) {
+      zsock_close(conn->fd);
+    }
+  }
+}
+
+// Parametros visiveis do grupo entram na tabela de leitura do WebSocket
+static int db_http_ws_add_group(db_group_id_t group_id) {
+  struct db_group *group;
+  struct db_param *param;
+  struct db_http_ws_item *item;
+  uint16_t len;
+
+  group = db_http_find_group(group_id);
+  if (!group) {
+    return -ENOENT;
+  }
+
+  for (uint16_t i = 0; i < group->count; i++) {
+    param = (struct db_param *)&group->params[i];
+    if (!db_http_param_visible(param)) {
+      continue;
+    }
+
+    len = ROUND_UP(param->config.var_size, DB_HTTP_VALUE_ALIGN);
+    if ((g_ws_count >= ARRAY_SIZE(g_ws_items)) || ((g_ws_used + len) > sizeof(g_ws_shadow))) {
+      LOG_WRN("Group %u does not fit the subscription table", group_id);
+      return -ENOMEM;
+    }
+
+    item = &g_ws_items[g_ws_count++];
+    item->param = param;
+    item->group = group_id;
+    item->offset = g_ws_used;
+    g_ws_used += len;
+  }
+
+  return 0;
+}
+
+// Pong e close: sem espaco no socket o quadro se perde (o cliente repete o ping)
+static int db_http_ws_send_frame(int fd, uint8_t opcode, const uint8_t *data, size_t len) {
+  uint8_t frame[2 + DB_HTTP_WS_CTRL_MAX];
+  bool sent = false;
+  int ret;
+
+  len = MIN(len, DB_HTTP_WS_CTRL_MAX);
+  frame[0] = DB_HTTP_WS_FIN | opcode;
+  frame[1] = len;
+  memcpy(&frame[2], data, len);
+
+  ret = db_http_ws_send_nb(fd, frame, 2 + len, &sent, k_uptime_get() + CONFIG_APP_HTTP_WS_SEND_MS);
+
+  return (ret == -EAGAIN) ? 0 : ret;
+}
+
+/*
+ * Cabecalho de um quadro do cliente com len bytes ja recebidos. Retorna o
+ * tamanho do cabecalho com a mascara, 0 se ainda incompleto ou -EPROTO.
+ */
+static int db_http_ws_parse_frame(const uint8_t *data, size_t len, uint8_t *opcode,
+                                  uint64_t *payload) {
+  size_t hlen = 2;
+
+  if (len < 2) {
+    return 0;
+  }
+
+  // Todo quadro do cliente vem mascarado (RFC 6455)
+  if (!(data[1] & DB_HTTP_WS_MASKED)) {
+    return -EPROTO;
+  }
+
+  *opcode = data[0] & 0x0F;
+  *payload = data[1] & 0x7F;
+
+  if (*payload == 126) {
+    hlen += 2;
+  } else if (*payload == 127) {
+    hlen += 8;
+  }
+
+  if (len < (hlen + 4)) {
+    return 0;
+  }
+
+  if (hlen == 4) {
+    *payload = sys_get_be16(&data[2]);
+  } else if (hlen == 10) {
+    *payload = sys_get_be64(&data[2]);
+  }
+
+  // Quadro de controle: ate 125 bytes, nunca fragmentado
+  if ((*opcode & DB_HTTP_WS_OP_CONTROL) &&
+      ((*payload > DB_HTTP_WS_CTRL_MAX) || !(data[0] & DB_HTTP_WS_FIN))) {
+    return -EPROTO;
+  }
+
+  return hlen + 4;
+}
+
+static void db_http_ws_consume(struct db_http_ws_client *client, size_t len) {
+  client->rx_len -= len;
+  memmove(client->rx, &client->rx[len], client->rx_len);
+}
+
+// Quadros completos em client->rx: responde ping e close, descarta dados
+static int db_http_ws_process(struct db_http_ws_client *client) {
+  uint8_t *payload;
+  const uint8_t *mask;
+  uint64_t len;
+  uint8_t opcode;
+  size_t used;
+  int hlen;
+  int ret;
+
+  while (client->rx_len > 0) {
+    hlen = db_http_ws_parse_frame(client->rx, client->rx_len, &opcode, &len);
+    if (hlen <= 0) {
+      return hlen;
+    }
+
+    // Dados nao sao usados: o que ja chegou sai do buffer, o resto na leitura
+    if (!(opcode & DB_HTTP_WS_OP_CONTROL)) {
+      used = MIN(len, client->rx_len - hlen);
+      client->rx_skip = len - used;
+      db_http_ws_consume(client, hlen + used);
+      continue;
+    }
+
+    if (client->rx_len < (hlen + len)) {
+      return 0;
+    }
+
+    mask = &client->rx[hlen - 4];
+    payload = &client->rx[hlen];
+    for (size_t i = 0; i < len; i++) {
+      payload[i] ^= mask[i % 4];
+    }
+
+    switch (opcode) {
+    case DB_HTTP_WS_OP_CLOSE:
+      db_http_ws_send_frame(client->fd, DB_HTTP_WS_OP_CLOSE, payload, MIN(len, 2));
+      ret = -ESHUTDOWN;
+      break;
+    case DB_HTTP_WS_OP_PING:
+      ret = db_http_ws_send_frame(client->fd, DB_HTTP_WS_OP_PONG, payload, len);
+      break;
+    default:
+      ret = 0;
+      break;
+    }
+
+    db_http_ws_consume(client, hlen + len);
+    if (ret != 0) {
+      return ret;
+    }
+  }
+
+  return 0;
+}
+
+// Le o que o poll anunciou, sem esperar pelo resto do quadro
+static int db_http_ws_input(struct db_http_ws_client *client) {
+  uint8_t discard[64];
+  ssize_t ret;
+
+  if (client->rx_skip > 0) {
+    ret = zsock_recv(client->fd, discard, MIN(client->rx_skip, sizeof(discard)),
+                     ZSOCK_MSG_DONTWAIT);
+  } else {
+    ret = zsock_recv(client->fd, &client->rx[client->rx_len], sizeof(client->rx) - client->rx_len,
+                     ZSOCK_MSG_DONTWAIT);
+  }
+
+  if (ret == 0) {
+    return -ECONNRESET;
+  }
+
+  if (ret < 0) {
+    return ((errno == EAGAIN) || (errno == EWOULDBLOCK)) ? 0 : -errno;
+  }
+
+  if (client->rx_skip > 0) {
+    client->rx_skip -= ret;
+    return 0;
+  }
+
+  client->rx_len += ret;
+
+  return db_http_ws_process(client);
+}
+
+static void db_http_ws_drop(struct db_http_ws_client *client, int err) {
+  zsock_close(client->fd);
+
+  k_mutex_lock(&g_lock, K_FOREVER);
+  client->fd = -1;
+  client->active = false;
+  if (err != -ESHUTDOWN) {
+    g_stats.ws_dropped++;
+  }
+  k_mutex_unlock(&g_lock);
+}
+
+// Mensagem com o retrato dos grupos (full) ou so com o que mudou no ciclo
+static int db_http_ws_send(int fd, uint32_t groups, bool full, uint32_t seq) {
+  struct db_http_sink sink = {
+      .fd = fd,
+      .ws = true,
+      .deadline = k_uptime_get() + CONFIG_APP_HTTP_WS_SEND_MS,
+  };
+  const struct db_http_ws_item *item;
+  struct json_stream js;
+  bool any = full;
+  int ret;
+
+  for (uint16_t i = 0; (i < g_ws_count) && !any; i++) {
+    any = g_ws_changed[i] && (groups & BIT(g_ws_items[i].group));
+  }
+
+  if (!any) {
+    return 0;
+  }
+
+  json_stream_init(&js, &g_ws_out[DB_HTTP_HEAD_ROOM], CONFIG_APP_HTTP_CHUNK_SIZE, db_http_sink,
+                   &sink);
+  json_stream_obj_start(&js, NULL);
+  json_stream_uint(&js, "seq", seq);
+  json_stream_uint(&js, "uptime", k_uptime_get_32());
+  json_stream_bool(&js, "full", full);
+  json_stream_arr_start(&js, "params");
+
+  for (uint16_t i = 0; i < g_ws_count; i++) {
+    item = &g_ws_items[i];
+
+    if (!(groups & BIT(item->group)) || (g_ws_raw[i].result <= 0) ||
+        (!full && !g_ws_changed[i])) {
+      continue;
+    }
+
+    json_stream_obj_start(&js, NULL);
+    json_stream_uint(&js, "group", item->group);
+    json_stream_uint(&js, "id", item->param->id);
+    db_http_json_value(&js, "value", item->param, &g_ws_shadow[item->offset]);
+    json_stream_obj_end(&js);
+  }
+
+  json_stream_arr_end(&js);
+  json_stream_obj_end(&js);
+  ret = json_stream_end(&js);
+  if (ret != 0) {
+    return ret;
+  }
+
+  k_mutex_lock(&g_lock, K_FOREVER);
+  g_stats.ws_messages++;
+  g_stats.bytes += sink.bytes;
+  k_mutex_unlock(&g_lock);
+
+  return 0;
+}
+
+/*
+ * Um ciclo do WebSocket: uma leitura em lote de todos os parametros assinados
+ * (so se a base mudou ou ha assinante novo), comparacao com a ultima copia
+ * enviada e uma mensagem por assinante, com o lock da base ja livre.
+ */
+static void db_http_ws_tick(void) {
+  struct db_http_ws_client *client;
+  const struct db_http_ws_item *item;
+  uint32_t groups = 0;
+  uint32_t seq;
+  bool full = false;
+  bool active;
+  int ret;
+
+  k_mutex_lock(&g_lock, K_FOREVER);
+  for (size_t i = 0; i < ARRAY_SIZE(g_ws_clients); i++) {
+    if (g_ws_clients[i].active) {
+      groups |= g_ws_clients[i].groups;
+      full |= g_ws_clients[i].full;
+    }
+  }
+  k_mutex_unlock(&g_lock);
+
+  // Grupos entram na tabela na primeira assinatura e nao saem mais
+  for (uint32_t id = 0; id < DB_HTTP_MAX_GROUPS; id++) {
+    if ((groups & BIT(id)) && !(g_ws_groups & BIT(id))) {
+      db_http_ws_add_group(id);
+      g_ws_groups |= BIT(id);
+      full = true;
+    }
+  }
+
+  seq = db_get_change_seq();
+  if ((g_ws_count == 0) || (!full && (seq == g_ws_last_seq))) {
+    return;
+  }
+
+  for (uint16_t i = 0; i < g_ws_count; i++) {
+    g_ws_raw[i].param = g_ws_items[i].param;
+    g_ws_raw[i].data = &g_ws_values[g_ws_items[i].offset];
+    g_ws_raw[i].len = g_ws_items[i].param->config.var_size;
+    g_ws_raw[i].result = 0;
+  }
+
+  ret = db_param_get_raw_batch(CONFIG_APP_HTTP_READ_ACCESS, g_ws_raw, g_ws_count);
+  if (ret == -ETIMEDOUT) {
+    return;
+  }
+
+  // Mudancas depois desta leitura do contador ficam para o proximo ciclo
+  g_ws_last_seq = seq;
+
+  for (uint16_t i = 0; i < g_ws_count; i++) {
+    item = &g_ws_items[i];
+    g_ws_changed[i] = (g_ws_raw[i].result > 0) &&
+                      (memcmp(&g_ws_shadow[item->offset], &g_ws_values[item->offset],
+                              g_ws_raw[i].len) != 0);
+    if (g_ws_changed[i]) {
+      memcpy(&g_ws_shadow[item->offset], &g_ws_values[item->offset], g_ws_raw[i].len);
+    }
+  }
+
+  // So esta thread desativa assinantes: fd e grupos ficam validos fora do lock
+  for (size_t i = 0; i < ARRAY_SIZE(g_ws_clients); i++) {
+    client = &g_ws_clients[i];
+
+    k_mutex_lock(&g_lock, K_FOREVER);
+    active = client->active;
+    full = client->full;
+    client->full = false;
+    k_mutex_unlock(&g_lock);
+
+    if (!active) {
+      continue;
+    }
+
+    ret = db_http_ws_send(client->fd, client->groups, full, seq);
+    if (ret == -EAGAIN) {
+      // Socket cheio: a mensagem fica para tras e a proxima leva o retrato
+      k_mutex_lock(&g_lock, K_FOREVER);
+      client->full = true;
+      g_stats.ws_skipped++;
+      k_mutex_unlock(&g_lock);
+    } else if (ret != 0) {
+      LOG_WRN("Subscriber dropped: %d", ret);
+      db_http_ws_drop(client, ret);
+    }
+  }
+}
+
+static void db_http_ws_thread(void *p1, void *p2, void *p3) {
+  struct zsock_pollfd fds[CONFIG_APP_HTTP_WS_CLIENTS];
+  struct db_http_ws_client *clients[CONFIG_APP_HTTP_WS_CLIENTS];
+  int64_t next_tick = k_uptime_get();
+  int64_t now;
+  int count;
+  int err;
+  int ret;
+
+  ARG_UNUSED(p1);
+  ARG_UNUSED(p2);
+  ARG_UNUSED(p3);
+
+  while (true) {
+    count = 0;
+
+    k_mutex_lock(&g_lock, K_FOREVER);
+    for (size_t i = 0; i < ARRAY_SIZE(g_ws_clients); i++) {
+      if (g_ws_clients[i].active) {
+        fds[count].fd = g_ws_clients[i].fd;
+        fds[count].events = ZSOCK_POLLIN;
+        fds[count].revents = 0;
+        clients[count++] = &g_ws_clients[i];
+      }
+    }
+    k_mutex_unlock(&g_lock);
+
+    if (count == 0) {
+      k_sem_take(&db_http_ws_wake, K_FOREVER);
+      next_tick = k_uptime_get();
+      continue;
+    }
+
+    ret = zsock_poll(fds, count, MAX(next_tick - k_uptime_get(), 0));
+
+    for (int i = 0; (ret > 0) && (i < count); i++) {
+      if (fds[i].revents & ZSOCK_POLLIN) {
+        err = db_http_ws_input(clients[i]);
+      } else if (fds[i].revents & (ZSOCK_POLLERR | ZSOCK_POLLHUP)) {
+        err = -ECONNRESET;
+      } else {
+        err = 0;
+      }
+
+      if (err != 0) {
+        db_http_ws_drop(clients[i], err);
+      }
+    }
+
+    now = k_uptime_get();
+    if (now >= next_tick) {
+      db_http_ws_tick();
+      next_tick += CONFIG_APP_HTTP_WS_PERIOD_MS;
+      if (next_tick <= now) {
+        next_tick = now + CONFIG_APP_HTTP_WS_PERIOD_MS;
+      }
+    }
+  }
+}
+
+/**
+ * @brief Inicia o servidor HTTP da base na porta port (todas as interfaces)
+ *
+ * Requer a base iniciada. O socket e aberto em segundo plano; as requisicoes
+ * sao atendidas quando a rede subir.
+ */
+int db_http_init(uint16_t port) {
+  if (g_started) {
+    return 0;
+  }
+
+  g_port = port;
+
+  for (size_t i = 0; i < ARRAY_SIZE(g_ws_clients); i++) {
+    g_ws_clients[i].fd = -1;
+  }
+
+  for (size_t i = 0; i < ARRAY_SIZE(g_conns); i++) {
+    k_thread_create(&g_conns[i].thread, g_worker_stacks[i],
+                    K_KERNEL_STACK_SIZEOF(g_worker_stacks[0]), db_http_worker_thread,
+                    &g_conns[i], NULL, NULL, CONFIG_APP_HTTP_PRIORITY, 0, K_NO_WAIT);
+    k_thread_name_set(&g_conns[i].thread, "http_worker");
+  }
+
+  k_thread_create(&g_ws_thread, g_ws_stack, K_KERNEL_STACK_SIZEOF(g_ws_stack), db_http_ws_thread,
+                  NULL, NULL, NULL, CONFIG_APP_HTTP_PRIORITY, 0, K_NO_WAIT);
+  k_thread_name_set(&g_ws_thread, "http_ws");
+
+  k_thread_create(&g_listen_thread, g_listen_stack, K_KERNEL_STACK_SIZEOF(g_listen_stack),
+                  db_http_listen_thread, NULL, NULL, NULL, CONFIG_APP_HTTP_PRIORITY, 0,
+                  K_NO_WAIT);
+  k_thread_name_set(&g_listen_thread, "http_listen");
+
+  g_started = true;
+
+  return 0;
+}
+
+int db_http_get_stats(struct db_http_stats *stats) {
+  if (!stats) {
+    return -EINVAL;
+  }
+
+  k_mutex_lock(&g_lock, K_FOREVER);
+  *stats = g_stats;
+  stats->ws_clients = 0;
+  for (size_t i = 0; i < ARRAY_SIZE(g_ws_clients); i++) {
+    stats->ws_clients += g_ws_clients[i].active ? 1 : 0;
+  }
+  k_mutex_unlock(&g_lock);
+
+  return 0;
+}
+
+static int db_http_shell_cmd_stats(const struct shell *shell, size_t argc, char **argv) {
+  struct db_http_stats stats;
+
+  ARG_UNUSED(argc);
+  ARG_UNUSED(argv);
+
+  db_http_get_stats(&stats);
+
+  shell_print(shell, "port: %u, workers: %u, queue: %u/%u", g_port, CONFIG_APP_HTTP_WORKERS,
+              k_msgq_num_used_get(&db_http_conn_queue), CONFIG_APP_HTTP_BACKLOG);
+  shell_print(shell, "requests: %u, errors: %u, busy: %u, writes: %u", stats.requests,
+              stats.errors, stats.busy, stats.writes);
+  shell_print(shell, "websocket: %u/%u clients, %u messages, %u skipped, %u dropped",
+              stats.ws_clients, CONFIG_APP_HTTP_WS_CLIENTS, stats.ws_messages, stats.ws_skipped,
+              stats.ws_dropped);
+  shell_print(shell, "sent: %u bytes, watched params: %u", stats.bytes, g_ws_count);
+
+  return 0;
+}
@@ -0,0 +1,54 @@
+#ifndef _DB_HTTP_H
+#define _DB_HTTP_H
+
+/* C++ detection */
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "database.h"
+
+/*
+ * API HTTP da base (uma requisicao por conexao, respostas JSON chunked):
+ *
+ *   GET  /api/groups              grupos: id, nome e numero de parametros
+ *   GET  /api/groups/<g>          parametros do grupo com tipo, faixa e valor
+ *   GET  /api/groups/<g>/<p>      um parametro
+ *   PUT  /api/groups/<g>          {"<id ou nome>": valor, ...}, tudo ou nada
+ *   PUT  /api/groups/<g>/<p>      valor JSON puro (42, 1.5, "texto", true)
+ *   GET  /api/ws?groups=2,4       WebSocket com as mudancas dos grupos
+ *
+ * Pelo WebSocket cada mensagem e um texto
+ *   {"seq":N,"uptime":ms,"full":bool,"params":[{"group":g,"id":p,"value":v},...]}
+ * com o retrato completo ("full") na primeira e depois so o que mudou. Sem
+ * groups na URL valem todos os grupos com id menor que 32. POST e aceito
+ * como PUT. Parametros de senha nunca aparecem.
+ *
+ * Escritas exigem "Authorization: Bearer <CONFIG_APP_HTTP_WRITE_TOKEN>" e
+ * ficam desligadas sem token. Cabecalhos CORS so saem para a origem de
+ * CONFIG_APP_HTTP_CORS_ORIGIN.
+ */
+
+struct db_http_stats {
+  uint32_t requests;
+  uint32_t errors;              // Respostas 4xx/5xx
+  uint32_t busy;                // Conexoes recusadas com a fila cheia (503)
+  uint32_t writes;              // Parametros escritos
+  uint32_t bytes;               // JSON enviado (HTTP e WebSocket)
+  uint32_t ws_clients;          // Assinantes agora
+  uint32_t ws_messages;
+  uint32_t ws_skipped;          // Mensagens puladas com o socket cheio
+  uint32_t ws_dropped;          // Assinantes desligados por erro ou lentidao
+};
+
+int db_http_init(uint16_t port);
+int db_http_get_stats(struct db_http_stats *stats);
+
+/* C++ detection */
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* _DB_HTTP_H */
@@ -0,0 +1,217 @@
+#include "json_stream.h"
+
+#include <errno.h>
+#include <math.h>
+#include <stdio.h>
+#include <string.h>
+#include <zephyr/sys/util.h>
+
+static void json_stream_flush(struct json_stream *js, bool final) {
+  int ret;
+
+  if (js->err) {
+    return;
+  }
+
+  ret = js->sink(js->ctx, js->buf, js->len, final);
+  if (ret < 0) {
+    js->err = ret;
+  }
+
+  js->len = 0;
+}
+
+// Enche o buffer e entrega ao sink a cada vez que ele fica cheio
+static void json_stream_put(struct json_stream *js, const char *data, size_t len) {
+  size_t chunk;
+
+  while ((len > 0) && !js->err) {
+    chunk = MIN(len, js->size - js->len);
+    memcpy(&js->buf[js->len], data, chunk);
+    js->len += chunk;
+    data += chunk;
+    len -= chunk;
+
+    if (js->len == js->size) {
+      json_stream_flush(js, false);
+    }
+  }
+}
+
+static void json_stream_putc(struct json_stream *js, char c) {
+  json_stream_put(js, &c, 1);
+}
+
+static void json_stream_escaped(struct json_stream *js, const char *str, size_t maxlen) {
+  static const char hex[] = "0123456789abcdef";
+  char esc[6] = {'\\', 'u', '0', '0'};
+  size_t start = 0;
+  size_t i;
+
+  json_stream_putc(js, '"');
+
+  // Trechos sem escape saem de uma vez
+  for (i = 0; (i < maxlen) && (str[i] != '\0'); i++) {
+    uint8_t c = (uint8_t)str[i];
+
+    if ((c >= 0x20) && (c != '"') && (c != '\\')) {
+      continue;
+    }
+
+    json_stream_put(js, &str[start], i - start);
+    start = i + 1;
+
+    if ((c == '"') || (c == '\\')) {
+      esc[1] = c;
+      json_stream_put(js, esc, 2);
+    } else if (c == '\n') {
+      json_stream_put(js, "\\n", 2);
+    } else {
+      esc[1] = 'u';
+      esc[4] = hex[c >> 4];
+      esc[5] = hex[c & 0xF];
+      json_stream_put(js, esc, sizeof(esc));
+    }
+  }
+
+  json_stream_put(js, &str[start], i - start);
+  json_stream_putc(js, '"');
+}
+
+// Virgula antes de todo elemento que nao e o primeiro do nivel, e a chave
+static void json_stream_key(struct json_stream *js, const char *key) {
+  uint32_t bit = BIT(js->depth);
+
+  if (js->items & bit) {
+    json_stream_putc(js, ',');
+  }
+  js->items |= bit;
+
+  if (key) {
+    json_stream_escaped(js, key, SIZE_MAX);
+    json_stream_putc(js, ':');
+  }
+}
+
+static void json_stream_open(struct json_stream *js, const char *key, char c) {
+  json_stream_key(js, key);
+  json_stream_putc(js, c);
+
+  if (js->depth >= (JSON_STREAM_MAX_DEPTH - 1)) {
+    js->err = -E2BIG;
+    return;
+  }
+
+  js->depth++;
+  js->items &= ~BIT(js->depth);
+}
+
+static void json_stream_close(struct json_stream *js, char c) {
+  if (js->depth > 0) {
+    js->depth--;
+  }
+
+  json_stream_putc(js, c);
+}
+
+/**
+ * @brief Inicia um documento sobre o buffer buf (size bytes)
+ */
+void json_stream_init(struct json_stream *js, uint8_t *buf, size_t size, json_stream_sink_t sink,
+                      void *ctx) {
+  memset(js, 0, sizeof(*js));
+  js->buf = buf;
+  js->size = size;
+  js->sink = sink;
+  js->ctx = ctx;
+}
+
+void json_stream_obj_start(struct json_stream *js, const char *key) {
+  json_stream_open(js, key, '{');
+}
+
+void json_stream_obj_end(struct json_stream *js) {
+  json_stream_close(js, '}');
+}
+
+void json_stream_arr_start(struct json_stream *js, const char *key) {
+  json_stream_open(js, key, '[');
+}
+
+void json_stream_arr_end(struct json_stream *js) {
+  json_stream_close(js, ']');
+}
+
+/**
+ * @brief String de ate maxlen bytes (para antes do terminador)
+ */
+void json_stream_str(struct json_stream *js, const char *key, const char *str, size_t maxlen) {
+  json_stream_key(js, key);
+  json_stream_escaped(js, str, maxlen);
+}
+
+// Sem printf: nao depende do suporte a 64 bits do cbprintf
+static void json_stream_digits(struct json_stream *js, uint64_t value) {
+  char digits[20];
+  size_t pos = sizeof(digits);
+
+  do {
+    digits[--pos] = '0' + (value % 10);
+    value /= 10;
+  } while (value > 0);
+
+  json_stream_put(js, &digits[pos], sizeof(digits) - pos);
+}
+
+void json_stream_uint(struct json_stream *js, const char *key, uint64_t value) {
+  json_stream_key(js, key);
+  json_stream_digits(js, value);
+}
+
+void json_stream_int(struct json_stream *js, const char *key, int64_t value) {
+  json_stream_key(js, key);
+
+  if (value < 0) {
+    json_stream_putc(js, '-');
+    json_stream_digits(js, (uint64_t)(-(value + 1)) + 1);
+  } else {
+    json_stream_digits(js, value);
+  }
+}
+
+/**
+ * @brief Numero com digits algarismos significativos; NaN e infinito viram null
+ */
+void json_stream_double(struct json_stream *js, const char *key, double value, int digits) {
+  char text[32];
+  int len;
+
+  if (!isfinite(value)) {
+    json_stream_null(js, key);
+    return;
+  }
+
+  len = snprintf(text, sizeof(text), "%.*g", digits, value);
+  json_stream_key(js, key);
+  json_stream_put(js, text, CLAMP(len, 0, (int)sizeof(text) - 1));
+}
+
+void json_stream_bool(struct json_stream *js, const char *key, bool value) {
+  json_stream_key(js, key);
+  json_stream_put(js, value ? "true" : "false", value ? 4 : 5);
+}
+
+void json_stream_null(struct json_stream *js, const char *key) {
+  json_stream_key(js, key);
+  json_stream_put(js, "null", 4);
+}
+
+/**
+ * @brief Entrega o que sobrou no buffer como ultimo bloco
+ *
+ * @return 0 ou o primeiro erro do sink
+ */
+int json_stream_end(struct json_stream *js) {
+  json_stream_flush(js, true);
+  return js->err;
+}
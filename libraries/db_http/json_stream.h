@@ -0,0 +1,60 @@
+#ifndef _JSON_STREAM_H
+#define _JSON_STREAM_H
+
+/* C++ detection */
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+/*
+ * Codificador JSON em fluxo: o documento nunca existe inteiro na RAM. Os
+ * bytes vao para um buffer fixo do chamador e, quando ele enche, para o
+ * sink (um bloco chunked do HTTP, um fragmento WebSocket...). O sink recebe
+ * o proprio buffer e pode usar espaco que o dono reservou antes e depois
+ * dele para montar o cabecalho do bloco sem copiar os dados.
+ *
+ * Cada valor recebe uma chave (dentro de objetos) ou NULL (em arrays e na
+ * raiz); as virgulas sao colocadas pelo codificador. Depois do primeiro
+ * erro do sink as chamadas nao fazem nada e json_stream_end() o retorna.
+ */
+
+#define JSON_STREAM_MAX_DEPTH  (32)
+
+// final: ultimo bloco do documento (pode ter len 0)
+typedef int (*json_stream_sink_t)(void *ctx, uint8_t *data, size_t len, bool final);
+
+struct json_stream {
+  uint8_t *buf;
+  size_t size;
+  size_t len;
+  json_stream_sink_t sink;
+  void *ctx;
+  uint32_t items;               // Bit por nivel: ja tem algum elemento
+  uint8_t depth;
+  int err;
+};
+
+void json_stream_init(struct json_stream *js, uint8_t *buf, size_t size, json_stream_sink_t sink,
+                      void *ctx);
+void json_stream_obj_start(struct json_stream *js, const char *key);
+void json_stream_obj_end(struct json_stream *js);
+void json_stream_arr_start(struct json_stream *js, const char *key);
+void json_stream_arr_end(struct json_stream *js);
+void json_stream_str(struct json_stream *js, const char *key, const char *str, size_t maxlen);
+void json_stream_int(struct json_stream *js, const char *key, int64_t value);
+void json_stream_uint(struct json_stream *js, const char *key, uint64_t value);
+void json_stream_double(struct json_stream *js, const char *key, double value, int digits);
+void json_stream_bool(struct json_stream *js, const char *key, bool value);
+void json_stream_null(struct json_stream *js, const char *key);
+int json_stream_end(struct json_stream *js);
+
+/* C++ detection */
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* _JSON_STREAM_H */
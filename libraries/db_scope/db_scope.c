@@ -0,0 +1,499 @@
+#include "db_scope.h"
+
+#include <stdlib.h>
+#include <string.h>
+#include <zephyr/kernel.h>
+#include <zephyr/logging/log.h>
+#include <zephyr/net/socket.h>
+#include <zephyr/shell/shell.h>
+#include <zephyr/sys/byteorder.h>
+
+LOG_MODULE_REGISTER(db_scope, CONFIG_LOG_DEFAULT_LEVEL);
+
+/*
+ * Osciloscopio da base por UDP. Um k_timer periodico acorda a thread de
+ * amostragem, que le todos os canais com uma unica tomada do lock da base
+ * direto para o quadro em montagem. Os quadros ficam num anel fixo
+ * (CONFIG_APP_SCOPE_FRAMES) que circula entre duas filas: livres e prontos.
+ * A thread de envio esvazia os prontos com sendto(); se a rede atrasa, a
+ * amostragem nao espera: sem quadro livre a amostra e perdida e contada.
+ *
+ * Os contadores de g_stats sao escritos cada um por uma so thread e lidos
+ * sem lock.
+ */
+
+#define DB_SCOPE_STACK_MEM_ATTRIBUTES Z_GENERIC_SECTION(.app_stack)
+#define DB_SCOPE_READ_ACCESS          ACC_LEVEL_FACTORY
+#define DB_SCOPE_VALUE_MAX            (8)
+#define DB_SCOPE_NO_FRAME             (UINT8_MAX)
+
+struct db_scope_channel {
+  struct db_param *param;
+  uint16_t did;
+  uint16_t offset;              // Posicao dentro da amostra
+};
+
+static struct db_scope_channel g_channels[CONFIG_APP_SCOPE_MAX_CHANNELS];
+static struct db_raw_item g_raw[CONFIG_APP_SCOPE_MAX_CHANNELS];
+static uint8_t g_count;
+static uint16_t g_sample_size;
+static uint16_t g_frame_samples;   // Amostras por quadro
+static uint32_t g_period_ticks;
+
+static uint8_t __aligned(4) g_frames[CONFIG_APP_SCOPE_FRAMES][CONFIG_APP_SCOPE_FRAME_SIZE];
+static uint16_t g_frame_len[CONFIG_APP_SCOPE_FRAMES];
+static uint8_t g_layout[DB_SCOPE_HEADER_LEN + (CONFIG_APP_SCOPE_MAX_CHANNELS * DB_SCOPE_CHANNEL_LEN)];
+static uint16_t g_layout_len;
+
+K_MSGQ_DEFINE(db_scope_free_q, sizeof(uint8_t), CONFIG_APP_SCOPE_FRAMES, 1);
+K_MSGQ_DEFINE(db_scope_ready_q, sizeof(uint8_t), CONFIG_APP_SCOPE_FRAMES, 1);
+K_SEM_DEFINE(db_scope_run_sem, 0, 1);
+K_SEM_DEFINE(db_scope_idle_sem, 0, 1);
+K_TIMER_DEFINE(db_scope_timer, NULL, NULL);
+
+// Quadro em montagem: so a thread de amostragem mexe
+static uint8_t g_cur = DB_SCOPE_NO_FRAME;
+static uint16_t g_cur_samples;
+static uint32_t g_sample;       // Indice da proxima amostra
+static uint32_t g_seq;
+static uint8_t g_flags;
+static int64_t g_start_ticks;
+
+static struct sockaddr_in g_dest;
+static int g_sock = -1;
+static bool g_running;
+static bool g_started;
+static atomic_t g_stop;
+static struct db_scope_stats g_stats;
+static K_MUTEX_DEFINE(g_lock);
+
+static struct k_thread g_sample_thread;
+static struct k_thread g_send_thread;
+
+Z_KERNEL_STACK_DEFINE_IN(g_sample_stack, CONFIG_APP_SCOPE_STACK_SIZE, DB_SCOPE_STACK_MEM_ATTRIBUTES);
+Z_KERNEL_STACK_DEFINE_IN(g_send_stack, CONFIG_APP_SCOPE_STACK_SIZE, DB_SCOPE_STACK_MEM_ATTRIBUTES);
+
+static int db_scope_shell_cmd_start(const struct shell *shell, size_t argc, char **argv);
+static int db_scope_shell_cmd_stop(const struct shell *shell, size_t argc, char **argv);
+static int db_scope_shell_cmd_stats(const struct shell *shell, size_t argc, char **argv);
+
+SHELL_STATIC_SUBCMD_SET_CREATE(
+    scope_cmds,
+    SHELL_CMD_ARG(start, NULL, "stream to <ip> [port]", db_scope_shell_cmd_start, 2, 1),
+    SHELL_CMD(stop, NULL, "stop streaming", db_scope_shell_cmd_stop),
+    SHELL_CMD(stats, NULL, "scope statistics", db_scope_shell_cmd_stats), SHELL_SUBCMD_SET_END);
+
+SHELL_CMD_REGISTER(scope, &scope_cmds, "UDP scope commands", NULL);
+
+static void db_scope_put_header(uint8_t *buf, uint8_t type, uint8_t flags, uint32_t seq,
+                                uint32_t sample, uint64_t time_us) {
+  buf[0] = DB_SCOPE_VERSION;
+  buf[1] = type;
+  buf[2] = g_count;
+  buf[3] = flags;
+  sys_put_le32(seq, &buf[4]);
+  sys_put_le32(sample, &buf[8]);
+  sys_put_le64(time_us, &buf[12]);
+  sys_put_le32(k_ticks_to_us_near32(g_period_ticks), &buf[20]);
+  sys_put_le16(0, &buf[24]);
+  sys_put_le16(g_sample_size, &buf[26]);
+}
+
+// Pega um quadro livre e escreve o cabecalho; false com o anel cheio
+static bool db_scope_frame_open(int64_t now) {
+  if (k_msgq_get(&db_scope_free_q, &g_cur, K_NO_WAIT) != 0) {
+    g_cur = DB_SCOPE_NO_FRAME;
+    return false;
+  }
+
+  db_scope_put_header(g_frames[g_cur], DB_SCOPE_TYPE_DATA, g_flags, g_seq++, g_sample,
+                      k_ticks_to_us_floor64(now));
+  g_cur_samples = 0;
+  g_flags = 0;
+
+  return true;
+}
+
+static void db_scope_frame_commit(void) {
+  if (g_cur == DB_SCOPE_NO_FRAME) {
+    return;
+  }
+
+  if (g_cur_samples == 0) {
+    k_msgq_put(&db_scope_free_q, &g_cur, K_NO_WAIT);
+  } else {
+    sys_put_le16(g_cur_samples, &g_frames[g_cur][24]);
+    g_frame_len[g_cur] = DB_SCOPE_HEADER_LEN + (g_cur_samples * g_sample_size);
+
+    // As duas filas tem lugar para todos os quadros: nunca falha
+    k_msgq_put(&db_scope_ready_q, &g_cur, K_NO_WAIT);
+    g_stats.queue_peak = MAX(g_stats.queue_peak, k_msgq_num_used_get(&db_scope_ready_q));
+  }
+
+  g_cur = DB_SCOPE_NO_FRAME;
+}
+
+static void db_scope_sample(void) {
+  int64_t now = k_uptime_ticks();
+  int64_t late;
+  uint8_t *data;
+
+  if ((g_cur == DB_SCOPE_NO_FRAME) && !db_scope_frame_open(now)) {
+    g_stats.overruns++;
+    g_sample++;
+    return;
+  }
+
+  data = &g_frames[g_cur][DB_SCOPE_HEADER_LEN + (g_cur_samples * g_sample_size)];
+  for (uint8_t i = 0; i < g_count; i++) {
+    g_raw[i].data = &data[g_channels[i].offset];
+  }
+
+  // Uma tomada do lock por amostra; valores ja no lugar final do quadro. O lock
+  // e um k_sem (sem heranca de prioridade): quem o segura atrasa a amostra
+  db_param_get_raw_batch(DB_SCOPE_READ_ACCESS, g_raw, g_count);
+
+  late = now - (g_start_ticks + ((int64_t)(g_sample + 1) * g_period_ticks));
+  if (late > 0) {
+    g_stats.late_max_us = MAX(g_stats.late_max_us, k_ticks_to_us_floor32((uint32_t)late));
+  }
+
+  g_sample++;
+  g_cur_samples++;
+  g_stats.samples++;
+
+  if (g_cur_samples >= g_frame_samples) {
+    db_scope_frame_commit();
+  }
+}
+
+static void db_scope_sample_thread(void *p1, void *p2, void *p3) {
+  uint32_t expired;
+
+  ARG_UNUSED(p1);
+  ARG_UNUSED(p2);
+  ARG_UNUSED(p3);
+
+  while (true) {
+    k_sem_take(&db_scope_run_sem, K_FOREVER);
+
+    g_sample = 0;
+    g_flags = DB_SCOPE_FLAG_START;
+    g_start_ticks = k_uptime_ticks();
+    k_timer_start(&db_scope_timer, K_TICKS(g_period_ticks), K_TICKS(g_period_ticks));
+
+    // k_timer_stop() acorda a espera com 0; g_stop cobre o stop antes do start
+    while (!atomic_get(&g_stop) && ((expired = k_timer_status_sync(&db_scope_timer)) > 0)) {
+      // Ticks perdidos: o quadro fecha e o proximo comeca no indice certo
+      if (expired > 1) {
+        g_stats.missed += expired - 1;
+        g_sample += expired - 1;
+        db_scope_frame_commit();
+      }
+
+      db_scope_sample();
+    }
+
+    k_timer_stop(&db_scope_timer);
+    db_scope_frame_commit();
+    k_sem_give(&db_scope_idle_sem);
+  }
+}
+
+static void db_scope_send(const uint8_t *data, size_t len, const struct sockaddr_in *dest) {
+  ssize_t ret;
+
+  ret = zsock_sendto(g_sock, data, len, 0, (const struct sockaddr *)dest, sizeof(*dest));
+  if (ret < 0) {
+    g_stats.send_errors++;
+    return;
+  }
+
+  g_stats.frames++;
+  g_stats.bytes += ret;
+}
+
+static void db_scope_send_thread(void *p1, void *p2, void *p3) {
+  struct sockaddr_in dest;
+  int64_t next_layout = 0;
+  uint8_t idx;
+
+  ARG_UNUSED(p1);
+  ARG_UNUSED(p2);
+  ARG_UNUSED(p3);
+
+  while (true) {
+    k_msgq_get(&db_scope_ready_q, &idx, K_FOREVER);
+
+    k_mutex_lock(&g_lock, K_FOREVER);
+    dest = g_dest;
+
+    // Layout antes do primeiro quadro e de tempos em tempos para quem entra depois
+    if ((g_frames[idx][3] & DB_SCOPE_FLAG_START) || (k_uptime_get() >= next_layout)) {
+      db_scope_send(g_layout, g_layout_len, &dest);
+      next_layout = k_uptime_get() + CONFIG_APP_SCOPE_LAYOUT_MS;
+    }
+    k_mutex_unlock(&g_lock);
+
+    db_scope_send(g_frames[idx], g_frame_len[idx], &dest);
+
+    k_msgq_put(&db_scope_free_q, &idx, K_NO_WAIT);
+  }
+}
+
+static int db_scope_resolve(const char *host, uint16_t port, struct sockaddr_in *addr) {
+  addr->sin_family = AF_INET;
+  addr->sin_port = htons(port);
+
+  if (zsock_inet_pton(AF_INET, host, &addr->sin_addr) == 1) {
+    return 0;
+  }
+
+#if defined(CONFIG_DNS_RESOLVER)
+  struct zsock_addrinfo hints = {.ai_family = AF_INET, .ai_socktype = SOCK_DGRAM};
+  struct zsock_addrinfo *res;
+
+  if (zsock_getaddrinfo(host, NULL, &hints, &res) != 0) {
+    return -EHOSTUNREACH;
+  }
+
+  addr->sin_addr = ((struct sockaddr_in *)res->ai_addr)->sin_addr;
+  zsock_freeaddrinfo(res);
+
+  return 0;
+#else
+  return -EHOSTUNREACH;
+#endif
+}
+
+// Chamado com g_lock: descricao dos canais enviada no quadro de layout
+static void db_scope_build_layout(void) {
+  uint8_t *pos = &g_layout[DB_SCOPE_HEADER_LEN];
+
+  db_scope_put_header(g_layout, DB_SCOPE_TYPE_LAYOUT, 0, 0, 0, 0);
+
+  for (uint8_t i = 0; i < g_count; i++) {
+    sys_put_le16(g_channels[i].did, &pos[0]);
+    pos[2] = g_channels[i].param->config.info.type;
+    pos[3] = g_channels[i].param->config.var_size;
+    pos += DB_SCOPE_CHANNEL_LEN;
+  }
+
+  g_layout_len = pos - g_layout;
+}
+
+/**
+ * @brief Acrescenta um parametro numerico a cada amostra
+ *
+ * Os canais sao fixos enquanto o streaming roda. Strings e senhas nao sao
+ * aceitas.
+ */
+int db_scope_add(db_group_id_t group_id, db_param_id_t param_id) {
+  struct db_group *group;
+  struct db_param *param;
+  struct db_scope_channel *channel;
+  uint16_t len;
+  int ret = 0;
+
+  if (db_get_var_config(&group, &param, group_id, param_id) != 0) {
+    return -ENOENT;
+  }
+
+  len = param->config.var_size;
+  if ((param->config.info.type == eSTR) || (param->config.info.type == eVOID) ||
+      (len > DB_SCOPE_VALUE_MAX)) {
+    return -ENOTSUP;
+  }
+
+  if (param->config.info.field == VAR_FIELD_PWD) {
+    return -EACCES;
+  }
+
+  k_mutex_lock(&g_lock, K_FOREVER);
+
+  if (g_running) {
+    ret = -EBUSY;
+  } else if ((g_count >= ARRAY_SIZE(g_channels)) ||
+             ((DB_SCOPE_HEADER_LEN + g_sample_size + len) > CONFIG_APP_SCOPE_FRAME_SIZE)) {
+    ret = -ENOMEM;
+  } else {
+    channel = &g_channels[g_count];
+    channel->param = param;
+    channel->did = DB_SCOPE_DID(group_id, param_id);
+    channel->offset = g_sample_size;
+
+    g_raw[g_count].param = param;
+    g_raw[g_count].len = len;
+
+    g_sample_size += len;
+    g_count++;
+  }
+
+  k_mutex_unlock(&g_lock);
+
+  return ret;
+}
+
+/**
+ * @brief Cria o socket e as threads; o streaming comeca com db_scope_start()
+ */
+int db_scope_init(void) {
+  uint8_t idx;
+
+  if (g_started) {
+    return 0;
+  }
+
+  g_sock = zsock_socket(AF_INET, SOCK_DGRAM, IPPROTO_UDP);
+  if (g_sock < 0) {
+    LOG_ERR("Socket: %d", -errno);
+    return -errno;
+  }
+
+  for (idx = 0; idx < CONFIG_APP_SCOPE_FRAMES; idx++) {
+    k_msgq_put(&db_scope_free_q, &idx, K_NO_WAIT);
+  }
+
+  g_period_ticks = MAX(k_us_to_ticks_ceil32(CONFIG_APP_SCOPE_PERIOD_US), 1);
+
+  k_thread_create(&g_sample_thread, g_sample_stack, K_KERNEL_STACK_SIZEOF(g_sample_stack),
+                  db_scope_sample_thread, NULL, NULL, NULL, CONFIG_APP_SCOPE_SAMPLE_PRIORITY, 0,
+                  K_NO_WAIT);
+  k_thread_name_set(&g_sample_thread, "scope_sample");
+
+  k_thread_create(&g_send_thread, g_send_stack, K_KERNEL_STACK_SIZEOF(g_send_stack),
+                  db_scope_send_thread, NULL, NULL, NULL, CONFIG_APP_SCOPE_SEND_PRIORITY, 0,
+                  K_NO_WAIT);
+  k_thread_name_set(&g_send_thread, "scope_send");
+
+  g_started = true;
+
+  return 0;
+}
+
+/**
+ * @brief Comeca a amostrar e enviar para host:port
+ *
+ * O periodo e CONFIG_APP_SCOPE_PERIOD_US arredondado para ticks do kernel;
+ * o valor real vai no cabecalho de cada quadro.
+ */
+int db_scope_start(const char *host, uint16_t port) {
+  struct sockaddr_in dest = {0};
+  int ret;
+
+  if (!host) {
+    return -EINVAL;
+  }
+
+  if (!g_started) {
+    return -EAGAIN;
+  }
+
+  ret = db_scope_resolve(host, port, &dest);
+  if (ret != 0) {
+    return ret;
+  }
+
+  k_mutex_lock(&g_lock, K_FOREVER);
+
+  if (g_running) {
+    ret = -EALREADY;
+  } else if (g_count == 0) {
+    ret = -ENOENT;
+  } else {
+    g_dest = dest;
+    g_frame_samples = (CONFIG_APP_SCOPE_FRAME_SIZE - DB_SCOPE_HEADER_LEN) / g_sample_size;
+    db_scope_build_layout();
+    g_running = true;
+    atomic_clear(&g_stop);
+    k_sem_give(&db_scope_run_sem);
+  }
+
+  k_mutex_unlock(&g_lock);
+
+  if (ret == 0) {
+    LOG_INF("Streaming %u channels every %u us to %s:%u", g_count,
+            k_ticks_to_us_near32(g_period_ticks), host, port);
+  }
+
+  return ret;
+}
+
+/**
+ * @brief Para a amostragem; o quadro incompleto ainda e enviado
+ */
+int db_scope_stop(void) {
+  int ret = 0;
+
+  k_mutex_lock(&g_lock, K_FOREVER);
+
+  if (!g_running) {
+    ret = -EALREADY;
+  } else {
+    atomic_set(&g_stop, 1);
+    k_timer_stop(&db_scope_timer);
+    k_sem_take(&db_scope_idle_sem, K_FOREVER);
+    g_running = false;
+  }
+
+  k_mutex_unlock(&g_lock);
+
+  return ret;
+}
+
+int db_scope_get_stats(struct db_scope_stats *stats) {
+  if (!stats) {
+    return -EINVAL;
+  }
+
+  k_mutex_lock(&g_lock, K_FOREVER);
+  *stats = g_stats;
+  stats->running = g_running;
+  stats->channels = g_count;
+  stats->sample_size = g_sample_size;
+  k_mutex_unlock(&g_lock);
+
+  return 0;
+}
+
+static int db_scope_shell_cmd_start(const struct shell *shell, size_t argc, char **argv) {
+  uint16_t port = (argc > 2) ? strtoul(argv[2], NULL, 10) : CONFIG_APP_SCOPE_PORT;
+  int ret;
+
+  ret = db_scope_start(argv[1], port);
+  if (ret != 0) {
+    shell_error(shell, "start failed: %d", ret);
+    return ret;
+  }
+
+  shell_print(shell, "streaming to %s:%u", argv[1], port);
+  return 0;
+}
+
+static int db_scope_shell_cmd_stop(const struct shell *shell, size_t argc, char **argv) {
+  ARG_UNUSED(argc);
+  ARG_UNUSED(argv);
+
+  return db_scope_stop();
+}
+
+static int db_scope_shell_cmd_stats(const struct shell *shell, size_t argc, char **argv) {
+  struct db_scope_stats stats;
+
+  ARG_UNUSED(argc);
+  ARG_UNUSED(argv);
+
+  db_scope_get_stats(&stats);
+
+  shell_print(shell, "%s, %u channels, %u bytes/sample, period %u us",
+              stats.running ? "running" : "stopped", stats.channels, stats.sample_size,
+              k_ticks_to_us_near32(g_period_ticks));
+  shell_print(shell, "samples: %u, missed ticks: %u, late max: %u us", stats.samples,
+              stats.missed, stats.late_max_us);
+  shell_print(shell, "frames: %u (%u bytes), send errors: %u", stats.frames, stats.bytes,
+              stats.send_errors);
+  shell_print(shell, "queue: peak %u/%u, overruns: %u samples", stats.queue_peak,
+              CONFIG_APP_SCOPE_FRAMES, stats.overruns);
+
+  return 0;
+}
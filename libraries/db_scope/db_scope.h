@@ -0,0 +1,63 @@
+#ifndef _DB_SCOPE_H
+#define _DB_SCOPE_H
+
+/* C++ detection */
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <zephyr/sys/util.h>
+#include "database.h"
+
+/*
+ * Formato binario (little endian), um datagrama UDP por quadro:
+ *
+ *   Cabecalho: | versao (1) | tipo (1) | canais (1) | flags (1) | seq (4) |
+ *              | amostra (4) | tempo us (8) | periodo us (4) | amostras (2) | tamanho (2) |
+ *   Dados:     amostras x tamanho bytes; cada amostra tem os canais na ordem
+ *              de db_scope_add(), valores na ordem de bytes da CPU
+ *   Layout:    canais x | did (2) | tipo (1) | tamanho (1) |   (amostras = 0)
+ *
+ * seq conta os quadros e amostra o indice da primeira amostra desde o start:
+ * quadros perdidos aparecem como salto em seq e amostras perdidas (fila
+ * cheia ou tick perdido) como salto em amostra. tempo e o uptime da primeira
+ * amostra; as seguintes estao a periodo us uma da outra. O layout sai antes
+ * do primeiro quadro e depois a cada CONFIG_APP_SCOPE_LAYOUT_MS. did e tipo
+ * seguem o UDS e enum variable_type.
+ */
+#define DB_SCOPE_VERSION          (1)
+#define DB_SCOPE_HEADER_LEN       (28)
+#define DB_SCOPE_CHANNEL_LEN      (4)
+#define DB_SCOPE_TYPE_DATA        (0)
+#define DB_SCOPE_TYPE_LAYOUT      (1)
+#define DB_SCOPE_FLAG_START       BIT(0)   // Primeiro quadro depois do start
+#define DB_SCOPE_DID(group, param) ((uint16_t)(((group) << 8) | ((param) & 0xFF)))
+
+struct db_scope_stats {
+  bool running;
+  uint8_t channels;
+  uint16_t sample_size;         // Bytes por amostra
+  uint32_t samples;             // Amostras gravadas
+  uint32_t frames;              // Datagramas enviados (com os de layout)
+  uint32_t bytes;
+  uint32_t missed;              // Ticks do timer sem amostra (thread atrasada)
+  uint32_t overruns;            // Amostras perdidas com a fila de quadros cheia
+  uint32_t send_errors;
+  uint32_t late_max_us;         // Maior atraso de uma amostra sobre o tick
+  uint16_t queue_peak;          // Maior numero de quadros esperando envio
+};
+
+int db_scope_add(db_group_id_t group_id, db_param_id_t param_id);
+int db_scope_init(void);
+int db_scope_start(const char *host, uint16_t port);
+int db_scope_stop(void);
+int db_scope_get_stats(struct db_scope_stats *stats);
+
+/* C++ detection */
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* _DB_SCOPE_H */
@@ -0,0 +1,192 @@
+#include "file_io.h"
+
+#include <string.h>
+#include <zephyr/logging/log.h>
+
+LOG_MODULE_REGISTER(file_io, CONFIG_LOG_DEFAULT_LEVEL);
+
+static int file_io_execute(struct file_io_request *request);
+static void file_io_complete(struct file_io *io, struct file_io_request *request,
+                             uint32_t wait_us, uint32_t exec_us, bool expired);
+static void file_io_thread(void *p1, void *p2, void *p3);
+
+static int file_io_execute(struct file_io_request *request) {
+  int ret;
+
+  switch (request->op) {
+  case FILE_IO_OPEN:
+    fs_file_t_init(request->file);
+    return fs_open(request->file, request->path, request->flags);
+
+  case FILE_IO_APPEND:
+    ret = fs_seek(request->file, 0, FS_SEEK_END);
+    if (ret != 0) {
+      return ret;
+    }
+    return fs_write(request->file, request->buffer, request->length);
+
+  case FILE_IO_READ:
+    if (request->offset >= 0) {
+      ret = fs_seek(request->file, request->offset, FS_SEEK_SET);
+      if (ret != 0) {
+        return ret;
+      }
+    }
+    // Leitura direto no buffer do chamador
+    return fs_read(request->file, request->buffer, request->length);
+
+  case FILE_IO_CLOSE:
+    return fs_close(request->file);
+
+  case FILE_IO_SYNC:
+    return fs_sync(request->file);
+
+  case FILE_IO_STAT:
+    return fs_stat(request->path, request->buffer);
+
+  case FILE_IO_TRUNCATE:
+    return fs_truncate(request->file, request->length);
+
+  default:
+    return -ENOTSUP;
+  }
+}
+
+static void file_io_complete(struct file_io *io, struct file_io_request *request,
+                             uint32_t wait_us, uint32_t exec_us, bool expired) {
+  struct file_io_op_stats *stats = &io->stats[request->op];
+  k_spinlock_key_t key;
+
+  key = k_spin_lock(&io->lock);
+
+  if (expired) {
+    stats->timeouts++;
+  } else {
+    stats->count++;
+    stats->total_us += exec_us;
+    if (request->result < 0) {
+      stats->errors++;
+    }
+    if (exec_us > stats->max_us) {
+      stats->max_us = exec_us;
+    }
+  }
+
+  if (wait_us > stats->max_wait_us) {
+    stats->max_wait_us = wait_us;
+  }
+
+  k_spin_unlock(&io->lock, key);
+
+  if (request->signal) {
+    k_poll_signal_raise(request->signal, request->result);
+  }
+
+  if (request->callback) {
+    request->callback(request, request->user_data);
+  }
+}
+
+static void file_io_thread(void *p1, void *p2, void *p3) {
+  struct file_io *io = p1;
+  struct file_io_request *request;
+  uint32_t start;
+  uint32_t wait_us;
+  uint32_t exec_us;
+  bool expired;
+
+  ARG_UNUSED(p2);
+  ARG_UNUSED(p3);
+
+  while (1) {
+    k_msgq_get(&io->queue, &request, K_FOREVER);
+
+    start = k_cycle_get_32();
+    wait_us = k_cyc_to_us_floor32(start - request->submit_cycles);
+
+    // Pedido que perdeu o prazo nao chega a tocar no cartao
+    expired = (request->deadline != 0) && (k_uptime_get() > request->deadline);
+    if (expired) {
+      request->result = -ETIMEDOUT;
+      exec_us = 0;
+    } else {
+      request->result = file_io_execute(request);
+      exec_us = k_cyc_to_us_floor32(k_cycle_get_32() - start);
+    }
+
+    file_io_complete(io, request, wait_us, exec_us, expired);
+  }
+}
+
+int file_io_init(struct file_io *io, const char *name) {
+  if (!io) {
+    return -EINVAL;
+  }
+
+  // A thread nunca termina: reiniciar (ex.: sdcard_init apos deinit) manteria
+  // dois donos para a mesma fila
+  if (io->started) {
+    return 0;
+  }
+
+  memset(io, 0, offsetof(struct file_io, thread));
+
+  k_msgq_init(&io->queue, io->queue_buffer, sizeof(struct file_io_request *),
+              FILE_IO_QUEUE_SIZE);
+
+  k_thread_create(&io->thread, io->stack, K_KERNEL_STACK_SIZEOF(io->stack), file_io_thread,
+                  io, NULL, NULL, FILE_IO_THREAD_PRIORITY, 0, K_NO_WAIT);
+  k_thread_name_set(&io->thread, name ? name : "file_io");
+  io->started = true;
+
+  return 0;
+}
+
+// Nao bloqueia: com a fila cheia retorna -ENOMEM e o pedido nao e executado
+int file_io_submit(struct file_io *io, struct file_io_request *request) {
+  k_spinlock_key_t key;
+  int ret;
+
+  if (!io || !request || (request->op >= FILE_IO_OP_COUNT) ||
+      (!request->file && (request->op != FILE_IO_STAT)) ||
+      (((request->op == FILE_IO_OPEN) || (request->op == FILE_IO_STAT)) && !request->path) ||
+      ((request->op == FILE_IO_STAT) && !request->buffer) ||
+      (((request->op == FILE_IO_READ) || (request->op == FILE_IO_APPEND)) &&
+       !request->buffer && request->length)) {
+    return -EINVAL;
+  }
+
+  request->result = -EINPROGRESS;
+  request->submit_cycles = k_cycle_get_32();
+  if (request->signal) {
+    k_poll_signal_reset(request->signal);
+  }
+
+  ret = k_msgq_put(&io->queue, &request, K_NO_WAIT);
+  if (ret != 0) {
+    key = k_spin_lock(&io->lock);
+    io->rejected++;
+    k_spin_unlock(&io->lock, key);
+    return -ENOMEM;
+  }
+
+  return 0;
+}
+
+int file_io_get_stats(struct file_io *io, enum file_io_op op, struct file_io_op_stats *stats) {
+  k_spinlock_key_t key;
+
+  if (!io || !stats || (op >= FILE_IO_OP_COUNT)) {
+    return -EINVAL;
+  }
+
+  key = k_spin_lock(&io->lock);
+  *stats = io->stats[op];
+  k_spin_unlock(&io->lock, key);
+
+  return 0;
+}
+
+uint32_t file_io_get_rejected(struct file_io *io) {
+  return io ? io->rejected : 0;
+}
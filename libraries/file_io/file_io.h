@@ -0,0 +1,84 @@
+#ifndef _FILE_IO_H
+#define _FILE_IO_H
+
+/* C++ detection */
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <zephyr/fs/fs.h>
+#include <zephyr/kernel.h>
+
+#define FILE_IO_QUEUE_SIZE      (16)
+#define FILE_IO_STACK_SIZE      (2048)
+#define FILE_IO_THREAD_PRIORITY (K_LOWEST_APPLICATION_THREAD_PRIO - 1)
+
+enum file_io_op {
+  FILE_IO_OPEN,
+  FILE_IO_APPEND,
+  FILE_IO_READ,
+  FILE_IO_CLOSE,
+  FILE_IO_SYNC,
+  FILE_IO_STAT,                 // Sem arquivo: so path e buffer
+  FILE_IO_TRUNCATE,             // Tamanho em length
+  FILE_IO_OP_COUNT,
+};
+
+struct file_io_request;
+
+// Chamado na thread de I/O; pode submeter o proximo pedido (encadeamento)
+typedef void (*file_io_done_cb_t)(struct file_io_request *request, void *user_data);
+
+/*
+ * Pedido assincrono. A memoria do pedido, do arquivo, do caminho e do buffer
+ * pertence a quem chama e deve continuar valida ate a conclusao.
+ */
+struct file_io_request {
+  enum file_io_op op;
+  struct fs_file_t *file;       // Arquivo do chamador (fs_file_t_init feito pelo OPEN)
+  const char *path;             // OPEN/STAT: caminho
+  fs_mode_t flags;              // OPEN: FS_O_*
+  void *buffer;                 // READ: destino (sem copia) / APPEND: origem / STAT: fs_dirent
+  size_t length;                // READ/APPEND: bytes / TRUNCATE: novo tamanho
+  off_t offset;                 // READ: posicao absoluta, < 0 = posicao atual
+  int64_t deadline;             // k_uptime_get() limite para iniciar, 0 = sem limite
+  file_io_done_cb_t callback;   // Opcional
+  void *user_data;
+  struct k_poll_signal *signal; // Opcional, sinalizado com o resultado
+  int result;                   // Bytes transferidos ou erro negativo
+  uint32_t submit_cycles;       // Uso interno
+};
+
+struct file_io_op_stats {
+  uint32_t count;               // Pedidos executados
+  uint32_t errors;              // Pedidos com erro
+  uint32_t timeouts;            // Pedidos descartados por deadline
+  uint32_t max_wait_us;         // Maior espera na fila
+  uint32_t max_us;              // Maior tempo de execucao
+  uint64_t total_us;            // Soma dos tempos de execucao
+};
+
+struct file_io {
+  struct k_msgq queue;
+  char __aligned(4) queue_buffer[FILE_IO_QUEUE_SIZE * sizeof(struct file_io_request *)];
+  struct k_spinlock lock;
+  struct file_io_op_stats stats[FILE_IO_OP_COUNT];
+  uint32_t rejected;            // Pedidos recusados (fila cheia)
+  bool started;                 // Thread criada; um novo init nao faz nada
+  struct k_thread thread;
+  K_KERNEL_STACK_MEMBER(stack, FILE_IO_STACK_SIZE);
+};
+
+int file_io_init(struct file_io *io, const char *name);
+int file_io_submit(struct file_io *io, struct file_io_request *request);
+int file_io_get_stats(struct file_io *io, enum file_io_op op, struct file_io_op_stats *stats);
+uint32_t file_io_get_rejected(struct file_io *io);
+
+/* C++ detection */
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* _FILE_IO_H */
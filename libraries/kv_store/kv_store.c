@@ -0,0 +1,398 @@
+#include "kv_store.h"
+
+#include <string.h>
+#include <zephyr/sys/crc.h>
+
+#include "eeprom_lib.h"
+
+#define KV_FLAG_DELETED      BIT(0)
+#define KV_ENTRY_SIZE(len)   (sizeof(struct kv_store_entry_header) + (len) + sizeof(uint16_t))
+#define KV_SECTOR_DATA(kv)   ((kv)->sector_size - sizeof(struct kv_store_sector_header))
+
+static size_t kv_sector_addr(struct kv_store *kv, uint8_t sector);
+static uint16_t kv_entry_crc(uint32_t generation, const struct kv_store_entry_header *header,
+                             const uint8_t *value);
+static int kv_sector_read_header(struct kv_store *kv, uint8_t sector, uint32_t *generation);
+static int kv_sector_format(struct kv_store *kv, uint8_t sector, uint32_t generation);
+static int kv_sector_invalidate(struct kv_store *kv, uint8_t sector);
+static void kv_index_apply(struct kv_store *kv, const struct kv_store_entry_header *header,
+                           uint32_t offset);
+static size_t kv_sector_scan(struct kv_store *kv, uint8_t sector, uint32_t generation);
+static int kv_append(struct kv_store *kv, uint16_t key, uint8_t flags, const void *value,
+                     uint8_t length);
+static int kv_collect(struct kv_store *kv);
+static int kv_reserve(struct kv_store *kv, size_t size);
+
+static size_t kv_sector_addr(struct kv_store *kv, uint8_t sector) {
+  return kv->base + (sector * kv->sector_size);
+}
+
+static uint16_t kv_entry_crc(uint32_t generation, const struct kv_store_entry_header *header,
+                             const uint8_t *value) {
+  uint16_t crc;
+
+  crc = crc16_ccitt(0xFFFF, (const uint8_t *)&generation, sizeof(generation));
+  crc = crc16_ccitt(crc, (const uint8_t *)header, sizeof(*header));
+  return crc16_ccitt(crc, value, header->length);
+}
+
+static int kv_sector_read_header(struct kv_store *kv, uint8_t sector, uint32_t *generation) {
+  struct kv_store_sector_header header;
+  int ret;
+
+  ret = eeprom_lib_read(kv_sector_addr(kv, sector), &header, sizeof(header));
+  if (ret) {
+    return ret;
+  }
+
+  if ((header.magic != KV_STORE_SECTOR_MAGIC) ||
+      (crc16_ccitt(0xFFFF, (const uint8_t *)&header, offsetof(struct kv_store_sector_header, crc)) !=
+       header.crc)) {
+    return -ENOENT;
+  }
+
+  *generation = header.generation;
+
+  return 0;
+}
+
+static int kv_sector_format(struct kv_store *kv, uint8_t sector, uint32_t generation) {
+  struct kv_store_sector_header header = {
+      .magic = KV_STORE_SECTOR_MAGIC,
+      .generation = generation,
+  };
+
+  header.crc = crc16_ccitt(0xFFFF, (const uint8_t *)&header,
+                           offsetof(struct kv_store_sector_header, crc));
+
+  return eeprom_lib_write(kv_sector_addr(kv, sector), &header, sizeof(header));
+}
+
+// Na EEPROM nao ha apagamento: basta destruir o header do setor
+static int kv_sector_invalidate(struct kv_store *kv, uint8_t sector) {
+  struct kv_store_sector_header header = {0};
+
+  return eeprom_lib_write(kv_sector_addr(kv, sector), &header, sizeof(header));
+}
+
+static void kv_index_apply(struct kv_store *kv, const struct kv_store_entry_header *header,
+                           uint32_t offset) {
+  struct kv_store_index *index;
+
+  if (header->key >= KV_STORE_MAX_KEYS) {
+    return;
+  }
+
+  index = &kv->index[header->key];
+  if (index->valid) {
+    kv->live_bytes -= KV_ENTRY_SIZE(index->length);
+  }
+
+  index->sequence = header->sequence;
+  index->valid = !(header->flags & KV_FLAG_DELETED);
+  if (index->valid) {
+    index->offset = offset + sizeof(*header);
+    index->length = header->length;
+    kv->live_bytes += KV_ENTRY_SIZE(header->length);
+  }
+}
+
+// Varredura sequencial do setor; retorna a posicao apos a ultima entrada valida
+static size_t kv_sector_scan(struct kv_store *kv, uint8_t sector, uint32_t generation) {
+  struct kv_store_entry_header header;
+  uint8_t value[KV_STORE_MAX_VALUE + sizeof(uint16_t)];
+  size_t addr = kv_sector_addr(kv, sector);
+  size_t offset = sizeof(struct kv_store_sector_header);
+  uint16_t crc;
+
+  while (offset + KV_ENTRY_SIZE(0) <= kv->sector_size) {
+    if (eeprom_lib_read(addr + offset, &header, sizeof(header)) ||
+        (header.length > KV_STORE_MAX_VALUE) ||
+        (offset + KV_ENTRY_SIZE(header.length) > kv->sector_size) ||
+        eeprom_lib_read(addr + offset + sizeof(header), value, header.length + sizeof(crc))) {
+      break;
+    }
+
+    memcpy(&crc, &value[header.length], sizeof(crc));
+    if (crc != kv_entry_crc(generation, &header, value)) {
+      break;
+    }
+
+    if ((header.key < KV_STORE_MAX_KEYS) &&
+        (header.sequence >= kv->index[header.key].sequence)) {
+      kv_index_apply(kv, &header, addr + offset);
+    }
+    kv->sequence = MAX(kv->sequence, header.sequence);
+
+    offset += KV_ENTRY_SIZE(header.length);
+  }
+
+  return offset;
+}
+
+static int kv_append(struct kv_store *kv, uint16_t key, uint8_t flags, const void *value,
+                     uint8_t length) {
+  uint8_t buf[KV_ENTRY_SIZE(KV_STORE_MAX_VALUE)];
+  struct kv_store_entry_header header = {
+      .key = key,
+      .length = length,
+      .flags = flags,
+      .sequence = kv->sequence + 1,
+  };
+  size_t addr = kv_sector_addr(kv, kv->active) + kv->write_offset;
+  uint16_t crc;
+  int ret;
+
+  memcpy(buf, &header, sizeof(header));
+  if (length) {
+    memcpy(&buf[sizeof(header)], value, length);
+  }
+  crc = kv_entry_crc(kv->generation, &header, &buf[sizeof(header)]);
+  memcpy(&buf[sizeof(header) + length], &crc, sizeof(crc));
+
+  ret = eeprom_lib_write(addr, buf, KV_ENTRY_SIZE(length));
+  if (ret) {
+    return ret;
+  }
+
+  kv->sequence++;
+  kv->write_offset += KV_ENTRY_SIZE(length);
+  kv->stats.writes++;
+  kv_index_apply(kv, &header, addr);
+
+  return 0;
+}
+
+// Copia as entradas vivas do setor mais antigo para o ativo e o libera. A
+// ordem (copias, sync, invalidacao, sync) garante que uma queda de energia
+// nunca perca a ultima versao de uma chave.
+static int kv_collect(struct kv_store *kv) {
+  uint8_t value[KV_STORE_MAX_VALUE];
+  uint8_t oldest = (kv->active + 1) % kv->sector_count;
+  size_t start = kv_sector_addr(kv, oldest);
+  size_t end = start + kv->sector_size;
+  struct kv_store_index *index;
+  uint32_t generation;
+  int ret;
+
+  // Setor ainda nao usado desde a formatacao: nada a recolher
+  if (kv_sector_read_header(kv, oldest, &generation) != 0) {
+    return 0;
+  }
+
+  for (uint16_t key = 0; key < KV_STORE_MAX_KEYS; key++) {
+    index = &kv->index[key];
+    if (!index->valid || (index->offset < start) || (index->offset >= end)) {
+      continue;
+    }
+
+    if (kv->write_offset + KV_ENTRY_SIZE(index->length) > kv->sector_size) {
+      return -ENOSPC;
+    }
+
+    ret = eeprom_lib_read(index->offset, value, index->length);
+    if (ret == 0) {
+      ret = kv_append(kv, key, 0, value, index->length);
+    }
+    if (ret) {
+      return ret;
+    }
+    kv->stats.relocated++;
+  }
+
+  ret = eeprom_lib_sync();
+  if (ret == 0) {
+    ret = kv_sector_invalidate(kv, oldest);
+  }
+  if (ret == 0) {
+    ret = eeprom_lib_sync();
+  }
+
+  kv->stats.compactions++;
+
+  return ret;
+}
+
+// Garante espaco para uma entrada, trocando de setor se necessario
+static int kv_reserve(struct kv_store *kv, size_t size) {
+  uint8_t next;
+  int ret;
+
+  if (kv->write_offset + size <= kv->sector_size) {
+    return 0;
+  }
+
+  next = (kv->active + 1) % kv->sector_count;
+  ret = kv_sector_format(kv, next, kv->generation + 1);
+  if (ret) {
+    return ret;
+  }
+
+  kv->generation++;
+  kv->active = next;
+  kv->write_offset = sizeof(struct kv_store_sector_header);
+
+  ret = kv_collect(kv);
+  if (ret) {
+    return ret;
+  }
+
+  return (kv->write_offset + size <= kv->sector_size) ? 0 : -ENOSPC;
+}
+
+int kv_store_init(struct kv_store *kv, size_t base, size_t sector_size, uint8_t sector_count) {
+  uint32_t generations[KV_STORE_MAX_SECTORS];
+  uint8_t valid = 0;
+  uint8_t scanned = 0;
+  uint8_t next;
+  int ret = 0;
+
+  if (!kv || (sector_count < 2) || (sector_count > KV_STORE_MAX_SECTORS) ||
+      (sector_size < sizeof(struct kv_store_sector_header) + KV_ENTRY_SIZE(KV_STORE_MAX_VALUE))) {
+    return -EINVAL;
+  }
+
+  memset(kv, 0, sizeof(struct kv_store));
+  k_mutex_init(&kv->mutex);
+  kv->base = base;
+  kv->sector_size = sector_size;
+  kv->sector_count = sector_count;
+
+  for (uint8_t s = 0; s < sector_count; s++) {
+    if (kv_sector_read_header(kv, s, &generations[s]) == 0) {
+      valid |= BIT(s);
+    }
+  }
+
+  if (valid == 0) {
+    kv->generation = 1;
+    kv->active = 0;
+    kv->write_offset = sizeof(struct kv_store_sector_header);
+    return kv_sector_format(kv, 0, kv->generation);
+  }
+
+  // Uma unica passada, do setor mais antigo para o mais novo
+  while (scanned != valid) {
+    next = 0xFF;
+    for (uint8_t s = 0; s < sector_count; s++) {
+      if ((valid & ~scanned & BIT(s)) &&
+          ((next == 0xFF) || (generations[s] < generations[next]))) {
+        next = s;
+      }
+    }
+
+    scanned |= BIT(next);
+    kv->active = next;
+    kv->generation = generations[next];
+    kv->write_offset = kv_sector_scan(kv, next, generations[next]);
+  }
+
+  // Sem setor livre: a ultima compactacao foi interrompida
+  if (valid == BIT_MASK(sector_count)) {
+    ret = kv_collect(kv);
+  }
+
+  return ret;
+}
+
+// Valor igual ao gravado nao gera escrita (desgaste)
+int kv_store_write(struct kv_store *kv, uint16_t key, const void *value, uint8_t length) {
+  uint8_t current[KV_STORE_MAX_VALUE];
+  struct kv_store_index *index;
+  size_t live;
+  int ret;
+
+  if (!kv || !value || (key >= KV_STORE_MAX_KEYS) || (length == 0) ||
+      (length > KV_STORE_MAX_VALUE)) {
+    return -EINVAL;
+  }
+
+  k_mutex_lock(&kv->mutex, K_FOREVER);
+
+  index = &kv->index[key];
+  if (index->valid && (index->length == length) &&
+      (eeprom_lib_read(index->offset, current, length) == 0) &&
+      (memcmp(current, value, length) == 0)) {
+    kv->stats.unchanged++;
+    k_mutex_unlock(&kv->mutex);
+    return 0;
+  }
+
+  // A versao antiga continua viva ate a nova ser gravada
+  live = kv->live_bytes + KV_ENTRY_SIZE(length);
+  if (live > KV_SECTOR_DATA(kv)) {
+    k_mutex_unlock(&kv->mutex);
+    return -ENOSPC;
+  }
+
+  ret = kv_reserve(kv, KV_ENTRY_SIZE(length));
+  if (ret == 0) {
+    ret = kv_append(kv, key, 0, value, length);
+  }
+
+  k_mutex_unlock(&kv->mutex);
+
+  return ret;
+}
+
+// Retorna o numero de bytes copiados ou -ENOENT
+int kv_store_read(struct kv_store *kv, uint16_t key, void *value, uint8_t length) {
+  struct kv_store_index *index;
+  uint8_t count;
+  int ret;
+
+  if (!kv || !value || (key >= KV_STORE_MAX_KEYS)) {
+    return -EINVAL;
+  }
+
+  k_mutex_lock(&kv->mutex, K_FOREVER);
+
+  index = &kv->index[key];
+  if (!index->valid) {
+    k_mutex_unlock(&kv->mutex);
+    return -ENOENT;
+  }
+
+  count = MIN(length, index->length);
+  ret = eeprom_lib_read(index->offset, value, count);
+
+  k_mutex_unlock(&kv->mutex);
+
+  return ret ? ret : count;
+}
+
+int kv_store_delete(struct kv_store *kv, uint16_t key) {
+  int ret;
+
+  if (!kv || (key >= KV_STORE_MAX_KEYS)) {
+    return -EINVAL;
+  }
+
+  k_mutex_lock(&kv->mutex, K_FOREVER);
+
+  if (!kv->index[key].valid) {
+    k_mutex_unlock(&kv->mutex);
+    return 0;
+  }
+
+  ret = kv_reserve(kv, KV_ENTRY_SIZE(0));
+  if (ret == 0) {
+    ret = kv_append(kv, key, KV_FLAG_DELETED, NULL, 0);
+  }
+
+  k_mutex_unlock(&kv->mutex);
+
+  return ret;
+}
+
+int kv_store_get_stats(struct kv_store *kv, struct kv_store_stats *stats) {
+  if (!kv || !stats) {
+    return -EINVAL;
+  }
+
+  k_mutex_lock(&kv->mutex, K_FOREVER);
+  *stats = kv->stats;
+  k_mutex_unlock(&kv->mutex);
+
+  return 0;
+}
@@ -0,0 +1,79 @@
+#ifndef _KV_STORE_H
+#define _KV_STORE_H
+
+/* C++ detection */
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <zephyr/kernel.h>
+
+#define KV_STORE_MAX_KEYS      (32)
+#define KV_STORE_MAX_VALUE     (32)
+#define KV_STORE_MAX_SECTORS   (8)
+#define KV_STORE_SECTOR_MAGIC  (0x4B565331) // "KVS1"
+
+/*
+ * Armazenamento log-structured sobre o eeprom_lib. A regiao e dividida em
+ * setores usados em anel; as entradas sao sempre acrescentadas no setor ativo,
+ * espalhando o desgaste. Um setor fica sempre livre: ao trocar de setor as
+ * entradas vivas do mais antigo sao copiadas para o novo e ele e invalidado.
+ * O crc de cada entrada inclui a geracao do setor, entao restos de uma
+ * geracao anterior nunca sao aceitos.
+ */
+struct kv_store_sector_header {
+  uint32_t magic;
+  uint32_t generation;
+  uint16_t crc;
+} __packed;
+
+// Seguido por length bytes de valor e crc16
+struct kv_store_entry_header {
+  uint16_t key;
+  uint8_t length;
+  uint8_t flags;
+  uint32_t sequence;
+} __packed;
+
+struct kv_store_index {
+  uint32_t offset;             // Endereco absoluto do valor
+  uint32_t sequence;
+  uint8_t length;
+  bool valid;
+};
+
+struct kv_store_stats {
+  uint32_t writes;             // Entradas gravadas
+  uint32_t unchanged;          // Escritas evitadas (valor igual)
+  uint32_t compactions;        // Trocas de setor
+  uint32_t relocated;          // Entradas copiadas na compactacao
+};
+
+struct kv_store {
+  struct k_mutex mutex;
+  size_t base;
+  size_t sector_size;
+  uint8_t sector_count;
+  uint8_t active;
+  uint32_t generation;
+  uint32_t sequence;
+  size_t write_offset;         // Proxima posicao livre no setor ativo
+  size_t live_bytes;           // Bytes das entradas vivas (limite de compactacao)
+  struct kv_store_index index[KV_STORE_MAX_KEYS];
+  struct kv_store_stats stats;
+};
+
+int kv_store_init(struct kv_store *kv, size_t base, size_t sector_size, uint8_t sector_count);
+int kv_store_write(struct kv_store *kv, uint16_t key, const void *value, uint8_t length);
+int kv_store_read(struct kv_store *kv, uint16_t key, void *value, uint8_t length);
+int kv_store_delete(struct kv_store *kv, uint16_t key);
+int kv_store_get_stats(struct kv_store *kv, struct kv_store_stats *stats);
+
+/* C++ detection */
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* _KV_STORE_H */
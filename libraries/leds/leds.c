@@ -4,6 +4,7 @@
 
  #include "leds.h"
  #include <zephyr/logging/log.h>
+ #include <zephyr/sys/util.h>
  
  #define LOG_LEVEL CONFIG_LOG_DEFAULT_LEVEL
  LOG_MODULE_REGISTER(bsp_leds);
@@ -18,45 +19,73 @@
  #define LED_HEARTBEAT_PHASE_3         100
  #define LED_HEARTBEAT_PHASE_4        1200
  
- /* Timer interval in milliseconds */
- #define LED_TIMER_INTERVAL            10
+ /* Marks an unused slot in config_index and an idle timer */
+ #define LED_CONFIG_INDEX_NONE         0xFF
+ #define LED_DEADLINE_NONE             INT64_MAX
+ 
+ static const uint16_t led_blink_slow_steps[] = {
+     LED_BLINK_SLOW_INTERVAL, LED_BLINK_SLOW_INTERVAL,
+ };
+ 
+ static const uint16_t led_blink_fast_steps[] = {
+     LED_BLINK_FAST_INTERVAL, LED_BLINK_FAST_INTERVAL,
+ };
+ 
+ static const uint16_t led_heartbeat_steps[] = {
+     LED_HEARTBEAT_PHASE_1, LED_HEARTBEAT_PHASE_2,
+     LED_HEARTBEAT_PHASE_3, LED_HEARTBEAT_PHASE_4,
+ };
+ 
+ static const led_pattern_t led_blink_slow = {
+     .steps = led_blink_slow_steps,
+     .step_count = ARRAY_SIZE(led_blink_slow_steps),
+     .repeat = true,
+ };
+ 
+ static const led_pattern_t led_blink_fast = {
+     .steps = led_blink_fast_steps,
+     .step_count = ARRAY_SIZE(led_blink_fast_steps),
+     .repeat = true,
+ };
+ 
+ static const led_pattern_t led_heartbeat = {
+     .steps = led_heartbeat_steps,
+     .step_count = ARRAY_SIZE(led_heartbeat_steps),
+     .repeat = true,
+ };
  
  static void led_timer_handler(struct k_timer *timer);
- static int led_mutex_lock(led_control_t *led_control);
- static int led_mutex_unlock(led_control_t *led_control);
  static uint32_t get_current_timestamp(void);
  static const led_config_list_t *find_led_config(led_control_t *led_control, int id);
  static void update_led_outputs(led_control_t *led_control);
- 
- static int led_mutex_lock(led_control_t *led_control) {
-     return k_mutex_lock(&led_control->mutex, K_FOREVER);
- }
- 
- static int led_mutex_unlock(led_control_t *led_control) {
-     return k_mutex_unlock(&led_control->mutex);
- }
+ static void led_pattern_start(led_control_t *led_control, uint32_t mask,
+                               const led_pattern_t *pattern, int64_t now);
+ static int64_t led_pattern_advance(led_control_t *led_control, int64_t now);
+ static void led_timer_schedule(led_control_t *led_control, int64_t deadline);
  
  static uint32_t get_current_timestamp(void) {
      return k_uptime_get_32();
  }
  
  static const led_config_list_t *find_led_config(led_control_t *led_control, int id) {
-     if (led_control == NULL || led_control->config_list == NULL) {
+     uint8_t index;
+ 
+     if (led_control == NULL || led_control->config_list == NULL ||
+         id < 0 || id >= LED_MAX_COUNT) {
          return NULL;
      }
  
-     for (int i = 0; i < led_control->config_count; i++) {
-         if (led_control->config_list[i].id == id) {
-             return &led_control->config_list[i];
-         }
+     index = led_control->config_index[id];
+     if (index == LED_CONFIG_INDEX_NONE) {
+         return NULL;
      }
  
-     return NULL;
+     return &led_control->config_list[index];
  }
  
  static void update_led_physical_state(led_control_t *led_control, int id, bool state) {
      const led_config_list_t *config = find_led_config(led_control, id);
-     
+ 
      if (config == NULL) {
          return;
      }
@@ -65,99 +94,122 @@
      gpio_pin_set_dt(config->gpio, gpio_state);
  }
  
+ /* Only the pins whose state differs from the last written mask are touched */
  static void update_led_outputs(led_control_t *led_control) {
-    int id;
-    bool is_on;
-    uint32_t active_leds = led_control->status_mask;
-     
-     for (int i = 0; i < led_control->config_count; i++) {
-         id = led_control->config_list[i].id;
-         is_on = (active_leds & (1U << id)) ? true : false;
-         update_led_physical_state(led_control, id, is_on);
+     int id;
+     uint32_t changed = led_control->status_mask ^ led_control->output_mask;
+ 
+     while (changed != 0U) {
+         id = find_lsb_set(changed) - 1;
+         changed &= ~BIT(id);
+         update_led_physical_state(led_control, id,
+                                   (led_control->status_mask & BIT(id)) != 0U);
      }
+ 
+     led_control->output_mask = led_control->status_mask;
  }
  
- static void led_timer_handler(struct k_timer *timer) {
-     led_control_t *led_control = CONTAINER_OF(timer, led_control_t, timer);
-     static uint16_t slow_counter = 0;
-     static uint16_t fast_counter = 0;
-     static uint16_t heartbeat_counter = 0;
-     static uint8_t heartbeat_phase = 0;
-     bool toggle_slow = false;
-     bool toggle_fast = false;
-     bool toggle_heartbeat = false;
-     
-     /* Increment counters */
-     slow_counter += LED_TIMER_INTERVAL;
-     fast_counter += LED_TIMER_INTERVAL;
-     heartbeat_counter += LED_TIMER_INTERVAL;
-     
-     /* Check for slow blink toggle */
-     if (slow_counter >= LED_BLINK_SLOW_INTERVAL) {
-         slow_counter = 0;
-         toggle_slow = true;
-     }
-     
-     /* Check for fast blink toggle */
-     if (fast_counter >= LED_BLINK_FAST_INTERVAL) {
-         fast_counter = 0;
-         toggle_fast = true;
+ static void led_pattern_start(led_control_t *led_control, uint32_t mask,
+                               const led_pattern_t *pattern, int64_t now) {
+     int id;
+     led_channel_t *channel;
+ 
+     /* All LEDs in the mask start on step 0 together, so they stay in phase */
+     while (mask != 0U) {
+         id = find_lsb_set(mask) - 1;
+         mask &= ~BIT(id);
+ 
+         channel = &led_control->channel[id];
+         channel->pattern = pattern;
+         channel->step = 0;
+         channel->deadline = now + pattern->steps[0];
+ 
+         led_control->pattern_mask |= BIT(id);
+         led_control->on_mask &= ~BIT(id);
+         led_control->status_mask |= BIT(id);
      }
-     
-     /* Check for heartbeat pattern transitions */
-     if (heartbeat_phase == 0 && heartbeat_counter >= LED_HEARTBEAT_PHASE_1) {
-         heartbeat_counter = 0;
-         heartbeat_phase = 1;
-         toggle_heartbeat = true;
-     } else if (heartbeat_phase == 1 && heartbeat_counter >= LED_HEARTBEAT_PHASE_2) {
-         heartbeat_counter = 0;
-         heartbeat_phase = 2;
-         toggle_heartbeat = true;
-     } else if (heartbeat_phase == 2 && heartbeat_counter >= LED_HEARTBEAT_PHASE_3) {
-         heartbeat_counter = 0;
-         heartbeat_phase = 3;
-         toggle_heartbeat = true;
-     } else if (heartbeat_phase == 3 && heartbeat_counter >= LED_HEARTBEAT_PHASE_4) {
-         heartbeat_counter = 0;
-         heartbeat_phase = 0;
-         toggle_heartbeat = true;
+ }
+ 
+ /* Moves every expired channel to its next step and returns the earliest
+  * pending deadline, or LED_DEADLINE_NONE when no LED is running a pattern. */
+ static int64_t led_pattern_advance(led_control_t *led_control, int64_t now) {
+     int id;
+     uint32_t mask = led_control->pattern_mask;
+     int64_t next = LED_DEADLINE_NONE;
+     led_channel_t *channel;
+     const led_pattern_t *pattern;
+ 
+     while (mask != 0U) {
+         id = find_lsb_set(mask) - 1;
+         mask &= ~BIT(id);
+ 
+         channel = &led_control->channel[id];
+         pattern = channel->pattern;
+ 
+         while (channel->deadline <= now) {
+             channel->step++;
+             if (channel->step >= pattern->step_count) {
+                 if (!pattern->repeat) {
+                     channel->pattern = NULL;
+                     led_control->pattern_mask &= ~BIT(id);
+                     led_control->status_mask &= ~BIT(id);
+                     break;
+                 }
+                 channel->step = 0;
+             }
+ 
+             /* Deadlines are absolute, so a late wakeup does not drift */
+             channel->deadline += pattern->steps[channel->step];
+ 
+             if ((channel->step & 1U) == 0U) {
+                 led_control->status_mask |= BIT(id);
+             } else {
+                 led_control->status_mask &= ~BIT(id);
+             }
+         }
+ 
+         if (channel->pattern != NULL && channel->deadline < next) {
+             next = channel->deadline;
+         }
      }
-     
-     /* Acquire mutex for updating LED states */
-     if (led_mutex_lock(led_control) < 0) {
+ 
+     return next;
+ }
+ 
+ static void led_timer_schedule(led_control_t *led_control, int64_t deadline) {
+     if (deadline == led_control->next_deadline) {
          return;
      }
-     
-     /* Handle slow blinking LEDs */
-     if (toggle_slow && led_control->blink_slow_mask) {
-         led_control->status_mask ^= led_control->blink_slow_mask;
-     }
-     
-     /* Handle fast blinking LEDs */
-     if (toggle_fast && led_control->blink_fast_mask) {
-         led_control->status_mask ^= led_control->blink_fast_mask;
-     }
-     
-     /* Handle heartbeat pattern LEDs */
-     if (toggle_heartbeat && led_control->heartbeat_mask) {
-         /* In phases 0 and 2, LED is off; in phases 1 and 3, LED is on */
-         if (heartbeat_phase == 0 || heartbeat_phase == 2) {
-             led_control->status_mask &= ~led_control->heartbeat_mask;
-         } else {
-             led_control->status_mask |= led_control->heartbeat_mask;
-         }
+ 
+     led_control->next_deadline = deadline;
+ 
+     if (deadline == LED_DEADLINE_NONE) {
+         k_timer_stop(&led_control->timer);
+     } else {
+         k_timer_start(&led_control->timer, K_TIMEOUT_ABS_MS(deadline), K_NO_WAIT);
      }
-     
-     /* Update physical LED states */
+ }
+ 
+ static void led_timer_handler(struct k_timer *timer) {
+     led_control_t *led_control = CONTAINER_OF(timer, led_control_t, timer);
+     k_spinlock_key_t key;
+     int64_t next;
+ 
+     key = k_spin_lock(&led_control->lock);
+ 
+     /* The one-shot timer has expired, nothing is armed anymore */
+     led_control->next_deadline = LED_DEADLINE_NONE;
+ 
+     next = led_pattern_advance(led_control, k_uptime_get());
      update_led_outputs(led_control);
-     
-     /* Release mutex */
-     led_mutex_unlock(led_control);
+     led_timer_schedule(led_control, next);
+ 
+     k_spin_unlock(&led_control->lock, key);
  }
  
- int led_init(led_control_t *led_control, 
+ int led_init(led_control_t *led_control,
               const led_config_list_t *config_list,
-              uint16_t config_count, 
+              uint16_t config_count,
               led_callback_t callback) {
      int ret;
  
@@ -167,15 +219,22 @@
      }
  
      memset(led_control, 0, sizeof(led_control_t));
-     k_mutex_init(&led_control->mutex);
+     memset(led_control->config_index, LED_CONFIG_INDEX_NONE,
+            sizeof(led_control->config_index));
  
      led_control->config_list = config_list;
      led_control->config_count = config_count;
      led_control->callback = callback;
+     led_control->next_deadline = LED_DEADLINE_NONE;
  
      for (int i = 0; i < config_count; i++) {
          const struct gpio_dt_spec *gpio = config_list[i].gpio;
  
+         if (config_list[i].id < 0 || config_list[i].id >= LED_MAX_COUNT) {
+             LOG_ERR("Invalid LED ID %d", config_list[i].id);
+             return -EINVAL;
+         }
+ 
          if (!gpio_is_ready_dt(gpio)) {
              LOG_ERR("GPIO not ready for LED ID %d", config_list[i].id);
              return -ENODEV;
@@ -195,108 +254,142 @@
                    config_list[i].id, ret);
              return ret;
          }
+ 
+         led_control->config_index[config_list[i].id] = i;
+         led_control->config_mask |= BIT(config_list[i].id);
      }
  
-     /* Initialize and start the timer for blinking patterns */
+     /* The pattern timer stays idle until some LED runs a pattern */
      k_timer_init(&led_control->timer, led_timer_handler, NULL);
-     k_timer_start(&led_control->timer, K_MSEC(LED_TIMER_INTERVAL), K_MSEC(LED_TIMER_INTERVAL));
  
      LOG_INF("LED system initialized with %d LEDs", config_count);
      return 0;
  }
  
  int led_set(led_control_t *led_control, int id, led_action_t action) {
+     if (id < 0 || id >= LED_MAX_COUNT) {
+         return -EINVAL;
+     }
+ 
      uint32_t mask = (1U << id);
      return led_set_mask(led_control, mask, action);
  }
  
  int led_set_mask(led_control_t *led_control, uint32_t mask, led_action_t action) {
-     int ret;
+     k_spinlock_key_t key;
+     uint32_t status_mask;
      uint32_t timestamp;
+     int64_t now;
  
      if (led_control == NULL) {
          return -EINVAL;
      }
  
-     ret = led_mutex_lock(led_control);
-     if (ret < 0) {
-         return ret;
-     }
+     mask &= led_control->config_mask;
+     now = k_uptime_get();
+ 
+     key = k_spin_lock(&led_control->lock);
  
      /* Update LED mode masks based on the requested action */
      switch (action) {
          case LED_ACTION_OFF:
              led_control->on_mask &= ~mask;
-             led_control->blink_slow_mask &= ~mask;
-             led_control->blink_fast_mask &= ~mask;
-             led_control->heartbeat_mask &= ~mask;
+             led_control->pattern_mask &= ~mask;
              led_control->status_mask &= ~mask;
              break;
  
          case LED_ACTION_ON:
              led_control->on_mask |= mask;
-             led_control->blink_slow_mask &= ~mask;
-             led_control->blink_fast_mask &= ~mask;
-             led_control->heartbeat_mask &= ~mask;
+             led_control->pattern_mask &= ~mask;
              led_control->status_mask |= mask;
              break;
  
          case LED_ACTION_TOGGLE:
              led_control->on_mask ^= mask;
-             led_control->blink_slow_mask &= ~mask;
-             led_control->blink_fast_mask &= ~mask;
-             led_control->heartbeat_mask &= ~mask;
+             led_control->pattern_mask &= ~mask;
              led_control->status_mask ^= mask;
              break;
  
          case LED_ACTION_BLINK_SLOW:
-             led_control->on_mask &= ~mask;
-             led_control->blink_slow_mask |= mask;
-             led_control->blink_fast_mask &= ~mask;
-             led_control->heartbeat_mask &= ~mask;
+             led_pattern_start(led_control, mask, &led_blink_slow, now);
              break;
  
          case LED_ACTION_BLINK_FAST:
-             led_control->on_mask &= ~mask;
-             led_control->blink_slow_mask &= ~mask;
-             led_control->blink_fast_mask |= mask;
-             led_control->heartbeat_mask &= ~mask;
+             led_pattern_start(led_control, mask, &led_blink_fast, now);
              break;
  
          case LED_ACTION_HEARTBEAT:
-             led_control->on_mask &= ~mask;
-             led_control->blink_slow_mask &= ~mask;
-             led_control->blink_fast_mask &= ~mask;
-             led_control->heartbeat_mask |= mask;
+             led_pattern_start(led_control, mask, &led_heartbeat, now);
              break;
  
          default:
-             led_mutex_unlock(led_control);
+             k_spin_unlock(&led_control->lock, key);
              return -EINVAL;
      }
  
-     /* Update physical LED states */
+     /* Update physical LED states and re-arm only if the next change moved */
      update_led_outputs(led_control);
+     led_timer_schedule(led_control, led_pattern_advance(led_control, now));
+ 
+     status_mask = led_control->status_mask;
+     k_spin_unlock(&led_control->lock, key);
  
      /* Call the callback if provided */
      if (led_control->callback != NULL) {
+         timestamp = get_current_timestamp();
          for (int i = 0; i < led_control->config_count; i++) {
              int id = led_control->config_list[i].id;
              if (mask & (1U << id)) {
-                 bool state = (led_control->status_mask & (1U << id)) ? true : false;
-                 timestamp = get_current_timestamp();
-                 led_control->callback(&led_control->config_list[i], state, 
-                                      timestamp, led_control->status_mask);
+                 bool state = (status_mask & (1U << id)) ? true : false;
+                 led_control->callback(&led_control->config_list[i], state,
+                                      timestamp, status_mask);
              }
          }
      }
  
-     led_mutex_unlock(led_control);
+     return 0;
+ }
+ 
+ int led_set_pattern(led_control_t *led_control, uint32_t mask,
+                     const led_pattern_t *pattern) {
+     k_spinlock_key_t key;
+     int64_t now;
+ 
+     if (led_control == NULL) {
+         return -EINVAL;
+     }
+ 
+     if (pattern == NULL) {
+         return led_set_mask(led_control, mask, LED_ACTION_OFF);
+     }
+ 
+     if (pattern->steps == NULL || pattern->step_count == 0) {
+         return -EINVAL;
+     }
+ 
+     /* A zero length step would never let the deadline move forward */
+     for (int i = 0; i < pattern->step_count; i++) {
+         if (pattern->steps[i] == 0) {
+             return -EINVAL;
+         }
+     }
+ 
+     mask &= led_control->config_mask;
+     now = k_uptime_get();
+ 
+     key = k_spin_lock(&led_control->lock);
+ 
+     led_pattern_start(led_control, mask, pattern, now);
+     update_led_outputs(led_control);
+     led_timer_schedule(led_control, led_pattern_advance(led_control, now));
+ 
+     k_spin_unlock(&led_control->lock, key);
+ 
      return 0;
  }
  
  bool led_get_status(led_control_t *led_control, int id) {
-     int ret;
+     k_spinlock_key_t key;
      int pin_value;
      bool is_on = false;
      const led_config_list_t *config;
@@ -323,36 +416,31 @@
          is_on = (pin_value == 0);
      }
  
-     ret = led_mutex_lock(led_control);
-     if (ret < 0) {
-         return is_on;
-     }
+     key = k_spin_lock(&led_control->lock);
  
      /* Update status mask to match actual hardware state */
      if (is_on) {
          led_control->status_mask |= (1U << id);
+         led_control->output_mask |= (1U << id);
      } else {
          led_control->status_mask &= ~(1U << id);
+         led_control->output_mask &= ~(1U << id);
      }
  
-     led_mutex_unlock(led_control);
+     k_spin_unlock(&led_control->lock, key);
      return is_on;
  }
  
  int led_get_status_all(led_control_t *led_control, uint32_t *mask) {
-     int ret;
+     k_spinlock_key_t key;
  
      if (led_control == NULL || mask == NULL) {
          return -EINVAL;
      }
  
-     ret = led_mutex_lock(led_control);
-     if (ret < 0) {
-         return ret;
-     }
- 
+     key = k_spin_lock(&led_control->lock);
      *mask = led_control->status_mask;
-     led_mutex_unlock(led_control);
+     k_spin_unlock(&led_control->lock, key);
  
      return 0;
  }
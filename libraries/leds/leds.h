@@ -36,16 +36,32 @@
      const led_config_list_t *config, bool state, uint32_t timestamp,
      uint32_t all_states_mask);
  
+ /* Pattern program: step durations in ms, even steps on, odd steps off */
+ typedef struct {
+     const uint16_t *steps;          /* Step durations (ms), starting with on */
+     uint8_t step_count;             /* Number of steps in the program */
+     bool repeat;                    /* Restart from step 0 after the last step */
+ } led_pattern_t;
+ 
+ typedef struct {
+     const led_pattern_t *pattern;   /* Running program, NULL when static */
+     uint8_t step;                   /* Current step index */
+     int64_t deadline;               /* Uptime (ms) of the next step change */
+ } led_channel_t;
+ 
  typedef struct {
      uint32_t status_mask;           /* Mask with current LED states */
      uint32_t on_mask;               /* Mask with LEDs that are solidly on */
-     uint32_t blink_slow_mask;       /* Mask with LEDs that are blinking slowly */
-     uint32_t blink_fast_mask;       /* Mask with LEDs that are blinking quickly */
-     uint32_t heartbeat_mask;        /* Mask with LEDs that are in heartbeat mode */
+     uint32_t pattern_mask;          /* Mask with LEDs running a pattern */
+     uint32_t output_mask;           /* Mask last written to the GPIOs */
+     uint32_t config_mask;           /* Mask with configured LEDs */
+     int64_t next_deadline;          /* Deadline the timer is armed for */
+     led_channel_t channel[LED_MAX_COUNT]; /* Per LED pattern state */
+     uint8_t config_index[LED_MAX_COUNT];  /* LED id -> config list index */
      const led_config_list_t *config_list; /* List of LED configurations */
      uint16_t config_count;          /* Number of items in config list */
-     struct k_mutex mutex;           /* Mutex for controlling access */
-     struct k_timer timer;           /* Timer for blinking patterns */
+     struct k_spinlock lock;         /* Protects state shared with the timer */
+     struct k_timer timer;           /* One-shot timer armed at next deadline */
      led_callback_t callback;        /* Optional callback function */
  } led_control_t;
  
@@ -56,6 +72,8 @@
  
  int led_set(led_control_t *led_control, int id, led_action_t action);
  int led_set_mask(led_control_t *led_control, uint32_t mask, led_action_t action);
+ int led_set_pattern(led_control_t *led_control, uint32_t mask,
+                     const led_pattern_t *pattern);
  bool led_get_status(led_control_t *led_control, int id);
  int led_get_status_all(led_control_t *led_control, uint32_t *mask);
  int led_show_list(led_control_t *led_control);
@@ -0,0 +1,686 @@
+#include "mqtt_telemetry.h"
+
+#include <string.h>
+#include <zephyr/kernel.h>
+#include <zephyr/logging/log.h>
+#include <zephyr/net/mqtt.h>
+#include <zephyr/net/socket.h>
+#include <zephyr/shell/shell.h>
+#include <zephyr/sys/byteorder.h>
+#include <zephyr/sys/ring_buffer.h>
+
+LOG_MODULE_REGISTER(mqtt_telemetry, CONFIG_LOG_DEFAULT_LEVEL);
+
+/*
+ * Telemetria da base por MQTT. A cada janela a thread le os parametros
+ * observados com uma unica tomada do lock (so se o contador de alteracoes
+ * mudou), compara com a copia enviada e monta um registro binario apenas com
+ * o que mudou. Os registros passam sempre pelo spool em RAM: com o broker fora
+ * eles acumulam ate CONFIG_APP_MQTT_SPOOL_SIZE e os mais antigos sao
+ * descartados. Em QoS 1 o registro so sai do spool com o PUBACK.
+ */
+
+#define MQTT_TELEMETRY_STACK_MEM_ATTRIBUTES Z_GENERIC_SECTION(.app_stack)
+#define MQTT_TELEMETRY_BUF_SIZE             (256)   // Cabecalho + topico (rx/tx)
+#define MQTT_TELEMETRY_CONNACK_MS           (3000)
+#define MQTT_TELEMETRY_READ_ACCESS          ACC_LEVEL_FACTORY
+#define MQTT_TELEMETRY_VALUE_ALIGN          (8)
+
+struct mqtt_telemetry_item {
+  struct db_param *param;
+  uint16_t did;
+  uint16_t offset;              // Posicao em g_shadow e g_values
+};
+
+struct mqtt_telemetry_record {
+  uint8_t flags;
+  uint16_t items;
+  size_t len;
+};
+
+static const struct mqtt_telemetry_config *g_config;
+static struct mqtt_telemetry_item g_items[CONFIG_APP_MQTT_MAX_PARAMS];
+static struct db_raw_item g_raw[CONFIG_APP_MQTT_MAX_PARAMS];
+static uint8_t __aligned(8) g_shadow[CONFIG_APP_MQTT_SHADOW_SIZE]; // Ultimo valor enviado
+static uint8_t __aligned(8) g_values[CONFIG_APP_MQTT_SHADOW_SIZE]; // Leitura da janela
+static uint16_t g_count;
+static uint16_t g_used;
+static uint32_t g_last_seq;
+static bool g_full = true;      // Proxima janela leva todos os parametros
+static uint16_t g_seq;
+
+// Registro em montagem e copia linear do registro em publicacao (com o tamanho)
+static uint8_t g_payload[CONFIG_APP_MQTT_PAYLOAD_SIZE];
+static uint8_t g_publish[sizeof(uint16_t) + CONFIG_APP_MQTT_PAYLOAD_SIZE];
+static uint8_t g_write[CONFIG_APP_MQTT_PAYLOAD_SIZE];
+static struct mqtt_telemetry_record g_record;
+
+RING_BUF_DECLARE(g_spool, CONFIG_APP_MQTT_SPOOL_SIZE);
+static uint16_t g_inflight_id;  // PUBACK esperado, 0 = nenhum
+static uint16_t g_message_id;
+
+static struct mqtt_client g_client;
+static struct sockaddr_storage g_broker;
+static uint8_t g_rx_buf[MQTT_TELEMETRY_BUF_SIZE];
+static uint8_t g_tx_buf[MQTT_TELEMETRY_BUF_SIZE];
+static struct mqtt_utf8 g_user_name;
+static struct mqtt_utf8 g_password;
+static bool g_connected;
+static int64_t g_next_connect;
+
+static struct mqtt_telemetry_stats g_stats;
+static bool g_started;
+static struct k_thread g_thread;
+static K_MUTEX_DEFINE(g_lock);
+
+Z_KERNEL_STACK_DEFINE_IN(g_stack, CONFIG_APP_MQTT_STACK_SIZE, MQTT_TELEMETRY_STACK_MEM_ATTRIBUTES);
+
+static int mqtt_telemetry_shell_cmd_stats(const struct shell *shell, size_t argc, char **argv);
+
+SHELL_STATIC_SUBCMD_SET_CREATE(
+    mqtt_tele, SHELL_CMD(stats, NULL, "telemetry statistics", mqtt_telemetry_shell_cmd_stats),
+    SHELL_SUBCMD_SET_END);
+
+SHELL_CMD_REGISTER(telemetry, &mqtt_tele, "MQTT telemetry commands", NULL);
+
+static uint16_t mqtt_telemetry_next_id(void) {
+  g_message_id = (g_message_id == UINT16_MAX) ? 1 : (g_message_id + 1);
+  return g_message_id;
+}
+
+// Remove o registro mais antigo
+static void mqtt_telemetry_spool_pop(void) {
+  uint16_t len;
+
+  if (ring_buf_get(&g_spool, (uint8_t *)&len, sizeof(len)) == sizeof(len)) {
+    ring_buf_get(&g_spool, NULL, len);
+    g_stats.spooled--;
+  }
+}
+
+static void mqtt_telemetry_spool_push(const uint8_t *data, uint16_t len) {
+  // Spool cheio: perde o mais antigo; se estava em voo o PUBACK sera ignorado
+  while (ring_buf_space_get(&g_spool) < (sizeof(len) + len)) {
+    // Vazio e ainda sem espaco: o registro nunca cabe (range do Kconfig)
+    if (ring_buf_is_empty(&g_spool)) {
+      g_stats.dropped++;
+      return;
+    }
+    mqtt_telemetry_spool_pop();
+    g_inflight_id = 0;
+    g_stats.dropped++;
+  }
+
+  ring_buf_put(&g_spool, (const uint8_t *)&len, sizeof(len));
+  ring_buf_put(&g_spool, data, len);
+  g_stats.spooled++;
+  g_stats.spool_peak = MAX(g_stats.spool_peak, ring_buf_size_get(&g_spool));
+}
+
+static void mqtt_telemetry_record_start(uint8_t flags) {
+  g_record.flags = flags;
+  g_record.items = 0;
+  g_record.len = MQTT_TELEMETRY_HEADER_LEN;
+}
+
+static void mqtt_telemetry_record_end(void) {
+  if (g_record.items == 0) {
+    return;
+  }
+
+  g_payload[0] = MQTT_TELEMETRY_VERSION;
+  g_payload[1] = g_record.flags;
+  sys_put_le16(g_seq++, &g_payload[2]);
+  sys_put_le32(k_uptime_get_32(), &g_payload[4]);
+  sys_put_le16(g_record.items, &g_payload[8]);
+
+  mqtt_telemetry_spool_push(g_payload, g_record.len);
+}
+
+// Item que nao cabe fecha o registro e abre outro com as mesmas flags
+static void mqtt_telemetry_record_add(const struct mqtt_telemetry_item *item, const uint8_t *value) {
+  size_t len = item->param->config.var_size;
+
+  if (item->param->config.info.type == eSTR) {
+    len = strnlen((const char *)value, len);
+  }
+
+  if ((g_record.len + MQTT_TELEMETRY_ITEM_LEN + len) > sizeof(g_payload)) {
+    mqtt_telemetry_record_end();
+    mqtt_telemetry_record_start(g_record.flags);
+  }
+
+  sys_put_le16(item->did, &g_payload[g_record.len]);
+  g_payload[g_record.len + 2] = len;
+  memcpy(&g_payload[g_record.len + MQTT_TELEMETRY_ITEM_LEN], value, len);
+  g_record.len += MQTT_TELEMETRY_ITEM_LEN + len;
+  g_record.items++;
+}
+
+// Chamado com g_lock: registro com os parametros alterados desde a ultima janela
+static void mqtt_telemetry_window(void) {
+  const struct mqtt_telemetry_item *item;
+  uint32_t seq = db_get_change_seq();
+  bool full = g_full;
+  uint16_t len;
+
+  if ((g_count == 0) || (!full && (seq == g_last_seq))) {
+    return;
+  }
+
+  // Mudancas depois desta leitura do contador ficam para a proxima janela
+  g_last_seq = seq;
+
+  for (uint16_t i = 0; i < g_count; i++) {
+    g_raw[i].param = g_items[i].param;
+    g_raw[i].data = &g_values[g_items[i].offset];
+    g_raw[i].len = g_items[i].param->config.var_size;
+  }
+
+  db_param_get_raw_batch(MQTT_TELEMETRY_READ_ACCESS, g_raw, g_count);
+
+  mqtt_telemetry_record_start(full ? MQTT_TELEMETRY_FLAG_FULL : 0);
+
+  for (uint16_t i = 0; i < g_count; i++) {
+    item = &g_items[i];
+    len = item->param->config.var_size;
+
+    if (g_raw[i].result <= 0) {
+      continue;
+    }
+
+    if (!full && (memcmp(&g_shadow[item->offset], &g_values[item->offset], len) == 0)) {
+      continue;
+    }
+
+    memcpy(&g_shadow[item->offset], &g_values[item->offset], len);
+    mqtt_telemetry_record_add(item, &g_values[item->offset]);
+    g_stats.items++;
+  }
+
+  if (g_record.items > 0) {
+    g_stats.windows++;
+  }
+
+  mqtt_telemetry_record_end();
+  g_full = false;
+}
+
+/*
+ * Escrita recebida: mesmo formato da janela. Os valores sao copiados
+ * alinhados para g_values e gravados de uma vez com o nivel
+ * CONFIG_APP_MQTT_WRITE_ACCESS; com qualquer item invalido nada muda.
+ */
+// Senhas, ocultos e sem tipo nao saem na telemetria nem aceitam escrita
+static bool mqtt_telemetry_param_visible(const struct db_param *param) {
+  return (param->config.info.type != eVOID) && (param->config.info.field != VAR_FIELD_PWD) &&
+         (param->config.info.field != VAR_FIELD_HIDDEN);
+}
+
+static int mqtt_telemetry_apply(const uint8_t *data, size_t len) {
+  struct db_group *group;
+  struct db_param *param;
+  uint16_t count;
+  uint16_t did;
+  size_t offset = 0;
+  size_t pos = MQTT_TELEMETRY_HEADER_LEN;
+  uint8_t vlen;
+  int ret;
+
+  if ((len < MQTT_TELEMETRY_HEADER_LEN) || (data[0] != MQTT_TELEMETRY_VERSION)) {
+    return -EINVAL;
+  }
+
+  count = sys_get_le16(&data[8]);
+  if ((count == 0) || (count > ARRAY_SIZE(g_raw))) {
+    return -EINVAL;
+  }
+
+  for (uint16_t i = 0; i < count; i++) {
+    if ((len - pos) < MQTT_TELEMETRY_ITEM_LEN) {
+      return -EINVAL;
+    }
+
+    did = sys_get_le16(&data[pos]);
+    vlen = data[pos + 2];
+    pos += MQTT_TELEMETRY_ITEM_LEN;
+
+    if (((len - pos) < vlen) || ((offset + vlen) > sizeof(g_values))) {
+      return -EINVAL;
+    }
+
+    if (db_get_var_config(&group, &param, did >> 8, did & 0xFF) != 0) {
+      return -ENOENT;
+    }
+
+    if (!mqtt_telemetry_param_visible(param)) {
+      return -EACCES;
+    }
+
+    memcpy(&g_values[offset], &data[pos], vlen);
+    g_raw[i].param = param;
+    g_raw[i].data = &g_values[offset];
+    g_raw[i].len = vlen;
+
+    offset += ROUND_UP(vlen, MQTT_TELEMETRY_VALUE_ALIGN);
+    pos += vlen;
+  }
+
+  ret = db_param_set_raw_batch(CONFIG_APP_MQTT_WRITE_ACCESS, g_raw, count);
+
+  return (ret < 0) ? ret : count;
+}
+
+static void mqtt_telemetry_on_publish(struct mqtt_client *client,
+                                      const struct mqtt_publish_param *pub) {
+  struct mqtt_puback_param ack = {.message_id = pub->message_id};
+  size_t len = pub->message.payload.len;
+  size_t chunk;
+  int ret;
+
+  if (len <= sizeof(g_write)) {
+    ret = mqtt_readall_publish_payload(client, g_write, len);
+    if (ret == 0) {
+      ret = mqtt_telemetry_apply(g_write, len);
+    }
+  } else {
+    // Grande demais: consome do socket e descarta
+    ret = -EMSGSIZE;
+    while (len > 0) {
+      chunk = MIN(len, sizeof(g_write));
+      if (mqtt_readall_publish_payload(client, g_write, chunk) != 0) {
+        break;
+      }
+      len -= chunk;
+    }
+  }
+
+  if (pub->message.topic.qos == MQTT_QOS_1_AT_LEAST_ONCE) {
+    mqtt_publish_qos1_ack(client, &ack);
+  }
+
+  if (ret < 0) {
+    g_stats.write_errors++;
+    LOG_WRN("Write rejected: %d", ret);
+  } else {
+    g_stats.writes += ret;
+  }
+}
+
+static void mqtt_telemetry_evt(struct mqtt_client *client, const struct mqtt_evt *evt) {
+  switch (evt->type) {
+  case MQTT_EVT_CONNACK:
+    g_connected = (evt->result == 0);
+    break;
+
+  case MQTT_EVT_DISCONNECT:
+    g_connected = false;
+    break;
+
+  case MQTT_EVT_PUBACK:
+    if ((evt->result == 0) && (g_inflight_id != 0) &&
+        (evt->param.puback.message_id == g_inflight_id)) {
+      g_stats.published++;
+      mqtt_telemetry_spool_pop();
+      g_inflight_id = 0;
+    }
+    break;
+
+  case MQTT_EVT_PUBLISH:
+    mqtt_telemetry_on_publish(client, &evt->param.publish);
+    break;
+
+  default:
+    break;
+  }
+}
+
+static int mqtt_telemetry_resolve(void) {
+  struct sockaddr_in *broker = (struct sockaddr_in *)&g_broker;
+
+  broker->sin_family = AF_INET;
+  broker->sin_port = htons(g_config->port);
+
+  if (zsock_inet_pton(AF_INET, g_config->host, &broker->sin_addr) == 1) {
+    return 0;
+  }
+
+#if defined(CONFIG_DNS_RESOLVER)
+  struct zsock_addrinfo hints = {.ai_family = AF_INET, .ai_socktype = SOCK_STREAM};
+  struct zsock_addrinfo *res;
+
+  if (zsock_getaddrinfo(g_config->host, NULL, &hints, &res) != 0) {
+    return -EHOSTUNREACH;
+  }
+
+  broker->sin_addr = ((struct sockaddr_in *)res->ai_addr)->sin_addr;
+  zsock_freeaddrinfo(res);
+
+  return 0;
+#else
+  return -EHOSTUNREACH;
+#endif
+}
+
+// Sem g_lock: a conexao TCP pode levar segundos
+static int mqtt_telemetry_connect(void) {
+  struct mqtt_topic topic;
+  struct mqtt_subscription_list subs;
+  struct zsock_pollfd fds;
+  int64_t deadline;
+  int ret;
+
+  ret = mqtt_telemetry_resolve();
+  if (ret != 0) {
+    return ret;
+  }
+
+  mqtt_client_init(&g_client);
+  g_client.broker = &g_broker;
+  g_client.evt_cb = mqtt_telemetry_evt;
+  g_client.client_id.utf8 = (const uint8_t *)g_config->client_id;
+  g_client.client_id.size = strlen(g_config->client_id);
+  g_client.protocol_version = MQTT_VERSION_3_1_1;
+  g_client.rx_buf = g_rx_buf;
+  g_client.rx_buf_size = sizeof(g_rx_buf);
+  g_client.tx_buf = g_tx_buf;
+  g_client.tx_buf_size = sizeof(g_tx_buf);
+  g_client.transport.type = MQTT_TRANSPORT_NON_SECURE;
+
+  if (g_config->user_name) {
+    g_user_name.utf8 = (const uint8_t *)g_config->user_name;
+    g_user_name.size = strlen(g_config->user_name);
+    g_client.user_name = &g_user_name;
+  }
+
+  if (g_config->password) {
+    g_password.utf8 = (const uint8_t *)g_config->password;
+    g_password.size = strlen(g_config->password);
+    g_client.password = &g_password;
+  }
+
+  ret = mqtt_connect(&g_client);
+  if (ret != 0) {
+    return ret;
+  }
+
+  fds.fd = g_client.transport.tcp.sock;
+  fds.events = ZSOCK_POLLIN;
+  deadline = k_uptime_get() + MQTT_TELEMETRY_CONNACK_MS;
+
+  while (!g_connected && (k_uptime_get() < deadline)) {
+    if ((zsock_poll(&fds, 1, deadline - k_uptime_get()) <= 0) || (mqtt_input(&g_client) != 0)) {
+      break;
+    }
+  }
+
+  if (!g_connected) {
+    mqtt_abort(&g_client);
+    return -ETIMEDOUT;
+  }
+
+  if (g_config->sub_topic) {
+    topic.topic.utf8 = (const uint8_t *)g_config->sub_topic;
+    topic.topic.size = strlen(g_config->sub_topic);
+    topic.qos = MQTT_QOS_1_AT_LEAST_ONCE;
+    subs.list = &topic;
+    subs.list_count = 1;
+    subs.message_id = mqtt_telemetry_next_id();
+
+    ret = mqtt_subscribe(&g_client, &subs);
+    if (ret != 0) {
+      mqtt_abort(&g_client);
+      g_connected = false;
+      return ret;
+    }
+  }
+
+  return 0;
+}
+
+// Chamado com g_lock: publica o registro mais antigo do spool
+static int mqtt_telemetry_spool_service(void) {
+  struct mqtt_publish_param param = {0};
+  uint16_t len;
+  int ret;
+
+  if (ring_buf_peek(&g_spool, (uint8_t *)&len, sizeof(len)) != sizeof(len)) {
+    return -ENODATA;
+  }
+
+  ring_buf_peek(&g_spool, g_publish, sizeof(len) + len);
+
+  param.message.topic.topic.utf8 = (const uint8_t *)g_config->pub_topic;
+  param.message.topic.topic.size = strlen(g_config->pub_topic);
+  param.message.topic.qos = g_config->qos ? MQTT_QOS_1_AT_LEAST_ONCE : MQTT_QOS_0_AT_MOST_ONCE;
+  param.message.payload.data = &g_publish[sizeof(len)];
+  param.message.payload.len = len;
+  param.message_id = mqtt_telemetry_next_id();
+
+  ret = mqtt_publish(&g_client, &param);
+  if (ret != 0) {
+    return ret;
+  }
+
+  g_stats.bytes += len;
+
+  if (g_config->qos) {
+    g_inflight_id = param.message_id;
+  } else {
+    g_stats.published++;
+    mqtt_telemetry_spool_pop();
+  }
+
+  return 0;
+}
+
+// Chamado com g_lock
+static void mqtt_telemetry_drop(int err) {
+  LOG_WRN("Broker connection lost: %d", err);
+
+  mqtt_abort(&g_client);
+  g_connected = false;
+  g_inflight_id = 0;
+  g_next_connect = k_uptime_get() + CONFIG_APP_MQTT_RECONNECT_MS;
+}
+
+static void mqtt_telemetry_thread(void *p1, void *p2, void *p3) {
+  struct zsock_pollfd fds;
+  int64_t next_window = k_uptime_get() + CONFIG_APP_MQTT_WINDOW_MS;
+  int64_t now;
+  int timeout;
+  int ret;
+
+  ARG_UNUSED(p1);
+  ARG_UNUSED(p2);
+  ARG_UNUSED(p3);
+
+  while (true) {
+    now = k_uptime_get();
+
+    if (!g_connected && (now >= g_next_connect)) {
+      ret = mqtt_telemetry_connect();
+
+      k_mutex_lock(&g_lock, K_FOREVER);
+      if (ret == 0) {
+        // Retrato completo apos cada conexao; o spool segue na ordem
+        g_stats.connects++;
+        g_inflight_id = 0;
+        g_full = true;
+        LOG_INF("Connected to %s:%u", g_config->host, g_config->port);
+      } else {
+        g_next_connect = k_uptime_get() + CONFIG_APP_MQTT_RECONNECT_MS;
+      }
+      k_mutex_unlock(&g_lock);
+
+      now = k_uptime_get();
+    }
+
+    timeout = MAX(next_window - now, 0);
+
+    if (g_connected) {
+      ret = mqtt_keepalive_time_left(&g_client);
+      if (ret >= 0) {
+        timeout = MIN(timeout, ret);
+      }
+
+      fds.fd = g_client.transport.tcp.sock;
+      fds.events = ZSOCK_POLLIN;
+      ret = zsock_poll(&fds, 1, timeout);
+
+      k_mutex_lock(&g_lock, K_FOREVER);
+
+      if ((ret > 0) && (fds.revents & ZSOCK_POLLIN)) {
+        ret = mqtt_input(&g_client);
+      } else if ((ret > 0) && (fds.revents & (ZSOCK_POLLERR | ZSOCK_POLLHUP))) {
+        ret = -ENOTCONN;
+      }
+
+      if ((ret >= 0) && g_connected) {
+        ret = mqtt_live(&g_client);
+        ret = (ret == -EAGAIN) ? 0 : ret;
+      }
+
+      if ((ret < 0) || !g_connected) {
+        mqtt_telemetry_drop(ret);
+      }
+
+      k_mutex_unlock(&g_lock);
+    } else {
+      k_msleep(MAX(MIN(timeout, g_next_connect - now), 0));
+    }
+
+    k_mutex_lock(&g_lock, K_FOREVER);
+
+    now = k_uptime_get();
+    if (now >= next_window) {
+      mqtt_telemetry_window();
+      next_window += CONFIG_APP_MQTT_WINDOW_MS;
+      if (next_window <= now) {
+        next_window = now + CONFIG_APP_MQTT_WINDOW_MS;
+      }
+    }
+
+    // QoS 1: um registro em voo por vez, o proximo sai com o PUBACK
+    while (g_connected && (g_inflight_id == 0) && (ring_buf_size_get(&g_spool) > 0)) {
+      ret = mqtt_telemetry_spool_service();
+      if (ret != 0) {
+        mqtt_telemetry_drop(ret);
+        break;
+      }
+
+      if (g_config->qos) {
+        break;
+      }
+    }
+
+    k_mutex_unlock(&g_lock);
+  }
+}
+
+/**
+ * @brief Observa todos os parametros de um grupo
+ *
+ * Parametros de senha sao ignorados. Pode ser chamado antes ou depois de
+ * mqtt_telemetry_init(); a proxima janela envia o retrato completo.
+ */
+int mqtt_telemetry_add_group(db_group_id_t group_id) {
+  struct db_group *group;
+  struct db_group *owner;
+  struct db_param *param;
+  struct mqtt_telemetry_item *item;
+  uint16_t len;
+  int ret = 0;
+
+  if (db_get_var_config(&group, &param, group_id, 0) != 0) {
+    return -ENOENT;
+  }
+
+  k_mutex_lock(&g_lock, K_FOREVER);
+
+  for (uint16_t i = 0; i < group->count; i++) {
+    if (db_get_var_config(&owner, &param, group_id, group->params[i].id) != 0) {
+      continue;
+    }
+
+    len = param->config.var_size;
+    if (!mqtt_telemetry_param_visible(param) || (len > UINT8_MAX)) {
+      continue;
+    }
+
+    if ((g_count >= ARRAY_SIZE(g_items)) ||
+        ((g_used + ROUND_UP(len, MQTT_TELEMETRY_VALUE_ALIGN)) > sizeof(g_shadow))) {
+      ret = -ENOMEM;
+      break;
+    }
+
+    item = &g_items[g_count++];
+    item->param = param;
+    item->did = MQTT_TELEMETRY_DID(group_id, param->id);
+    item->offset = g_used;
+    g_used += ROUND_UP(len, MQTT_TELEMETRY_VALUE_ALIGN);
+  }
+
+  g_full = true;
+
+  k_mutex_unlock(&g_lock);
+
+  return ret;
+}
+
+/**
+ * @brief Inicia a thread de telemetria
+ *
+ * A conexao e feita em segundo plano e refeita a cada
+ * CONFIG_APP_MQTT_RECONNECT_MS enquanto o broker estiver fora.
+ */
+int mqtt_telemetry_init(const struct mqtt_telemetry_config *config) {
+  if (g_started) {
+    return 0;
+  }
+
+  if (!config || !config->host || !config->client_id || !config->pub_topic) {
+    return -EINVAL;
+  }
+
+  g_config = config;
+
+  k_thread_create(&g_thread, g_stack, K_KERNEL_STACK_SIZEOF(g_stack), mqtt_telemetry_thread, NULL,
+                  NULL, NULL, CONFIG_APP_MQTT_PRIORITY, 0, K_NO_WAIT);
+  k_thread_name_set(&g_thread, "mqtt_tele");
+  g_started = true;
+
+  return 0;
+}
+
+int mqtt_telemetry_get_stats(struct mqtt_telemetry_stats *stats) {
+  if (!stats) {
+    return -EINVAL;
+  }
+
+  k_mutex_lock(&g_lock, K_FOREVER);
+  *stats = g_stats;
+  stats->connected = g_connected;
+  k_mutex_unlock(&g_lock);
+
+  return 0;
+}
+
+static int mqtt_telemetry_shell_cmd_stats(const struct shell *shell, size_t argc, char **argv) {
+  struct mqtt_telemetry_stats stats;
+
+  ARG_UNUSED(argc);
+  ARG_UNUSED(argv);
+
+  mqtt_telemetry_get_stats(&stats);
+
+  shell_print(shell, "broker: %s, connects: %u", stats.connected ? "connected" : "offline",
+              stats.connects);
+  shell_print(shell, "windows: %u, items: %u, published: %u (%u bytes)", stats.windows,
+              stats.items, stats.published, stats.bytes);
+  shell_print(shell, "spool: %u records, peak %u/%u bytes, dropped %u", stats.spooled,
+              stats.spool_peak, CONFIG_APP_MQTT_SPOOL_SIZE, stats.dropped);
+  shell_print(shell, "writes: %u, rejected: %u", stats.writes, stats.write_errors);
+
+  return 0;
+}
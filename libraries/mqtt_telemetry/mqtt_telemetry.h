@@ -0,0 +1,70 @@
+#ifndef _MQTT_TELEMETRY_H
+#define _MQTT_TELEMETRY_H
+
+/* C++ detection */
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <zephyr/sys/util.h>
+#include "database.h"
+
+/*
+ * Formato binario (little endian), o mesmo na publicacao e na escrita:
+ *
+ *   Janela: | versao (1) | flags (1) | seq (2) | uptime ms (4) | itens (2) | item... |
+ *   Item:   | did (2) | tamanho (1) | valor (tamanho) |
+ *
+ * did = (grupo << 8) | parametro, como no UDS. Valores na ordem de bytes da
+ * CPU; strings sem o terminador. Uma escrita recebida usa o mesmo formato
+ * (seq e uptime sao ignorados). A idade de uma janela guardada no spool e a
+ * diferenca para o uptime da janela mais recente.
+ */
+#define MQTT_TELEMETRY_VERSION     (1)
+#define MQTT_TELEMETRY_HEADER_LEN  (10)
+#define MQTT_TELEMETRY_ITEM_LEN    (3)
+#define MQTT_TELEMETRY_FLAG_FULL   BIT(0)   // Retrato completo (conexao ou inicio)
+#define MQTT_TELEMETRY_DID(group, param) ((uint16_t)(((group) << 8) | ((param) & 0xFF)))
+
+/*
+ * Conexao com o broker. As strings devem continuar validas enquanto o servico
+ * roda. communication.h nao e usado aqui: seu enum mqtt_qos colide com o do
+ * cliente MQTT do Zephyr.
+ */
+struct mqtt_telemetry_config {
+  const char *host;             // IPv4 ou nome (com CONFIG_DNS_RESOLVER)
+  uint16_t port;
+  const char *client_id;
+  const char *user_name;        // NULL sem autenticacao
+  const char *password;
+  const char *pub_topic;
+  const char *sub_topic;        // Escritas na base; NULL desliga
+  uint8_t qos;                  // 0 ou 1 (spool so e liberado com PUBACK)
+};
+
+struct mqtt_telemetry_stats {
+  uint32_t windows;             // Janelas com alguma mudanca
+  uint32_t items;               // Parametros enviados
+  uint32_t published;           // Publicacoes confirmadas (ou enviadas em QoS 0)
+  uint32_t bytes;
+  uint32_t spooled;             // Registros no spool agora
+  uint32_t spool_peak;          // Maior ocupacao do spool (bytes)
+  uint32_t dropped;             // Registros descartados com o spool cheio
+  uint32_t writes;              // Escritas recebidas aplicadas
+  uint32_t write_errors;
+  uint32_t connects;
+  bool connected;
+};
+
+int mqtt_telemetry_add_group(db_group_id_t group_id);
+int mqtt_telemetry_init(const struct mqtt_telemetry_config *config);
+int mqtt_telemetry_get_stats(struct mqtt_telemetry_stats *stats);
+
+/* C++ detection */
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* _MQTT_TELEMETRY_H */
@@ -27,87 +27,289 @@ LOG_MODULE_REGISTER(ringtone, CONFIG_LOG_DEFAULT_LEVEL);
 #define NOTE_FS 11 // F#
 #define NOTE_GS 12 // G#
 
-// Tempo mínimo (em ms) para formar a duração 1/32
-#define RTTTL_TIME_MIN(beat) (7500 / beat)
-
-// Definições de frequências base para as notas (4ª oitava)
-static const float NOTE_FREQUENCIES[] = {
-    0,     // p (pausa)
-    440.0, // a - Lá
-    493.9, // b - Si
-    261.6, // c - Dó
-    293.7, // d - Ré
-    329.6, // e - Mi
-    349.2, // f - Fá
-    392.0, // g - Sol
-    466.2, // a# - Lá#
-    277.2, // c# - Dó#
-    311.1, // d# - Ré#
-    370.0, // f# - Fá#
-    415.3  // g# - Sol#
+// Duracao de uma semibreve (1/1) em us para beat = 1
+#define RTTTL_WHOLE_NOTE_US(beat) (240000000U / (beat))
+
+// Valores padrao do formato RTTTL quando nao informados
+#define RTTTL_DEFAULT_DURATION 4
+#define RTTTL_DEFAULT_OCTAVE 6
+#define RTTTL_DEFAULT_BEAT 63
+
+// Oitava de referencia da tabela de periodos
+#define RTTTL_BASE_OCTAVE 4
+
+// Faixa de oitavas aceita: mantem o deslocamento do periodo abaixo de 32 bits
+#define RTTTL_MIN_OCTAVE 1
+#define RTTTL_MAX_OCTAVE 8
+
+// Maior divisor de duracao do formato (1/32)
+#define RTTTL_MAX_DURATION 32
+
+// Periodos (ns) das notas na 4ª oitava, calculados em tempo de compilacao
+// para que a reproducao nao precise de ponto flutuante
+static const uint32_t NOTE_PERIODS_NS[] = {
+    0,       // p (pausa)
+    2272727, // a - Lá
+    2024770, // b - Si
+    3822256, // c - Dó
+    3405243, // d - Ré
+    3033727, // e - Mi
+    2863457, // f - Fá
+    2551050, // g - Sol
+    2145169, // a# - Lá#
+    3607730, // c# - Dó#
+    3214122, // d# - Ré#
+    2702743, // f# - Fá#
+    2407871  // g# - Sol#
 };
 
-// Callback do timer
+// Satura em UINT16_MAX para que numeros longos nao voltem a um valor valido
+static uint16_t rtttl_parse_number(const char **cursor) {
+  uint32_t value = 0;
+
+  while (**cursor >= '0' && **cursor <= '9') {
+    value = MIN((value * 10) + (**cursor - '0'), UINT16_MAX);
+    (*cursor)++;
+  }
+
+  return value;
+}
+
+// Duracoes do formato: 1, 2, 4, 8, 16 ou 32
+static bool rtttl_duration_valid(uint16_t duration) {
+  return (duration > 0) && (duration <= RTTTL_MAX_DURATION) &&
+         ((duration & (duration - 1)) == 0);
+}
+
+static bool rtttl_octave_valid(uint16_t octave) {
+  return (octave >= RTTTL_MIN_OCTAVE) && (octave <= RTTTL_MAX_OCTAVE);
+}
+
+// Le a secao "nome:d=N,o=N,b=N:" e retorna o inicio das notas
+static const char *rtttl_parse_header(const char *rtttl, uint16_t *duration,
+                                      uint16_t *octave, uint16_t *beat) {
+  const char *defaults;
+  const char *notes;
+  uint16_t value;
+  char key;
+
+  defaults = strchr(rtttl, ':');
+  if (defaults == NULL) {
+    // Sem cabecalho, a string contem apenas notas
+    return rtttl;
+  }
+  defaults++;
+
+  notes = strchr(defaults, ':');
+  if (notes == NULL) {
+    // Apenas "nome:notas"
+    return defaults;
+  }
+
+  while (defaults < notes) {
+    key = *defaults++;
+    if (*defaults != '=') {
+      continue;
+    }
+    defaults++;
+
+    value = rtttl_parse_number(&defaults);
+    switch (key) {
+    case 'd':
+      if (value > 0) {
+        *duration = value;
+      }
+      break;
+    case 'o':
+      if (value > 0) {
+        *octave = value;
+      }
+      break;
+    case 'b':
+      if (value > 0) {
+        *beat = value;
+      }
+      break;
+    default:
+      break;
+    }
+  }
+
+  return notes + 1;
+}
+
+// Callback do timer: a nota atual terminou, aplica a proxima
 static void ringtone_timer_callback(struct k_timer *timer) {
   ringstones_t *ringstones = CONTAINER_OF(timer, ringstones_t, timer);
 
-  bool is_playing;
-  bool stop_request;
-  bool note_processed;
-  uint32_t note_end_time;
-  uint32_t current_time;
+  ringtones_process_next_note(ringstones);
+}
 
-  // Verifica parâmetros
-  if (ringstones == NULL) {
-    return;
+/**
+ * @brief Compila uma string RTTTL em uma lista de notas (periodo, pulso,
+ * duracao em ticks). Retorna o numero de notas ou erro negativo.
+ */
+int ringtones_compile(const char *rtttl_string, uint8_t default_duration,
+                      uint8_t default_octave, uint16_t beat_value,
+                      ringtone_note_t *notes, uint16_t max_notes) {
+  const char *cursor;
+  uint16_t header_duration = default_duration;
+  uint16_t header_octave = default_octave;
+  uint16_t duration;
+  uint8_t octave;
+  uint8_t note;
+  bool has_dot;
+  uint32_t note_us;
+  uint32_t period;
+  uint16_t count = 0;
+
+  if ((rtttl_string == NULL) || (notes == NULL)) {
+    return -EINVAL;
   }
 
-  // Adquire o mutex
-  if (k_mutex_lock(&ringstones->mutex, K_MSEC(10)) != 0) {
-    return;
+  // Valores padrao da configuracao, sobrescritos pelo cabecalho RTTTL
+  if (header_duration == 0) {
+    header_duration = RTTTL_DEFAULT_DURATION;
+  }
+  if (header_octave == 0) {
+    header_octave = RTTTL_DEFAULT_OCTAVE;
+  }
+  if (beat_value == 0) {
+    beat_value = RTTTL_DEFAULT_BEAT;
   }
 
-  // Copia variáveis locais para minimizar tempo com mutex bloqueado
-  is_playing = ringstones->is_playing;
-  stop_request = ringstones->stop_request;
-  note_processed = ringstones->note_processed;
-  note_end_time = ringstones->note_end_time;
+  cursor = rtttl_parse_header(rtttl_string, &header_duration, &header_octave,
+                              &beat_value);
 
-  // Captura o tempo atual para comparação
-  current_time = k_uptime_get_32();
+  // A string pode vir de fora (Buzzer_PlayCustom): duracao zero divide por
+  // zero e oitava fora da tabela desloca o periodo 32 bits ou mais
+  if (!rtttl_duration_valid(header_duration) ||
+      !rtttl_octave_valid(header_octave)) {
+    return -EINVAL;
+  }
 
-  // Verifica se precisa processar próxima nota
-  if (is_playing && (note_processed || (current_time >= note_end_time))) {
-    ringstones->note_processed = 0; // Marca como não processada
+  while (*cursor != '\0') {
+    // Ignora separadores
+    if (*cursor == ',' || *cursor == ' ') {
+      cursor++;
+      continue;
+    }
 
-    // Libera o mutex antes de processar a nota
-    k_mutex_unlock(&ringstones->mutex);
+    // Parse da duração
+    duration = rtttl_parse_number(&cursor);
+    if (duration == 0) {
+      duration = header_duration;
+    } else if (!rtttl_duration_valid(duration)) {
+      return -EINVAL;
+    }
 
-    // Processa a próxima nota fora do mutex
-    ringtones_process_next_note(ringstones);
-  } else {
-    // Libera o mutex
-    k_mutex_unlock(&ringstones->mutex);
-  }
+    // Parse da nota
+    switch (*cursor) {
+    case 'a':
+    case 'A':
+      note = NOTE_A;
+      break;
+    case 'b':
+    case 'B':
+      note = NOTE_B;
+      break;
+    case 'c':
+    case 'C':
+      note = NOTE_C;
+      break;
+    case 'd':
+    case 'D':
+      note = NOTE_D;
+      break;
+    case 'e':
+    case 'E':
+      note = NOTE_E;
+      break;
+    case 'f':
+    case 'F':
+      note = NOTE_F;
+      break;
+    case 'g':
+    case 'G':
+      note = NOTE_G;
+      break;
+    case 'p':
+    case 'P':
+      note = NOTE_P;
+      break;
+    default:
+      // Caractere inválido, avança para o próximo
+      cursor++;
+      continue;
+    }
+    cursor++;
+
+    // Verifica se é sustenido
+    if (*cursor == '#') {
+      switch (note) {
+      case NOTE_A:
+        note = NOTE_AS;
+        break;
+      case NOTE_C:
+        note = NOTE_CS;
+        break;
+      case NOTE_D:
+        note = NOTE_DS;
+        break;
+      case NOTE_F:
+        note = NOTE_FS;
+        break;
+      case NOTE_G:
+        note = NOTE_GS;
+        break;
+      }
+      cursor++;
+    }
 
-  // Se houver solicitação de parada, processa isso
-  if (stop_request) {
-    // Desliga o PWM
-    pwm_set_pulse_dt(ringstones->config.buzzer_pwm, 0);
+    // O ponto pode vir antes ou depois da oitava
+    has_dot = false;
+    if (*cursor == '.') {
+      has_dot = true;
+      cursor++;
+    }
 
-    // Atualiza status
-    if (k_mutex_lock(&ringstones->mutex, K_NO_WAIT) == 0) {
-      ringstones->is_playing = 0;
-      ringstones->stop_request = 0;
-      k_mutex_unlock(&ringstones->mutex);
+    // Verifica oitava
+    octave = header_octave;
+    if (*cursor >= '0' + RTTTL_MIN_OCTAVE && *cursor <= '0' + RTTTL_MAX_OCTAVE) {
+      octave = *cursor - '0';
+      cursor++;
     }
 
-    // Para o timer
-    k_timer_stop(timer);
+    if (*cursor == '.') {
+      has_dot = true;
+      cursor++;
+    }
 
-    // Sinaliza conclusão
-    k_sem_give(&ringstones->done_semaphore);
+    if (count >= max_notes) {
+      return -ENOMEM;
+    }
+
+    // Calcula o tempo da nota (ponto aumenta a duração em 50%)
+    note_us = RTTTL_WHOLE_NOTE_US(beat_value) / duration;
+    if (has_dot) {
+      note_us += note_us / 2;
+    }
+
+    // Ajusta o período para a oitava: cada oitava dobra a frequência
+    period = NOTE_PERIODS_NS[note];
+    if (octave > RTTTL_BASE_OCTAVE) {
+      period >>= (octave - RTTTL_BASE_OCTAVE);
+    } else {
+      period <<= (RTTTL_BASE_OCTAVE - octave);
+    }
+
+    notes[count].period = period;
+    notes[count].pulse = period / 2; // 50% duty cycle
+    notes[count].ticks = k_us_to_ticks_near32(note_us);
+    count++;
   }
+
+  return count;
 }
 
 /**
@@ -124,26 +326,22 @@ int ringtones_init(ringstones_t *ringstones,
 
   // Configura a estrutura
   ringstones->config.buzzer_pwm = buzzer_pwm;
-  ringstones->config.rtttl_string = rtttl_string;
   ringstones->config.default_duration = default_duration;
   ringstones->config.default_octave = default_octave;
   ringstones->config.beat_value = beat_value;
   ringstones->current_index = 0;
   ringstones->is_playing = 0;
-  ringstones->stop_request = 0;
-  ringstones->note_end_time = 0;
-  ringstones->note_processed = 1; // Começa como processada para iniciar nova nota
-
-  // Inicializa mutex para proteção dos dados
-  k_mutex_init(&ringstones->mutex);
+  ringstones->note_deadline = 0;
+  ringstones->done_cb = NULL;
+  ringstones->done_user_data = NULL;
 
-  // Inicializa semáforo para sinalizar conclusão
+  // Inicializa semáforo para sinalizar conclusao
   k_sem_init(&ringstones->done_semaphore, 0, 1);
 
   // Inicializa o timer
   k_timer_init(&ringstones->timer, ringtone_timer_callback, NULL);
 
-  return 0;
+  return ringtones_set_rtttl(ringstones, rtttl_string);
 }
 
 /**
@@ -160,40 +358,118 @@ int ringtones_deinit(ringstones_t *ringstones) {
   return 0;
 }
 
+/**
+ * @brief Compila uma string RTTTL no buffer interno e a seleciona
+ */
+int ringtones_set_rtttl(ringstones_t *ringstones, const char *rtttl_string) {
+  int count;
+
+  if ((ringstones == NULL) || (rtttl_string == NULL)) {
+    return -EINVAL;
+  }
+
+  if (ringtones_is_playing(ringstones)) {
+    return -EBUSY;
+  }
+
+  count = ringtones_compile(rtttl_string, ringstones->config.default_duration,
+                            ringstones->config.default_octave,
+                            ringstones->config.beat_value,
+                            ringstones->notes_buffer, RINGTONE_MAX_NOTES);
+  if (count < 0) {
+    LOG_ERR("Failed to compile RTTTL: %d", count);
+    return count;
+  }
+
+  ringstones->config.rtttl_string = rtttl_string;
+
+  return ringtones_set_notes(ringstones, ringstones->notes_buffer, count);
+}
+
+/**
+ * @brief Seleciona uma musica ja compilada (ex.: tabelas estaticas)
+ */
+int ringtones_set_notes(ringstones_t *ringstones, const ringtone_note_t *notes,
+                        uint16_t note_count) {
+  k_spinlock_key_t key;
+  int ret = 0;
+
+  if ((ringstones == NULL) || (notes == NULL)) {
+    return -EINVAL;
+  }
+
+  key = k_spin_lock(&ringstones->lock);
+
+  if (ringstones->is_playing) {
+    ret = -EBUSY;
+  } else {
+    ringstones->notes = notes;
+    ringstones->note_count = note_count;
+    ringstones->current_index = 0;
+  }
+
+  k_spin_unlock(&ringstones->lock, key);
+
+  return ret;
+}
+
+/**
+ * @brief Registra o callback de fim da musica (nao chamado em ringtones_stop)
+ */
+int ringtones_set_done_callback(ringstones_t *ringstones,
+                                ringtones_done_cb_t done_cb, void *user_data) {
+  k_spinlock_key_t key;
+
+  if (ringstones == NULL) {
+    return -EINVAL;
+  }
+
+  key = k_spin_lock(&ringstones->lock);
+  ringstones->done_cb = done_cb;
+  ringstones->done_user_data = user_data;
+  k_spin_unlock(&ringstones->lock, key);
+
+  return 0;
+}
+
 /**
  * @brief Inicia a reprodução do ringtone
  */
 int ringtones_play(ringstones_t *ringstones) {
+  return ringtones_play_from(ringstones, 0);
+}
+
+/**
+ * @brief Inicia a reprodução a partir de uma nota (ex.: retomar uma musica
+ * interrompida). Pode ser chamada de qualquer contexto.
+ */
+int ringtones_play_from(ringstones_t *ringstones, uint16_t index) {
+  k_spinlock_key_t key;
+
   if (ringstones == NULL) {
     return -EINVAL;
   }
 
-  // Adquire o mutex
-  if (k_mutex_lock(&ringstones->mutex, K_MSEC(100)) != 0) {
-    return -EAGAIN;
-  }
+  key = k_spin_lock(&ringstones->lock);
 
   // Se já está tocando, não faz nada
   if (ringstones->is_playing) {
-    k_mutex_unlock(&ringstones->mutex);
+    k_spin_unlock(&ringstones->lock, key);
     return 0;
   }
 
-  // Reinicia o índice e limpa flag de parada
-  ringstones->current_index = 0;
-  ringstones->stop_request = 0;
+  // Posiciona o índice; a primeira nota começa agora
+  ringstones->current_index = index;
   ringstones->is_playing = 1;
-  ringstones->note_processed = 1; // Para processar a primeira nota imediatamente
-  ringstones->note_end_time = 0;
+  ringstones->note_deadline = k_uptime_ticks();
 
-  // Libera o mutex
-  k_mutex_unlock(&ringstones->mutex);
+  k_spin_unlock(&ringstones->lock, key);
 
   // Reinicia o semáforo de conclusão
   k_sem_reset(&ringstones->done_semaphore);
 
-  // Inicia o timer (1ms interval)
-  k_timer_start(&ringstones->timer, K_MSEC(1), K_MSEC(5));
+  // Aplica a primeira nota; as seguintes são aplicadas pelo timer
+  ringtones_process_next_note(ringstones);
 
   return 0;
 }
@@ -202,33 +478,27 @@ int ringtones_play(ringstones_t *ringstones) {
  * @brief Para a reprodução do ringtone
  */
 int ringtones_stop(ringstones_t *ringstones) {
+  k_spinlock_key_t key;
+
   if (ringstones == NULL) {
     return -EINVAL;
   }
 
-  // Adquire o mutex
-  if (k_mutex_lock(&ringstones->mutex, K_MSEC(100)) != 0) {
-    return -EAGAIN;
-  }
+  key = k_spin_lock(&ringstones->lock);
 
   // Se não está tocando, não faz nada
   if (!ringstones->is_playing) {
-    k_mutex_unlock(&ringstones->mutex);
+    k_spin_unlock(&ringstones->lock, key);
     return 0;
   }
 
-  // Solicita parada
-  ringstones->stop_request = 1;
   ringstones->is_playing = 0;
 
-  // Libera o mutex
-  k_mutex_unlock(&ringstones->mutex);
-
-  // Desliga o PWM
+  // Para o timer e desliga o PWM
+  k_timer_stop(&ringstones->timer);
   pwm_set_pulse_dt(ringstones->config.buzzer_pwm, 0);
 
-  // Para o timer
-  k_timer_stop(&ringstones->timer);
+  k_spin_unlock(&ringstones->lock, key);
 
   // Sinaliza conclusão
   k_sem_give(&ringstones->done_semaphore);
@@ -237,22 +507,35 @@ int ringtones_stop(ringstones_t *ringstones) {
 }
 
 /**
- * @brief Verifica se o ringtone está tocando
+ * @brief Retorna o indice da nota em reproducao (ou da proxima, se parado)
  */
-bool ringtones_is_playing(ringstones_t *ringstones) {
-  bool is_playing = false;
+uint16_t ringtones_get_position(ringstones_t *ringstones) {
+  k_spinlock_key_t key;
+  uint16_t position;
 
   if (ringstones == NULL) {
-    return false;
+    return 0;
+  }
+
+  key = k_spin_lock(&ringstones->lock);
+  position = ringstones->current_index;
+  if (ringstones->is_playing && position > 0) {
+    position--;
   }
+  k_spin_unlock(&ringstones->lock, key);
+
+  return position;
+}
 
-  // Adquire o mutex
-  if (k_mutex_lock(&ringstones->mutex, K_MSEC(10)) == 0) {
-    is_playing = ringstones->is_playing;
-    k_mutex_unlock(&ringstones->mutex);
+/**
+ * @brief Verifica se o ringtone está tocando
+ */
+bool ringtones_is_playing(ringstones_t *ringstones) {
+  if (ringstones == NULL) {
+    return false;
   }
 
-  return is_playing;
+  return ringstones->is_playing;
 }
 
 /**
@@ -272,197 +555,57 @@ int ringtones_wait_done(ringstones_t *ringstones, k_timeout_t timeout) {
 }
 
 /**
- * @brief Processa a próxima nota
+ * @brief Aplica a próxima nota compilada e rearma o timer para o fim dela
  */
 void ringtones_process_next_note(ringstones_t *ringstones) {
-  const char *rtttl;
-  uint16_t index;
-  uint8_t duration;
-  uint8_t octave;
-  uint8_t note;
-  uint8_t has_dot;
-  uint8_t is_pause;
-  uint16_t note_time;
-  uint32_t current_time;
-  float freq;
-  uint32_t pulse_width;
-
-  // Adquire o mutex
-  if (k_mutex_lock(&ringstones->mutex, K_NO_WAIT) != 0) {
-    return;
-  }
+  const ringtone_note_t *note;
+  ringtones_done_cb_t done_cb;
+  void *done_user_data;
+  k_spinlock_key_t key;
+  int ret = 0;
 
-  // Copia variáveis locais
-  rtttl = ringstones->config.rtttl_string;
-  index = ringstones->current_index;
+  key = k_spin_lock(&ringstones->lock);
 
   // Se não está tocando, sai
   if (!ringstones->is_playing) {
-    k_mutex_unlock(&ringstones->mutex);
+    k_spin_unlock(&ringstones->lock, key);
     return;
   }
 
   // Verifica final da música
-  if (rtttl[index] == '\0') {
-    // Desliga o PWM
+  if (ringstones->current_index >= ringstones->note_count) {
     pwm_set_pulse_dt(ringstones->config.buzzer_pwm, 0);
-
-    // Atualiza status
     ringstones->is_playing = 0;
     ringstones->current_index = 0;
-
-    // Libera o mutex
-    k_mutex_unlock(&ringstones->mutex);
-
-    // Para o timer
-    k_timer_stop(&ringstones->timer);
+    done_cb = ringstones->done_cb;
+    done_user_data = ringstones->done_user_data;
+    k_spin_unlock(&ringstones->lock, key);
 
     // Sinaliza conclusão
     k_sem_give(&ringstones->done_semaphore);
-
-    return;
-  }
-
-  // Configura valores padrão
-  duration = ringstones->config.default_duration;
-  octave = ringstones->config.default_octave;
-  has_dot = 0;
-  is_pause = 0;
-
-  // Parse da duração
-  if (rtttl[index] >= '0' && rtttl[index] <= '9') {
-    if (index + 1 < strlen(rtttl) && rtttl[index + 1] >= '0' &&
-        rtttl[index + 1] <= '9') {
-      // Duração de dois dígitos (16, 32)
-      duration = (rtttl[index] - '0') * 10 + (rtttl[index + 1] - '0');
-      index += 2;
-    } else {
-      // Duração de um dígito (1, 2, 4, 8)
-      duration = rtttl[index] - '0';
-      index++;
+    if (done_cb != NULL) {
+      done_cb(done_user_data);
     }
-  }
-
-  // Parse da nota
-  switch (rtttl[index]) {
-  case 'a':
-    note = NOTE_A;
-    break;
-  case 'b':
-    note = NOTE_B;
-    break;
-  case 'c':
-    note = NOTE_C;
-    break;
-  case 'd':
-    note = NOTE_D;
-    break;
-  case 'e':
-    note = NOTE_E;
-    break;
-  case 'f':
-    note = NOTE_F;
-    break;
-  case 'g':
-    note = NOTE_G;
-    break;
-  case 'p':
-    note = NOTE_P;
-    is_pause = 1;
-    break;
-  default:
-    // Nota inválida, avança para o próximo caractere
-    ringstones->current_index = index + 1;
-    k_mutex_unlock(&ringstones->mutex);
     return;
   }
-  index++;
 
-  // Verifica se é sustenido
-  if (index < strlen(rtttl) && rtttl[index] == '#') {
-    switch (note) {
-    case NOTE_A:
-      note = NOTE_AS;
-      break;
-    case NOTE_C:
-      note = NOTE_CS;
-      break;
-    case NOTE_D:
-      note = NOTE_DS;
-      break;
-    case NOTE_F:
-      note = NOTE_FS;
-      break;
-    case NOTE_G:
-      note = NOTE_GS;
-      break;
-    }
-    index++;
-  }
+  note = &ringstones->notes[ringstones->current_index++];
 
-  // Verifica oitava
-  if (index < strlen(rtttl) && rtttl[index] >= '4' && rtttl[index] <= '7') {
-    octave = rtttl[index] - '0';
-    index++;
-  }
+  // O fim da nota é absoluto, então a latência do timer não se acumula
+  ringstones->note_deadline += note->ticks;
+  k_timer_start(&ringstones->timer,
+                K_TIMEOUT_ABS_TICKS(ringstones->note_deadline), K_NO_WAIT);
 
-  // Verifica se tem ponto (aumenta duração em 50%)
-  if (index < strlen(rtttl) && rtttl[index] == '.') {
-    has_dot = 1;
-    index++;
-  }
-
-  // Calcula o tempo da nota
-  uint8_t n = 32 / duration;
-  if (has_dot) {
-    n = n + (n / 2);
-  }
-
-  note_time = n * RTTTL_TIME_MIN(ringstones->config.beat_value);
-
-  // Atualiza o índice para o próximo caractere
-  if (index < strlen(rtttl) && rtttl[index] == ',') {
-    index++;
+  // O PWM é atualizado sob o lock para não competir com ringtones_stop()
+  if (note->period == 0) {
+    ret = pwm_set_pulse_dt(ringstones->config.buzzer_pwm, 0);
+  } else {
+    ret = pwm_set_dt(ringstones->config.buzzer_pwm, note->period, note->pulse);
   }
 
-  // Captura o tempo atual
-  current_time = k_uptime_get_32();
+  k_spin_unlock(&ringstones->lock, key);
 
-  // Atualiza o tempo de término da nota
-  ringstones->note_end_time = current_time + note_time;
-  ringstones->current_index = index;
-
-  // Libera o mutex
-  k_mutex_unlock(&ringstones->mutex);
-
-  // Configura a frequência da nota
-  if (is_pause) {
-    // Para pausas, desliga o PWM
-    pwm_set_pulse_dt(ringstones->config.buzzer_pwm, 0);
-  } else {
-    // Calcula a frequência baseada na nota e oitava
-    freq = NOTE_FREQUENCIES[note];
-
-    // Ajusta a frequência para a oitava
-    if (octave > 4) {
-      // Para oitavas acima de 4, dobra a frequência para cada oitava
-      for (int i = 4; i < octave; i++) {
-        freq *= 2.0f;
-      }
-    } else if (octave < 4) {
-      // Para oitavas abaixo de 4, reduz a frequência pela metade para cada
-      // oitava
-      for (int i = octave; i < 4; i++) {
-        freq /= 2.0f;
-      }
-    }
-
-    // Configura o PWM com a frequência calculada
-    uint32_t period = (uint32_t)(1000000000 / freq); // Nanosegundos
-    pulse_width = period / 2;                        // 50% duty cycle
-    int ret = pwm_set_dt(ringstones->config.buzzer_pwm, period, pulse_width);
-    if (ret) {
-      LOG_ERR("Failed to set PWM: %d", ret);
-    }
+  if (ret) {
+    LOG_ERR("Failed to set PWM: %d", ret);
   }
-}
\ No newline at end of file
+}
@@ -15,6 +15,16 @@
  extern "C" {
  #endif
  
+ // Numero maximo de notas de uma musica compilada
+ #define RINGTONE_MAX_NOTES 64
+ 
+ // Nota pre-compilada, pronta para ser aplicada no PWM
+ typedef struct {
+     uint32_t period;                       // Periodo do PWM em ns (0 = pausa)
+     uint32_t pulse;                        // Largura do pulso em ns
+     uint32_t ticks;                        // Duracao da nota em ticks do kernel
+ } ringtone_note_t;
+ 
  // Estrutura para configuracao do Ringtone
  typedef struct {
      const struct pwm_dt_spec *buzzer_pwm;  // Spec do PWM a ser usado
@@ -24,26 +34,42 @@
      uint16_t beat_value;                   // Valor de batida (quanto maior, mais rápido)
  } ringtones_config_t;
  
+ // Callback chamado (em contexto de timer) quando a musica termina
+ typedef void (*ringtones_done_cb_t)(void *user_data);
+ 
  // Estrutura para controle interno
  typedef struct {
      ringtones_config_t config;
-     struct k_mutex mutex;                 // Mutex para protecao
+     struct k_spinlock lock;               // Protege o estado compartilhado com o timer
      struct k_sem done_semaphore;          // Semáforo para sinalizar conclusao
-     struct k_timer timer;                 // Timer para controle de tempo
+     struct k_timer timer;                 // Timer one-shot rearmado a cada nota
+     const ringtone_note_t *notes;         // Musica compilada em reproducao
+     uint16_t note_count;                  // Numero de notas da musica
+     uint16_t current_index;               // Indice da proxima nota
+     k_ticks_t note_deadline;              // Instante absoluto (ticks) do fim da nota
      uint8_t is_playing;                   // Flag de reproducao
-     uint8_t stop_request;                 // Flag para solicitar parada
-     uint16_t current_index;               // Indice atual na string RTTTL
-     uint32_t note_end_time;               // Tempo em que a nota atual deve terminar
-     uint8_t note_processed;               // Flag indicando se a nota atual foi processada
+     ringtones_done_cb_t done_cb;          // Callback opcional de fim da musica
+     void *done_user_data;                 // Parametro do callback
+     ringtone_note_t notes_buffer[RINGTONE_MAX_NOTES]; // Musica compilada de config.rtttl_string
  } ringstones_t;
  
  // Funcoes exportadas
  int ringtones_init(ringstones_t *ringstones, const struct pwm_dt_spec *buzzer_pwm,
 		   const char *rtttl_string, uint8_t default_duration,
 		   uint8_t default_octave, uint16_t beat_value);
-		   
+ 
  int ringtones_deinit(ringstones_t *ringstones);
+ int ringtones_compile(const char *rtttl_string, uint8_t default_duration,
+                       uint8_t default_octave, uint16_t beat_value,
+                       ringtone_note_t *notes, uint16_t max_notes);
+ int ringtones_set_rtttl(ringstones_t *ringstones, const char *rtttl_string);
+ int ringtones_set_notes(ringstones_t *ringstones, const ringtone_note_t *notes,
+                         uint16_t note_count);
+ int ringtones_set_done_callback(ringstones_t *ringstones, ringtones_done_cb_t done_cb,
+                                 void *user_data);
  int ringtones_play(ringstones_t *ringstones);
+ int ringtones_play_from(ringstones_t *ringstones, uint16_t index);
+ uint16_t ringtones_get_position(ringstones_t *ringstones);
  int ringtones_stop(ringstones_t *ringstones);
  bool ringtones_is_playing(ringstones_t *ringstones);
  int ringtones_wait_done(ringstones_t *ringstones, k_timeout_t timeout);
@@ -0,0 +1,234 @@
+/**
+ * @file    ringtone_manager.c
+ * @brief   Gerenciador de reproducao do buzzer com prioridades, fila limitada,
+ * preempcao e retomada. Todas as funcoes sao nao bloqueantes e podem ser
+ * chamadas de qualquer contexto (thread, work queue ou ISR).
+ */
+
+#include "ringtone_manager.h"
+#include <string.h>
+#include <zephyr/logging/log.h>
+
+LOG_MODULE_REGISTER(ringtone_manager, CONFIG_LOG_DEFAULT_LEVEL);
+
+static void ringtone_manager_start(ringtone_manager_t *manager,
+                                   const ringtone_request_t *request);
+static int ringtone_queue_insert(ringtone_manager_t *manager,
+                                 const ringtone_request_t *request, bool front);
+static void ringtone_queue_pop(ringtone_manager_t *manager,
+                               ringtone_request_t *request);
+static void ringtone_manager_done(void *user_data);
+
+// Inicia um pedido no player; chamada com o lock do gerenciador adquirido
+static void ringtone_manager_start(ringtone_manager_t *manager,
+                                   const ringtone_request_t *request) {
+  manager->active = *request;
+  manager->active_valid = true;
+
+  ringtones_set_notes(manager->player, request->notes, request->note_count);
+  ringtones_play_from(manager->player, request->start_index);
+}
+
+// Mantem a fila ordenada por prioridade (maior primeiro), FIFO dentro da mesma
+// prioridade. Pedidos retomados entram na frente dos de mesma prioridade.
+static int ringtone_queue_insert(ringtone_manager_t *manager,
+                                 const ringtone_request_t *request, bool front) {
+  uint8_t pos = 0;
+
+  if (manager->queue_count >= RINGTONE_QUEUE_SIZE) {
+    // Fila cheia: so aceita se puder descartar um pedido de menor prioridade
+    if (manager->queue[manager->queue_count - 1].priority >= request->priority) {
+      manager->stats.dropped++;
+      return -ENOMEM;
+    }
+    manager->queue_count--;
+    manager->stats.dropped++;
+  }
+
+  while ((pos < manager->queue_count) &&
+         ((manager->queue[pos].priority > request->priority) ||
+          (!front && (manager->queue[pos].priority == request->priority)))) {
+    pos++;
+  }
+
+  memmove(&manager->queue[pos + 1], &manager->queue[pos],
+          (manager->queue_count - pos) * sizeof(ringtone_request_t));
+  manager->queue[pos] = *request;
+  manager->queue_count++;
+
+  return 0;
+}
+
+static void ringtone_queue_pop(ringtone_manager_t *manager,
+                               ringtone_request_t *request) {
+  *request = manager->queue[0];
+  manager->queue_count--;
+  memmove(&manager->queue[0], &manager->queue[1],
+          manager->queue_count * sizeof(ringtone_request_t));
+}
+
+// Fim natural de uma musica (contexto do timer): inicia o proximo pendente
+static void ringtone_manager_done(void *user_data) {
+  ringtone_manager_t *manager = user_data;
+  ringtone_request_t next;
+  k_spinlock_key_t key;
+
+  key = k_spin_lock(&manager->lock);
+
+  // Uma preempcao pode ter iniciado outra musica antes deste callback
+  if (ringtones_is_playing(manager->player)) {
+    k_spin_unlock(&manager->lock, key);
+    return;
+  }
+
+  manager->active_valid = false;
+
+  if (manager->queue_count > 0) {
+    ringtone_queue_pop(manager, &next);
+    ringtone_manager_start(manager, &next);
+  }
+
+  k_spin_unlock(&manager->lock, key);
+}
+
+/**
+ * @brief Inicializa o gerenciador sobre um player ja inicializado
+ */
+int ringtone_manager_init(ringtone_manager_t *manager, ringstones_t *player) {
+  if ((manager == NULL) || (player == NULL)) {
+    return -EINVAL;
+  }
+
+  memset(manager, 0, sizeof(ringtone_manager_t));
+  manager->player = player;
+
+  return ringtones_set_done_callback(player, ringtone_manager_done, manager);
+}
+
+/**
+ * @brief Pede a reproducao de uma musica pre-compilada. Nunca bloqueia: uma
+ * prioridade maior que a atual comeca imediatamente, as demais entram na fila.
+ */
+int ringtone_manager_enqueue(ringtone_manager_t *manager,
+                             const ringtone_note_t *notes, uint16_t note_count,
+                             ringtone_priority_t priority, uint8_t flags) {
+  ringtone_request_t request;
+  ringtone_request_t preempted;
+  k_spinlock_key_t key;
+  int ret = 0;
+
+  if ((manager == NULL) || (notes == NULL) || (note_count == 0) ||
+      (priority >= RINGTONE_PRIO_MAX)) {
+    return -EINVAL;
+  }
+
+  request.notes = notes;
+  request.note_count = note_count;
+  request.start_index = 0;
+  request.priority = priority;
+  request.flags = flags;
+
+  key = k_spin_lock(&manager->lock);
+
+  if (flags & RINGTONE_FLAG_COALESCE) {
+    bool duplicate = manager->active_valid && (manager->active.notes == notes) &&
+                     ringtones_is_playing(manager->player);
+
+    for (uint8_t i = 0; (i < manager->queue_count) && !duplicate; i++) {
+      duplicate = (manager->queue[i].notes == notes);
+    }
+
+    if (duplicate) {
+      manager->stats.coalesced++;
+      k_spin_unlock(&manager->lock, key);
+      return 0;
+    }
+  }
+
+  if (!manager->active_valid || !ringtones_is_playing(manager->player)) {
+    // Buzzer livre
+    ringtone_manager_start(manager, &request);
+    manager->stats.enqueued++;
+  } else if (priority > manager->active.priority) {
+    // Preempcao: guarda a posicao antes de parar
+    preempted = manager->active;
+    preempted.start_index = ringtones_get_position(manager->player);
+    ringtones_stop(manager->player);
+    manager->stats.preempted++;
+
+    if ((preempted.flags & RINGTONE_FLAG_RESUME) &&
+        (preempted.start_index < preempted.note_count)) {
+      ringtone_queue_insert(manager, &preempted, true);
+    }
+
+    ringtone_manager_start(manager, &request);
+    manager->stats.enqueued++;
+  } else if (flags & RINGTONE_FLAG_DISCARD_IF_BUSY) {
+    manager->stats.dropped++;
+    ret = -EBUSY;
+  } else {
+    ret = ringtone_queue_insert(manager, &request, false);
+    if (ret == 0) {
+      manager->stats.enqueued++;
+    }
+  }
+
+  k_spin_unlock(&manager->lock, key);
+
+  return ret;
+}
+
+/**
+ * @brief Remove os pedidos de uma prioridade (fila e reproducao atual)
+ */
+int ringtone_manager_cancel(ringtone_manager_t *manager,
+                            ringtone_priority_t priority) {
+  ringtone_request_t next;
+  k_spinlock_key_t key;
+  uint8_t kept = 0;
+
+  if ((manager == NULL) || (priority >= RINGTONE_PRIO_MAX)) {
+    return -EINVAL;
+  }
+
+  key = k_spin_lock(&manager->lock);
+
+  for (uint8_t i = 0; i < manager->queue_count; i++) {
+    if (manager->queue[i].priority != priority) {
+      manager->queue[kept++] = manager->queue[i];
+    }
+  }
+  manager->queue_count = kept;
+
+  if (manager->active_valid && (manager->active.priority == priority)) {
+    ringtones_stop(manager->player);
+    manager->active_valid = false;
+
+    if (manager->queue_count > 0) {
+      ringtone_queue_pop(manager, &next);
+      ringtone_manager_start(manager, &next);
+    }
+  }
+
+  k_spin_unlock(&manager->lock, key);
+
+  return 0;
+}
+
+/**
+ * @brief Copia os contadores do gerenciador
+ */
+int ringtone_manager_get_stats(ringtone_manager_t *manager,
+                               ringtone_manager_stats_t *stats) {
+  k_spinlock_key_t key;
+
+  if ((manager == NULL) || (stats == NULL)) {
+    return -EINVAL;
+  }
+
+  key = k_spin_lock(&manager->lock);
+  *stats = manager->stats;
+  k_spin_unlock(&manager->lock, key);
+
+  return 0;
+}
\ No newline at end of file
@@ -0,0 +1,71 @@
+/**
+ * @file    ringtone_manager.h
+ * @brief   Fila de reproducao com prioridades para o buzzer
+ */
+
+ #ifndef __RINGTONE_MANAGER_H_
+ #define __RINGTONE_MANAGER_H_
+
+ #include "ringtone.h"
+ #include <zephyr/kernel.h>
+ #include <stdint.h>
+
+ /* C++ detection */
+ #ifdef __cplusplus
+ extern "C" {
+ #endif
+
+ // Tamanho maximo da fila de pedidos pendentes
+ #define RINGTONE_QUEUE_SIZE 8
+
+ // Niveis de prioridade: uma prioridade maior interrompe uma menor
+ typedef enum {
+     RINGTONE_PRIO_LOW = 0,                // Feedback de toque
+     RINGTONE_PRIO_NORMAL,                 // Notificacoes gerais
+     RINGTONE_PRIO_HIGH,                   // Alarmes
+     RINGTONE_PRIO_MAX,
+ } ringtone_priority_t;
+
+ // Flags de cada pedido
+ #define RINGTONE_FLAG_COALESCE        BIT(0)  // Descarta se a mesma musica ja esta tocando/na fila
+ #define RINGTONE_FLAG_RESUME          BIT(1)  // Retoma do ponto onde foi interrompida
+ #define RINGTONE_FLAG_DISCARD_IF_BUSY BIT(2)  // Nao entra na fila se nao puder tocar agora
+
+ typedef struct {
+     const ringtone_note_t *notes;         // Musica pre-compilada
+     uint16_t note_count;                  // Numero de notas
+     uint16_t start_index;                 // Nota inicial (retomada)
+     uint8_t priority;                     // ringtone_priority_t
+     uint8_t flags;                        // RINGTONE_FLAG_*
+ } ringtone_request_t;
+
+ typedef struct {
+     uint32_t enqueued;                    // Pedidos aceitos
+     uint32_t coalesced;                   // Pedidos descartados por duplicidade
+     uint32_t preempted;                   // Musicas interrompidas por prioridade maior
+     uint32_t dropped;                     // Pedidos descartados (fila cheia/ocupado)
+ } ringtone_manager_stats_t;
+
+ typedef struct {
+     ringstones_t *player;                 // Player controlado pelo gerenciador
+     struct k_spinlock lock;               // Protege fila e pedido ativo
+     ringtone_request_t active;            // Pedido em reproducao
+     bool active_valid;                    // Existe pedido em reproducao
+     ringtone_request_t queue[RINGTONE_QUEUE_SIZE]; // Pendentes, ordem de prioridade
+     uint8_t queue_count;                  // Numero de pendentes
+     ringtone_manager_stats_t stats;       // Contadores
+ } ringtone_manager_t;
+
+ int ringtone_manager_init(ringtone_manager_t *manager, ringstones_t *player);
+ int ringtone_manager_enqueue(ringtone_manager_t *manager, const ringtone_note_t *notes,
+                              uint16_t note_count, ringtone_priority_t priority,
+                              uint8_t flags);
+ int ringtone_manager_cancel(ringtone_manager_t *manager, ringtone_priority_t priority);
+ int ringtone_manager_get_stats(ringtone_manager_t *manager,
+                                ringtone_manager_stats_t *stats);
+
+ #ifdef __cplusplus
+ }
+ #endif
+
+ #endif /* __RINGTONE_MANAGER_H_ */
\ No newline at end of file
@@ -0,0 +1,99 @@
+#include "app_dma.h"
+#include <errno.h>
+#include <zephyr/cache.h>
+#include <zephyr/init.h>
+#include <zephyr/kernel.h>
+#include <zephyr/sys/sys_heap.h>
+#include <zephyr/sys/util.h>
+
+#if defined(CONFIG_APP_DMA_NOCACHE)
+// Regiao nao cacheavel configurada pelo MPU: manutencao de cache dispensada
+#define APP_DMA_MEM_ATTRIBUTES __nocache
+#else
+#define APP_DMA_MEM_ATTRIBUTES Z_GENERIC_SECTION(.app_dma)
+#endif
+
+#define APP_DMA_HEAP_SIZE ROUND_UP(CONFIG_APP_DMA_HEAP_SIZE, APP_DMA_ALIGN)
+
+static uint8_t __aligned(APP_DMA_ALIGN) dma_memory[APP_DMA_HEAP_SIZE] APP_DMA_MEM_ATTRIBUTES;
+static struct k_heap dma_heap;
+
+static int app_dma_init(void);
+
+static int app_dma_init(void) {
+  k_heap_init(&dma_heap, dma_memory, sizeof(dma_memory));
+  return 0;
+}
+
+SYS_INIT(app_dma_init, POST_KERNEL, CONFIG_APPLICATION_INIT_PRIORITY);
+
+void *app_dma_alloc(size_t size) {
+  if (size == 0) {
+    return NULL;
+  }
+
+  return k_heap_aligned_alloc(&dma_heap, APP_DMA_ALIGN, ROUND_UP(size, APP_DMA_ALIGN),
+                              K_NO_WAIT);
+}
+
+void app_dma_free(void *buf) {
+  if (buf) {
+    k_heap_free(&dma_heap, buf);
+  }
+}
+
+int app_dma_get_stats(struct sys_memory_stats *stats) {
+  return sys_heap_runtime_stats_get(&dma_heap.heap, stats);
+}
+
+// Linhas inteiras: vale para buffers do app_dma_alloc e estaticos bem declarados
+bool app_dma_is_safe(const void *buf, size_t size) {
+  return (buf != NULL) && (((uintptr_t)buf % APP_DMA_ALIGN) == 0) &&
+         ((size % APP_DMA_ALIGN) == 0);
+}
+
+int app_dma_sync_for_device(void *buf, size_t size, enum app_dma_dir dir) {
+  if (!app_dma_is_safe(buf, size)) {
+    return -EINVAL;
+  }
+
+#if defined(CONFIG_APP_DMA_NOCACHE)
+  ARG_UNUSED(dir);
+  return 0;
+#else
+  switch (dir) {
+  case APP_DMA_TO_DEVICE:
+    // Dados da CPU precisam estar na memoria antes do periferico ler
+    return sys_cache_data_flush_range(buf, size);
+  case APP_DMA_FROM_DEVICE:
+    // Nenhuma linha suja pode ser despejada por cima do que o periferico gravar
+    return sys_cache_data_invd_range(buf, size);
+  case APP_DMA_BIDIRECTIONAL:
+    return sys_cache_data_flush_and_invd_range(buf, size);
+  default:
+    return -EINVAL;
+  }
+#endif
+}
+
+int app_dma_sync_for_cpu(void *buf, size_t size, enum app_dma_dir dir) {
+  if (!app_dma_is_safe(buf, size)) {
+    return -EINVAL;
+  }
+
+#if defined(CONFIG_APP_DMA_NOCACHE)
+  ARG_UNUSED(dir);
+  return 0;
+#else
+  switch (dir) {
+  case APP_DMA_TO_DEVICE:
+    return 0;
+  case APP_DMA_FROM_DEVICE:
+  case APP_DMA_BIDIRECTIONAL:
+    // Descarta linhas trazidas por leitura especulativa durante a transferencia
+    return sys_cache_data_invd_range(buf, size);
+  default:
+    return -EINVAL;
+  }
+#endif
+}
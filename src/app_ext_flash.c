@@ -1,19 +1,42 @@
 #include "app_ext_flash.h"
-#include "app_icon.h"
+#include "asset_store.h"
 #include <string.h>
 #include <zephyr/init.h>
 #include <zephyr/kernel.h>
 #include <zephyr/sys/sys_heap.h>
 
+#if defined(CONFIG_CODE_DATA_RELOCATION)
+#include "app_icon.h"
+#endif
+
+#define EXT_MEM_TEST_ASSET "hello.txt"
+#define EXT_MEM_TEST_MSG "A caminhada é longa, mas o resultado faz cada passo valer a pena!"
+
 int ext_mem_test(void) {
+  char buf[sizeof(EXT_MEM_TEST_MSG)];
+  struct asset asset;
+  int ret;
+
+#if defined(CONFIG_CODE_DATA_RELOCATION)
   printk("Ext flash buffer 1 local: %p\n", nor_glyph_bitmap);
   printk("Ext flash buffer 2 local: %p\n", nor_hello_msg);
-  // if (!strcmp(nor_hello_msg, "A caminhada é longa, mas o resultado faz cada
-  // passo valer a pena!\0"))
-  // {
-  //     printk("Ext flash test with success\n");
-  //     return 0;
-  // }
+#endif
+
+  ret = asset_store_init();
+  if (ret == 0) {
+    ret = asset_find(EXT_MEM_TEST_ASSET, &asset);
+  }
+
+  if (ret == 0) {
+    memset(buf, 0, sizeof(buf));
+    ret = asset_read(&asset, 0, buf, sizeof(buf) - 1);
+  }
+
+  if ((ret > 0) && !strcmp(buf, EXT_MEM_TEST_MSG)) {
+    printk("Ext flash test with success\n");
+    return 0;
+  }
+
   printk("Ext flash test fail\n");
 
   return -EIO;
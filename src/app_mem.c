@@ -0,0 +1,262 @@
+#include "app_mem.h"
+#include "app_dma.h"
+#include "app_sdram.h"
+#include "database.h"
+#include "setup_database.h"
+#include <string.h>
+#include <zephyr/kernel.h>
+#include <zephyr/shell/shell.h>
+#include <zephyr/sys/sys_heap.h>
+#ifdef CONFIG_LVGL
+#include <lvgl_mem.h>
+#endif
+
+struct app_mem_heap {
+  const char *name;
+  int (*get_stats)(struct sys_memory_stats *stats);
+};
+
+// Valores publicados no banco (grupo GROUP_MEM_STATS)
+struct app_mem_db_values {
+  uint32_t used;
+  uint32_t peak;
+};
+
+struct app_mem_stacks {
+  uint8_t worst_pct;
+};
+
+#if CONFIG_HEAP_MEM_POOL_SIZE > 0
+extern struct k_heap _system_heap;
+#endif
+#ifdef CONFIG_SYS_HEAP_RUNTIME_STATS
+extern int malloc_runtime_stats_get(struct sys_memory_stats *stats);
+#endif
+
+static int app_mem_system_stats(struct sys_memory_stats *stats);
+static int app_mem_libc_stats(struct sys_memory_stats *stats);
+static int app_mem_lvgl_stats(struct sys_memory_stats *stats);
+static void app_mem_stack_cb(const struct k_thread *thread, void *user_data);
+static void app_mem_sample(struct k_work *work);
+static void app_mem_shell_stack_cb(const struct k_thread *thread, void *user_data);
+static int app_mem_shell_cmd_show(const struct shell *shell, size_t argc, char **argv);
+static int app_mem_shell_cmd_stacks(const struct shell *shell, size_t argc, char **argv);
+
+static const struct app_mem_heap g_heaps[APP_MEM_HEAP_COUNT] = {
+    [APP_MEM_HEAP_SYSTEM] = {"system", app_mem_system_stats},
+    [APP_MEM_HEAP_LIBC] = {"libc", app_mem_libc_stats},
+    [APP_MEM_HEAP_USER] = {"user", app_heap_get_stats},
+    [APP_MEM_HEAP_DMA] = {"dma", app_dma_get_stats},
+    [APP_MEM_HEAP_LVGL] = {"lvgl", app_mem_lvgl_stats},
+};
+
+static struct app_mem_heap_info g_heap_info[APP_MEM_HEAP_COUNT];
+static struct app_mem_db_values g_db_mem[APP_MEM_HEAP_COUNT];
+static uint8_t g_db_stack_worst_pct;
+static uint32_t g_db_pool_failures;
+static struct k_spinlock g_lock;
+static struct k_work_delayable g_sample_work;
+static int64_t g_stack_next;
+
+static const struct db_param g_db_mem_stats[] = {
+    DB_PARAMS_ADD_B32(MEM_STATS_SYS_HEAP_USED,   ACC_LEVEL_USER, VAR_FIELD_READ_ONLY, "MemSysUsed",   eU32, g_db_mem[APP_MEM_HEAP_SYSTEM].used, MIN_U32, MAX_U32, 0),
+    DB_PARAMS_ADD_B32(MEM_STATS_SYS_HEAP_PEAK,   ACC_LEVEL_USER, VAR_FIELD_READ_ONLY, "MemSysPeak",   eU32, g_db_mem[APP_MEM_HEAP_SYSTEM].peak, MIN_U32, MAX_U32, 0),
+    DB_PARAMS_ADD_B32(MEM_STATS_LIBC_USED,       ACC_LEVEL_USER, VAR_FIELD_READ_ONLY, "MemLibcUsed",  eU32, g_db_mem[APP_MEM_HEAP_LIBC].used,   MIN_U32, MAX_U32, 0),
+    DB_PARAMS_ADD_B32(MEM_STATS_LIBC_PEAK,       ACC_LEVEL_USER, VAR_FIELD_READ_ONLY, "MemLibcPeak",  eU32, g_db_mem[APP_MEM_HEAP_LIBC].peak,   MIN_U32, MAX_U32, 0),
+    DB_PARAMS_ADD_B32(MEM_STATS_USER_HEAP_USED,  ACC_LEVEL_USER, VAR_FIELD_READ_ONLY, "MemUserUsed",  eU32, g_db_mem[APP_MEM_HEAP_USER].used,   MIN_U32, MAX_U32, 0),
+    DB_PARAMS_ADD_B32(MEM_STATS_USER_HEAP_PEAK,  ACC_LEVEL_USER, VAR_FIELD_READ_ONLY, "MemUserPeak",  eU32, g_db_mem[APP_MEM_HEAP_USER].peak,   MIN_U32, MAX_U32, 0),
+    DB_PARAMS_ADD_B32(MEM_STATS_DMA_USED,        ACC_LEVEL_USER, VAR_FIELD_READ_ONLY, "MemDmaUsed",   eU32, g_db_mem[APP_MEM_HEAP_DMA].used,    MIN_U32, MAX_U32, 0),
+    DB_PARAMS_ADD_B32(MEM_STATS_DMA_PEAK,        ACC_LEVEL_USER, VAR_FIELD_READ_ONLY, "MemDmaPeak",   eU32, g_db_mem[APP_MEM_HEAP_DMA].peak,    MIN_U32, MAX_U32, 0),
+    DB_PARAMS_ADD_B32(MEM_STATS_LVGL_USED,       ACC_LEVEL_USER, VAR_FIELD_READ_ONLY, "MemLvglUsed",  eU32, g_db_mem[APP_MEM_HEAP_LVGL].used,   MIN_U32, MAX_U32, 0),
+    DB_PARAMS_ADD_B32(MEM_STATS_LVGL_PEAK,       ACC_LEVEL_USER, VAR_FIELD_READ_ONLY, "MemLvglPeak",  eU32, g_db_mem[APP_MEM_HEAP_LVGL].peak,   MIN_U32, MAX_U32, 0),
+    DB_PARAMS_ADD_B08(MEM_STATS_STACK_WORST_PCT, ACC_LEVEL_USER, VAR_FIELD_READ_ONLY, "MemStackWorst", eU08, g_db_stack_worst_pct,                  0,     100, 0),
+    DB_PARAMS_ADD_B32(MEM_STATS_POOL_FAILURES,   ACC_LEVEL_USER, VAR_FIELD_READ_ONLY, "MemPoolFail",  eU32, g_db_pool_failures,                 MIN_U32, MAX_U32, 0),
+};
+
+static struct db_group g_db_grp_mem_stats = DATABASE_CREATE_GROUP(GROUP_MEM_STATS, "MemStats", g_db_mem_stats);
+
+SHELL_STATIC_SUBCMD_SET_CREATE(
+    mem, SHELL_CMD(show, NULL, "heaps usage and peak", app_mem_shell_cmd_show),
+    SHELL_CMD(stacks, NULL, "threads stack high-water marks", app_mem_shell_cmd_stacks),
+    SHELL_SUBCMD_SET_END);
+
+SHELL_CMD_REGISTER(mem, &mem, "memory usage commands", NULL);
+
+static int app_mem_system_stats(struct sys_memory_stats *stats) {
+#if CONFIG_HEAP_MEM_POOL_SIZE > 0
+  return sys_heap_runtime_stats_get(&_system_heap.heap, stats);
+#else
+  ARG_UNUSED(stats);
+  return -ENOTSUP;
+#endif
+}
+
+static int app_mem_libc_stats(struct sys_memory_stats *stats) {
+#ifdef CONFIG_SYS_HEAP_RUNTIME_STATS
+  return malloc_runtime_stats_get(stats);
+#else
+  ARG_UNUSED(stats);
+  return -ENOTSUP;
+#endif
+}
+
+static int app_mem_lvgl_stats(struct sys_memory_stats *stats) {
+#ifdef CONFIG_LVGL
+  lvgl_heap_stats(stats);
+  return 0;
+#else
+  ARG_UNUSED(stats);
+  return -ENOTSUP;
+#endif
+}
+
+static void app_mem_stack_cb(const struct k_thread *thread, void *user_data) {
+  struct app_mem_stacks *stacks = user_data;
+  size_t size = thread->stack_info.size;
+  size_t unused;
+  uint8_t pct;
+
+  if ((size == 0) || (k_thread_stack_space_get(thread, &unused) != 0)) {
+    return;
+  }
+
+  pct = ((size - unused) * 100) / size;
+  if (pct > stacks->worst_pct) {
+    stacks->worst_pct = pct;
+  }
+}
+
+static void app_mem_sample(struct k_work *work) {
+  struct k_work_delayable *dwork = k_work_delayable_from_work(work);
+  struct app_mem_stacks stacks = {0};
+  struct app_pool_stats pool;
+  struct sys_memory_stats stats;
+  struct app_mem_heap_info info;
+  uint32_t pool_failures = 0;
+  bool changed = false;
+  k_spinlock_key_t key;
+
+  for (int i = 0; i < APP_MEM_HEAP_COUNT; i++) {
+    memset(&info, 0, sizeof(info));
+    info.name = g_heaps[i].name;
+
+    if (g_heaps[i].get_stats(&stats) == 0) {
+      info.available = true;
+      info.size = stats.free_bytes + stats.allocated_bytes;
+      info.used = stats.allocated_bytes;
+      info.peak = stats.max_allocated_bytes;
+    }
+
+    key = k_spin_lock(&g_lock);
+    g_heap_info[i] = info;
+    k_spin_unlock(&g_lock, key);
+
+    // Escrita direta: os parametros sao somente leitura para o banco
+    if ((g_db_mem[i].used != info.used) || (g_db_mem[i].peak != info.peak)) {
+      g_db_mem[i].used = info.used;
+      g_db_mem[i].peak = info.peak;
+      changed = true;
+    }
+  }
+
+  // Cada pilha e varrida inteira: bem menos frequente que os heaps
+  if ((CONFIG_APP_MEM_STACK_INTERVAL_S > 0) && (k_uptime_get() >= g_stack_next)) {
+    k_thread_foreach_unlocked(app_mem_stack_cb, &stacks);
+    if (g_db_stack_worst_pct != stacks.worst_pct) {
+      g_db_stack_worst_pct = stacks.worst_pct;
+      changed = true;
+    }
+    g_stack_next = k_uptime_get() + (CONFIG_APP_MEM_STACK_INTERVAL_S * MSEC_PER_SEC);
+  }
+
+  for (int i = 0; i < APP_POOL_COUNT; i++) {
+    if (app_pool_get_stats(i, &pool) == 0) {
+      pool_failures += pool.failures;
+    }
+  }
+  if (g_db_pool_failures != pool_failures) {
+    g_db_pool_failures = pool_failures;
+    changed = true;
+  }
+
+  // Sem mudanca nao avanca a sequencia (tela, telemetria, PDO, WebSocket)
+  if (changed) {
+    db_notify_change();
+  }
+
+  k_work_reschedule(dwork, K_MSEC(CONFIG_APP_MEM_SAMPLE_INTERVAL_MS));
+}
+
+int app_mem_init(void) {
+  int err;
+
+  err = db_group_add(&g_db_grp_mem_stats);
+  if (err < 0) {
+    return err;
+  }
+
+  k_work_init_delayable(&g_sample_work, app_mem_sample);
+  k_work_schedule(&g_sample_work, K_NO_WAIT);
+
+  return 0;
+}
+
+int app_mem_get_heap(enum app_mem_heap_id id, struct app_mem_heap_info *info) {
+  k_spinlock_key_t key;
+
+  if ((id >= APP_MEM_HEAP_COUNT) || (info == NULL)) {
+    return -EINVAL;
+  }
+
+  key = k_spin_lock(&g_lock);
+  *info = g_heap_info[id];
+  k_spin_unlock(&g_lock, key);
+
+  return info->available ? 0 : -ENOTSUP;
+}
+
+static int app_mem_shell_cmd_show(const struct shell *shell, size_t argc, char **argv) {
+  struct app_mem_heap_info info;
+
+  ARG_UNUSED(argc);
+  ARG_UNUSED(argv);
+
+  shell_print(shell, "%-8s %9s %9s %9s", "heap", "size", "used", "peak");
+
+  for (int i = 0; i < APP_MEM_HEAP_COUNT; i++) {
+    if (app_mem_get_heap(i, &info) != 0) {
+      shell_print(shell, "%-8s %9s", g_heaps[i].name, "n/a");
+      continue;
+    }
+
+    shell_print(shell, "%-8s %9u %9u %9u", info.name, (uint32_t)info.size,
+                (uint32_t)info.used, (uint32_t)info.peak);
+  }
+
+  return 0;
+}
+
+static void app_mem_shell_stack_cb(const struct k_thread *thread, void *user_data) {
+  const struct shell *shell = user_data;
+  size_t size = thread->stack_info.size;
+  size_t unused;
+  const char *name;
+
+  if ((size == 0) || (k_thread_stack_space_get(thread, &unused) != 0)) {
+    return;
+  }
+
+  name = k_thread_name_get((k_tid_t)thread);
+  shell_print(shell, "%-20s %7u %7u %4u%%", (name && name[0]) ? name : "?", (uint32_t)size,
+              (uint32_t)(size - unused), (uint32_t)(((size - unused) * 100) / size));
+}
+
+static int app_mem_shell_cmd_stacks(const struct shell *shell, size_t argc, char **argv) {
+  ARG_UNUSED(argc);
+  ARG_UNUSED(argv);
+
+  shell_print(shell, "%-20s %7s %7s %5s", "thread", "size", "peak", "used");
+  k_thread_foreach_unlocked(app_mem_shell_stack_cb, (void *)shell);
+
+  return 0;
+}
@@ -0,0 +1,586 @@
+#include "app_ota.h"
+#include "app_dma.h"
+#include "app_sdram.h"
+#include "database.h"
+#include "file_io.h"
+#include "sdcard_lib.h"
+#include "setup_database.h"
+
+#include <mbedtls/sha256.h>
+#include <stdio.h>
+#include <string.h>
+#include <zephyr/dfu/flash_img.h>
+#include <zephyr/dfu/mcuboot.h>
+#include <zephyr/drivers/flash.h>
+#include <zephyr/kernel.h>
+#include <zephyr/logging/log.h>
+#include <zephyr/shell/shell.h>
+#include <zephyr/storage/flash_map.h>
+#include <zephyr/sys/byteorder.h>
+#include <zephyr/sys/util.h>
+
+LOG_MODULE_REGISTER(app_ota, CONFIG_LOG_DEFAULT_LEVEL);
+
+/*
+ * Atualizacao em fluxo para o slot secundario do MCUboot. Os dados passam uma
+ * unica vez: SHA-256 incremental e escrita em blocos de CONFIG_IMG_BLOCK_BUF_SIZE
+ * (flash_img). A RAM usada e fixa, qualquer que seja o tamanho da imagem.
+ */
+
+#define OTA_STACK_MEM_ATTRIBUTES Z_GENERIC_SECTION(.app_stack)
+#define OTA_SLOT_ID              FIXED_PARTITION_ID(slot1_partition)
+#define OTA_IMAGE_MAGIC          0x96f3b83dU   // Inicio do cabecalho MCUboot
+#define OTA_HASH_LEN             (32)
+#define OTA_SD_MOUNT_PT          "/SD:"
+#define OTA_SD_TIMEOUT_MS        (5000)
+#define OTA_SD_CHUNK_SIZE        CONFIG_APP_POOL_NET_BLOCK_SIZE
+#define OTA_SD_BLOCK_SIZE        ROUND_UP(OTA_SD_CHUNK_SIZE, APP_DMA_ALIGN)  // Bloco do pool
+
+struct app_ota {
+  bool active;
+  enum app_ota_source source;
+  size_t size;
+  size_t written;
+  uint8_t percent;
+  uint16_t status;
+  struct flash_img_context img;
+  mbedtls_sha256_context sha;
+};
+
+// Leitura do SD em andamento; duas para ler o proximo bloco enquanto grava.
+// Os buffers sao blocos do pool de rede (SDRAM), so durante a atualizacao
+struct app_ota_sd_read {
+  struct file_io_request request;
+  struct k_poll_signal signal;
+  uint8_t *data;
+};
+
+static struct app_ota g_ota;
+static K_MUTEX_DEFINE(g_lock);
+
+static struct app_ota_sd_read g_sd_reads[2];
+static char g_sd_path[sizeof(((struct update_info *)0)->file) + sizeof(OTA_SD_MOUNT_PT)];
+static atomic_t g_sd_busy;
+static struct k_thread g_sd_thread;
+static bool g_sd_started;
+
+Z_KERNEL_STACK_DEFINE_IN(g_sd_stack, CONFIG_APP_OTA_STACK_SIZE, OTA_STACK_MEM_ATTRIBUTES);
+
+static int ota_shell_cmd_sd(const struct shell *shell, size_t argc, char **argv);
+static int ota_shell_cmd_status(const struct shell *shell, size_t argc, char **argv);
+static int ota_shell_cmd_abort(const struct shell *shell, size_t argc, char **argv);
+
+SHELL_STATIC_SUBCMD_SET_CREATE(
+    ota, SHELL_CMD_ARG(sd, NULL, "update from SD card [file]", ota_shell_cmd_sd, 1, 1),
+    SHELL_CMD(status, NULL, "update status", ota_shell_cmd_status),
+    SHELL_CMD(abort, NULL, "abort the running update", ota_shell_cmd_abort),
+    SHELL_SUBCMD_SET_END);
+
+SHELL_CMD_REGISTER(ota, &ota, "firmware update commands", NULL);
+
+// Chamado com g_lock
+static void app_ota_set_status(enum app_ota_state state, uint8_t percent) {
+  g_ota.status = APP_OTA_STATUS(state, percent);
+  db_acc_set_u16(ACC_LEVEL_FACTORY, GROUP_SYS_OTA_CONF, PARAM_CNFG_OTA_STATUS, g_ota.status);
+}
+
+// Chamado com g_lock: encerra a tentativa com o estado de erro
+static int app_ota_fail(enum app_ota_state state, int err) {
+  if (g_ota.active) {
+    mbedtls_sha256_free(&g_ota.sha);
+    g_ota.active = false;
+  }
+
+  app_ota_set_status(state, g_ota.percent);
+  LOG_ERR("Update failed at %zu/%zu bytes: state 0x%02x, %d", g_ota.written, g_ota.size, state, err);
+
+  return err;
+}
+
+/*
+ * Apaga so os setores que a imagem ocupa, mais o ultimo do slot, onde o
+ * MCUboot grava o trailer em boot_request_upgrade().
+ */
+static int app_ota_erase(const struct flash_area *fa, size_t size) {
+  const struct device *dev = flash_area_get_device(fa);
+  struct flash_pages_info info;
+  off_t end;
+  int ret;
+
+  ret = flash_get_page_info_by_offs(dev, fa->fa_off + size - 1, &info);
+  if (ret != 0) {
+    return ret;
+  }
+
+  end = info.start_offset + info.size - fa->fa_off;
+  ret = flash_area_erase(fa, 0, end);
+  if ((ret != 0) || (end >= fa->fa_size)) {
+    return ret;
+  }
+
+  ret = flash_get_page_info_by_offs(dev, fa->fa_off + fa->fa_size - 1, &info);
+  if (ret != 0) {
+    return ret;
+  }
+
+  return flash_area_erase(fa, info.start_offset - fa->fa_off, info.size);
+}
+
+/**
+ * @brief Inicia uma atualizacao de size bytes
+ *
+ * Confere o tamanho com o slot e com PARAM_CNFG_OTA_FILE_SIZE (quando
+ * diferente de zero), apaga a area necessaria e conta a tentativa.
+ * Bloqueia durante o apagamento (segundos em setores de 128 KB).
+ */
+int app_ota_begin(enum app_ota_source source, size_t size) {
+  const struct flash_area *fa;
+  uint32_t expected = 0;
+  uint16_t attempts = 0;
+  int ret;
+
+  k_mutex_lock(&g_lock, K_FOREVER);
+
+  if (g_ota.active) {
+    k_mutex_unlock(&g_lock);
+    return -EBUSY;
+  }
+
+  g_ota.source = source;
+  g_ota.size = size;
+  g_ota.written = 0;
+  g_ota.percent = 0;
+
+  ret = flash_area_open(OTA_SLOT_ID, &fa);
+  if (ret != 0) {
+    ret = app_ota_fail(APP_OTA_ERR_FLASH, ret);
+    k_mutex_unlock(&g_lock);
+    return ret;
+  }
+
+  db_acc_get_u32(ACC_LEVEL_FACTORY, GROUP_SYS_OTA_CONF, PARAM_CNFG_OTA_FILE_SIZE, &expected);
+  if ((size == 0) || (size > fa->fa_size) || ((expected != 0) && (expected != size))) {
+    flash_area_close(fa);
+    ret = app_ota_fail(APP_OTA_ERR_SIZE, -EFBIG);
+    k_mutex_unlock(&g_lock);
+    return ret;
+  }
+
+  db_acc_get_u16(ACC_LEVEL_FACTORY, GROUP_SYS_OTA_CONF, PARAM_CNFG_OTA_NUM_ATTEMPTS, &attempts);
+  db_acc_set_u16(ACC_LEVEL_FACTORY, GROUP_SYS_OTA_CONF, PARAM_CNFG_OTA_NUM_ATTEMPTS, attempts + 1);
+
+  app_ota_set_status(APP_OTA_ERASING, 0);
+  ret = app_ota_erase(fa, size);
+  flash_area_close(fa);
+
+  if (ret == 0) {
+    ret = flash_img_init_id(&g_ota.img, OTA_SLOT_ID);
+  }
+
+  if (ret != 0) {
+    ret = app_ota_fail(APP_OTA_ERR_FLASH, ret);
+    k_mutex_unlock(&g_lock);
+    return ret;
+  }
+
+  mbedtls_sha256_init(&g_ota.sha);
+  mbedtls_sha256_starts(&g_ota.sha, 0);
+  g_ota.active = true;
+  app_ota_set_status(APP_OTA_RECEIVING, 0);
+
+  k_mutex_unlock(&g_lock);
+
+  LOG_INF("Update started: %zu bytes from %s", size,
+          (source == APP_OTA_SRC_SDCARD) ? "SD card" : "ISO-TP");
+
+  return 0;
+}
+
+/**
+ * @brief Proximo trecho da imagem, na ordem
+ *
+ * O hash e atualizado e os dados seguem para a flash em blocos do tamanho do
+ * buffer do flash_img. O progresso so vai para a base quando o percentual muda.
+ */
+int app_ota_write(const void *data, size_t len) {
+  uint8_t percent;
+  int ret;
+
+  k_mutex_lock(&g_lock, K_FOREVER);
+
+  if (!g_ota.active) {
+    k_mutex_unlock(&g_lock);
+    return -EPERM;
+  }
+
+  if (len > (g_ota.size - g_ota.written)) {
+    ret = app_ota_fail(APP_OTA_ERR_SIZE, -EFBIG);
+    k_mutex_unlock(&g_lock);
+    return ret;
+  }
+
+  // Rejeita cedo o que nao e imagem do MCUboot, antes de gastar o barramento
+  if ((g_ota.written == 0) && (len >= sizeof(uint32_t)) && (sys_get_le32(data) != OTA_IMAGE_MAGIC)) {
+    ret = app_ota_fail(APP_OTA_ERR_SOURCE, -EILSEQ);
+    k_mutex_unlock(&g_lock);
+    return ret;
+  }
+
+  mbedtls_sha256_update(&g_ota.sha, data, len);
+
+  ret = flash_img_buffered_write(&g_ota.img, data, len, false);
+  if (ret != 0) {
+    ret = app_ota_fail(APP_OTA_ERR_FLASH, ret);
+    k_mutex_unlock(&g_lock);
+    return ret;
+  }
+
+  g_ota.written += len;
+
+  percent = (uint8_t)(((uint64_t)g_ota.written * 100) / g_ota.size);
+  if (percent != g_ota.percent) {
+    g_ota.percent = percent;
+    app_ota_set_status(APP_OTA_RECEIVING, percent);
+  }
+
+  k_mutex_unlock(&g_lock);
+
+  return 0;
+}
+
+/**
+ * @brief Fecha a imagem e confere o SHA-256 com PARAM_CNFG_OTA_HASH
+ *
+ * O hash esperado e texto hexadecimal (64 caracteres). Com a imagem valida
+ * o MCUboot faz a troca (em teste) no proximo reset.
+ */
+int app_ota_finish(void) {
+  char hash[sizeof(((struct update_info *)0)->hash)];
+  uint8_t expected[OTA_HASH_LEN];
+  uint8_t digest[OTA_HASH_LEN];
+  int ret;
+
+  k_mutex_lock(&g_lock, K_FOREVER);
+
+  if (!g_ota.active) {
+    k_mutex_unlock(&g_lock);
+    return -EPERM;
+  }
+
+  if (g_ota.written != g_ota.size) {
+    ret = app_ota_fail(APP_OTA_ERR_SIZE, -EMSGSIZE);
+    k_mutex_unlock(&g_lock);
+    return ret;
+  }
+
+  ret = flash_img_buffered_write(&g_ota.img, NULL, 0, true);
+  if (ret != 0) {
+    ret = app_ota_fail(APP_OTA_ERR_FLASH, ret);
+    k_mutex_unlock(&g_lock);
+    return ret;
+  }
+
+  app_ota_set_status(APP_OTA_VERIFYING, 100);
+  mbedtls_sha256_finish(&g_ota.sha, digest);
+
+  db_acc_get_str(ACC_LEVEL_FACTORY, GROUP_SYS_OTA_CONF, PARAM_CNFG_OTA_HASH, hash, sizeof(hash));
+  if ((hex2bin(hash, strnlen(hash, sizeof(hash)), expected, sizeof(expected)) != sizeof(expected)) ||
+      (memcmp(expected, digest, sizeof(digest)) != 0)) {
+    ret = app_ota_fail(APP_OTA_ERR_HASH, -EBADMSG);
+    k_mutex_unlock(&g_lock);
+    return ret;
+  }
+
+  ret = boot_request_upgrade(BOOT_UPGRADE_TEST);
+  if (ret != 0) {
+    ret = app_ota_fail(APP_OTA_ERR_FLASH, ret);
+    k_mutex_unlock(&g_lock);
+    return ret;
+  }
+
+  mbedtls_sha256_free(&g_ota.sha);
+  g_ota.active = false;
+  app_ota_set_status(APP_OTA_PENDING, 100);
+
+  k_mutex_unlock(&g_lock);
+
+  LOG_INF("Update verified (%zu bytes), swap on next reset", g_ota.size);
+
+  return 0;
+}
+
+/**
+ * @brief Confirma a imagem em execucao
+ *
+ * Depois de uma troca o MCUboot roda a imagem nova em teste: sem esta chamada
+ * ele volta a anterior no proximo reset. O main chama quando a inicializacao
+ * terminou bem; uma imagem que trava antes disso e revertida.
+ */
+int app_ota_confirm(void) {
+  int ret;
+
+  if (boot_is_img_confirmed()) {
+    return 0;
+  }
+
+  ret = boot_write_img_confirmed();
+  if (ret != 0) {
+    LOG_ERR("Image confirm failed: %d", ret);
+    return ret;
+  }
+
+  k_mutex_lock(&g_lock, K_FOREVER);
+  app_ota_set_status(APP_OTA_IDLE, 0);
+  k_mutex_unlock(&g_lock);
+
+  LOG_INF("Running image confirmed");
+
+  return 0;
+}
+
+void app_ota_abort(void) {
+  k_mutex_lock(&g_lock, K_FOREVER);
+
+  if (g_ota.active) {
+    app_ota_fail(APP_OTA_ABORTED, -ECANCELED);
+  }
+
+  k_mutex_unlock(&g_lock);
+}
+
+uint16_t app_ota_get_status(void) {
+  return g_ota.status;
+}
+
+// So chamado com o pedido livre (app_ota_sd_wait ja retornou)
+static int app_ota_sd_submit(struct app_ota_sd_read *rd, enum file_io_op op, struct fs_file_t *file,
+                             void *buffer, off_t offset, size_t len) {
+  memset(&rd->request, 0, sizeof(rd->request));
+  rd->request.op = op;
+  rd->request.file = file;
+  rd->request.path = g_sd_path;
+  rd->request.flags = FS_O_READ;
+  rd->request.buffer = buffer;
+  rd->request.length = len;
+  rd->request.offset = offset;
+  rd->request.deadline = k_uptime_get() + OTA_SD_TIMEOUT_MS;
+  rd->request.signal = &rd->signal;
+
+  // O bloco inteiro do pool (linhas de cache completas) recebe o DMA do SDMMC
+  if (op == FILE_IO_READ) {
+    app_dma_sync_for_device(buffer, OTA_SD_BLOCK_SIZE, APP_DMA_FROM_DEVICE);
+  }
+
+  return sdcard_io_submit(&rd->request);
+}
+
+/*
+ * O pedido pertence a thread de I/O ate ser sinalizado e nunca e reaproveitado
+ * antes disso. Parado na fila alem do prazo ele e descartado com -ETIMEDOUT;
+ * ja em execucao, e esperado ate o fim.
+ */
+static int app_ota_sd_wait(struct app_ota_sd_read *rd) {
+  struct k_poll_event event =
+      K_POLL_EVENT_INITIALIZER(K_POLL_TYPE_SIGNAL, K_POLL_MODE_NOTIFY_ONLY, &rd->signal);
+  unsigned int signaled;
+  int result;
+
+  if (k_poll(&event, 1, K_MSEC(OTA_SD_TIMEOUT_MS)) != 0) {
+    LOG_WRN("SD request %d still running after %d ms", rd->request.op, OTA_SD_TIMEOUT_MS);
+    k_poll(&event, 1, K_FOREVER);
+  }
+
+  k_poll_signal_check(&rd->signal, &signaled, &result);
+
+  if (rd->request.op == FILE_IO_READ) {
+    app_dma_sync_for_cpu(rd->request.buffer, OTA_SD_BLOCK_SIZE, APP_DMA_FROM_DEVICE);
+  }
+
+  return result;
+}
+
+/*
+ * Le a imagem pela thread de I/O do SD com duas leituras em voo: enquanto um
+ * bloco e gravado na flash o proximo ja esta sendo lido.
+ */
+static void app_ota_sd_thread(void *p1, void *p2, void *p3) {
+  struct fs_file_t file;
+  struct fs_dirent entry;
+  struct app_ota_sd_read *rd;
+  off_t offset = 0;
+  off_t next;
+  int cur = 0;
+  int ret;
+
+  ARG_UNUSED(p1);
+  ARG_UNUSED(p2);
+  ARG_UNUSED(p3);
+
+  g_sd_reads[0].data = app_pool_alloc(APP_POOL_NET);
+  g_sd_reads[1].data = app_pool_alloc(APP_POOL_NET);
+  if (!g_sd_reads[0].data || !g_sd_reads[1].data) {
+    LOG_ERR("No read buffers");
+    goto release;
+  }
+
+  // Tambem o stat passa pela thread de I/O, dona do volume
+  ret = app_ota_sd_submit(&g_sd_reads[0], FILE_IO_STAT, NULL, &entry, 0, 0);
+  ret = (ret == 0) ? app_ota_sd_wait(&g_sd_reads[0]) : ret;
+  if (ret != 0) {
+    LOG_ERR("%s: %d", g_sd_path, ret);
+    goto release;
+  }
+
+  ret = app_ota_begin(APP_OTA_SRC_SDCARD, entry.size);
+  if (ret != 0) {
+    goto release;
+  }
+
+  ret = app_ota_sd_submit(&g_sd_reads[0], FILE_IO_OPEN, &file, NULL, 0, 0);
+  ret = (ret == 0) ? app_ota_sd_wait(&g_sd_reads[0]) : ret;
+  if (ret < 0) {
+    goto fail;
+  }
+
+  ret = app_ota_sd_submit(&g_sd_reads[0], FILE_IO_READ, &file, g_sd_reads[0].data, 0,
+                          MIN(entry.size, OTA_SD_CHUNK_SIZE));
+
+  while ((ret == 0) && (offset < entry.size)) {
+    rd = &g_sd_reads[cur];
+    ret = app_ota_sd_wait(rd);
+    if (ret <= 0) {
+      ret = (ret == 0) ? -EIO : ret;
+      break;
+    }
+
+    next = offset + ret;
+    if (next < entry.size) {
+      rd = &g_sd_reads[cur ^ 1];
+      ret = app_ota_sd_submit(rd, FILE_IO_READ, &file, rd->data, next,
+                              MIN(entry.size - next, OTA_SD_CHUNK_SIZE));
+      rd = &g_sd_reads[cur];
+      if (ret != 0) {
+        break;
+      }
+    }
+
+    // Erro de gravacao ja foi registrado no status por app_ota_write
+    if (app_ota_write(rd->data, next - offset) != 0) {
+      if (next < entry.size) {
+        app_ota_sd_wait(&g_sd_reads[cur ^ 1]);
+      }
+      ret = -EIO;
+      goto close;
+    }
+
+    offset = next;
+    cur ^= 1;
+  }
+
+  if (ret == 0) {
+    ret = app_ota_finish();
+  }
+
+close:
+  if (app_ota_sd_submit(&g_sd_reads[0], FILE_IO_CLOSE, &file, NULL, 0, 0) == 0) {
+    app_ota_sd_wait(&g_sd_reads[0]);
+  }
+
+fail:
+  // Falha de leitura: a gravacao ainda esta aberta
+  if (ret != 0) {
+    k_mutex_lock(&g_lock, K_FOREVER);
+    if (g_ota.active) {
+      app_ota_fail(APP_OTA_ERR_SOURCE, ret);
+    }
+    k_mutex_unlock(&g_lock);
+  }
+
+release:
+  for (size_t i = 0; i < ARRAY_SIZE(g_sd_reads); i++) {
+    app_pool_free(APP_POOL_NET, g_sd_reads[i].data);
+    g_sd_reads[i].data = NULL;
+  }
+
+  atomic_clear(&g_sd_busy);
+}
+
+/**
+ * @brief Atualiza a partir de um arquivo do cartao SD, em segundo plano
+ *
+ * path NULL usa PARAM_CNFG_OTA_FILE (vazio: -ENOENT); caminhos relativos
+ * ficam na raiz do cartao. O andamento fica em PARAM_CNFG_OTA_STATUS.
+ */
+int app_ota_from_sdcard(const char *path) {
+  char file[sizeof(((struct update_info *)0)->file)];
+
+  if (!atomic_cas(&g_sd_busy, 0, 1)) {
+    return -EBUSY;
+  }
+
+  if (path == NULL) {
+    file[0] = '\0';
+    db_acc_get_str(ACC_LEVEL_FACTORY, GROUP_SYS_OTA_CONF, PARAM_CNFG_OTA_FILE, file, sizeof(file));
+    path = file;
+  }
+
+  if (path[0] == '\0') {
+    atomic_clear(&g_sd_busy);
+    return -ENOENT;
+  }
+
+  if (path[0] == '/') {
+    snprintf(g_sd_path, sizeof(g_sd_path), "%s", path);
+  } else {
+    snprintf(g_sd_path, sizeof(g_sd_path), OTA_SD_MOUNT_PT "/%s", path);
+  }
+
+  // g_sd_busy cai antes do fim da thread anterior; a estrutura so e reusada
+  // depois que ela termina
+  if (g_sd_started) {
+    k_thread_join(&g_sd_thread, K_FOREVER);
+  }
+
+  for (size_t i = 0; i < ARRAY_SIZE(g_sd_reads); i++) {
+    k_poll_signal_init(&g_sd_reads[i].signal);
+  }
+
+  k_thread_create(&g_sd_thread, g_sd_stack, K_KERNEL_STACK_SIZEOF(g_sd_stack), app_ota_sd_thread,
+                  NULL, NULL, NULL, CONFIG_APP_OTA_PRIORITY, 0, K_NO_WAIT);
+  k_thread_name_set(&g_sd_thread, "app_ota_sd");
+  g_sd_started = true;
+
+  return 0;
+}
+
+static int ota_shell_cmd_sd(const struct shell *shell, size_t argc, char **argv) {
+  int ret = app_ota_from_sdcard((argc > 1) ? argv[1] : NULL);
+
+  if (ret != 0) {
+    shell_error(shell, "Update not started: %d", ret);
+  }
+
+  return ret;
+}
+
+static int ota_shell_cmd_status(const struct shell *shell, size_t argc, char **argv) {
+  uint16_t status = app_ota_get_status();
+
+  ARG_UNUSED(argc);
+  ARG_UNUSED(argv);
+
+  shell_print(shell, "state 0x%02x, %u%%, %zu/%zu bytes", APP_OTA_STATUS_STATE(status),
+              APP_OTA_STATUS_PERCENT(status), g_ota.written, g_ota.size);
+
+  return 0;
+}
+
+static int ota_shell_cmd_abort(const struct shell *shell, size_t argc, char **argv) {
+  ARG_UNUSED(shell);
+  ARG_UNUSED(argc);
+  ARG_UNUSED(argv);
+
+  app_ota_abort();
+
+  return 0;
+}
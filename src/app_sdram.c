@@ -5,20 +5,56 @@
  */
 
 #include "app_sdram.h"
+#include "app_dma.h"
 #include <string.h>
 #include <zephyr/init.h>
 #include <zephyr/kernel.h>
+#include <zephyr/shell/shell.h>
 #include <zephyr/sys/sys_heap.h>
 
 #define USER_HEAP_SIZE (1024 * 4)
 #define USER_HEAP_MEM_ATTRIBUTES Z_GENERIC_SECTION(.jorge_heap)
+#define APP_POOL_MEM_ATTRIBUTES Z_GENERIC_SECTION(.app_pool)
+#define APP_POOL_ALIGN APP_DMA_ALIGN
+
+// Blocos alinhados a linha de cache, para uso seguro com DMA
+#define APP_POOL_BLOCK(size) ROUND_UP(size, APP_POOL_ALIGN)
+
+struct app_pool {
+  const char *name;
+  struct k_mem_slab slab;
+  uint8_t *buffer;
+  size_t block_size;
+  uint32_t block_count;
+  uint32_t max_used;
+  uint32_t failures;
+};
 
 static uint8_t user_memory[USER_HEAP_SIZE] USER_HEAP_MEM_ATTRIBUTES;
 static struct k_heap user_heap;
 
+static uint8_t __aligned(APP_POOL_ALIGN)
+    net_pool_buffer[APP_POOL_BLOCK(CONFIG_APP_POOL_NET_BLOCK_SIZE) *
+                    CONFIG_APP_POOL_NET_BLOCK_COUNT] APP_POOL_MEM_ATTRIBUTES;
+
+static struct app_pool pools[APP_POOL_COUNT] = {
+    [APP_POOL_NET] = {.name = "net",
+                      .buffer = net_pool_buffer,
+                      .block_size = APP_POOL_BLOCK(CONFIG_APP_POOL_NET_BLOCK_SIZE),
+                      .block_count = CONFIG_APP_POOL_NET_BLOCK_COUNT},
+};
+static struct k_spinlock pools_lock;
+
 static void *os_mem_alloc(int size);
 static void os_mem_free(void *ptr);
 static int os_mem_heap_init(void);
+static int app_pool_shell_cmd_show(const struct shell *shell, size_t argc, char **argv);
+
+SHELL_STATIC_SUBCMD_SET_CREATE(
+    pool, SHELL_CMD(show, NULL, "memory pools status", app_pool_shell_cmd_show),
+    SHELL_SUBCMD_SET_END);
+
+SHELL_CMD_REGISTER(pool, &pool, "memory pool commands", NULL);
 
 static void *os_mem_alloc(int size) {
   return (k_heap_alloc(&user_heap, size, K_NO_WAIT));
@@ -26,8 +62,104 @@ static void *os_mem_alloc(int size) {
 
 static void os_mem_free(void *ptr) { k_heap_free(&user_heap, ptr); }
 
+// Os slabs sao iniciados aqui (POST_KERNEL), com a SDRAM ja configurada
 static int os_mem_heap_init(void) {
   k_heap_init(&user_heap, &user_memory[0], USER_HEAP_SIZE);
+
+  for (int i = 0; i < APP_POOL_COUNT; i++) {
+    k_mem_slab_init(&pools[i].slab, pools[i].buffer, pools[i].block_size,
+                    pools[i].block_count);
+  }
+
+  return 0;
+}
+
+/**
+ * @brief Aloca um bloco do pool em O(1), sem bloquear
+ */
+void *app_pool_alloc(enum app_pool_id id) {
+  struct app_pool *pool;
+  k_spinlock_key_t key;
+  void *block = NULL;
+  uint32_t used;
+
+  if (id >= APP_POOL_COUNT) {
+    return NULL;
+  }
+
+  pool = &pools[id];
+  key = k_spin_lock(&pools_lock);
+
+  if (k_mem_slab_alloc(&pool->slab, &block, K_NO_WAIT) == 0) {
+    used = k_mem_slab_num_used_get(&pool->slab);
+    if (used > pool->max_used) {
+      pool->max_used = used;
+    }
+  } else {
+    block = NULL;
+    pool->failures++;
+  }
+
+  k_spin_unlock(&pools_lock, key);
+
+  return block;
+}
+
+void app_pool_free(enum app_pool_id id, void *block) {
+  if ((id >= APP_POOL_COUNT) || (block == NULL)) {
+    return;
+  }
+
+  k_mem_slab_free(&pools[id].slab, block);
+}
+
+int app_pool_get_stats(enum app_pool_id id, struct app_pool_stats *stats) {
+  struct app_pool *pool;
+  k_spinlock_key_t key;
+
+  if ((id >= APP_POOL_COUNT) || (stats == NULL)) {
+    return -EINVAL;
+  }
+
+  pool = &pools[id];
+  key = k_spin_lock(&pools_lock);
+  stats->name = pool->name;
+  stats->block_size = pool->block_size;
+  stats->block_count = pool->block_count;
+  stats->used = k_mem_slab_num_used_get(&pool->slab);
+  stats->max_used = pool->max_used;
+  stats->failures = pool->failures;
+  k_spin_unlock(&pools_lock, key);
+
+  return 0;
+}
+
+/**
+ * @brief Heap geral, reservado para alocacoes raras de tamanho variavel
+ */
+void *app_heap_alloc(size_t size) { return os_mem_alloc(size); }
+
+void app_heap_free(void *ptr) { os_mem_free(ptr); }
+
+int app_heap_get_stats(struct sys_memory_stats *stats) {
+  return sys_heap_runtime_stats_get(&user_heap.heap, stats);
+}
+
+static int app_pool_shell_cmd_show(const struct shell *shell, size_t argc, char **argv) {
+  struct app_pool_stats stats;
+
+  ARG_UNUSED(argc);
+  ARG_UNUSED(argv);
+
+  shell_print(shell, "%-8s %6s %6s %6s %6s %8s", "pool", "size", "count", "used", "max",
+              "failures");
+
+  for (int i = 0; i < APP_POOL_COUNT; i++) {
+    app_pool_get_stats(i, &stats);
+    shell_print(shell, "%-8s %6u %6u %6u %6u %8u", stats.name, (uint32_t)stats.block_size,
+                stats.block_count, stats.used, stats.max_used, stats.failures);
+  }
+
   return 0;
 }
 
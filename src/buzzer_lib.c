@@ -1,33 +1,77 @@
 
 #include "buzzer_lib.h"
 #include "ringtone.h"
+#include "ringtone_manager.h"
 #include <zephyr/drivers/pwm.h>
 #include <zephyr/kernel.h>
 
 #define NUM_STEPS 50U
 #define SLEEP_MSEC 25U
 
-// Tipo para notificacoes de buzzer
-typedef enum {
-  RINGTONE_TOUCH_PRESSED,
-  RINGTONE_ALARM1,
-  RINGTONE_ALARM2,
-} ringtone_notification_type_t;
-
 // Exemplo de ringtone personalizado
-static const char *MARIO_RTTTL =
+static const char MARIO_RTTTL[] =
     "Super Mario:d=4,o=5,b=100:16e6,16e6,32p,8e6,16c6,8e6,8g6,8p,8g,8p,"
     "8c6,16p,8g,16p,8e,16p,8a,8b,16a#,8a,16g.,16e6,16g6,"
     "8a6,16f6,8g6,8e6,16c6,16d6,8b";
-static const char *TOUCHSCREEN_PRESSED_RTTTL = "Touch:d=16,o=6,b=180:c,p";
-static const char *TOUCHSCREEN_LONG_PRESSED_RTTTL = "beep:d=4,o=5,b=100:c6";
-static const char *ALARM1_RTTTL = "Alarm1:d=8,o=5,b=160:c6,p,c6,p,c6,p,c6";
-static const char *ALARM2_RTTTL = "Alarm2:d=4,o=5,b=200:c6,g5,c6,g5,c6,g5,c6";
+static const char TOUCHSCREEN_PRESSED_RTTTL[] = "Touch:d=16,o=6,b=180:c,p";
+static const char TOUCHSCREEN_LONG_PRESSED_RTTTL[] = "beep:d=4,o=5,b=100:c6";
+static const char ALARM1_RTTTL[] = "Alarm1:d=8,o=5,b=160:c6,p,c6,p,c6,p,c6";
+static const char ALARM2_RTTTL[] = "Alarm2:d=4,o=5,b=200:c6,g5,c6,g5,c6,g5,c6";
+
+// Notificacao compilada uma unica vez no init, tocada sem reprocessar RTTTL
+typedef struct {
+  const char *rtttl;
+  ringtone_priority_t priority;
+  uint8_t flags;
+  ringtone_note_t notes[RINGTONE_MAX_NOTES];
+  uint16_t count;
+} buzzer_tune_t;
+
+// Toques de tela nunca atrasam um alarme: prioridade baixa, agrupados e
+// descartados se o buzzer estiver ocupado (um clique interrompido nao volta).
+// Alarmes interrompem tudo abaixo deles e nunca sao interrompidos: a
+// preempcao exige prioridade maior. A musica personalizada, interrompida por
+// um alarme, retoma de onde parou.
+static buzzer_tune_t g_tunes[] = {
+    [RINGTONE_TOUCH_PRESSED] = {.rtttl = TOUCHSCREEN_PRESSED_RTTTL,
+                                .priority = RINGTONE_PRIO_LOW,
+                                .flags = RINGTONE_FLAG_COALESCE |
+                                         RINGTONE_FLAG_DISCARD_IF_BUSY},
+    [RINGTONE_ALARM1] = {.rtttl = ALARM1_RTTTL,
+                         .priority = RINGTONE_PRIO_HIGH,
+                         .flags = RINGTONE_FLAG_COALESCE},
+    [RINGTONE_ALARM2] = {.rtttl = ALARM2_RTTTL,
+                         .priority = RINGTONE_PRIO_HIGH,
+                         .flags = RINGTONE_FLAG_COALESCE},
+};
+
+// Musica personalizada (Buzzer_PlayCustom), tocada com prioridade normal e
+// retomada depois de um alarme. O mutex serializa cancelamento, compilacao e
+// enfileiramento: o buffer e unico e o gerenciador pode estar lendo-o
+static ringtone_note_t g_custom_notes[RINGTONE_MAX_NOTES];
+static K_MUTEX_DEFINE(g_custom_lock);
 
 static ringstones_t g_ringstones;
+static ringtone_manager_t g_ringtone_manager;
 static const struct pwm_dt_spec g_buzzer =
     PWM_DT_SPEC_GET(DT_ALIAS(pwm_buzzer0));
 
+static int buzzer_compile_tunes(void) {
+  int count;
+
+  for (int i = 0; i < ARRAY_SIZE(g_tunes); i++) {
+    count = ringtones_compile(g_tunes[i].rtttl, 4, 5, 100, g_tunes[i].notes,
+                              RINGTONE_MAX_NOTES);
+    if (count < 0) {
+      printk("Error %d: failed to compile tune %d\n", count, i);
+      return count;
+    }
+    g_tunes[i].count = count;
+  }
+
+  return 0;
+}
+
 int buzzer_init(void) {
   int err;
 
@@ -39,7 +83,20 @@ int buzzer_init(void) {
 
   pwm_set_pulse_dt(&g_buzzer, 0);
 
-  return 0;
+  err = ringtones_init(&g_ringstones, &g_buzzer, TOUCHSCREEN_PRESSED_RTTTL, 4,
+                       5, 100);
+  if (err) {
+    printk("Failed to initialize ringtones: %d\n", err);
+    return err;
+  }
+
+  err = ringtone_manager_init(&g_ringtone_manager, &g_ringstones);
+  if (err) {
+    printk("Failed to initialize ringtone manager: %d\n", err);
+    return err;
+  }
+
+  return buzzer_compile_tunes();
 }
 
 int buzzer_set_percent(int percent) {
@@ -135,40 +192,54 @@ int buzzer_test(int test_cycles) {
   return 0;
 }
 
+// Nao bloqueante, pode ser chamada de qualquer contexto (ex.: callback de alarme)
 int buzzer_play_notification(ringtone_notification_type_t type) {
-  if (ringtones_is_playing(&g_ringstones)) {
-    ringtones_stop(&g_ringstones);
+  if (type < 0 || type >= ARRAY_SIZE(g_tunes)) {
+    return -EINVAL;
   }
 
-  switch (type) {
-  case RINGTONE_TOUCH_PRESSED:
-    g_ringstones.config.rtttl_string = MARIO_RTTTL;
-    break;
-  case RINGTONE_ALARM1:
-    g_ringstones.config.rtttl_string = ALARM1_RTTTL;
-    break;
-  case RINGTONE_ALARM2:
-    g_ringstones.config.rtttl_string = ALARM2_RTTTL;
-    break;
-  default:
+  return ringtone_manager_enqueue(&g_ringtone_manager, g_tunes[type].notes,
+                                  g_tunes[type].count, g_tunes[type].priority,
+                                  g_tunes[type].flags);
+}
+
+// Para alarmes e notificacoes ativos de um nivel (ex.: alarme reconhecido)
+int buzzer_cancel_notification(ringtone_notification_type_t type) {
+  if (type < 0 || type >= ARRAY_SIZE(g_tunes)) {
     return -EINVAL;
   }
 
-  return ringtones_play(&g_ringstones);
+  return ringtone_manager_cancel(&g_ringtone_manager, g_tunes[type].priority);
 }
 
+// Bloqueante (mutex): nao chamar de ISR
 int Buzzer_PlayCustom(const char *rtttl_string) {
+  int count;
+  int ret;
+
   if (rtttl_string == NULL) {
     return -EINVAL;
   }
 
-  if (ringtones_is_playing(&g_ringstones)) {
-    ringtones_stop(&g_ringstones);
+  k_mutex_lock(&g_custom_lock, K_FOREVER);
+
+  // O buffer e unico: remove a musica personalizada anterior (tocando,
+  // pendente ou interrompida) antes de recompilar
+  ringtone_manager_cancel(&g_ringtone_manager, RINGTONE_PRIO_NORMAL);
+
+  count = ringtones_compile(rtttl_string, 4, 5, 100, g_custom_notes,
+                            RINGTONE_MAX_NOTES);
+  if (count < 0) {
+    k_mutex_unlock(&g_custom_lock);
+    return count;
   }
 
-  g_ringstones.config.rtttl_string = rtttl_string;
+  ret = ringtone_manager_enqueue(&g_ringtone_manager, g_custom_notes, count,
+                                 RINGTONE_PRIO_NORMAL, RINGTONE_FLAG_RESUME);
 
-  return ringtones_play(&g_ringstones);
+  k_mutex_unlock(&g_custom_lock);
+
+  return ret;
 }
 
 int buzzer_ringotne_test(void) {
@@ -181,13 +252,6 @@ int buzzer_ringotne_test(void) {
     return ret;
   }
 
-  ret = ringtones_init(&g_ringstones, &g_buzzer, TOUCHSCREEN_PRESSED_RTTTL, 4,
-                       5, 100);
-  if (ret) {
-    printk("Failed to initialize ringtones: %d", ret);
-    return ret;
-  }
-
   // Toca um toque na tela
   printk("Playing touch sound\n");
 
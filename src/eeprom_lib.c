@@ -1,85 +1,438 @@
 #include "eeprom_lib.h"
+#include "kv_store.h"
 #include <zephyr/device.h>
 #include <zephyr/drivers/eeprom.h>
 #include <zephyr/kernel.h>
 
+// Cache write-back por pagina: escritas pequenas sao agrupadas e gravadas em
+// uma unica transferencia por pagina, em segundo plano
+// A pagina do cache nunca passa da pagina do dispositivo nem do limite do Kconfig
+#define EEPROM_NODE DT_ALIAS(eeprom_0)
+#define EEPROM_DEVICE_PAGE_SIZE DT_PROP_OR(EEPROM_NODE, pagesize, 64)
+#define EEPROM_CACHE_PAGE_SIZE MIN(EEPROM_DEVICE_PAGE_SIZE, CONFIG_APP_EEPROM_CACHE_PAGE_SIZE)
+#define EEPROM_CACHE_PAGES 8
+#define EEPROM_CACHE_FLUSH_MS 100
+
+// Contadores frequentes ficam no fim da memoria, em setores rotativos
+#define EEPROM_KV_SECTOR_SIZE 1024
+#define EEPROM_KV_SECTORS 4
+#define EEPROM_KV_SIZE (EEPROM_KV_SECTOR_SIZE * EEPROM_KV_SECTORS)
+
+struct eeprom_cache_page {
+  size_t base;
+  bool used;
+  bool valid;         // Pagina inteira lida do dispositivo
+  uint16_t dirty_lo;  // Faixa suja [dirty_lo, dirty_hi)
+  uint16_t dirty_hi;
+  uint32_t last_use;
+  uint8_t data[EEPROM_CACHE_PAGE_SIZE];
+};
+
+// Uma gravacao de pagina do cache nao pode cruzar a pagina do dispositivo
+BUILD_ASSERT((EEPROM_DEVICE_PAGE_SIZE % EEPROM_CACHE_PAGE_SIZE) == 0,
+             "APP_EEPROM_CACHE_PAGE_SIZE must divide the device page size");
+
 static int mutex_lock(void);
 static void mutex_unlock(void);
+static int eeprom_bus_read(size_t offset, void *buf, size_t buflen);
+static int eeprom_bus_write(size_t offset, const void *buf, size_t buflen);
+static bool cache_page_dirty(const struct eeprom_cache_page *page);
+static struct eeprom_cache_page *cache_find(size_t base);
+static int cache_page_flush(struct eeprom_cache_page *page);
+static int cache_page_load(struct eeprom_cache_page *page);
+static struct eeprom_cache_page *cache_alloc(size_t base);
+static int cache_flush_all(void);
+static void cache_flush_work_handler(struct k_work *work);
 
 static bool eeprom_init = false;
 static struct k_mutex eeprom_mutex;
+static size_t eeprom_size;
+static struct eeprom_cache_page cache[EEPROM_CACHE_PAGES];
+static uint8_t cache_scratch[EEPROM_CACHE_PAGE_SIZE];  // Leitura de pagina, sob eeprom_mutex
+static uint32_t cache_clock;
+static struct eeprom_lib_stats cache_stats;
+static struct k_work_delayable cache_flush_work;
+static struct kv_store eeprom_kv;
+static bool eeprom_kv_ready = false;
 const struct device *const dev_eepromm = DEVICE_DT_GET(DT_ALIAS(eeprom_0));
 
 static int mutex_lock(void) {
-  return k_mutex_lock(&eeprom_mutex, K_MSEC(10000));
+  return k_mutex_lock(&eeprom_mutex, K_FOREVER);
 }
 
 static void mutex_unlock(void) { k_mutex_unlock(&eeprom_mutex); }
 
+static int eeprom_bus_read(size_t offset, void *buf, size_t buflen) {
+  uint32_t start = k_cycle_get_32();
+  int rc;
+
+  rc = eeprom_read(dev_eepromm, offset, buf, buflen);
+  cache_stats.bus_reads++;
+  cache_stats.bus_time_us += k_cyc_to_us_floor32(k_cycle_get_32() - start);
+  if (rc < 0) {
+    printk("Error: Couldn't read fram: err:%d.\n", rc);
+  }
+
+  return rc;
+}
+
+static int eeprom_bus_write(size_t offset, const void *buf, size_t buflen) {
+  uint32_t start = k_cycle_get_32();
+  int rc;
+
+  rc = eeprom_write(dev_eepromm, offset, buf, buflen);
+  cache_stats.bus_writes++;
+  cache_stats.bus_time_us += k_cyc_to_us_floor32(k_cycle_get_32() - start);
+  if (rc < 0) {
+    printk("Error: Couldn't write fram: err:%d.\n", rc);
+  }
+
+  return rc;
+}
+
+static bool cache_page_dirty(const struct eeprom_cache_page *page) {
+  return page->dirty_hi > page->dirty_lo;
+}
+
+static struct eeprom_cache_page *cache_find(size_t base) {
+  for (int i = 0; i < EEPROM_CACHE_PAGES; i++) {
+    if (cache[i].used && (cache[i].base == base)) {
+      return &cache[i];
+    }
+  }
+
+  return NULL;
+}
+
+static int cache_page_flush(struct eeprom_cache_page *page) {
+  int rc;
+
+  if (!cache_page_dirty(page)) {
+    return 0;
+  }
+
+  rc = eeprom_bus_write(page->base + page->dirty_lo, &page->data[page->dirty_lo],
+                        page->dirty_hi - page->dirty_lo);
+  if (rc == 0) {
+    page->dirty_lo = 0;
+    page->dirty_hi = 0;
+    cache_stats.page_flushes++;
+  }
+
+  return rc;
+}
+
+// Le a pagina do dispositivo sem sobrescrever os bytes ainda nao gravados.
+// Chamado com eeprom_mutex: usa o buffer estatico em vez da pilha
+static int cache_page_load(struct eeprom_cache_page *page) {
+  uint8_t *tmp = cache_scratch;
+  size_t len = MIN(EEPROM_CACHE_PAGE_SIZE, eeprom_size - page->base);
+  int rc;
+
+  rc = eeprom_bus_read(page->base, tmp, len);
+  if (rc < 0) {
+    return rc;
+  }
+
+  if (cache_page_dirty(page)) {
+    memcpy(page->data, tmp, page->dirty_lo);
+    if (page->dirty_hi < len) {
+      memcpy(&page->data[page->dirty_hi], &tmp[page->dirty_hi], len - page->dirty_hi);
+    }
+  } else {
+    memcpy(page->data, tmp, len);
+  }
+
+  page->valid = true;
+
+  return 0;
+}
+
+// Pagina menos usada, preferindo as limpas; uma pagina suja e gravada antes
+static struct eeprom_cache_page *cache_alloc(size_t base) {
+  struct eeprom_cache_page *victim = NULL;
+  struct eeprom_cache_page *page;
+
+  for (int i = 0; i < EEPROM_CACHE_PAGES; i++) {
+    page = &cache[i];
+    if (!page->used) {
+      victim = page;
+      break;
+    }
+    if ((victim == NULL) ||
+        (cache_page_dirty(victim) && !cache_page_dirty(page)) ||
+        ((cache_page_dirty(victim) == cache_page_dirty(page)) &&
+         (page->last_use < victim->last_use))) {
+      victim = page;
+    }
+  }
+
+  if (victim->used) {
+    cache_stats.evictions++;
+    if (cache_page_flush(victim) < 0) {
+      return NULL;
+    }
+  }
+
+  victim->used = true;
+  victim->valid = false;
+  victim->base = base;
+  victim->dirty_lo = 0;
+  victim->dirty_hi = 0;
+
+  return victim;
+}
+
+// Grava as paginas sujas em ordem de endereco, nao na ordem do array
+static int cache_flush_all(void) {
+  struct eeprom_cache_page *dirty[EEPROM_CACHE_PAGES];
+  struct eeprom_cache_page *page;
+  int count = 0;
+  int ret = 0;
+  int rc;
+  int j;
+
+  for (int i = 0; i < EEPROM_CACHE_PAGES; i++) {
+    page = &cache[i];
+    if (!page->used || !cache_page_dirty(page)) {
+      continue;
+    }
+    for (j = count; (j > 0) && (dirty[j - 1]->base > page->base); j--) {
+      dirty[j] = dirty[j - 1];
+    }
+    dirty[j] = page;
+    count++;
+  }
+
+  for (int i = 0; i < count; i++) {
+    rc = cache_page_flush(dirty[i]);
+    if (rc < 0) {
+      ret = rc;
+    }
+  }
+
+  return ret;
+}
+
+static void cache_flush_work_handler(struct k_work *work) {
+  ARG_UNUSED(work);
+
+  if (mutex_lock() == 0) {
+    if (cache_flush_all() < 0) {
+      // Tenta novamente no proximo ciclo
+      k_work_schedule(&cache_flush_work, K_MSEC(EEPROM_CACHE_FLUSH_MS));
+    }
+    mutex_unlock();
+  }
+}
+
 int eeprom_lib_init(void) {
+  k_mutex_init(&eeprom_mutex);
+  k_work_init_delayable(&cache_flush_work, cache_flush_work_handler);
+
   if (!device_is_ready(dev_eepromm)) {
     printk("Device \"%s\" is not ready\n", dev_eepromm->name);
-    mutex_unlock();
     return -EIO;
   }
 
+  eeprom_size = eeprom_get_size(dev_eepromm);
+  memset(cache, 0, sizeof(cache));
+
   eeprom_init = true;
   printk("Found fram device \"%s\"\n", dev_eepromm->name);
 
-  mutex_unlock();
+  if (eeprom_size >= EEPROM_KV_SIZE) {
+    int rc = kv_store_init(&eeprom_kv, eeprom_size - EEPROM_KV_SIZE,
+                           EEPROM_KV_SECTOR_SIZE, EEPROM_KV_SECTORS);
+    if (rc) {
+      printk("Error: Couldn't init fram kv store: err:%d.\n", rc);
+    } else {
+      eeprom_kv_ready = true;
+    }
+  }
+
   return 0;
 }
 
+// A escrita vai para o cache; a gravacao no dispositivo ocorre em ate
+// EEPROM_CACHE_FLUSH_MS ou em eeprom_lib_sync()
 int eeprom_lib_write(size_t offset, const void *buf, size_t buflen) {
+  const uint8_t *src = buf;
+  struct eeprom_cache_page *page;
+  size_t base, pos, chunk;
   int rc;
 
   if (!eeprom_init) {
     return -EIO;
   }
 
+  if ((buf == NULL) || (offset + buflen > eeprom_size)) {
+    return -EINVAL;
+  }
+
   rc = mutex_lock();
   if (rc) {
     return rc;
   }
 
-  if (dev_eepromm == NULL) {
-    printk("fram device is not initialized.\n");
-    mutex_unlock();
-    return -EINVAL;
-  }
+  while (buflen > 0) {
+    base = ROUND_DOWN(offset, EEPROM_CACHE_PAGE_SIZE);
+    pos = offset - base;
+    chunk = MIN(buflen, EEPROM_CACHE_PAGE_SIZE - pos);
 
-  rc = eeprom_write(dev_eepromm, offset, buf, buflen);
-  if (rc < 0) {
-    printk("Error: Couldn't write fram: err:%d.\n", rc);
+    page = cache_find(base);
+    if (page) {
+      cache_stats.hits++;
+    } else {
+      cache_stats.misses++;
+      page = cache_alloc(base);
+      if (page == NULL) {
+        rc = -EIO;
+        break;
+      }
+    }
+
+    // Faixa nao contigua a suja: completa a pagina para gravar em uma transferencia
+    if (cache_page_dirty(page) && !page->valid &&
+        ((pos > page->dirty_hi) || (pos + chunk < page->dirty_lo))) {
+      rc = cache_page_load(page);
+      if (rc < 0) {
+        break;
+      }
+    }
+
+    memcpy(&page->data[pos], src, chunk);
+    if (cache_page_dirty(page)) {
+      page->dirty_lo = MIN(page->dirty_lo, pos);
+      page->dirty_hi = MAX(page->dirty_hi, pos + chunk);
+    } else {
+      page->dirty_lo = pos;
+      page->dirty_hi = pos + chunk;
+    }
+    page->last_use = ++cache_clock;
+
+    offset += chunk;
+    src += chunk;
+    buflen -= chunk;
   }
 
   mutex_unlock();
+
+  k_work_schedule(&cache_flush_work, K_MSEC(EEPROM_CACHE_FLUSH_MS));
+
   return rc;
 }
 
 int eeprom_lib_read(size_t offset, void *buf, size_t buflen) {
+  struct eeprom_cache_page *page;
+  uint8_t *dest = buf;
+  size_t base, pos, chunk;
   int rc = 0;
 
   if (!eeprom_init) {
     return -EIO;
   }
 
+  if ((buf == NULL) || (offset + buflen > eeprom_size)) {
+    return -EINVAL;
+  }
+
   rc = mutex_lock();
   if (rc) {
     return rc;
   }
 
-  rc = eeprom_read(dev_eepromm, offset, buf, buflen);
-  if (rc < 0) {
-    printk("Error: Couldn't write fram: err:%d.\n", rc);
-  } else {
-    printk("Data read from fram.\n");
+  while (buflen > 0) {
+    base = ROUND_DOWN(offset, EEPROM_CACHE_PAGE_SIZE);
+    pos = offset - base;
+    chunk = MIN(buflen, EEPROM_CACHE_PAGE_SIZE - pos);
+
+    page = cache_find(base);
+    if (page && (page->valid || ((pos >= page->dirty_lo) && (pos + chunk <= page->dirty_hi)))) {
+      cache_stats.hits++;
+    } else {
+      cache_stats.misses++;
+      if (page == NULL) {
+        page = cache_alloc(base);
+        if (page == NULL) {
+          rc = -EIO;
+          break;
+        }
+      }
+
+      rc = cache_page_load(page);
+      if (rc < 0) {
+        // Descarta a pagina se nao houver dados pendentes nela
+        page->used = cache_page_dirty(page);
+        break;
+      }
+    }
+
+    memcpy(dest, &page->data[pos], chunk);
+    page->last_use = ++cache_clock;
+
+    offset += chunk;
+    dest += chunk;
+    buflen -= chunk;
+  }
+
+  mutex_unlock();
+  return rc;
+}
+
+// Grava imediatamente todas as paginas sujas
+int eeprom_lib_sync(void) {
+  int rc;
+
+  if (!eeprom_init) {
+    return -EIO;
+  }
+
+  rc = mutex_lock();
+  if (rc) {
+    return rc;
   }
 
+  rc = cache_flush_all();
+
   mutex_unlock();
   return rc;
 }
 
+int eeprom_lib_get_stats(struct eeprom_lib_stats *stats) {
+  int rc;
+
+  if (stats == NULL) {
+    return -EINVAL;
+  }
+
+  rc = mutex_lock();
+  if (rc) {
+    return rc;
+  }
+
+  *stats = cache_stats;
+
+  mutex_unlock();
+  return 0;
+}
+
+int eeprom_kv_write(enum eeprom_kv_key key, const void *value, uint8_t length) {
+  if (!eeprom_kv_ready) {
+    return -EIO;
+  }
+
+  return kv_store_write(&eeprom_kv, key, value, length);
+}
+
+int eeprom_kv_read(enum eeprom_kv_key key, void *value, uint8_t length) {
+  if (!eeprom_kv_ready) {
+    return -EIO;
+  }
+
+  return kv_store_read(&eeprom_kv, key, value, length);
+}
+
 int eeprom_test(void) {
   int ret;
   char msg[] =
@@ -89,6 +442,9 @@ int eeprom_test(void) {
   memset(read_msg, 0, sizeof(read_msg));
 
   ret = eeprom_lib_write(0, msg, sizeof(msg));
+  if (!ret) {
+    ret = eeprom_lib_sync();
+  }
   if (!ret) {
     ret = eeprom_lib_read(0, read_msg, sizeof(msg));
     if (!ret) {
@@ -1,21 +1,78 @@
 #include "isotp_conn.h"
 
+#include <string.h>
 #include <zephyr/canbus/isotp.h>
 #include <zephyr/kernel.h>
 #include <zephyr/net_buf.h>
+#include <zephyr/shell/shell.h>
 #include <zephyr/sys/slist.h>
 
+#define ISOTP_CONN_STACK_MEM_ATTRIBUTES Z_GENERIC_SECTION(.app_stack)
+
 /**
  * @brief Dados do usuário anexados a cada buffer
  */
 struct isotp_buf_user_data {
   uint32_t addr; // Endereço CAN
+  uint32_t fc_addr;             // Onde o destino responde com flow control
+  isotp_conn_tx_cb_t cb;
+  void *user_data;
+  uint32_t cycles;              // Momento do enfileiramento (latencia)
+  uint8_t prio;
+};
+
+enum isotp_conn_tx_state {
+  ISOTP_CONN_TX_IDLE = 0,
+  ISOTP_CONN_TX_BUSY,
+  ISOTP_CONN_TX_DONE,           // Finalizado pelo isotp, aguardando a thread
+  ISOTP_CONN_TX_BACKOFF,        // Falhou; reenvia apos o atraso
+};
+
+/**
+ * @brief Contexto de envio; um por destino em andamento
+ *
+ * O buffer fica preso ao contexto ate o fim, inclusive durante as novas
+ * tentativas: o isotp_send nao copia os dados e o destino segue ocupado, o que
+ * mantem a ordem das mensagens para ele.
+ */
+struct isotp_conn_tx_ctx {
+  struct isotp_send_ctx sctx;
+  struct net_buf *buf;
+  uint32_t addr;
+  uint32_t fc_addr;
+  int error;
+  uint8_t retries;
+  uint32_t retry_at;            // k_uptime_get_32 do proximo reenvio
+  atomic_t state;
+};
+
+// Fila de uma prioridade; slots limitam a profundidade (back-pressure)
+struct isotp_conn_lane {
+  sys_slist_t queue;
+  struct k_sem slots;
+  struct isotp_conn_lane_stats stats;
+};
+
+// Recepcao de um endereco; a thread bloqueia no contexto isotp
+struct isotp_conn_binding {
+  struct isotp_recv_ctx rctx;
+  struct k_thread thread;
+  uint32_t rx_addr;
+  uint32_t tx_addr;
+  bool used;
+};
+
+struct isotp_conn_rx_entry {
+  uint32_t rx_addr;
+  int16_t service;
+  isotp_conn_rx_handler_t handler;
+  void *user_data;
 };
 
-static int isotp_conn_lock(void);
-static void isotp_conn_unlock(void);
-static int isotp_conn_msg_lock(void);
-static void isotp_conn_msg_unlock(void);
+static void isotp_conn_tx_callback(int error_nr, void *arg);
+static void isotp_conn_tx_thread(void *p1, void *p2, void *p3);
+static void isotp_conn_rx_thread(void *p1, void *p2, void *p3);
+static int isotp_conn_shell_cmd_stats(const struct shell *shell, size_t argc, char **argv);
 
 // Define o pool de buffers fora da classe
 NET_BUF_POOL_DEFINE(isotp_tx_pool, ISOTP_NUM_BUFFERS, ISOTP_MAX_DATA_LEN,
@@ -23,28 +80,236 @@ NET_BUF_POOL_DEFINE(isotp_tx_pool, ISOTP_NUM_BUFFERS, ISOTP_MAX_DATA_LEN,
 
 static const struct device *m_can_dev = DEVICE_DT_GET(DT_CHOSEN(zephyr_canbus));
 static const struct isotp_fc_opts m_fc_opts = {.bs = 8, .stmin = 1};
-static struct isotp_recv_ctx m_rctx;
-static struct isotp_send_ctx m_sctx;
-static sys_slist_t m_tx_queue;
+static const char *const m_lane_names[ISOTP_CONN_PRIO_COUNT] = {"urgent", "normal", "bulk"};
+static struct isotp_conn_tx_ctx m_tx_ctx[CONFIG_APP_ISOTP_TX_CONTEXTS];
+static struct isotp_conn_lane m_lanes[ISOTP_CONN_PRIO_COUNT];
+static struct isotp_conn_binding m_bindings[CONFIG_APP_ISOTP_BINDINGS];
+static struct isotp_conn_rx_entry m_rx_handlers[CONFIG_APP_ISOTP_RX_HANDLERS];
+static struct isotp_conn_rx_stats m_rx_stats;
+static struct k_spinlock m_lane_lock;
+static struct k_spinlock m_rx_lock;
+static struct k_thread m_tx_thread;
+static bool m_tx_started;
+
+Z_KERNEL_STACK_DEFINE_IN(m_tx_stack, CONFIG_APP_ISOTP_TX_STACK_SIZE,
+                         ISOTP_CONN_STACK_MEM_ATTRIBUTES);
+Z_KERNEL_STACK_ARRAY_DEFINE_IN(m_rx_stacks, CONFIG_APP_ISOTP_BINDINGS,
+                               CONFIG_APP_ISOTP_RX_STACK_SIZE, ISOTP_CONN_STACK_MEM_ATTRIBUTES);
+K_SEM_DEFINE(isotp_conn_tx_signal, 0, 1);
+K_MUTEX_DEFINE(isotp_conn_bind_mutex);
+
+SHELL_STATIC_SUBCMD_SET_CREATE(
+    isotp, SHELL_CMD(stats, NULL, "transmit lanes statistics", isotp_conn_shell_cmd_stats),
+    SHELL_SUBCMD_SET_END);
+
+SHELL_CMD_REGISTER(isotp, &isotp, "ISO-TP commands", NULL);
+
+static void isotp_conn_msg_id(struct isotp_msg_id *id, uint32_t addr) {
+  memset(id, 0x0, sizeof(*id));
+  id->std_id = addr;
+
+#if defined(CONFIG_APP_ISOTP_CAN_FD)
+  // Quadros de 64 bytes: mensagens de varios KB com menos quadros
+  id->flags = ISOTP_MSG_FDF | ISOTP_MSG_BRS;
+  id->dl = 64;
+#endif
+}
 
-K_SEM_DEFINE(isotp_conn_mutex, 0, 1);
-K_SEM_DEFINE(isotp_conn_msg_mutex, 0, 1);
+// Contexto do isotp: apenas marca o fim e acorda a thread de envio
+static void isotp_conn_tx_callback(int error_nr, void *arg) {
+  struct isotp_conn_tx_ctx *ctx = arg;
 
-static int isotp_conn_lock(void) {
-  return k_sem_take(&isotp_conn_mutex, K_MSEC(0));
+  ctx->error = error_nr;
+  atomic_set(&ctx->state, ISOTP_CONN_TX_DONE);
+  k_sem_give(&isotp_conn_tx_signal);
 }
 
-static void isotp_conn_unlock(void) { return k_sem_give(&isotp_conn_mutex); }
+static void isotp_conn_tx_start(struct isotp_conn_tx_ctx *ctx) {
+  struct isotp_msg_id dst_addr;
+  struct isotp_msg_id fc_addr;
+  int ret;
 
-static int isotp_conn_msg_lock(void) {
-  return k_sem_take(&isotp_conn_msg_mutex, K_MSEC(0));
+  isotp_conn_msg_id(&dst_addr, ctx->addr);
+  isotp_conn_msg_id(&fc_addr, ctx->fc_addr);
+
+  ctx->error = ISOTP_N_OK;
+  atomic_set(&ctx->state, ISOTP_CONN_TX_BUSY);
+
+  ret = isotp_send(&ctx->sctx, m_can_dev, ctx->buf->data, ctx->buf->len, &dst_addr, &fc_addr,
+                   isotp_conn_tx_callback, ctx);
+  if (ret != ISOTP_N_OK) {
+    isotp_conn_tx_callback(ret, ctx);
+  }
 }
 
-static void isotp_conn_msg_unlock(void) {
-  return k_sem_give(&isotp_conn_msg_mutex);
+// Fim definitivo: estatisticas, callback do usuario e devolucao do slot
+static void isotp_conn_tx_finish(struct isotp_conn_tx_ctx *ctx) {
+  struct isotp_buf_user_data user_data = *(struct isotp_buf_user_data *)net_buf_user_data(ctx->buf);
+  struct isotp_conn_lane *lane = &m_lanes[user_data.prio];
+  uint32_t latency_us = k_cyc_to_us_floor32(k_cycle_get_32() - user_data.cycles);
+  k_spinlock_key_t key;
+
+  key = k_spin_lock(&m_lane_lock);
+  if (ctx->error == ISOTP_N_OK) {
+    lane->stats.sent++;
+  } else {
+    lane->stats.failed++;
+  }
+  lane->stats.latency_us_last = latency_us;
+  lane->stats.latency_us_max = MAX(lane->stats.latency_us_max, latency_us);
+  k_spin_unlock(&m_lane_lock, key);
+
+  if (ctx->error != ISOTP_N_OK) {
+    printk("Erro ao enviar mensagem para 0x%X [%d]\n", ctx->addr, ctx->error);
+  }
+
+  net_buf_unref(ctx->buf);
+  ctx->buf = NULL;
+  atomic_set(&ctx->state, ISOTP_CONN_TX_IDLE);
+  k_sem_give(&lane->slots);
+
+  if (user_data.cb) {
+    user_data.cb(ctx->error, user_data.addr, user_data.user_data);
+  }
+}
+
+/**
+ * @brief Trata os contextos finalizados e os reenvios pendentes
+ *
+ * @return ms ate o proximo reenvio agendado ou SYS_FOREVER_MS
+ */
+static int32_t isotp_conn_tx_service(void) {
+  struct isotp_conn_tx_ctx *ctx;
+  struct isotp_conn_lane *lane;
+  uint32_t now = k_uptime_get_32();
+  int32_t wait_ms = SYS_FOREVER_MS;
+  int32_t remaining;
+  k_spinlock_key_t key;
+
+  for (size_t i = 0; i < ARRAY_SIZE(m_tx_ctx); i++) {
+    ctx = &m_tx_ctx[i];
+
+    switch (atomic_get(&ctx->state)) {
+    case ISOTP_CONN_TX_DONE:
+      if ((ctx->error == ISOTP_N_OK) || (ctx->retries >= CONFIG_APP_ISOTP_TX_RETRIES)) {
+        isotp_conn_tx_finish(ctx);
+        break;
+      }
+
+      ctx->retries++;
+      ctx->retry_at = now + CONFIG_APP_ISOTP_TX_RETRY_DELAY_MS;
+      atomic_set(&ctx->state, ISOTP_CONN_TX_BACKOFF);
+
+      lane = &m_lanes[((struct isotp_buf_user_data *)net_buf_user_data(ctx->buf))->prio];
+      key = k_spin_lock(&m_lane_lock);
+      lane->stats.retries++;
+      k_spin_unlock(&m_lane_lock, key);
+      __fallthrough;
+
+    case ISOTP_CONN_TX_BACKOFF:
+      remaining = (int32_t)(ctx->retry_at - now);
+      if (remaining <= 0) {
+        isotp_conn_tx_start(ctx);
+      } else if ((wait_ms == SYS_FOREVER_MS) || (remaining < wait_ms)) {
+        wait_ms = remaining;
+      }
+      break;
+
+    default:
+      break;
+    }
+  }
+
+  return wait_ms;
 }
 
-void isotp_conn_tx_callback(int error_nr, void *arg) { isotp_conn_unlock(); }
+static bool isotp_conn_tx_dst_busy(uint32_t addr) {
+  for (size_t i = 0; i < ARRAY_SIZE(m_tx_ctx); i++) {
+    if ((atomic_get(&m_tx_ctx[i].state) != ISOTP_CONN_TX_IDLE) && (m_tx_ctx[i].addr == addr)) {
+      return true;
+    }
+  }
+
+  return false;
+}
+
+/**
+ * @brief Retira a proxima mensagem a enviar, da fila mais prioritaria
+ *
+ * Mensagens para um destino ocupado ficam na fila em ordem; destinos
+ * diferentes transmitem em paralelo ate o limite de contextos.
+ */
+static struct net_buf *isotp_conn_tx_next(void) {
+  struct isotp_buf_user_data *user_data;
+  struct isotp_conn_lane *lane;
+  struct net_buf *buf;
+  sys_snode_t *node;
+  sys_snode_t *next;
+  sys_snode_t *prev;
+  k_spinlock_key_t key;
+
+  key = k_spin_lock(&m_lane_lock);
+
+  for (size_t i = 0; i < ARRAY_SIZE(m_lanes); i++) {
+    lane = &m_lanes[i];
+    prev = NULL;
+
+    SYS_SLIST_FOR_EACH_NODE_SAFE(&lane->queue, node, next) {
+      buf = CONTAINER_OF(node, struct net_buf, node);
+      user_data = net_buf_user_data(buf);
+
+      if (isotp_conn_tx_dst_busy(user_data->addr)) {
+        prev = node;
+        continue;
+      }
+
+      sys_slist_remove(&lane->queue, prev, node);
+      lane->stats.depth--;
+      k_spin_unlock(&m_lane_lock, key);
+
+      return buf;
+    }
+  }
+
+  k_spin_unlock(&m_lane_lock, key);
+
+  return NULL;
+}
+
+// Acorda ao enfileirar, ao fim de cada envio e no prazo do proximo reenvio
+static void isotp_conn_tx_thread(void *p1, void *p2, void *p3) {
+  struct isotp_conn_tx_ctx *ctx;
+  struct net_buf *buf;
+  int32_t wait_ms;
+
+  ARG_UNUSED(p1);
+  ARG_UNUSED(p2);
+  ARG_UNUSED(p3);
+
+  while (1) {
+    wait_ms = isotp_conn_tx_service();
+
+    for (size_t i = 0; i < ARRAY_SIZE(m_tx_ctx); i++) {
+      ctx = &m_tx_ctx[i];
+      if (atomic_get(&ctx->state) != ISOTP_CONN_TX_IDLE) {
+        continue;
+      }
+
+      buf = isotp_conn_tx_next();
+      if (!buf) {
+        break;
+      }
+
+      ctx->buf = buf;
+      ctx->addr = ((struct isotp_buf_user_data *)net_buf_user_data(buf))->addr;
+      ctx->fc_addr = ((struct isotp_buf_user_data *)net_buf_user_data(buf))->fc_addr;
+      ctx->retries = 0;
+      isotp_conn_tx_start(ctx);
+    }
+
+    k_sem_take(&isotp_conn_tx_signal, SYS_TIMEOUT_MS(wait_ms));
+  }
+}
 
 int isotp_conn_init(void) {
   int ret;
@@ -54,11 +319,9 @@ int isotp_conn_init(void) {
     return -EIO;
   }
 
-  sys_slist_init(&m_tx_queue);
-
   const can_mode_t mode =
       (IS_ENABLED(CONFIG_SAMPLE_LOOPBACK_MODE) ? CAN_MODE_LOOPBACK : 0) |
-      (IS_ENABLED(CONFIG_SAMPLE_CAN_FD_MODE) ? CAN_MODE_FD : 0);
+      (IS_ENABLED(CONFIG_APP_ISOTP_CAN_FD) ? CAN_MODE_FD : 0);
 
   ret = can_set_mode(m_can_dev, mode);
   if (ret != 0) {
@@ -72,48 +335,131 @@ int isotp_conn_init(void) {
     return ret;
   }
 
+  if (!m_tx_started) {
+    for (size_t i = 0; i < ARRAY_SIZE(m_lanes); i++) {
+      sys_slist_init(&m_lanes[i].queue);
+      k_sem_init(&m_lanes[i].slots, CONFIG_APP_ISOTP_LANE_DEPTH, CONFIG_APP_ISOTP_LANE_DEPTH);
+    }
+
+    k_thread_create(&m_tx_thread, m_tx_stack, K_KERNEL_STACK_SIZEOF(m_tx_stack),
+                    isotp_conn_tx_thread, NULL, NULL, NULL, CONFIG_APP_ISOTP_TX_PRIORITY, 0,
+                    K_NO_WAIT);
+    k_thread_name_set(&m_tx_thread, "isotp_tx");
+    m_tx_started = true;
+  }
+
   printk("CAN inicializada\n");
   return 0;
 }
 
+static struct isotp_conn_binding *isotp_conn_find_binding(uint32_t rx_addr) {
+  for (size_t i = 0; i < ARRAY_SIZE(m_bindings); i++) {
+    if (m_bindings[i].used && (m_bindings[i].rx_addr == rx_addr)) {
+      return &m_bindings[i];
+    }
+  }
+
+  return NULL;
+}
+
+/**
+ * @brief Registra uma recepcao ISO-TP; varias podem coexistir
+ *
+ * @return 0, -EALREADY se rx_addr ja esta registrado ou -ENOMEM sem slots
+ */
 int isotp_conn_bind(uint32_t rx_addr, uint32_t tx_addr) {
   int ret;
+  struct isotp_conn_binding *binding = NULL;
   struct isotp_msg_id isotp_rx;
   struct isotp_msg_id isotp_tx;
 
-  memset(&isotp_rx, 0x0, sizeof(isotp_rx));
-  memset(&isotp_tx, 0x0, sizeof(isotp_rx));
+  k_mutex_lock(&isotp_conn_bind_mutex, K_FOREVER);
+
+  if (isotp_conn_find_binding(rx_addr)) {
+    k_mutex_unlock(&isotp_conn_bind_mutex);
+    return -EALREADY;
+  }
+
+  for (size_t i = 0; i < ARRAY_SIZE(m_bindings); i++) {
+    if (!m_bindings[i].used) {
+      binding = &m_bindings[i];
+      break;
+    }
+  }
+
+  if (!binding) {
+    k_mutex_unlock(&isotp_conn_bind_mutex);
+    return -ENOMEM;
+  }
 
-  isotp_rx.std_id = rx_addr;
-  isotp_tx.std_id = tx_addr;
+  isotp_conn_msg_id(&isotp_rx, rx_addr);
+  isotp_conn_msg_id(&isotp_tx, tx_addr);
 
   printk("Registrando enderecos isotp\n");
   printk("RX: 0x%X - TX: 0x%X\n", isotp_rx.std_id, isotp_tx.std_id);
 
-  isotp_conn_unlock();
-  isotp_conn_msg_unlock();
-  ret = isotp_bind(&m_rctx, m_can_dev, &isotp_rx, &isotp_tx, &m_fc_opts,
-                   K_FOREVER);
+  ret = isotp_bind(&binding->rctx, m_can_dev, &isotp_rx, &isotp_tx, &m_fc_opts, K_FOREVER);
   if (ret != ISOTP_N_OK) {
     printk("Erro ao configurar endereco isotp: %d\n", ret);
+    k_mutex_unlock(&isotp_conn_bind_mutex);
     return ret;
   }
 
+  binding->rx_addr = rx_addr;
+  binding->tx_addr = tx_addr;
+  binding->used = true;
+
+  k_thread_create(&binding->thread, m_rx_stacks[binding - m_bindings],
+                  K_KERNEL_STACK_SIZEOF(m_rx_stacks[0]), isotp_conn_rx_thread, binding, NULL, NULL,
+                  CONFIG_APP_ISOTP_RX_PRIORITY, 0, K_NO_WAIT);
+  k_thread_name_set(&binding->thread, "isotp_rx");
+
+  k_mutex_unlock(&isotp_conn_bind_mutex);
+
   return 0;
 }
 
-void isotp_conn_unbind(void) {
-  struct net_buf *buf;
-  while ((buf = (struct net_buf *)sys_slist_get(&m_tx_queue)) != NULL) {
-    net_buf_unref(buf);
+int isotp_conn_unbind(uint32_t rx_addr) {
+  struct isotp_conn_binding *binding;
+
+  k_mutex_lock(&isotp_conn_bind_mutex, K_FOREVER);
+
+  binding = isotp_conn_find_binding(rx_addr);
+  if (!binding) {
+    k_mutex_unlock(&isotp_conn_bind_mutex);
+    return -ENOENT;
   }
-  isotp_unbind(&m_rctx);
+
+  // Acorda a thread bloqueada na fila do contexto para que ela termine
+  binding->used = false;
+  isotp_unbind(&binding->rctx);
+  k_fifo_cancel_wait(&binding->rctx.fifo);
+  k_thread_join(&binding->thread, K_FOREVER);
+
+  k_mutex_unlock(&isotp_conn_bind_mutex);
+
+  return 0;
 }
 
-int isotp_conn_transmit(uint32_t addr, const uint8_t *data, size_t len) {
-  int ret;
-  struct isotp_msg_id dst_addr;
-  struct isotp_msg_id fc_addr;
+/**
+ * @brief Enfileira um envio ISO-TP para addr na fila da prioridade dada
+ *
+ * fc_addr e o ID em que o destino manda o flow control das mensagens de
+ * varios quadros; numa resposta, o ID da requisicao (rx_addr do bind).
+ * Os dados sao copiados. Com a fila cheia espera ate timeout por espaco
+ * (back-pressure) em vez de descartar mensagens. Falhas do isotp sao
+ * repetidas CONFIG_APP_ISOTP_TX_RETRIES vezes. cb (opcional) e chamado na
+ * thread de envio com o resultado final (ISOTP_N_OK em caso de sucesso).
+ *
+ * @return 0, -EAGAIN se a fila continuou cheia ou -ENODEV antes do init
+ */
+int isotp_conn_send(uint32_t addr, uint32_t fc_addr, const uint8_t *data, size_t len,
+                    enum isotp_conn_prio prio, k_timeout_t timeout, isotp_conn_tx_cb_t cb,
+                    void *user_data) {
+  struct isotp_buf_user_data *buf_user_data;
+  struct isotp_conn_lane *lane;
+  struct net_buf *buf;
+  k_spinlock_key_t key;
 
   if (len > ISOTP_MAX_DATA_LEN) {
     printk("Erro: Tamanho de dados excede o máximo (%d > %d)\n", len,
@@ -121,155 +467,269 @@ int isotp_conn_transmit(uint32_t addr, const uint8_t *data, size_t len) {
     return -EINVAL;
   }
 
-  ret = isotp_conn_lock();
-  if (ret) {
-    return ret;
+  if (prio >= ISOTP_CONN_PRIO_COUNT) {
+    return -EINVAL;
   }
 
-  memset(&dst_addr, 0x0, sizeof(dst_addr));
-  memset(&fc_addr, 0x0, sizeof(fc_addr));
+  if (!m_tx_started) {
+    return -ENODEV;
+  }
 
-  dst_addr.std_id = addr;
-  fc_addr.std_id = addr - 0x100;
+  lane = &m_lanes[prio];
 
-  ret = isotp_send(&m_sctx, m_can_dev, data, len, &dst_addr, &fc_addr,
-                   isotp_conn_tx_callback, NULL);
+  if (k_sem_take(&lane->slots, timeout) != 0) {
+    key = k_spin_lock(&m_lane_lock);
+    lane->stats.rejected++;
+    k_spin_unlock(&m_lane_lock, key);
+    return -EAGAIN;
+  }
 
-  return ret;
+  // O pool tem um buffer por slot
+  buf = net_buf_alloc(&isotp_tx_pool, K_NO_WAIT);
+  if (!buf) {
+    k_sem_give(&lane->slots);
+    return -ENOMEM;
+  }
+
+  net_buf_add_mem(buf, data, len);
+  buf_user_data = net_buf_user_data(buf);
+  buf_user_data->addr = addr;
+  buf_user_data->fc_addr = fc_addr;
+  buf_user_data->cb = cb;
+  buf_user_data->user_data = user_data;
+  buf_user_data->cycles = k_cycle_get_32();
+  buf_user_data->prio = prio;
+
+  key = k_spin_lock(&m_lane_lock);
+  sys_slist_append(&lane->queue, &buf->node);
+  lane->stats.depth++;
+  lane->stats.max_depth = MAX(lane->stats.max_depth, lane->stats.depth);
+  k_spin_unlock(&m_lane_lock, key);
+
+  k_sem_give(&isotp_conn_tx_signal);
+
+  return 0;
 }
 
-int isotp_conn_receive(uint8_t data[], size_t max_len) {
-  int ret;
-  struct net_buf *buf = NULL;
-  size_t received_len = 0;
-  int rem_len;
+// Prioridade normal; bloqueia enquanto a fila estiver cheia
+int isotp_conn_transmit(uint32_t addr, const uint8_t *data, size_t len) {
+  return isotp_conn_send(addr, ISOTP_CONN_FC_ADDR(addr), data, len, ISOTP_CONN_PRIO_NORMAL, K_FOREVER, NULL, NULL);
+}
 
-  ret = isotp_conn_lock();
-  if (ret) {
-    return ret;
-  }
+/**
+ * @brief Entrega uma mensagem completa ao handler do endereco/servico
+ *
+ * Handler do servico (primeiro byte) tem preferencia sobre o de qualquer
+ * servico. A cadeia de buffers so e valida durante o handler.
+ */
+static void isotp_conn_rx_dispatch(uint32_t rx_addr, struct net_buf *msg) {
+  struct isotp_conn_rx_entry *entry;
+  isotp_conn_rx_handler_t handler = NULL;
+  void *user_data = NULL;
+  int16_t service = (msg->len > 0) ? msg->data[0] : ISOTP_CONN_ANY_SERVICE;
+  k_spinlock_key_t key;
+
+  key = k_spin_lock(&m_rx_lock);
+
+  for (size_t i = 0; i < ARRAY_SIZE(m_rx_handlers); i++) {
+    entry = &m_rx_handlers[i];
+    if (!entry->handler || (entry->rx_addr != rx_addr)) {
+      continue;
+    }
 
-  do {
-    rem_len = isotp_recv_net(&m_rctx, &buf, K_MSEC(0));
-    if (rem_len < 0) {
+    if (entry->service == service) {
+      handler = entry->handler;
+      user_data = entry->user_data;
       break;
     }
 
-    while (buf != NULL) {
-      if ((received_len + buf->len) > max_len) {
-        printk("Erro: Buffer de recepção muito pequeno\n");
-        while (buf != NULL) {
-          net_buf_frag_del(NULL, buf);
-        }
+    if ((entry->service == ISOTP_CONN_ANY_SERVICE) && !handler) {
+      handler = entry->handler;
+      user_data = entry->user_data;
+    }
+  }
+
+  m_rx_stats.messages++;
+  m_rx_stats.bytes += net_buf_frags_len(msg);
+  if (!handler) {
+    m_rx_stats.unhandled++;
+  }
+
+  k_spin_unlock(&m_rx_lock, key);
+
+  if (handler) {
+    handler(rx_addr, msg, user_data);
+  }
+}
+
+/**
+ * @brief Monta a mensagem encadeando os blocos recebidos, sem copia
+ *
+ * O tamanho maximo depende de CONFIG_ISOTP_RX_BUF_COUNT x CONFIG_ISOTP_RX_BUF_SIZE.
+ */
+static void isotp_conn_rx_thread(void *p1, void *p2, void *p3) {
+  struct isotp_conn_binding *binding = p1;
+  struct net_buf *msg = NULL;
+  struct net_buf *buf;
+  k_spinlock_key_t key;
+  int rem_len;
+
+  ARG_UNUSED(p2);
+  ARG_UNUSED(p3);
 
-        isotp_conn_unlock();
-        return 0;
+  while (binding->used) {
+    rem_len = isotp_recv_net(&binding->rctx, &buf, K_FOREVER);
+    if (rem_len < 0) {
+      // Erro do isotp (timeout, sequencia, overflow) ou unbind: descarta o parcial
+      if (msg) {
+        net_buf_unref(msg);
+        msg = NULL;
       }
 
-      memcpy(data + received_len, buf->data, buf->len);
-      received_len += buf->len;
-      buf = net_buf_frag_del(NULL, buf);
+      if (binding->used) {
+        key = k_spin_lock(&m_rx_lock);
+        m_rx_stats.errors++;
+        k_spin_unlock(&m_rx_lock, key);
+      }
+      continue;
     }
-  } while (rem_len);
 
-  isotp_conn_unlock();
+    if (msg) {
+      net_buf_frag_add(msg, buf);
+    } else {
+      msg = buf;
+    }
 
-  return received_len;
+    if (rem_len == 0) {
+      isotp_conn_rx_dispatch(binding->rx_addr, msg);
+      net_buf_unref(msg);
+      msg = NULL;
+    }
+  }
+
+  if (msg) {
+    net_buf_unref(msg);
+  }
 }
 
-int isotp_conn_add_message(uint32_t addr, const uint8_t *data, size_t len) {
-  int ret;
-  struct net_buf *buf;
-  struct net_buf *old_buf;
+/**
+ * @brief Registra o handler das mensagens recebidas em rx_addr
+ *
+ * service e o primeiro byte da mensagem (ex.: servico UDS) ou
+ * ISOTP_CONN_ANY_SERVICE. O handler roda na thread de recepcao do endereco.
+ */
+int isotp_conn_rx_register(uint32_t rx_addr, int16_t service, isotp_conn_rx_handler_t handler,
+                           void *user_data) {
+  struct isotp_conn_rx_entry *slot = NULL;
+  k_spinlock_key_t key;
 
-  if (len > ISOTP_MAX_DATA_LEN) {
-    printk("Erro: Tamanho de dados excede o máximo (%d > %d)\n", len,
-           ISOTP_MAX_DATA_LEN);
+  if (!handler) {
     return -EINVAL;
   }
 
-  ret = isotp_conn_msg_lock();
-  if (ret) {
-    return ret;
-  }
+  key = k_spin_lock(&m_rx_lock);
 
-  // Tenta alocar um novo buffer
-  buf = net_buf_alloc(&isotp_tx_pool, K_NO_WAIT);
+  for (size_t i = 0; i < ARRAY_SIZE(m_rx_handlers); i++) {
+    if (m_rx_handlers[i].handler && (m_rx_handlers[i].rx_addr == rx_addr) &&
+        (m_rx_handlers[i].service == service)) {
+      k_spin_unlock(&m_rx_lock, key);
+      return -EALREADY;
+    }
 
-  // Se não há buffers disponíveis, remove o mais antigo
-  if (!buf) {
-    printk("Pool cheio, removendo mensagem mais antiga\n");
-    old_buf = (struct net_buf *)sys_slist_get(&m_tx_queue);
-    if (old_buf) {
-      net_buf_unref(old_buf);
-      // Tenta alocar novamente após liberar um buffer
-      buf = net_buf_alloc(&isotp_tx_pool, K_NO_WAIT);
+    if (!m_rx_handlers[i].handler && !slot) {
+      slot = &m_rx_handlers[i];
     }
   }
 
-  // Se ainda não conseguiu um buffer, falha
-  if (!buf) {
-    printk("Erro: Falha crítica ao alocar buffer\n");
-    isotp_conn_msg_unlock();
-    return -EIO;
+  if (slot) {
+    slot->rx_addr = rx_addr;
+    slot->service = service;
+    slot->handler = handler;
+    slot->user_data = user_data;
   }
 
-  // Copia os dados e configura o endereço
-  net_buf_add_mem(buf, data, len);
-  struct isotp_buf_user_data *user_data = net_buf_user_data(buf);
-  user_data->addr = addr;
+  k_spin_unlock(&m_rx_lock, key);
+
+  return slot ? 0 : -ENOMEM;
+}
+
+int isotp_conn_rx_unregister(uint32_t rx_addr, int16_t service) {
+  k_spinlock_key_t key;
+  int ret = -ENOENT;
+
+  key = k_spin_lock(&m_rx_lock);
+
+  for (size_t i = 0; i < ARRAY_SIZE(m_rx_handlers); i++) {
+    if (m_rx_handlers[i].handler && (m_rx_handlers[i].rx_addr == rx_addr) &&
+        (m_rx_handlers[i].service == service)) {
+      m_rx_handlers[i].handler = NULL;
+      ret = 0;
+      break;
+    }
+  }
+
+  k_spin_unlock(&m_rx_lock, key);
+
+  return ret;
+}
 
-  // Adiciona à fila de transmissão
-  sys_slist_append(&m_tx_queue, &buf->node);
+int isotp_conn_get_rx_stats(struct isotp_conn_rx_stats *stats) {
+  k_spinlock_key_t key;
 
-  isotp_conn_msg_unlock();
+  if (!stats) {
+    return -EINVAL;
+  }
+
+  key = k_spin_lock(&m_rx_lock);
+  *stats = m_rx_stats;
+  k_spin_unlock(&m_rx_lock, key);
 
   return 0;
 }
 
-int isotp_conn_process_send(void) {
-  int ret;
-  struct isotp_msg_id dst_addr;
-  struct isotp_msg_id fc_addr;
-  struct isotp_buf_user_data *user_data;
-  struct net_buf *buf;
+/**
+ * @brief Enfileira telemetria na fila de menor prioridade sem bloquear
+ *
+ * @return 0 ou -EAGAIN com a fila cheia; a mensagem fica com o chamador
+ */
+int isotp_conn_add_message(uint32_t addr, const uint8_t *data, size_t len) {
+  return isotp_conn_send(addr, ISOTP_CONN_FC_ADDR(addr), data, len, ISOTP_CONN_PRIO_BULK, K_NO_WAIT, NULL, NULL);
+}
 
-  while (1) {
+int isotp_conn_get_stats(enum isotp_conn_prio prio, struct isotp_conn_lane_stats *stats) {
+  k_spinlock_key_t key;
 
-    ret = isotp_conn_lock();
-    if (ret) {
-      return ret;
-    }
+  if (!stats || (prio >= ISOTP_CONN_PRIO_COUNT)) {
+    return -EINVAL;
+  }
 
-    if (sys_slist_is_empty(&m_tx_queue)) {
-      isotp_conn_unlock();
-      break;
-    }
+  key = k_spin_lock(&m_lane_lock);
+  *stats = m_lanes[prio].stats;
+  k_spin_unlock(&m_lane_lock, key);
 
-    buf = (struct net_buf *)sys_slist_get(&m_tx_queue);
-    if (!buf) {
-      isotp_conn_unlock();
-      break;
-    }
+  return 0;
+}
 
-    user_data = net_buf_user_data(buf);
-    memset(&dst_addr, 0x0, sizeof(dst_addr));
-    memset(&fc_addr, 0x0, sizeof(fc_addr));
+static int isotp_conn_shell_cmd_stats(const struct shell *shell, size_t argc, char **argv) {
+  struct isotp_conn_lane_stats stats;
+  struct isotp_conn_rx_stats rx_stats;
 
-    dst_addr.std_id = user_data->addr;
-    fc_addr.std_id = user_data->addr - 0x100;
+  ARG_UNUSED(argc);
+  ARG_UNUSED(argv);
 
-    ret = isotp_send(&m_sctx, m_can_dev, buf->data, buf->len, &dst_addr,
-                     &fc_addr, isotp_conn_tx_callback, NULL);
-    if (ret != ISOTP_N_OK) {
-      printk("Erro ao enviar mensagem para 0x%X [%d]\n", dst_addr.std_id, ret);
-      // Em caso de erro, volta mensagem para fila
-      // sys_slist_append(&m_tx_queue, &buf->node);
-      // break;
-    }
+  shell_print(shell, "%-7s %5s %5s %8s %6s %6s %6s %9s %9s", "lane", "depth", "max", "sent",
+              "failed", "retry", "reject", "lat us", "max us");
 
-    net_buf_unref(buf);
+  for (int i = 0; i < ISOTP_CONN_PRIO_COUNT; i++) {
+    isotp_conn_get_stats(i, &stats);
+    shell_print(shell, "%-7s %5u %5u %8u %6u %6u %6u %9u %9u", m_lane_names[i], stats.depth,
+                stats.max_depth, stats.sent, stats.failed, stats.retries, stats.rejected,
+                stats.latency_us_last, stats.latency_us_max);
   }
 
-  return ret;
+  isotp_conn_get_rx_stats(&rx_stats);
+  shell_print(shell, "rx: %u messages %llu bytes, %u errors, %u unhandled", rx_stats.messages,
+              rx_stats.bytes, rx_stats.errors, rx_stats.unhandled);
+
+  return 0;
 }
@@ -1,19 +1,86 @@
 
 
 #include "lcd_lib.h"
+#include "asset_store.h"
+#include "db_bind.h"
+#include "ui_screens.h"
 #include <lv_demos.h>
 #include <lvgl.h>
+#include <math.h>
+#include <stdlib.h>
 #include <zephyr/drivers/display.h>
 #include <zephyr/drivers/pwm.h>
+#include <zephyr/drivers/sensor.h>
+#include <zephyr/input/input.h>
 #include <zephyr/kernel.h>
+#include <zephyr/shell/shell.h>
 
 #define NUM_STEPS 50U
 #define SLEEP_MSEC 100U
 
+// Thread da interface: unica que chama o LVGL
+#define LCD_UI_MAX_SLEEP_MS 100U
+#define LCD_UI_STACK_MEM_ATTRIBUTES Z_GENERIC_SECTION(.app_stack)
+
 const struct device *display_dev = DEVICE_DT_GET(DT_CHOSEN(zephyr_display));
 static const struct pwm_dt_spec g_backlight =
     PWM_DT_SPEC_GET(DT_ALIAS(pwm_backlight0));
 
+// Backlight: nivel em permilagem, fades por um unico k_timer
+#define LCD_BKLIGHT_POLL_MS 1000U
+#define LCD_BKLIGHT_AMBIENT \
+  (IS_ENABLED(CONFIG_APP_BKLIGHT_AMBIENT) && DT_NODE_EXISTS(DT_ALIAS(ambient_light0)))
+
+struct lcd_bklight {
+  int32_t level;                // Permilagem aplicada no PWM
+  int32_t target;
+  int32_t step;                 // Permilagem por expiracao do timer
+  int active;                   // Percentual fora do escurecimento
+  bool dimmed;
+  uint32_t last_activity;       // k_uptime do ultimo toque
+};
+
+#if LCD_BKLIGHT_AMBIENT
+static const struct device *g_ambient = DEVICE_DT_GET(DT_ALIAS(ambient_light0));
+#endif
+
+static uint16_t g_bklight_lut[101];
+static struct lcd_bklight g_bklight;
+static struct k_spinlock g_bklight_lock;
+
+Z_KERNEL_STACK_DEFINE_IN(g_ui_stack, CONFIG_APP_UI_THREAD_STACK_SIZE,
+                         LCD_UI_STACK_MEM_ATTRIBUTES);
+static struct k_thread g_ui_thread;
+K_MSGQ_DEFINE(g_ui_queue, sizeof(struct lcd_ui_msg), CONFIG_APP_UI_QUEUE_SIZE, 4);
+
+static struct lcd_ui_stats g_ui_stats;
+static struct k_spinlock g_ui_lock;
+static uint32_t g_render_start;
+static uint32_t g_input_pending;  // Ciclo do primeiro evento de entrada ainda nao desenhado
+static uint32_t g_update_pending; // Ciclo do primeiro post ainda nao desenhado
+static bool g_ui_started;
+
+static void lcd_bklight_fade_handler(struct k_timer *timer);
+static void lcd_bklight_idle_handler(struct k_work *work);
+static void lcd_ui_build(void);
+static void lcd_ui_render_cb(lv_event_t *event);
+static void lcd_ui_input_cb(struct input_event *evt, void *user_data);
+static void lcd_ui_thread(void *p1, void *p2, void *p3);
+static int lcd_ui_shell_cmd_stats(const struct shell *shell, size_t argc, char **argv);
+
+static int lcd_ui_shell_cmd_bklight(const struct shell *shell, size_t argc, char **argv);
+
+K_TIMER_DEFINE(g_bklight_fade_timer, lcd_bklight_fade_handler, NULL);
+K_WORK_DELAYABLE_DEFINE(g_bklight_idle_work, lcd_bklight_idle_handler);
+INPUT_CALLBACK_DEFINE(NULL, lcd_ui_input_cb, NULL);
+
+SHELL_STATIC_SUBCMD_SET_CREATE(
+    ui, SHELL_CMD(stats, NULL, "frame time and latency", lcd_ui_shell_cmd_stats),
+    SHELL_CMD_ARG(bklight, NULL, "backlight <percent> [fade ms]", lcd_ui_shell_cmd_bklight, 2, 1),
+    SHELL_SUBCMD_SET_END);
+
+SHELL_CMD_REGISTER(ui, &ui, "user interface commands", NULL);
+
 int lcd_init(void) {
   int err;
 
@@ -29,57 +96,188 @@ int lcd_init(void) {
     return -EIO;
   }
 
+  // Curva de brilho percebido: duty = (percent / 100) ^ gamma
+  for (int i = 0; i <= 100; i++) {
+    g_bklight_lut[i] = (uint16_t)(powf(i / 100.0f, CONFIG_APP_BKLIGHT_GAMMA_X10 / 10.0f) * UINT16_MAX + 0.5f);
+  }
+
+  k_work_schedule(&g_bklight_idle_work, K_NO_WAIT);
+
   return 0;
 }
 
-int lcd_bklight_set_percent(int percent) {
-  uint32_t pulse_width;
-  int ret;
+// Chamado com g_bklight_lock; interpola a tabela em permilagem
+static void lcd_bklight_apply(int32_t permille) {
+  uint32_t index = permille / 10;
+  uint32_t duty = g_bklight_lut[index];
 
-  // Verifica se a porcentagem está dentro dos limites válidos
-  if (percent < 0 || percent > 100) {
-    return -EINVAL; // Retorna erro de valor inválido
+  if (index < 100) {
+    duty += ((g_bklight_lut[index + 1] - duty) * (permille % 10)) / 10;
   }
 
-  // Calcula a largura do pulso baseado na porcentagem
-  pulse_width = (g_backlight.period * percent) / 100;
+  pwm_set_pulse_dt(&g_backlight, ((uint64_t)g_backlight.period * duty) / UINT16_MAX);
+}
 
-  // Define o pulso PWM
-  ret = pwm_set_pulse_dt(&g_backlight, pulse_width);
-  if (ret) {
-    printk("Error %d: failed to set pulse width\n", ret);
-    return ret;
+// Um passo do fade por expiracao do timer; para quando chega no alvo
+static void lcd_bklight_fade_handler(struct k_timer *timer) {
+  k_spinlock_key_t key = k_spin_lock(&g_bklight_lock);
+
+  g_bklight.level += g_bklight.step;
+  if (((g_bklight.step > 0) && (g_bklight.level >= g_bklight.target)) ||
+      ((g_bklight.step < 0) && (g_bklight.level <= g_bklight.target))) {
+    g_bklight.level = g_bklight.target;
+    k_timer_stop(timer);
+  }
+
+  lcd_bklight_apply(g_bklight.level);
+
+  k_spin_unlock(&g_bklight_lock, key);
+}
+
+// Chamado com g_bklight_lock
+static void lcd_bklight_start_fade(int32_t target, uint32_t duration_ms) {
+  uint32_t ticks = duration_ms / CONFIG_APP_BKLIGHT_FADE_STEP_MS;
+
+  g_bklight.target = target;
+
+  if ((ticks == 0) || (target == g_bklight.level)) {
+    k_timer_stop(&g_bklight_fade_timer);
+    g_bklight.level = target;
+    lcd_bklight_apply(target);
+    return;
   }
 
-  printk("PWM set to %d%%\n", percent);
+  g_bklight.step = (target - g_bklight.level) / (int32_t)ticks;
+  if (g_bklight.step == 0) {
+    g_bklight.step = (target > g_bklight.level) ? 1 : -1;
+  }
+
+  k_timer_start(&g_bklight_fade_timer, K_MSEC(CONFIG_APP_BKLIGHT_FADE_STEP_MS),
+                K_MSEC(CONFIG_APP_BKLIGHT_FADE_STEP_MS));
+}
+
+/**
+ * @brief Leva o brilho ate percent em duration_ms sem bloquear
+ *
+ * Passa a ser o nivel ativo, restaurado ao sair do escurecimento por inatividade.
+ */
+int lcd_bklight_fade_to(int percent, uint32_t duration_ms) {
+  k_spinlock_key_t key;
+
+  if (percent < 0 || percent > 100) {
+    return -EINVAL;
+  }
+
+  key = k_spin_lock(&g_bklight_lock);
+  g_bklight.active = percent;
+  if (!g_bklight.dimmed) {
+    lcd_bklight_start_fade(percent * 10, duration_ms);
+  }
+  k_spin_unlock(&g_bklight_lock, key);
+
   return 0;
 }
 
+int lcd_bklight_set_percent(int percent) {
+  return lcd_bklight_fade_to(percent, 0);
+}
+
+int lcd_bklight_get_percent(void) {
+  k_spinlock_key_t key = k_spin_lock(&g_bklight_lock);
+  int percent = g_bklight.level / 10;
+
+  k_spin_unlock(&g_bklight_lock, key);
+
+  return percent;
+}
+
+// Toque na tela: volta ao nivel ativo e reinicia a contagem de inatividade
+void lcd_bklight_activity(void) {
+  k_spinlock_key_t key = k_spin_lock(&g_bklight_lock);
+
+  g_bklight.last_activity = k_uptime_get_32();
+  if (g_bklight.dimmed) {
+    g_bklight.dimmed = false;
+    lcd_bklight_start_fade(g_bklight.active * 10, CONFIG_APP_BKLIGHT_WAKE_FADE_MS);
+  }
+
+  k_spin_unlock(&g_bklight_lock, key);
+}
+
+#if LCD_BKLIGHT_AMBIENT
+// Mapeia a luz ambiente entre o brilho minimo e o maximo
+static void lcd_bklight_ambient_update(void) {
+  struct sensor_value lux;
+  int32_t percent;
+
+  if (!device_is_ready(g_ambient) || (sensor_sample_fetch(g_ambient) != 0) ||
+      (sensor_channel_get(g_ambient, SENSOR_CHAN_LIGHT, &lux) != 0)) {
+    return;
+  }
+
+  percent = CONFIG_APP_BKLIGHT_AMBIENT_MIN_PERCENT +
+            ((100 - CONFIG_APP_BKLIGHT_AMBIENT_MIN_PERCENT) *
+             MIN(lux.val1, CONFIG_APP_BKLIGHT_AMBIENT_FULL_LUX)) /
+                CONFIG_APP_BKLIGHT_AMBIENT_FULL_LUX;
+
+  lcd_bklight_fade_to(percent, CONFIG_APP_BKLIGHT_WAKE_FADE_MS);
+}
+#endif
+
+// Periodico no workqueue do sistema: inatividade e sensor de luz
+static void lcd_bklight_idle_handler(struct k_work *work) {
+  k_spinlock_key_t key;
+
+  ARG_UNUSED(work);
+
+#if LCD_BKLIGHT_AMBIENT
+  lcd_bklight_ambient_update();
+#endif
+
+  key = k_spin_lock(&g_bklight_lock);
+  if ((CONFIG_APP_BKLIGHT_IDLE_TIMEOUT_S > 0) && !g_bklight.dimmed &&
+      ((k_uptime_get_32() - g_bklight.last_activity) >= (CONFIG_APP_BKLIGHT_IDLE_TIMEOUT_S * 1000U)) &&
+      (g_bklight.active > CONFIG_APP_BKLIGHT_DIM_PERCENT)) {
+    g_bklight.dimmed = true;
+    lcd_bklight_start_fade(CONFIG_APP_BKLIGHT_DIM_PERCENT * 10, CONFIG_APP_BKLIGHT_DIM_FADE_MS);
+  }
+  k_spin_unlock(&g_bklight_lock, key);
+
+  k_work_schedule(&g_bklight_idle_work, K_MSEC(LCD_BKLIGHT_POLL_MS));
+}
+
 int lcd_bklight_test(int test_cycles) {
   int count = 0;
-  int percent = 0U;
   int ret;
 
   do {
     count++;
-    percent = 0;
 
-    while (percent < 100) {
-      percent++;
-
-      ret = lcd_bklight_set_percent(percent);
-      if (ret) {
-        return ret;
-      }
+    ret = lcd_bklight_set_percent(0);
+    if (ret) {
+      return ret;
+    }
 
-      k_sleep(K_MSEC(SLEEP_MSEC));
+    ret = lcd_bklight_fade_to(100, NUM_STEPS * SLEEP_MSEC);
+    if (ret) {
+      return ret;
     }
+
+    k_sleep(K_MSEC(NUM_STEPS * SLEEP_MSEC));
   } while (count < test_cycles);
 
   return 0;
 }
 
-int lcd_lvgl_demo(void) {
+static void lcd_ui_build(void) {
+  if (IS_ENABLED(CONFIG_APP_UI_STATUS_SCREEN)) {
+    ui_screen_status_create(lv_screen_active());
+#if defined(CONFIG_APP_TREND)
+    ui_screen_trend_create(lv_screen_active(), CONFIG_APP_TREND_POINTS);
+#endif
+    return;
+  }
+
 #if defined(CONFIG_LV_USE_DEMO_MUSIC)
   lv_demo_music();
 #elif defined(CONFIG_LV_USE_DEMO_BENCHMARK)
@@ -89,17 +287,209 @@ int lcd_lvgl_demo(void) {
 #elif defined(CONFIG_LV_USE_DEMO_WIDGETS)
   lv_demo_widgets();
 #else
-#error Enable one of the demos CONFIG_LV_USE_DEMO_MUSIC, CONFIG_LV_USE_DEMO_BENCHMARK ,\
-	CONFIG_LV_USE_DEMO_STRESS, or CONFIG_LV_USE_DEMO_WIDGETS
+  ui_screen_status_create(lv_screen_active());
 #endif
+}
+
+// Eventos de render do display: tempo de quadro e latencias ate a tela
+static void lcd_ui_render_cb(lv_event_t *event) {
+  uint32_t now = k_cycle_get_32();
+  uint32_t frame_us;
+  uint32_t latency_us;
+  k_spinlock_key_t key;
+
+  if (lv_event_get_code(event) == LV_EVENT_RENDER_START) {
+    g_render_start = now;
+    return;
+  }
+
+  frame_us = k_cyc_to_us_floor32(now - g_render_start);
+
+  key = k_spin_lock(&g_ui_lock);
+
+  g_ui_stats.frames++;
+  g_ui_stats.frame_us_last = frame_us;
+  g_ui_stats.frame_us_total += frame_us;
+  if (frame_us > g_ui_stats.frame_us_max) {
+    g_ui_stats.frame_us_max = frame_us;
+  }
+
+  if (g_input_pending) {
+    latency_us = k_cyc_to_us_floor32(now - g_input_pending);
+    g_ui_stats.input_latency_us_last = latency_us;
+    if (latency_us > g_ui_stats.input_latency_us_max) {
+      g_ui_stats.input_latency_us_max = latency_us;
+    }
+    g_input_pending = 0;
+  }
+
+  if (g_update_pending) {
+    latency_us = k_cyc_to_us_floor32(now - g_update_pending);
+    if (latency_us > g_ui_stats.update_latency_us_max) {
+      g_ui_stats.update_latency_us_max = latency_us;
+    }
+    g_update_pending = 0;
+  }
+
+  k_spin_unlock(&g_ui_lock, key);
+}
+
+static void lcd_ui_input_cb(struct input_event *evt, void *user_data) {
+  k_spinlock_key_t key;
+
+  ARG_UNUSED(user_data);
 
+  if (!evt->sync) {
+    return;
+  }
+
+  lcd_bklight_activity();
+
+  key = k_spin_lock(&g_ui_lock);
+  if (!g_input_pending) {
+    g_input_pending = k_cycle_get_32() | 1;
+  }
+  k_spin_unlock(&g_ui_lock, key);
+}
+
+static void lcd_ui_thread(void *p1, void *p2, void *p3) {
+  struct lcd_ui_msg msg;
+  lv_display_t *display;
+  uint32_t sleep_ms;
+  k_spinlock_key_t key;
+
+  ARG_UNUSED(p1);
+  ARG_UNUSED(p2);
+  ARG_UNUSED(p3);
+
+  display = lv_display_get_default();
+  lv_display_add_event_cb(display, lcd_ui_render_cb, LV_EVENT_RENDER_START, NULL);
+  lv_display_add_event_cb(display, lcd_ui_render_cb, LV_EVENT_RENDER_READY, NULL);
+
+  // Sem imagem de assets a interface segue apenas com as fontes internas
+  if (asset_store_init() == 0) {
+    asset_lvgl_init();
+  }
+
+  db_bind_init();
+  lcd_ui_build();
   lv_timer_handler();
   display_blanking_off(display_dev);
-  
+
   while (1) {
-    uint32_t sleep_ms = lv_timer_handler();
-    k_msleep(MIN(sleep_ms, INT32_MAX));
+    sleep_ms = lv_timer_handler();
+
+    // Acorda no proximo timer do LVGL ou na chegada de uma atualizacao
+    if (k_msgq_get(&g_ui_queue, &msg, K_MSEC(MIN(sleep_ms, LCD_UI_MAX_SLEEP_MS))) != 0) {
+      continue;
+    }
+
+    do {
+      key = k_spin_lock(&g_ui_lock);
+      if (!g_update_pending) {
+        g_update_pending = msg.cycles | 1;
+      }
+      k_spin_unlock(&g_ui_lock, key);
+
+      msg.handler(msg.user_data, msg.value);
+    } while (k_msgq_get(&g_ui_queue, &msg, K_NO_WAIT) == 0);
   }
+}
+
+/**
+ * @brief Cria a thread da interface; o boot segue em paralelo
+ */
+int lcd_ui_start(void) {
+  if (g_ui_started) {
+    return -EALREADY;
+  }
+
+  g_ui_started = true;
+  k_thread_create(&g_ui_thread, g_ui_stack, K_KERNEL_STACK_SIZEOF(g_ui_stack), lcd_ui_thread,
+                  NULL, NULL, NULL, CONFIG_APP_UI_THREAD_PRIORITY, 0, K_NO_WAIT);
+  k_thread_name_set(&g_ui_thread, "lcd_ui");
+
+  return 0;
+}
+
+/**
+ * @brief Agenda handler(user_data, value) na thread da interface
+ *
+ * Unico caminho para outras threads mexerem em objetos LVGL. Nao bloqueia:
+ * com a fila cheia retorna -ENOMEM e a atualizacao e descartada.
+ */
+int lcd_ui_post(lcd_ui_handler_t handler, void *user_data, int32_t value) {
+  struct lcd_ui_msg msg = {
+      .handler = handler,
+      .user_data = user_data,
+      .value = value,
+      .cycles = k_cycle_get_32(),
+  };
+  k_spinlock_key_t key;
+  int ret;
+
+  if (!handler) {
+    return -EINVAL;
+  }
+
+  ret = k_msgq_put(&g_ui_queue, &msg, K_NO_WAIT);
+
+  key = k_spin_lock(&g_ui_lock);
+  if (ret == 0) {
+    g_ui_stats.posted++;
+  } else {
+    g_ui_stats.dropped++;
+  }
+  k_spin_unlock(&g_ui_lock, key);
+
+  return (ret == 0) ? 0 : -ENOMEM;
+}
+
+int lcd_ui_get_stats(struct lcd_ui_stats *stats) {
+  k_spinlock_key_t key;
+
+  if (!stats) {
+    return -EINVAL;
+  }
+
+  key = k_spin_lock(&g_ui_lock);
+  *stats = g_ui_stats;
+  k_spin_unlock(&g_ui_lock, key);
+
+  return 0;
+}
+
+static int lcd_ui_shell_cmd_stats(const struct shell *shell, size_t argc, char **argv) {
+  struct lcd_ui_stats stats;
+
+  ARG_UNUSED(argc);
+  ARG_UNUSED(argv);
+
+  lcd_ui_get_stats(&stats);
+
+  shell_print(shell, "frames: %u", stats.frames);
+  shell_print(shell, "frame us: last %u max %u avg %u", stats.frame_us_last, stats.frame_us_max,
+              stats.frames ? (uint32_t)(stats.frame_us_total / stats.frames) : 0);
+  shell_print(shell, "input->render us: last %u max %u", stats.input_latency_us_last,
+              stats.input_latency_us_max);
+  shell_print(shell, "post->render us: max %u", stats.update_latency_us_max);
+  shell_print(shell, "posted: %u dropped: %u", stats.posted, stats.dropped);
+
+  return 0;
+}
+
+static int lcd_ui_shell_cmd_bklight(const struct shell *shell, size_t argc, char **argv) {
+  int percent = atoi(argv[1]);
+  uint32_t fade_ms = (argc > 2) ? strtoul(argv[2], NULL, 10) : 0;
+  int ret;
+
+  ret = lcd_bklight_fade_to(percent, fade_ms);
+  if (ret) {
+    shell_error(shell, "Invalid percent");
+    return ret;
+  }
+
+  shell_print(shell, "backlight -> %d%% in %u ms", percent, fade_ms);
 
   return 0;
 }
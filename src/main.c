@@ -1,15 +1,24 @@
 #include "app_ext_flash.h"
+#include "app_mem.h"
+#include "app_ota.h"
 #include "app_sdram.h"
 #include "app_version.h"
 #include "buzzer_lib.h"
 #include "database.h"
+#include "db_http.h"
 #include "eeprom_lib.h"
 #include "eth_lib.h"
+#include "isotp_conn.h"
 #include "lcd_lib.h"
 #include "leds_lib.h"
+#include "process_pdo.h"
+#include "process_scope.h"
+#include "process_telemetry.h"
+#include "process_trend.h"
 #include "rtc_lib.h"
 #include "setup_database.h"
 #include "slave_modbus.h"
+#include "uds_server.h"
 #include <zephyr/kernel.h>
 
 #include "mask_format.h"
@@ -23,6 +32,7 @@
 int main(void) {
   char *buf;
   enum leds_lib_channel channel = LED_BLUE;
+  int health;
 
   k_msleep(1000);
 
@@ -34,7 +44,9 @@ int main(void) {
   eeprom_lib_init();
   leds_lib_init();
   lcd_bklight_set_percent(50);
-  // sdcard_init();
+  if (sdcard_init() == 0) {
+    sdcard_logger_init();
+  }
 
   buf = rtc_format_datetime(NULL);
   printk("Time: %s\n", buf);
@@ -47,32 +59,52 @@ int main(void) {
   sdcard_test();
   sdram_test();
   // ext_mem_test();
-  lcd_lvgl_demo();
+  lcd_ui_start();
   eth_init();
 
-  setup_database_init();
+  health = setup_database_init();
+  app_mem_init();
   slave_modbus_init();
 
+  if (isotp_conn_init() == 0) {
+#if defined(CONFIG_APP_UDS)
+    uds_server_init();
+#endif
+#if defined(CONFIG_APP_PDO)
+    process_pdo_init();
+#endif
+  }
+
+#if defined(CONFIG_APP_MQTT_TELEMETRY)
+  process_telemetry_init();
+#endif
+#if defined(CONFIG_APP_HTTP_API)
+  db_http_init(CONFIG_APP_HTTP_PORT);
+#endif
+#if defined(CONFIG_APP_SCOPE)
+  process_scope_init();
+#endif
+#if defined(CONFIG_APP_TREND)
+  process_trend_init();
+#endif
+
+#if defined(CONFIG_APP_OTA)
+  // Imagem nova em teste so fica se chegou aqui com a base de parametros no ar
+  if (health == 0) {
+    app_ota_confirm();
+  }
+#endif
+
   // buzzer_ringotne_test();
 
   uint8_t cnt = 0;
   uint8_t cnt2 = 0;
-  char nome[40];
-  char nome2[40];
   while (1) {
     cnt2 = cnt++;
-    snprintf(nome, sizeof(nome), "valor: %d", cnt2);
     db_acc_set_u8(ACC_LEVEL_FACTORY, GROUP_PROC_VAR, PROC_VAR_MDB_IQC, cnt2);
-    db_acc_set_str(ACC_LEVEL_FACTORY, GROUP_SYS_OTA_CONF, PARAM_CNFG_OTA_FILE,
-                   nome, sizeof(nome));
+    sdcard_log_write(SDCARD_LOG_PROC_VAR, &cnt2, sizeof(cnt2));
     k_msleep(1000);
 
-    cnt2 = 0;
-    db_acc_get_u8(ACC_LEVEL_FACTORY, GROUP_PROC_VAR, PROC_VAR_MDB_IQC, &cnt2);
-    db_acc_get_str(ACC_LEVEL_FACTORY, GROUP_SYS_OTA_CONF, PARAM_CNFG_OTA_FILE,
-                   nome2, sizeof(nome2));
-    printk("%s\n", nome2);
-
     channel = channel >= LED_MAX ? LED_BLUE : channel + 1;
     leds_lib_set(channel, true);
 
@@ -0,0 +1,72 @@
+#include "process_pdo.h"
+#include "can_pdo.h"
+#include "setup_database.h"
+
+#include <zephyr/device.h>
+#include <zephyr/kernel.h>
+
+/*
+ * Dados de processo trocados com os controladores vizinhos. Temperatura e
+ * umidade em centesimos: o deadband evita quadros por ruido do sensor.
+ */
+
+static struct can_pdo_map g_tx1_maps[] = {
+    CAN_PDO_MAP(GROUP_PROC_VAR, PROC_VAR_SENSOR_TEMPER, 0, 5),
+    CAN_PDO_MAP(GROUP_PROC_VAR, PROC_VAR_SENSOR_HUMID,  2, 20),
+    CAN_PDO_MAP(GROUP_PROC_VAR, PROC_VAR_MDB_IQC,       4, 0),
+};
+
+static struct can_pdo_map g_tx2_maps[] = {
+    CAN_PDO_MAP(GROUP_PROC_VAR, PROC_VAR_UPTIME, 0, 0),
+};
+
+// Mesmo layout do PDO 1 do vizinho
+static struct can_pdo_map g_rx1_maps[] = {
+    CAN_PDO_MAP(GROUP_PEER_VAR, PEER_VAR_SENSOR_TEMPER, 0, 0),
+    CAN_PDO_MAP(GROUP_PEER_VAR, PEER_VAR_SENSOR_HUMID,  2, 0),
+    CAN_PDO_MAP(GROUP_PEER_VAR, PEER_VAR_MDB_IQC,       4, 0),
+};
+
+// Ciclo de 100 ms, mudancas em ate 10 ms (inhibit)
+static struct can_pdo g_tx_pdos[] = {
+    CAN_PDO_TX("proc_fast", PROCESS_PDO_TX1_ID(CONFIG_APP_PDO_NODE_ID), 8, 100, 10, true, g_tx1_maps),
+    CAN_PDO_TX("proc_slow", PROCESS_PDO_TX2_ID(CONFIG_APP_PDO_NODE_ID), 8, 1000, 0, false, g_tx2_maps),
+};
+
+static struct can_pdo g_rx_pdos[] = {
+    CAN_PDO_RX("peer_fast", PROCESS_PDO_TX1_ID(CONFIG_APP_PDO_PEER_NODE_ID), 8, ACC_LEVEL_FACTORY, g_rx1_maps),
+};
+
+/**
+ * @brief Registra os PDOs da aplicacao
+ *
+ * Requer a base iniciada e o controlador CAN ja em operacao (isotp_conn_init).
+ */
+int process_pdo_init(void) {
+  const struct device *can_dev = DEVICE_DT_GET(DT_CHOSEN(zephyr_canbus));
+  int ret;
+
+  ret = can_pdo_init(can_dev);
+  if (ret != 0) {
+    printk("PDO: falha ao iniciar: %d\n", ret);
+    return ret;
+  }
+
+  for (size_t i = 0; i < ARRAY_SIZE(g_rx_pdos); i++) {
+    ret = can_pdo_rx_add(&g_rx_pdos[i]);
+    if (ret != 0) {
+      printk("PDO: %s: %d\n", g_rx_pdos[i].name, ret);
+      return ret;
+    }
+  }
+
+  for (size_t i = 0; i < ARRAY_SIZE(g_tx_pdos); i++) {
+    ret = can_pdo_tx_add(&g_tx_pdos[i]);
+    if (ret != 0) {
+      printk("PDO: %s: %d\n", g_tx_pdos[i].name, ret);
+      return ret;
+    }
+  }
+
+  return 0;
+}
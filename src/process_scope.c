@@ -0,0 +1,56 @@
+#include "process_scope.h"
+#include "db_scope.h"
+#include "setup_database.h"
+
+#include <zephyr/kernel.h>
+
+/*
+ * Sinais vistos no comissionamento, amostrados a cada
+ * CONFIG_APP_SCOPE_PERIOD_US. Entradas e saidas digitais entram aqui quando
+ * tiverem parametros na base. O streaming comeca pelo shell
+ * (scope start <ip> [porta]) ou sozinho com CONFIG_APP_SCOPE_HOST.
+ */
+
+struct process_scope_channel {
+  db_group_id_t group_id;
+  db_param_id_t param_id;
+};
+
+static const struct process_scope_channel g_channels[] = {
+    {GROUP_PROC_VAR, PROC_VAR_SENSOR_TEMPER},
+    {GROUP_PROC_VAR, PROC_VAR_SENSOR_HUMID},
+    {GROUP_PROC_VAR, PROC_VAR_MDB_IQC},
+    {GROUP_PEER_VAR, PEER_VAR_SENSOR_TEMPER},
+    {GROUP_PROC_VAR, PROC_VAR_UPTIME},
+};
+
+/**
+ * @brief Registra os canais e inicia o servico de scope
+ *
+ * Requer a base iniciada.
+ */
+int process_scope_init(void) {
+  int ret;
+
+  for (size_t i = 0; i < ARRAY_SIZE(g_channels); i++) {
+    ret = db_scope_add(g_channels[i].group_id, g_channels[i].param_id);
+    if (ret != 0) {
+      printk("Scope: %02x.%02x: %d\n", g_channels[i].group_id, g_channels[i].param_id, ret);
+    }
+  }
+
+  ret = db_scope_init();
+  if (ret != 0) {
+    printk("Scope: falha ao iniciar: %d\n", ret);
+    return ret;
+  }
+
+  if (CONFIG_APP_SCOPE_HOST[0] != '\0') {
+    ret = db_scope_start(CONFIG_APP_SCOPE_HOST, CONFIG_APP_SCOPE_PORT);
+    if (ret != 0) {
+      printk("Scope: %s:%d: %d\n", CONFIG_APP_SCOPE_HOST, CONFIG_APP_SCOPE_PORT, ret);
+    }
+  }
+
+  return ret;
+}
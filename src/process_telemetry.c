@@ -0,0 +1,84 @@
+#include "process_telemetry.h"
+#include "communication.h"
+#include "mqtt_telemetry.h"
+#include "setup_database.h"
+
+#include <stdio.h>
+#include <string.h>
+#include <zephyr/drivers/hwinfo.h>
+#include <zephyr/kernel.h>
+
+/*
+ * Grupos enviados ao broker. A configuracao de conexao usa a struct
+ * comm_mqtt_config; o client id vem do id unico do microcontrolador.
+ */
+
+static const db_group_id_t g_groups[] = {
+    GROUP_PROC_VAR,
+    GROUP_PEER_VAR,
+    GROUP_MEM_STATS,
+    GROUP_SYS_OTA_CONF,
+    GROUP_SYS_CONF,
+};
+
+static struct comm_mqtt_config g_mqtt_config;
+static struct mqtt_telemetry_config g_telemetry_config;
+
+static void process_telemetry_client_id(char *buf, size_t len) {
+  uint8_t id[8];
+  ssize_t id_len;
+  size_t pos = 0;
+
+  id_len = hwinfo_get_device_id(id, sizeof(id));
+  if (id_len <= 0) {
+    snprintf(buf, len, "linum");
+    return;
+  }
+
+  for (ssize_t i = 0; (i < id_len) && ((pos + 2) < len); i++) {
+    pos += snprintf(&buf[pos], len - pos, "%02x", id[i]);
+  }
+}
+
+/**
+ * @brief Inicia a telemetria com o broker de CONFIG_MQTT_SERVICE_SERVER_DOMAIN_NAME
+ *
+ * Requer a base iniciada. A conexao acontece quando a rede subir.
+ */
+int process_telemetry_init(void) {
+  struct comm_mqtt_config *cfg = &g_mqtt_config;
+  int ret;
+
+  process_telemetry_client_id(cfg->client_id, sizeof(cfg->client_id));
+  snprintf(cfg->host_ip, sizeof(cfg->host_ip), "%s", CONFIG_MQTT_SERVICE_SERVER_DOMAIN_NAME);
+  cfg->port = CONFIG_APP_MQTT_BROKER_PORT;
+  cfg->protocol = COMM_TCP;
+  cfg->qos = CONFIG_APP_MQTT_QOS;
+  snprintf(cfg->pub_topic, sizeof(cfg->pub_topic), "%s/%s/tele", CONFIG_APP_MQTT_TOPIC_PREFIX,
+           cfg->client_id);
+  snprintf(cfg->sub_topic, sizeof(cfg->sub_topic), "%s/%s/set", CONFIG_APP_MQTT_TOPIC_PREFIX,
+           cfg->client_id);
+
+  g_telemetry_config.host = cfg->host_ip;
+  g_telemetry_config.port = cfg->port;
+  g_telemetry_config.client_id = cfg->client_id;
+  g_telemetry_config.user_name = (cfg->user_name[0] != '\0') ? cfg->user_name : NULL;
+  g_telemetry_config.password = (cfg->password[0] != '\0') ? cfg->password : NULL;
+  g_telemetry_config.pub_topic = cfg->pub_topic;
+  g_telemetry_config.sub_topic = cfg->sub_topic;
+  g_telemetry_config.qos = cfg->qos;
+
+  for (size_t i = 0; i < ARRAY_SIZE(g_groups); i++) {
+    ret = mqtt_telemetry_add_group(g_groups[i]);
+    if (ret != 0) {
+      printk("Telemetry: group %u: %d\n", g_groups[i], ret);
+    }
+  }
+
+  ret = mqtt_telemetry_init(&g_telemetry_config);
+  if (ret == 0) {
+    printk("Telemetry: %s -> %s:%d\n", cfg->pub_topic, cfg->host_ip, cfg->port);
+  }
+
+  return ret;
+}
@@ -0,0 +1,330 @@
+#include "process_trend.h"
+#include "column_log.h"
+#include "database.h"
+#include "lcd_lib.h"
+#include "rtc_lib.h"
+#include "sdcard_lib.h"
+#include "setup_database.h"
+#include "ui_screens.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <zephyr/kernel.h>
+#include <zephyr/shell/shell.h>
+
+/*
+ * Tendencia dos sinais de processo no cartao SD, em log colunar
+ * (column_log, pelo servico de I/O do cartao). Uma amostra a cada
+ * CONFIG_APP_TREND_PERIOD_S com o timestamp do RTC. No boot o grafico da tela
+ * de status e carregado do proprio log, entao o historico sobrevive ao reset;
+ * depois cada amostra nova vai tambem para o grafico. "trend export
+ * <segundos>" lista um intervalo em CSV no shell.
+ */
+
+#define PROCESS_TREND_DATA_PATH   "/SD:/TREND.BIN"
+#define PROCESS_TREND_INDEX_PATH  "/SD:/TREND.IDX"
+#define PROCESS_TREND_STACK_SIZE  (2048)
+#define PROCESS_TREND_PRIORITY    (K_LOWEST_APPLICATION_THREAD_PRIO)
+#define PROCESS_TREND_READ_ACCESS ACC_LEVEL_FACTORY
+#define PROCESS_TREND_CHART       (0)   // Coluna mostrada no grafico
+
+struct process_trend_channel {
+  db_group_id_t group_id;
+  db_param_id_t param_id;
+  const char *name;
+};
+
+struct process_trend_stats {
+  uint32_t samples;             // Amostras aceitas pelo log
+  uint32_t dropped;             // Bloco anterior ainda no cartao ou fila de I/O cheia
+  uint32_t errors;              // Falhas de abertura/gravacao (log reaberto)
+};
+
+static const struct process_trend_channel g_channels[] = {
+    {GROUP_PROC_VAR, PROC_VAR_SENSOR_TEMPER, "temper"},
+    {GROUP_PROC_VAR, PROC_VAR_SENSOR_HUMID, "humid"},
+    {GROUP_PROC_VAR, PROC_VAR_MDB_IQC, "iqc"},
+    {GROUP_PEER_VAR, PEER_VAR_SENSOR_TEMPER, "peer_temper"},
+};
+
+BUILD_ASSERT(ARRAY_SIZE(g_channels) <= COLUMN_LOG_MAX_COLUMNS);
+
+static struct file_io *g_io;
+static struct column_log_writer g_writer;
+static struct column_log_reader g_reader;   // Historico do grafico e export do shell
+static K_MUTEX_DEFINE(g_reader_lock);
+static struct db_raw_item g_raw[ARRAY_SIZE(g_channels)];
+static uint32_t g_raw_data[ARRAY_SIZE(g_channels)];
+static int32_t g_history[CONFIG_APP_TREND_POINTS];
+static struct process_trend_stats g_stats;
+static struct k_spinlock g_lock;
+
+K_THREAD_STACK_DEFINE(g_trend_stack, PROCESS_TREND_STACK_SIZE);
+static struct k_thread g_trend_thread;
+
+static int process_trend_shell_cmd_export(const struct shell *shell, size_t argc, char **argv);
+static int process_trend_shell_cmd_stats(const struct shell *shell, size_t argc, char **argv);
+
+SHELL_STATIC_SUBCMD_SET_CREATE(
+    trend,
+    SHELL_CMD_ARG(export, NULL, "export <seconds>: CSV of the last seconds on the card",
+                  process_trend_shell_cmd_export, 2, 0),
+    SHELL_CMD(stats, NULL, "samples, drops and errors", process_trend_shell_cmd_stats),
+    SHELL_SUBCMD_SET_END);
+
+SHELL_CMD_REGISTER(trend, &trend, "trend log commands", NULL);
+
+// Valor do parametro como inteiro (os canais sao inteiros de ate 32 bits)
+static int32_t process_trend_value(const struct db_param *param, const void *raw) {
+  switch (param->config.info.type) {
+  case eBOL:
+  case eU08:
+    return *(const uint8_t *)raw;
+  case eS08:
+    return *(const int8_t *)raw;
+  case eU16:
+    return *(const uint16_t *)raw;
+  case eS16:
+    return *(const int16_t *)raw;
+  case eU32:
+    return (int32_t)*(const uint32_t *)raw;
+  case eS32:
+    return *(const int32_t *)raw;
+  default:
+    return 0;
+  }
+}
+
+static uint32_t process_trend_now(void) {
+  uint32_t timestamp;
+
+  if (rtc_get_timestamp(&timestamp) != 0) {
+    timestamp = k_uptime_get() / MSEC_PER_SEC;
+  }
+
+  return timestamp;
+}
+
+static void process_trend_ui_load(void *user_data, int32_t value) {
+  ui_screen_trend_load(user_data, value);
+}
+
+static void process_trend_ui_push(void *user_data, int32_t value) {
+  ARG_UNUSED(user_data);
+
+  ui_screen_trend_push(value);
+}
+
+static int process_trend_history_cb(uint32_t timestamp, const int32_t *values,
+                                    uint32_t column_mask, void *user_data) {
+  uint32_t t_start = *(const uint32_t *)user_data;
+  uint32_t slot = (timestamp - t_start) / CONFIG_APP_TREND_PERIOD_S;
+
+  ARG_UNUSED(column_mask);
+
+  if (slot < CONFIG_APP_TREND_POINTS) {
+    g_history[slot] = values[PROCESS_TREND_CHART];
+  }
+
+  return 0;
+}
+
+// Carrega o grafico com a janela que termina agora, um ponto por periodo
+static void process_trend_load_history(void) {
+  uint32_t span = (CONFIG_APP_TREND_POINTS - 1) * CONFIG_APP_TREND_PERIOD_S;
+  uint32_t now = process_trend_now();
+  uint32_t t_start = (now > span) ? (now - span) : 0;
+  int ret;
+
+  for (size_t i = 0; i < ARRAY_SIZE(g_history); i++) {
+    g_history[i] = LV_CHART_POINT_NONE;
+  }
+
+  k_mutex_lock(&g_reader_lock, K_FOREVER);
+
+  ret = column_log_reader_open(&g_reader, g_io, PROCESS_TREND_DATA_PATH,
+                               PROCESS_TREND_INDEX_PATH);
+  if (ret == 0) {
+    ret = column_log_read_range(&g_reader, t_start, now, BIT(PROCESS_TREND_CHART),
+                                process_trend_history_cb, &t_start);
+    column_log_reader_close(&g_reader);
+  }
+
+  k_mutex_unlock(&g_reader_lock);
+
+  if (ret < 0) {
+    // Cartao novo: ainda nao ha log
+    printk("Trend: no history (%d)\n", ret);
+  }
+
+  lcd_ui_post(process_trend_ui_load, g_history, ARRAY_SIZE(g_history));
+}
+
+static void process_trend_sample(void) {
+  int32_t values[ARRAY_SIZE(g_channels)];
+  uint32_t timestamp;
+  k_spinlock_key_t key;
+  int ret;
+
+  db_param_get_raw_batch(PROCESS_TREND_READ_ACCESS, g_raw, ARRAY_SIZE(g_raw));
+  for (size_t i = 0; i < ARRAY_SIZE(g_channels); i++) {
+    values[i] = (g_raw[i].result > 0) ? process_trend_value(g_raw[i].param, g_raw[i].data) : 0;
+  }
+
+  lcd_ui_post(process_trend_ui_push, NULL, values[PROCESS_TREND_CHART]);
+
+  // Depois de uma falha o log e reaberto, o que descarta o bloco incompleto
+  ret = g_writer.open ? 0
+                      : column_log_writer_open(&g_writer, g_io, PROCESS_TREND_DATA_PATH,
+                                               PROCESS_TREND_INDEX_PATH, ARRAY_SIZE(g_channels));
+  if (ret == 0) {
+    // Relogio acertado para tras: o log exige tempo nao decrescente
+    timestamp = MAX(process_trend_now(), g_writer.last_timestamp);
+    ret = column_log_append(&g_writer, timestamp, values);
+  }
+
+  // -EBUSY/-ENOMEM: so esta amostra se perde, o bloco cheio e gravado na proxima
+  if ((ret != 0) && (ret != -EBUSY) && (ret != -ENOMEM) && g_writer.open) {
+    column_log_writer_close(&g_writer);
+  }
+
+  key = k_spin_lock(&g_lock);
+  if (ret == 0) {
+    g_stats.samples++;
+  } else if ((ret == -EBUSY) || (ret == -ENOMEM)) {
+    g_stats.dropped++;
+  } else {
+    g_stats.errors++;
+  }
+  k_spin_unlock(&g_lock, key);
+}
+
+static void process_trend_thread(void *p1, void *p2, void *p3) {
+  int64_t next = k_uptime_get();
+
+  ARG_UNUSED(p1);
+  ARG_UNUSED(p2);
+  ARG_UNUSED(p3);
+
+  process_trend_load_history();
+
+  while (1) {
+    process_trend_sample();
+
+    next += CONFIG_APP_TREND_PERIOD_S * MSEC_PER_SEC;
+    k_sleep(K_TIMEOUT_ABS_MS(next));
+  }
+}
+
+/**
+ * @brief Inicia a amostragem da tendencia no cartao SD
+ *
+ * Requer a base iniciada, o cartao montado (sdcard_init) e, para o grafico,
+ * a interface no ar (lcd_ui_start).
+ */
+int process_trend_init(void) {
+  struct db_group *group;
+  struct db_param *param;
+  int ret;
+
+  g_io = sdcard_io_get();
+  if (!g_io) {
+    printk("Trend: no SD card\n");
+    return -ENODEV;
+  }
+
+  for (size_t i = 0; i < ARRAY_SIZE(g_channels); i++) {
+    ret = db_get_var_config(&group, &param, g_channels[i].group_id, g_channels[i].param_id);
+    if (ret != 0) {
+      printk("Trend: %02x.%02x: %d\n", g_channels[i].group_id, g_channels[i].param_id, ret);
+      return ret;
+    }
+
+    g_raw[i].param = param;
+    g_raw[i].data = &g_raw_data[i];
+    g_raw[i].len = sizeof(g_raw_data[i]);
+  }
+
+  k_thread_create(&g_trend_thread, g_trend_stack, K_THREAD_STACK_SIZEOF(g_trend_stack),
+                  process_trend_thread, NULL, NULL, NULL, PROCESS_TREND_PRIORITY, 0, K_NO_WAIT);
+  k_thread_name_set(&g_trend_thread, "trend");
+
+  return 0;
+}
+
+static int process_trend_export_cb(uint32_t timestamp, const int32_t *values,
+                                   uint32_t column_mask, void *user_data) {
+  const struct shell *shell = user_data;
+  char line[16 + (ARRAY_SIZE(g_channels) * 12)];
+  size_t pos;
+
+  ARG_UNUSED(column_mask);
+
+  pos = snprintf(line, sizeof(line), "%u", timestamp);
+  for (size_t i = 0; i < ARRAY_SIZE(g_channels); i++) {
+    pos += snprintf(&line[pos], sizeof(line) - pos, ",%d", values[i]);
+  }
+
+  shell_print(shell, "%s", line);
+
+  return 0;
+}
+
+static int process_trend_shell_cmd_export(const struct shell *shell, size_t argc, char **argv) {
+  uint32_t seconds = strtoul(argv[1], NULL, 0);
+  uint32_t now = process_trend_now();
+  uint32_t t_start = (now > seconds) ? (now - seconds) : 0;
+  char header[80];
+  size_t pos;
+  int ret;
+
+  ARG_UNUSED(argc);
+
+  if (!g_io) {
+    shell_error(shell, "no SD card");
+    return -ENODEV;
+  }
+
+  pos = snprintf(header, sizeof(header), "timestamp");
+  for (size_t i = 0; i < ARRAY_SIZE(g_channels); i++) {
+    pos += snprintf(&header[pos], sizeof(header) - pos, ",%s", g_channels[i].name);
+  }
+  shell_print(shell, "%s", header);
+
+  // Blocos completos ja no cartao; o bloco em preenchimento fica de fora
+  k_mutex_lock(&g_reader_lock, K_FOREVER);
+
+  ret = column_log_reader_open(&g_reader, g_io, PROCESS_TREND_DATA_PATH,
+                               PROCESS_TREND_INDEX_PATH);
+  if (ret == 0) {
+    ret = column_log_read_range(&g_reader, t_start, now, BIT_MASK(ARRAY_SIZE(g_channels)),
+                                process_trend_export_cb, (void *)shell);
+    column_log_reader_close(&g_reader);
+  }
+
+  k_mutex_unlock(&g_reader_lock);
+
+  if (ret < 0) {
+    shell_error(shell, "read failed: %d", ret);
+    return ret;
+  }
+
+  return 0;
+}
+
+static int process_trend_shell_cmd_stats(const struct shell *shell, size_t argc, char **argv) {
+  struct process_trend_stats stats;
+  k_spinlock_key_t key;
+
+  ARG_UNUSED(argc);
+  ARG_UNUSED(argv);
+
+  key = k_spin_lock(&g_lock);
+  stats = g_stats;
+  k_spin_unlock(&g_lock, key);
+
+  shell_print(shell, "samples %u, dropped %u, errors %u, blocks %u", stats.samples,
+              stats.dropped, stats.errors, g_writer.sequence);
+
+  return 0;
+}
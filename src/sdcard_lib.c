@@ -1,4 +1,7 @@
 #include "sdcard_lib.h"
+#include "app_dma.h"
+#include "data_logger.h"
+#include "file_io.h"
 #include <zephyr/kernel.h>
 #include <zephyr/device.h>
 #include <zephyr/storage/disk_access.h>
@@ -33,9 +36,41 @@ static struct fs_mount_t mp = {
 #define SOME_DIR_NAME "some"
 #define SOME_REQUIRED_LEN MAX(sizeof(SOME_FILE_NAME), sizeof(SOME_DIR_NAME))
 
+// Logger continuo: buffers DMA-safe, descarregados em setores inteiros
+#define SDCARD_LOG_DIR              DISK_MOUNT_PT "/LOG"
+#define SDCARD_LOG_BUFFER_SIZE      (8 * 1024)
+#define SDCARD_LOG_BUFFER_COUNT     (3)
+#define SDCARD_LOG_FILE_SIZE        (4 * 1024 * 1024)
+#define SDCARD_LOG_FLUSH_MS         (5000)
+
+static uint8_t *g_log_storage;
+static struct data_logger g_logger;
+static bool g_mounted;
+
+// Servico de I/O assincrono do cartao
+#define SDCARD_IO_DEADLINE_MS       (2000)
+
+enum sdcard_test_step {
+    SDCARD_TEST_OPEN_WRITE,
+    SDCARD_TEST_WRITE,
+    SDCARD_TEST_CLOSE_WRITE,
+    SDCARD_TEST_OPEN_READ,
+    SDCARD_TEST_READ,
+    SDCARD_TEST_CLOSE_READ,
+    SDCARD_TEST_ABORT,
+};
+
+static struct file_io g_file_io;
+static struct file_io_request g_test_request;
+static char g_test_read_buf[40];
+
 
 int sdcard_init(void)
 {
+    if (g_mounted) {
+        return 0;
+    }
+
     // int ret;
 
     // LOG_INF("Initializing SD Card");
@@ -96,113 +131,186 @@ int sdcard_init(void)
 
 	mp.mnt_point = disk_mount_pt;
 
+	// O volume fica montado: o logger mantem arquivos abertos
 	int res = fs_mount(&mp);
 
-	if (res == FS_RET_OK) {
-		printk("Disk mounted.\n");
-		/* Try to unmount and remount the disk */
-		res = fs_unmount(&mp);
-		if (res != FS_RET_OK) {
-			printk("Error unmounting disk\n");
-			return res;
-		}
-		res = fs_mount(&mp);
-		if (res != FS_RET_OK) {
-			printk("Error remounting disk\n");
-			return res;
-		}
-
-		// if (lsdir(disk_mount_pt) == 0) {
-#ifdef CONFIG_FS_SAMPLE_CREATE_SOME_ENTRIES
-			if (create_some_entries(disk_mount_pt)) {
-				lsdir(disk_mount_pt);
-			}
-#endif
-		// }
-	} else {
+	if (res != FS_RET_OK) {
 		printk("Error mounting disk.\n");
+		return res;
 	}
 
-	fs_unmount(&mp);
+	printk("Disk mounted.\n");
+	g_mounted = true;
+
+	file_io_init(&g_file_io, "sdcard_io");
 
-	// while (1) {
-	// 	k_sleep(K_MSEC(1000));
-	// }
 	return 0;
 }
 
-int sdcard_test(void)
+// Buffer cheio ou completado ate o setor: o SDMMC le direto da SDRAM por DMA
+static int sdcard_log_prepare(void *data, size_t length)
 {
-    int ret;
-    char read_buf[40] = {0};
+    return app_dma_sync_for_device(data, length, APP_DMA_TO_DEVICE);
+}
 
-    LOG_INF("Starting SD Card test");
-    memset(read_buf, 0, sizeof(read_buf));
+int sdcard_logger_init(void)
+{
+    struct data_logger_config config = {
+        .directory = SDCARD_LOG_DIR,
+        .buffer_size = SDCARD_LOG_BUFFER_SIZE,
+        .buffer_count = SDCARD_LOG_BUFFER_COUNT,
+        .file_size = SDCARD_LOG_FILE_SIZE,
+        .flush_interval_ms = SDCARD_LOG_FLUSH_MS,
+        .prepare = sdcard_log_prepare,
+    };
+    int ret;
 
-    // Write file
-    fs_file_t_init(&file);
-    
-    ret = fs_open(&file, FILE_PATH, FS_O_CREATE | FS_O_WRITE);
-    if (ret != 0) {
-        LOG_ERR("Failed to open file for write (%d)", ret);
-        return ret;
+    if (!g_mounted) {
+        return -ENODEV;
     }
 
-    ret = fs_write(&file, hello_str, strlen(hello_str));
-    if (ret < 0) {
-        LOG_ERR("Failed to write to file (%d)", ret);
-        fs_close(&file);
-        return ret;
+    // Setores inteiros vao direto do buffer para o SDMMC, sem copia
+    if (!g_log_storage) {
+        g_log_storage = app_dma_alloc(SDCARD_LOG_BUFFER_COUNT * SDCARD_LOG_BUFFER_SIZE);
+        if (!g_log_storage) {
+            return -ENOMEM;
+        }
     }
+    config.storage = g_log_storage;
 
-    ret = fs_close(&file);
+    ret = data_logger_init(&g_logger, &config);
     if (ret != 0) {
-        LOG_ERR("Failed to close file (%d)", ret);
-        return ret;
+        LOG_ERR("Failed to start data logger (%d)", ret);
     }
 
-    LOG_INF("File written successfully");
+    return ret;
+}
+
+int sdcard_log_write(enum sdcard_log_type type, const void *data, uint16_t length)
+{
+    return data_logger_write(&g_logger, type, data, length);
+}
 
-    // Read file
-    fs_file_t_init(&file);
-    ret = fs_open(&file, FILE_PATH, FS_O_READ);
-    if (ret != 0) {
-        LOG_ERR("Failed to open file for read (%d)", ret);
-        return ret;
+int sdcard_log_get_stats(struct data_logger_stats *stats)
+{
+    return data_logger_get_stats(&g_logger, stats);
+}
+
+// Teste encadeado pelos callbacks do servico de I/O: nao bloqueia quem chama
+static void sdcard_test_next(struct file_io_request *request, void *user_data);
+
+static int sdcard_test_submit(enum sdcard_test_step step)
+{
+    struct file_io_request *request = &g_test_request;
+
+    memset(request, 0, sizeof(*request));
+    request->file = &file;
+    request->offset = -1;
+    request->deadline = k_uptime_get() + SDCARD_IO_DEADLINE_MS;
+    request->callback = sdcard_test_next;
+    request->user_data = (void *)(intptr_t)step;
+
+    switch (step) {
+    case SDCARD_TEST_OPEN_WRITE:
+        request->op = FILE_IO_OPEN;
+        request->path = FILE_PATH;
+        request->flags = FS_O_CREATE | FS_O_WRITE | FS_O_TRUNC;
+        break;
+    case SDCARD_TEST_WRITE:
+        request->op = FILE_IO_APPEND;
+        request->buffer = (void *)hello_str;
+        request->length = strlen(hello_str);
+        break;
+    case SDCARD_TEST_OPEN_READ:
+        request->op = FILE_IO_OPEN;
+        request->path = FILE_PATH;
+        request->flags = FS_O_READ;
+        break;
+    case SDCARD_TEST_READ:
+        request->op = FILE_IO_READ;
+        request->buffer = g_test_read_buf;
+        request->length = sizeof(g_test_read_buf) - 1;
+        request->offset = 0;
+        break;
+    default:
+        request->op = FILE_IO_CLOSE;
+        break;
     }
 
-    ret = fs_read(&file, read_buf, sizeof(read_buf));
-    if (ret < 0) {
-        LOG_ERR("Failed to read file (%d)", ret);
-        fs_close(&file);
-        return ret;
+    return file_io_submit(&g_file_io, request);
+}
+
+static void sdcard_test_next(struct file_io_request *request, void *user_data)
+{
+    enum sdcard_test_step step = (enum sdcard_test_step)(intptr_t)user_data;
+
+    if (request->result < 0) {
+        LOG_ERR("SD Card test step %d failed (%d)", step, request->result);
+        if ((step == SDCARD_TEST_WRITE) || (step == SDCARD_TEST_READ)) {
+            sdcard_test_submit(SDCARD_TEST_ABORT);
+        }
+        return;
     }
 
-    ret = fs_close(&file);
-    if (ret != 0) {
-        LOG_ERR("Failed to close file (%d)", ret);
-        return ret;
+    switch (step) {
+    case SDCARD_TEST_CLOSE_WRITE:
+        LOG_INF("File written successfully");
+        break;
+    case SDCARD_TEST_READ:
+        g_test_read_buf[request->result] = '\0';
+        LOG_INF("File content: %s", g_test_read_buf);
+        break;
+    case SDCARD_TEST_CLOSE_READ:
+        LOG_INF("SD Card test completed successfully");
+        return;
+    case SDCARD_TEST_ABORT:
+        return;
+    default:
+        break;
     }
 
-    LOG_INF("File content: %s", read_buf);
+    sdcard_test_submit(step + 1);
+}
 
-    // Verify content
-    // if (strcmp(hello_str, read_buf) {
-    //     LOG_ERR("Content verification failed!");
-    //     return -EIO;
-    // }
+int sdcard_test(void)
+{
+    if (!g_mounted) {
+        return -ENODEV;
+    }
 
-    LOG_INF("SD Card test completed successfully");
-    return 0;
+    LOG_INF("Starting SD Card test");
+
+    return sdcard_test_submit(SDCARD_TEST_OPEN_WRITE);
+}
+
+int sdcard_io_submit(struct file_io_request *request)
+{
+    if (!g_mounted) {
+        return -ENODEV;
+    }
+
+    return file_io_submit(&g_file_io, request);
+}
+
+// Servico de I/O do cartao para bibliotecas que fazem os proprios pedidos
+// (ex.: column_log); NULL sem cartao montado
+struct file_io *sdcard_io_get(void)
+{
+    return g_mounted ? &g_file_io : NULL;
 }
 
 int sdcard_deinit(void)
 {
-    int ret = fs_unmount(&mp);
+    int ret;
+
+    data_logger_deinit(&g_logger, K_SECONDS(5));
+
+    ret = fs_unmount(&mp);
     if (ret != 0) {
         LOG_ERR("Failed to unmount filesystem (%d)", ret);
         return ret;
     }
+    g_mounted = false;
     LOG_INF("Filesystem unmounted successfully");
     return 0;
 }
\ No newline at end of file
@@ -12,6 +12,7 @@
 
 static struct db_sys_conf g_db_sys_conf;       
 static struct db_sys_proc g_db_sys_proc;  
+static struct db_peer_proc g_db_peer_proc;
 static struct db_sys_update_conf g_db_sys_ota_conf;
 
 static const struct db_param g_db_sys_conf_vars[] =
@@ -36,6 +37,13 @@ static const struct db_param g_db_sys_proc_var[] =
     DB_PARAMS_ADD_B16(PROC_VAR_SENSOR_HUMID,  ACC_LEVEL_USER, VAR_FIELD_NORMAL, "Humi",   eS16, g_db_sys_proc.humidity, MIN_S16,  MAX_S16, 5678),
 };
 
+static const struct db_param g_db_peer_proc_var[] =
+{
+    DB_PARAMS_ADD_B08(PEER_VAR_MDB_IQC,       ACC_LEVEL_USER, VAR_FIELD_NORMAL, "PeerIQC",    eU08, g_db_peer_proc.mdb_iqc,        0,      100, 0),
+    DB_PARAMS_ADD_B16(PEER_VAR_SENSOR_TEMPER, ACC_LEVEL_USER, VAR_FIELD_NORMAL, "PeerTemper", eS16, g_db_peer_proc.temper,   MIN_S16,  MAX_S16, 0),
+    DB_PARAMS_ADD_B16(PEER_VAR_SENSOR_HUMID,  ACC_LEVEL_USER, VAR_FIELD_NORMAL, "PeerHumi",   eS16, g_db_peer_proc.humidity, MIN_S16,  MAX_S16, 0),
+};
+
 static const struct db_param g_db_params_sys_update_conf[] =
 {
     DB_PARAMS_ADD_STR( PARAM_CNFG_OTA_FILE,         ACC_LEVEL_USER, VAR_FIELD_NORMAL, "CnfgOtaFile",       eSTR, g_db_sys_ota_conf.update.file,                NULL,     NULL,   " "),
@@ -50,6 +58,7 @@ static const struct db_param g_db_params_sys_update_conf[] =
 
 static struct db_group g_db_grp_sys_conf = DATABASE_CREATE_GROUP(GROUP_SYS_CONF, "SysConfigVar", g_db_sys_conf_vars);
 static struct db_group g_db_grp_sys_proc = DATABASE_CREATE_GROUP(GROUP_PROC_VAR,   "SysProcVar",  g_db_sys_proc_var);
+static struct db_group g_db_grp_peer_proc = DATABASE_CREATE_GROUP(GROUP_PEER_VAR,   "PeerProcVar", g_db_peer_proc_var);
 static struct db_group g_db_grp_sys_update_config = DATABASE_CREATE_GROUP( GROUP_SYS_OTA_CONF,  "SysOtaConfig",  g_db_params_sys_update_conf );
 
 int setup_database_init(void)
@@ -58,6 +67,7 @@ int setup_database_init(void)
   db_group_add( &g_db_grp_sys_conf );
   db_group_add( &g_db_grp_sys_update_config );
   db_group_add( &g_db_grp_sys_proc );
+  db_group_add( &g_db_grp_peer_proc );
   db_group_load_default(DB_GROUP_SELECT_ALL, ACC_LEVEL_FACTORY);
   return 0;
 }
\ No newline at end of file
@@ -0,0 +1,721 @@
+#include "uds_server.h"
+#include "app_ota.h"
+#include "database.h"
+#include "isotp_conn.h"
+
+#include <mbedtls/sha256.h>
+#include <string.h>
+#include <zephyr/kernel.h>
+#include <zephyr/logging/log.h>
+#include <zephyr/net_buf.h>
+#include <zephyr/random/random.h>
+#include <zephyr/sys/byteorder.h>
+
+LOG_MODULE_REGISTER(uds_server, CONFIG_LOG_DEFAULT_LEVEL);
+
+#define UDS_SID_SESSION_CONTROL   0x10
+#define UDS_SID_READ_DID          0x22
+#define UDS_SID_SECURITY_ACCESS   0x27
+#define UDS_SID_WRITE_DID         0x2E
+#define UDS_SID_REQUEST_DOWNLOAD  0x34
+#define UDS_SID_TRANSFER_DATA     0x36
+#define UDS_SID_TRANSFER_EXIT     0x37
+#define UDS_SID_TESTER_PRESENT    0x3E
+#define UDS_SID_NEGATIVE          0x7F
+#define UDS_POSITIVE(sid)         ((sid) + 0x40)
+#define UDS_SUPPRESS_POS_RSP      0x80
+
+#define UDS_SESSION_DEFAULT       0x01
+#define UDS_SESSION_EXTENDED      0x03
+
+#define UDS_P2_MS                 50
+#define UDS_P2_EXT_MS             5000
+#define UDS_PENDING_MS            (UDS_P2_EXT_MS / 2) // Reenvio do 0x78 dentro do P2*
+#define UDS_SEED_LEN              8
+#define UDS_KEY_LEN               8                   // HMAC-SHA256 truncado
+#define UDS_HMAC_BLOCK            64
+#define UDS_HASH_LEN              32
+#define UDS_MAX_ATTEMPTS          3
+#define UDS_DOWNLOAD_ACCESS       ACC_LEVEL_ENGINEER
+#define UDS_LEN_FORMAT_2_BYTES    0x20
+
+enum uds_nrc {
+  UDS_NRC_SERVICE_NOT_SUPPORTED = 0x11,
+  UDS_NRC_SUBFUNCTION_NOT_SUPPORTED = 0x12,
+  UDS_NRC_INCORRECT_LENGTH = 0x13,
+  UDS_NRC_RESPONSE_TOO_LONG = 0x14,
+  UDS_NRC_CONDITIONS_NOT_CORRECT = 0x22,
+  UDS_NRC_REQUEST_SEQUENCE = 0x24,
+  UDS_NRC_OUT_OF_RANGE = 0x31,
+  UDS_NRC_SECURITY_DENIED = 0x33,
+  UDS_NRC_INVALID_KEY = 0x35,
+  UDS_NRC_EXCEEDED_ATTEMPTS = 0x36,
+  UDS_NRC_TIME_DELAY = 0x37,
+  UDS_NRC_DOWNLOAD_NOT_ACCEPTED = 0x70,
+  UDS_NRC_TRANSFER_SUSPENDED = 0x71,
+  UDS_NRC_PROGRAMMING_FAILURE = 0x72,
+  UDS_NRC_WRONG_BLOCK_SEQUENCE = 0x73,
+  UDS_NRC_RESPONSE_PENDING = 0x78,
+  UDS_NRC_NOT_IN_SESSION = 0x7F,
+};
+
+// Servico: retorna o tamanho da resposta, 0 para suprimir ou -NRC
+struct uds_service {
+  uint8_t sid;
+  int (*handler)(uint8_t *req, size_t len);
+};
+
+// Estado do testador; acessado apenas pela thread de recepcao do isotp
+struct uds_server {
+  uint8_t session;
+  enum access_level access;
+  enum access_level seed_level; // Nivel com seed pendente
+  uint8_t seed[UDS_SEED_LEN];
+  uint8_t attempts;             // Chaves erradas; nao zera com a troca de sessao
+  int64_t delay_until;          // Sem SecurityAccess ate este uptime
+  int64_t last_request;
+#if defined(CONFIG_APP_OTA)
+  bool download;                // RequestDownload aceito
+  bool block_written;           // Algum TransferData ja gravado
+  uint8_t block_seq;            // Proximo blockSequenceCounter esperado
+#endif
+  struct db_raw_item items[CONFIG_APP_UDS_MAX_DIDS];
+  uint8_t req[CONFIG_APP_UDS_MAX_REQUEST];
+  uint8_t rsp[ISOTP_MAX_DATA_LEN];
+};
+
+static struct uds_server g_uds;
+
+// 0x78 repetido enquanto um servico longo bloqueia a thread de recepcao
+static struct k_work_delayable g_pending_work;
+static uint8_t g_pending_sid;
+
+static int uds_session_control(uint8_t *req, size_t len);
+static int uds_tester_present(uint8_t *req, size_t len);
+static int uds_security_access(uint8_t *req, size_t len);
+static int uds_read_did(uint8_t *req, size_t len);
+static int uds_write_did(uint8_t *req, size_t len);
+#if defined(CONFIG_APP_OTA)
+static int uds_request_download(uint8_t *req, size_t len);
+static int uds_transfer_data(uint8_t *req, size_t len);
+static int uds_transfer_exit(uint8_t *req, size_t len);
+#endif
+
+static const struct uds_service g_services[] = {
+    {UDS_SID_SESSION_CONTROL, uds_session_control},
+    {UDS_SID_TESTER_PRESENT, uds_tester_present},
+    {UDS_SID_SECURITY_ACCESS, uds_security_access},
+    {UDS_SID_READ_DID, uds_read_did},
+    {UDS_SID_WRITE_DID, uds_write_did},
+#if defined(CONFIG_APP_OTA)
+    {UDS_SID_REQUEST_DOWNLOAD, uds_request_download},
+    {UDS_SID_TRANSFER_DATA, uds_transfer_data},
+    {UDS_SID_TRANSFER_EXIT, uds_transfer_exit},
+#endif
+};
+
+/*
+ * Troca de sessao sempre bloqueia o acesso de novo (ISO 14229). As tentativas
+ * e o atraso continuam valendo: trocar de sessao nao libera novas chaves.
+ */
+static void uds_server_reset_session(uint8_t session) {
+  g_uds.session = session;
+  g_uds.access = ACC_LEVEL_USER;
+  g_uds.seed_level = ACC_LEVEL_NONE;
+
+#if defined(CONFIG_APP_OTA)
+  // Transferencia pela metade nao sobrevive a troca de sessao
+  if (g_uds.download) {
+    g_uds.download = false;
+    app_ota_abort();
+  }
+#endif
+}
+
+static void uds_server_send(const uint8_t *data, size_t len) {
+  int ret;
+
+  // O tester manda o flow control das respostas longas no ID da requisicao
+  ret = isotp_conn_send(CONFIG_APP_UDS_TX_ADDR, CONFIG_APP_UDS_RX_ADDR, data, len,
+                        ISOTP_CONN_PRIO_URGENT, K_MSEC(UDS_P2_MS), NULL, NULL);
+  if (ret != 0) {
+    LOG_WRN("Response 0x%02x dropped: %d", data[0], ret);
+  }
+}
+
+static void uds_server_pending_work(struct k_work *work) {
+  uint8_t pending[3] = {UDS_SID_NEGATIVE, g_pending_sid, UDS_NRC_RESPONSE_PENDING};
+
+  uds_server_send(pending, sizeof(pending));
+  k_work_reschedule(k_work_delayable_from_work(work), K_MSEC(UDS_PENDING_MS));
+}
+
+// Responde 0x78 agora e a cada UDS_PENDING_MS ate uds_server_pending_stop()
+static void uds_server_pending_start(uint8_t sid) {
+  g_pending_sid = sid;
+  k_work_reschedule(&g_pending_work, K_NO_WAIT);
+}
+
+static void uds_server_pending_stop(void) {
+  struct k_work_sync sync;
+
+  k_work_cancel_delayable_sync(&g_pending_work, &sync);
+}
+
+/*
+ * Chave = primeiros UDS_KEY_LEN bytes de HMAC-SHA256(segredo, nivel | seed).
+ * Sem o segredo um par seed/chave capturado nao ajuda a calcular o proximo.
+ */
+static void uds_server_key(const uint8_t *seed, enum access_level level, uint8_t *key) {
+  const char *secret = CONFIG_APP_UDS_SECURITY_SECRET;
+  size_t secret_len = strlen(secret);
+  uint8_t pad[UDS_HMAC_BLOCK];
+  uint8_t hash[UDS_HASH_LEN];
+  uint8_t msg = level;
+  mbedtls_sha256_context sha;
+
+  mbedtls_sha256_init(&sha);
+
+  // Segredo maior que o bloco entra pelo seu hash (RFC 2104)
+  memset(pad, 0, sizeof(pad));
+  if (secret_len > sizeof(pad)) {
+    mbedtls_sha256((const uint8_t *)secret, secret_len, pad, 0);
+  } else {
+    memcpy(pad, secret, secret_len);
+  }
+
+  for (size_t i = 0; i < sizeof(pad); i++) {
+    pad[i] ^= 0x36;
+  }
+  mbedtls_sha256_starts(&sha, 0);
+  mbedtls_sha256_update(&sha, pad, sizeof(pad));
+  mbedtls_sha256_update(&sha, &msg, sizeof(msg));
+  mbedtls_sha256_update(&sha, seed, UDS_SEED_LEN);
+  mbedtls_sha256_finish(&sha, hash);
+
+  for (size_t i = 0; i < sizeof(pad); i++) {
+    pad[i] ^= 0x36 ^ 0x5C;
+  }
+  mbedtls_sha256_starts(&sha, 0);
+  mbedtls_sha256_update(&sha, pad, sizeof(pad));
+  mbedtls_sha256_update(&sha, hash, sizeof(hash));
+  mbedtls_sha256_finish(&sha, hash);
+
+  mbedtls_sha256_free(&sha);
+  memcpy(key, hash, UDS_KEY_LEN);
+  memset(pad, 0, sizeof(pad));
+  memset(hash, 0, sizeof(hash));
+}
+
+// Comparacao em tempo constante
+static bool uds_server_key_equal(const uint8_t *a, const uint8_t *b) {
+  uint8_t diff = 0;
+
+  for (size_t i = 0; i < UDS_KEY_LEN; i++) {
+    diff |= a[i] ^ b[i];
+  }
+
+  return diff == 0;
+}
+
+static int uds_server_find(uint16_t did, struct db_param **param) {
+  struct db_group *group;
+
+  if (db_get_var_config(&group, param, did >> 8, did & 0xFF) != 0) {
+    return -UDS_NRC_OUT_OF_RANGE;
+  }
+
+  return 0;
+}
+
+// Numeros trafegam em big endian; strings como estao
+static void uds_server_swap(const struct db_raw_item *item) {
+  enum variable_type type = item->param->config.info.type;
+
+  if ((type != eSTR) && (type != eVOID)) {
+    sys_mem_swap(item->data, item->len);
+  }
+}
+
+static int uds_session_control(uint8_t *req, size_t len) {
+  uint8_t session;
+
+  if (len != 2) {
+    return -UDS_NRC_INCORRECT_LENGTH;
+  }
+
+  session = req[1] & ~UDS_SUPPRESS_POS_RSP;
+  if ((session != UDS_SESSION_DEFAULT) && (session != UDS_SESSION_EXTENDED)) {
+    return -UDS_NRC_SUBFUNCTION_NOT_SUPPORTED;
+  }
+
+  uds_server_reset_session(session);
+
+  if (req[1] & UDS_SUPPRESS_POS_RSP) {
+    return 0;
+  }
+
+  g_uds.rsp[0] = UDS_POSITIVE(UDS_SID_SESSION_CONTROL);
+  g_uds.rsp[1] = session;
+  sys_put_be16(UDS_P2_MS, &g_uds.rsp[2]);
+  sys_put_be16(UDS_P2_EXT_MS / 10, &g_uds.rsp[4]);
+
+  return 6;
+}
+
+static int uds_tester_present(uint8_t *req, size_t len) {
+  if (len != 2) {
+    return -UDS_NRC_INCORRECT_LENGTH;
+  }
+
+  if ((req[1] & ~UDS_SUPPRESS_POS_RSP) != 0) {
+    return -UDS_NRC_SUBFUNCTION_NOT_SUPPORTED;
+  }
+
+  if (req[1] & UDS_SUPPRESS_POS_RSP) {
+    return 0;
+  }
+
+  g_uds.rsp[0] = UDS_POSITIVE(UDS_SID_TESTER_PRESENT);
+  g_uds.rsp[1] = 0;
+
+  return 2;
+}
+
+/**
+ * @brief SecurityAccess: sub-funcao 2 * nivel - 1 pede a seed, 2 * nivel envia a chave
+ *
+ * O nivel liberado e o enum access_level usado pela base nas leituras e escritas.
+ */
+static int uds_security_access(uint8_t *req, size_t len) {
+  uint8_t key[UDS_KEY_LEN];
+  enum access_level level;
+  uint8_t sub;
+
+  if (len < 2) {
+    return -UDS_NRC_INCORRECT_LENGTH;
+  }
+
+  sub = req[1] & ~UDS_SUPPRESS_POS_RSP;
+  level = (sub + 1) / 2;
+  if ((sub == 0) || (level >= ACC_LEVEL_MAX)) {
+    return -UDS_NRC_SUBFUNCTION_NOT_SUPPORTED;
+  }
+
+  if (g_uds.session != UDS_SESSION_EXTENDED) {
+    return -UDS_NRC_NOT_IN_SESSION;
+  }
+
+  // Sem segredo configurado nenhum nivel pode ser liberado
+  if (CONFIG_APP_UDS_SECURITY_SECRET[0] == '\0') {
+    return -UDS_NRC_CONDITIONS_NOT_CORRECT;
+  }
+
+  // Atraso depois das tentativas esgotadas (e no boot); vencido, recomeca a contagem
+  if (k_uptime_get() < g_uds.delay_until) {
+    return -UDS_NRC_TIME_DELAY;
+  }
+
+  if (g_uds.attempts >= UDS_MAX_ATTEMPTS) {
+    g_uds.attempts = 0;
+  }
+
+  g_uds.rsp[0] = UDS_POSITIVE(UDS_SID_SECURITY_ACCESS);
+  g_uds.rsp[1] = sub;
+
+  if (sub & 0x01) {
+    if (len != 2) {
+      return -UDS_NRC_INCORRECT_LENGTH;
+    }
+
+    // Nivel ja liberado: seed zerada
+    if (g_uds.access >= level) {
+      memset(g_uds.seed, 0, sizeof(g_uds.seed));
+      g_uds.seed_level = ACC_LEVEL_NONE;
+    } else {
+      if (sys_csrand_get(g_uds.seed, sizeof(g_uds.seed)) != 0) {
+        return -UDS_NRC_CONDITIONS_NOT_CORRECT;
+      }
+      g_uds.seed_level = level;
+    }
+
+    memcpy(&g_uds.rsp[2], g_uds.seed, UDS_SEED_LEN);
+    return 2 + UDS_SEED_LEN;
+  }
+
+  if (len != (2 + UDS_KEY_LEN)) {
+    return -UDS_NRC_INCORRECT_LENGTH;
+  }
+
+  if (g_uds.seed_level != level) {
+    return -UDS_NRC_REQUEST_SEQUENCE;
+  }
+
+  g_uds.seed_level = ACC_LEVEL_NONE;
+
+  uds_server_key(g_uds.seed, level, key);
+  if (!uds_server_key_equal(&req[2], key)) {
+    g_uds.attempts++;
+    if (g_uds.attempts < UDS_MAX_ATTEMPTS) {
+      return -UDS_NRC_INVALID_KEY;
+    }
+
+    g_uds.delay_until = k_uptime_get() + CONFIG_APP_UDS_SECURITY_DELAY_MS;
+    LOG_WRN("SecurityAccess locked for %d ms", CONFIG_APP_UDS_SECURITY_DELAY_MS);
+    return -UDS_NRC_EXCEEDED_ATTEMPTS;
+  }
+
+  g_uds.access = level;
+  g_uds.attempts = 0;
+  LOG_INF("Access level %d unlocked", level);
+
+  return (req[1] & UDS_SUPPRESS_POS_RSP) ? 0 : 2;
+}
+
+/**
+ * @brief ReadDataByIdentifier com varios DIDs na mesma requisicao
+ *
+ * Os valores sao copiados direto para a resposta sob um unico lock da base,
+ * formando um retrato consistente da tela do service tool.
+ */
+static int uds_read_did(uint8_t *req, size_t len) {
+  struct db_raw_item *item;
+  struct db_param *param;
+  size_t count = (len - 1) / 2;
+  size_t pos = 1;
+  uint16_t did;
+  int ret;
+
+  if ((len < 3) || !(len & 0x01) || (count > ARRAY_SIZE(g_uds.items))) {
+    return -UDS_NRC_INCORRECT_LENGTH;
+  }
+
+  g_uds.rsp[0] = UDS_POSITIVE(UDS_SID_READ_DID);
+
+  for (size_t i = 0; i < count; i++) {
+    did = sys_get_be16(&req[1 + (2 * i)]);
+    ret = uds_server_find(did, &param);
+    if (ret < 0) {
+      return ret;
+    }
+
+    // Senhas nao saem pelo barramento
+    if (param->config.info.field == VAR_FIELD_PWD) {
+      return -UDS_NRC_SECURITY_DENIED;
+    }
+
+    if ((pos + 2 + param->config.var_size) > sizeof(g_uds.rsp)) {
+      return -UDS_NRC_RESPONSE_TOO_LONG;
+    }
+
+    sys_put_be16(did, &g_uds.rsp[pos]);
+    item = &g_uds.items[i];
+    item->param = param;
+    item->data = &g_uds.rsp[pos + 2];
+    item->len = param->config.var_size;
+    pos += 2 + param->config.var_size;
+  }
+
+  ret = db_param_get_raw_batch(g_uds.access, g_uds.items, count);
+  if (ret == -EACCES) {
+    return -UDS_NRC_SECURITY_DENIED;
+  } else if (ret < 0) {
+    return -UDS_NRC_CONDITIONS_NOT_CORRECT;
+  }
+
+  for (size_t i = 0; i < count; i++) {
+    uds_server_swap(&g_uds.items[i]);
+  }
+
+  return pos;
+}
+
+/**
+ * @brief WriteDataByIdentifier com um ou mais pares DID + valor
+ *
+ * O tamanho de cada valor vem da base (var_size). A escrita e atomica: com
+ * qualquer DID invalido nada e alterado.
+ */
+static int uds_write_did(uint8_t *req, size_t len) {
+  struct db_raw_item *item;
+  struct db_param *param;
+  size_t count = 0;
+  size_t pos = 1;
+  uint16_t did;
+  int ret;
+
+  while (pos < len) {
+    if ((count >= ARRAY_SIZE(g_uds.items)) || ((len - pos) < 2)) {
+      return -UDS_NRC_INCORRECT_LENGTH;
+    }
+
+    did = sys_get_be16(&req[pos]);
+    ret = uds_server_find(did, &param);
+    if (ret < 0) {
+      return ret;
+    }
+
+    if ((len - pos - 2) < param->config.var_size) {
+      return -UDS_NRC_INCORRECT_LENGTH;
+    }
+
+    item = &g_uds.items[count++];
+    item->param = param;
+    item->data = &req[pos + 2];
+    item->len = param->config.var_size;
+
+    if (param->config.info.type == eSTR) {
+      item->len = strnlen((const char *)item->data, param->config.var_size);
+    } else {
+      uds_server_swap(item);
+    }
+
+    // Resposta lista os DIDs escritos
+    sys_put_be16(did, &g_uds.rsp[1 + (2 * (count - 1))]);
+    pos += 2 + param->config.var_size;
+  }
+
+  if (count == 0) {
+    return -UDS_NRC_INCORRECT_LENGTH;
+  }
+
+  ret = db_param_set_raw_batch(g_uds.access, g_uds.items, count);
+  if (ret == -EACCES) {
+    return -UDS_NRC_SECURITY_DENIED;
+  } else if (ret == -EINVAL) {
+    return -UDS_NRC_OUT_OF_RANGE;
+  } else if (ret < 0) {
+    return -UDS_NRC_PROGRAMMING_FAILURE;
+  }
+
+  g_uds.rsp[0] = UDS_POSITIVE(UDS_SID_WRITE_DID);
+
+  return 1 + (2 * count);
+}
+
+#if defined(CONFIG_APP_OTA)
+/**
+ * @brief RequestDownload da imagem para o slot secundario
+ *
+ * Sem compressao/criptografia (dataFormatIdentifier 0) e com endereco 0
+ * (inicio do slot). O apagamento leva segundos: o 0x78 e repetido a cada
+ * UDS_PENDING_MS enquanto durar, para o testador nao estourar o P2*.
+ */
+static int uds_request_download(uint8_t *req, size_t len) {
+  uint8_t addr_len;
+  uint8_t size_len;
+  uint32_t addr = 0;
+  uint32_t size = 0;
+  int ret;
+
+  if (len < 3) {
+    return -UDS_NRC_INCORRECT_LENGTH;
+  }
+
+  addr_len = req[2] & 0x0F;
+  size_len = req[2] >> 4;
+  if ((addr_len == 0) || (addr_len > 4) || (size_len == 0) || (size_len > 4)) {
+    return -UDS_NRC_OUT_OF_RANGE;
+  }
+
+  if (len != (3 + addr_len + size_len)) {
+    return -UDS_NRC_INCORRECT_LENGTH;
+  }
+
+  if (g_uds.session != UDS_SESSION_EXTENDED) {
+    return -UDS_NRC_NOT_IN_SESSION;
+  }
+
+  if (g_uds.access < UDS_DOWNLOAD_ACCESS) {
+    return -UDS_NRC_SECURITY_DENIED;
+  }
+
+  if (g_uds.download) {
+    return -UDS_NRC_CONDITIONS_NOT_CORRECT;
+  }
+
+  for (uint8_t i = 0; i < addr_len; i++) {
+    addr = (addr << 8) | req[3 + i];
+  }
+
+  for (uint8_t i = 0; i < size_len; i++) {
+    size = (size << 8) | req[3 + addr_len + i];
+  }
+
+  if ((req[1] != 0) || (addr != 0)) {
+    return -UDS_NRC_OUT_OF_RANGE;
+  }
+
+  uds_server_pending_start(UDS_SID_REQUEST_DOWNLOAD);
+  ret = app_ota_begin(APP_OTA_SRC_ISOTP, size);
+  uds_server_pending_stop();
+
+  if (ret == -EBUSY) {
+    return -UDS_NRC_CONDITIONS_NOT_CORRECT;
+  } else if (ret == -EFBIG) {
+    return -UDS_NRC_DOWNLOAD_NOT_ACCEPTED;
+  } else if (ret < 0) {
+    return -UDS_NRC_PROGRAMMING_FAILURE;
+  }
+
+  g_uds.download = true;
+  g_uds.block_written = false;
+  g_uds.block_seq = 1;
+
+  // maxNumberOfBlockLength conta o SID e o contador
+  g_uds.rsp[0] = UDS_POSITIVE(UDS_SID_REQUEST_DOWNLOAD);
+  g_uds.rsp[1] = UDS_LEN_FORMAT_2_BYTES;
+  sys_put_be16(sizeof(g_uds.req), &g_uds.rsp[2]);
+
+  return 4;
+}
+
+/**
+ * @brief TransferData: um bloco da imagem, na ordem do contador
+ *
+ * A repeticao do ultimo bloco (resposta perdida) e confirmada sem gravar.
+ */
+static int uds_transfer_data(uint8_t *req, size_t len) {
+  int ret;
+
+  if (!g_uds.download) {
+    return -UDS_NRC_REQUEST_SEQUENCE;
+  }
+
+  if (len < 2) {
+    return -UDS_NRC_INCORRECT_LENGTH;
+  }
+
+  g_uds.rsp[0] = UDS_POSITIVE(UDS_SID_TRANSFER_DATA);
+  g_uds.rsp[1] = req[1];
+
+  if (g_uds.block_written && (req[1] == (uint8_t)(g_uds.block_seq - 1))) {
+    return 2;
+  }
+
+  if (req[1] != g_uds.block_seq) {
+    return -UDS_NRC_WRONG_BLOCK_SEQUENCE;
+  }
+
+  ret = app_ota_write(&req[2], len - 2);
+  if (ret < 0) {
+    g_uds.download = false;
+    return ((ret == -EFBIG) || (ret == -EILSEQ)) ? -UDS_NRC_TRANSFER_SUSPENDED
+                                                 : -UDS_NRC_PROGRAMMING_FAILURE;
+  }
+
+  g_uds.block_written = true;
+  g_uds.block_seq++;
+
+  return 2;
+}
+
+static int uds_transfer_exit(uint8_t *req, size_t len) {
+  int ret;
+
+  ARG_UNUSED(req);
+  ARG_UNUSED(len);
+
+  if (!g_uds.download) {
+    return -UDS_NRC_REQUEST_SEQUENCE;
+  }
+
+  g_uds.download = false;
+
+  ret = app_ota_finish();
+  if (ret == -EMSGSIZE) {
+    return -UDS_NRC_REQUEST_SEQUENCE;
+  } else if (ret < 0) {
+    return -UDS_NRC_PROGRAMMING_FAILURE;
+  }
+
+  g_uds.rsp[0] = UDS_POSITIVE(UDS_SID_TRANSFER_EXIT);
+
+  return 1;
+}
+#endif
+
+static void uds_server_rx(uint32_t rx_addr, struct net_buf *buf, void *user_data) {
+  const struct uds_service *service = NULL;
+  size_t len = net_buf_frags_len(buf);
+  int64_t now = k_uptime_get();
+  uint8_t nrc[3];
+  int ret;
+
+  ARG_UNUSED(rx_addr);
+  ARG_UNUSED(user_data);
+
+  if (len == 0) {
+    return;
+  }
+
+  nrc[0] = UDS_SID_NEGATIVE;
+  nrc[1] = buf->data[0];
+
+  if (len > sizeof(g_uds.req)) {
+    nrc[2] = UDS_NRC_INCORRECT_LENGTH;
+    uds_server_send(nrc, sizeof(nrc));
+    return;
+  }
+
+  // Sessao S3 expirada: volta ao padrao antes de atender
+  if ((g_uds.session != UDS_SESSION_DEFAULT) &&
+      ((now - g_uds.last_request) > CONFIG_APP_UDS_S3_TIMEOUT_MS)) {
+    uds_server_reset_session(UDS_SESSION_DEFAULT);
+  }
+
+  g_uds.last_request = now;
+
+  net_buf_linearize(g_uds.req, sizeof(g_uds.req), buf, 0, len);
+
+  for (size_t i = 0; i < ARRAY_SIZE(g_services); i++) {
+    if (g_services[i].sid == g_uds.req[0]) {
+      service = &g_services[i];
+      break;
+    }
+  }
+
+  ret = service ? service->handler(g_uds.req, len) : -UDS_NRC_SERVICE_NOT_SUPPORTED;
+  if (ret < 0) {
+    nrc[2] = -ret;
+    uds_server_send(nrc, sizeof(nrc));
+  } else if (ret > 0) {
+    uds_server_send(g_uds.rsp, ret);
+  }
+}
+
+/**
+ * @brief Registra o servidor no endereco de diagnostico
+ *
+ * Requer isotp_conn_init(). As requisicoes sao atendidas na thread de
+ * recepcao do isotp_conn.
+ */
+int uds_server_init(void) {
+  int ret;
+
+  k_work_init_delayable(&g_pending_work, uds_server_pending_work);
+  uds_server_reset_session(UDS_SESSION_DEFAULT);
+
+  // Atraso tambem no boot: reiniciar o modulo nao zera as tentativas
+  g_uds.delay_until = CONFIG_APP_UDS_SECURITY_DELAY_MS;
+
+  if (CONFIG_APP_UDS_SECURITY_SECRET[0] == '\0') {
+    LOG_WRN("CONFIG_APP_UDS_SECURITY_SECRET empty: SecurityAccess disabled");
+  }
+
+  ret = isotp_conn_bind(CONFIG_APP_UDS_RX_ADDR, CONFIG_APP_UDS_TX_ADDR);
+  if (ret != 0) {
+    LOG_ERR("ISO-TP bind failed: %d", ret);
+    return ret;
+  }
+
+  ret = isotp_conn_rx_register(CONFIG_APP_UDS_RX_ADDR, ISOTP_CONN_ANY_SERVICE, uds_server_rx, NULL);
+  if (ret != 0) {
+    isotp_conn_unbind(CONFIG_APP_UDS_RX_ADDR);
+    return ret;
+  }
+
+  LOG_INF("UDS server on 0x%03x -> 0x%03x", CONFIG_APP_UDS_RX_ADDR, CONFIG_APP_UDS_TX_ADDR);
+
+  return 0;
+}
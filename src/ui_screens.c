@@ -0,0 +1,132 @@
+#include "ui_screens.h"
+#include "asset_store.h"
+#include "db_bind.h"
+#include "setup_database.h"
+#include <zephyr/sys/util.h>
+
+// Tela de status: widgets ligados ao banco, redesenhados so quando o valor muda
+static const struct db_bind_fmt g_fmt_int = {.type = DB_BIND_FMT_NUMBER};
+static const struct db_bind_fmt g_fmt_centi = {.type = DB_BIND_FMT_NUMBER, .digits = 5, .precision = 2};
+static const struct db_bind_fmt g_fmt_hex = {.type = DB_BIND_FMT_MASK, .mask = FORMAT_HEXA_TYPE_1};
+static const struct db_bind_fmt g_fmt_seconds = {.type = DB_BIND_FMT_NUMBER, .suffix = " s"};
+
+static const struct {
+  const char *title;
+  db_group_id_t group_id;
+  db_param_id_t param_id;
+  const struct db_bind_fmt *fmt;
+} g_status_items[] = {
+    {"Device", GROUP_SYS_CONF, SYS_CONF_DEVICE_CODE, &g_fmt_hex},
+    {"Firmware", GROUP_SYS_CONF, SYS_CONF_FW_VERSION, &g_fmt_int},
+    {"Serial", GROUP_SYS_CONF, SYS_CONF_SN, &g_fmt_int},
+    {"Uptime", GROUP_PROC_VAR, PROC_VAR_UPTIME, &g_fmt_seconds},
+    {"Temperature", GROUP_PROC_VAR, PROC_VAR_SENSOR_TEMPER, &g_fmt_centi},
+    {"Humidity", GROUP_PROC_VAR, PROC_VAR_SENSOR_HUMID, &g_fmt_centi},
+    {"Modbus IQC", GROUP_PROC_VAR, PROC_VAR_MDB_IQC, &g_fmt_int},
+};
+
+// Logotipo lido da flash externa pelo cache do asset store ("A:"), se empacotado
+#define UI_LOGO_ASSET "logo.bin"
+
+static struct db_bind g_status_binds[ARRAY_SIZE(g_status_items)];
+static struct db_bind g_mdb_addr_bind;
+
+void ui_screen_status_create(lv_obj_t *screen) {
+  struct asset logo;
+  lv_obj_t *row;
+  lv_obj_t *label;
+  lv_obj_t *spinbox;
+
+  lv_obj_set_flex_flow(screen, LV_FLEX_FLOW_COLUMN);
+
+  if (asset_find(UI_LOGO_ASSET, &logo) == 0) {
+    lv_image_set_src(lv_image_create(screen), CONFIG_APP_ASSETS_LVGL_LETTER ":" UI_LOGO_ASSET);
+  }
+
+  for (size_t i = 0; i < ARRAY_SIZE(g_status_items); i++) {
+    row = lv_obj_create(screen);
+    lv_obj_set_size(row, LV_PCT(100), LV_SIZE_CONTENT);
+    lv_obj_set_flex_flow(row, LV_FLEX_FLOW_ROW);
+
+    label = lv_label_create(row);
+    lv_label_set_text(label, g_status_items[i].title);
+    lv_obj_set_width(label, LV_PCT(50));
+
+    label = lv_label_create(row);
+    lv_label_set_text(label, "");
+    db_bind_label(&g_status_binds[i], label, g_status_items[i].group_id,
+                  g_status_items[i].param_id, g_status_items[i].fmt);
+  }
+
+  row = lv_obj_create(screen);
+  lv_obj_set_size(row, LV_PCT(100), LV_SIZE_CONTENT);
+  lv_obj_set_flex_flow(row, LV_FLEX_FLOW_ROW);
+
+  label = lv_label_create(row);
+  lv_label_set_text(label, "Modbus addr");
+  lv_obj_set_width(label, LV_PCT(50));
+
+  spinbox = lv_spinbox_create(row);
+  db_bind_input(&g_mdb_addr_bind, spinbox, DB_BIND_SPINBOX, GROUP_SYS_CONF, SYS_CONF_MDB_ADDR,
+                NULL, ACC_LEVEL_USER);
+}
+
+// Grafico de tendencia: historico lido do column_log no boot e amostras novas
+// empurradas pela thread de tendencia (process_trend) via lcd_ui_post
+static lv_obj_t *g_trend_chart;
+static lv_chart_series_t *g_trend_series;
+
+// Ajusta a escala ao intervalo dos pontos validos
+static void ui_screen_trend_fit(void) {
+  int32_t *values = lv_chart_get_y_array(g_trend_chart, g_trend_series);
+  uint32_t count = lv_chart_get_point_count(g_trend_chart);
+  int32_t min = INT32_MAX;
+  int32_t max = INT32_MIN;
+
+  for (uint32_t i = 0; i < count; i++) {
+    if (values[i] != LV_CHART_POINT_NONE) {
+      min = MIN(min, values[i]);
+      max = MAX(max, values[i]);
+    }
+  }
+
+  if (min > max) {
+    return;
+  }
+  if (min == max) {
+    max = min + 1;
+  }
+
+  lv_chart_set_range(g_trend_chart, LV_CHART_AXIS_PRIMARY_Y, min, max);
+}
+
+void ui_screen_trend_create(lv_obj_t *screen, uint16_t points) {
+  g_trend_chart = lv_chart_create(screen);
+  lv_obj_set_size(g_trend_chart, LV_PCT(100), 120);
+  lv_chart_set_type(g_trend_chart, LV_CHART_TYPE_LINE);
+  lv_chart_set_update_mode(g_trend_chart, LV_CHART_UPDATE_MODE_SHIFT);
+  lv_chart_set_point_count(g_trend_chart, points);
+  lv_obj_set_style_size(g_trend_chart, 0, 0, LV_PART_INDICATOR);
+
+  g_trend_series = lv_chart_add_series(g_trend_chart, lv_palette_main(LV_PALETTE_RED),
+                                       LV_CHART_AXIS_PRIMARY_Y);
+  lv_chart_set_all_value(g_trend_chart, g_trend_series, LV_CHART_POINT_NONE);
+}
+
+// Pontos mais antigos primeiro; LV_CHART_POINT_NONE onde nao ha amostra
+void ui_screen_trend_load(const int32_t *values, uint16_t count) {
+  if (!g_trend_chart) {
+    return;
+  }
+
+  for (uint16_t i = 0; i < count; i++) {
+    lv_chart_set_next_value(g_trend_chart, g_trend_series, values[i]);
+  }
+
+  ui_screen_trend_fit();
+  lv_chart_refresh(g_trend_chart);
+}
+
+void ui_screen_trend_push(int32_t value) {
+  ui_screen_trend_load(&value, 1);
+}
@@ -0,0 +1,226 @@
+#include <string.h>
+#include <ff.h>
+#include <zephyr/fs/fs.h>
+#include <zephyr/kernel.h>
+#include <zephyr/ztest.h>
+#include "column_log.h"
+#include "file_io.h"
+
+#define TEST_MOUNT      "/RAM:"
+#define TEST_DATA_PATH  TEST_MOUNT "/TREND.BIN"
+#define TEST_INDEX_PATH TEST_MOUNT "/TREND.IDX"
+#define TEST_COLUMNS    (3)
+#define TEST_SAMPLES    (700)           // Mais de dois blocos cheios
+#define TEST_T0         (1000)
+#define TEST_MAX_READ   (1024)
+#define TEST_ALL        (BIT(TEST_COLUMNS) - 1)
+
+static FATFS g_fat;
+static struct fs_mount_t g_mount = {
+  .type = FS_FATFS,
+  .fs_data = &g_fat,
+  .mnt_point = TEST_MOUNT,
+};
+
+static struct file_io g_io;
+static struct column_log_writer g_writer;
+static struct column_log_reader g_reader;
+
+struct test_read {
+  uint32_t count;
+  uint32_t column_mask;
+  uint32_t timestamps[TEST_MAX_READ];
+  int32_t values[TEST_MAX_READ][TEST_COLUMNS];
+};
+
+static struct test_read g_read;
+
+// Amostra n: timestamps com passo irregular e colunas com sinais e saltos
+static uint32_t test_timestamp(uint32_t n) {
+  return TEST_T0 + (n * 2) + (n / 10);
+}
+
+static void test_values(uint32_t n, int32_t *values) {
+  values[0] = (int32_t)n;
+  values[1] = -(int32_t)n * 3;
+  values[2] = (int32_t)((n * n) % 1000) - 500;
+}
+
+// Bloco anterior ainda no cartao: espera e tenta de novo, como o chamador real
+static void test_append(uint32_t n) {
+  int32_t values[TEST_COLUMNS];
+  int ret;
+
+  test_values(n, values);
+
+  for (int retry = 0; retry < 100; retry++) {
+    ret = column_log_append(&g_writer, test_timestamp(n), values);
+    if (ret != -EBUSY) {
+      break;
+    }
+    k_msleep(1);
+  }
+
+  zassert_ok(ret, "append %u: %d", n, ret);
+}
+
+static void test_write(uint32_t first, uint32_t count) {
+  for (uint32_t n = first; n < first + count; n++) {
+    test_append(n);
+  }
+}
+
+static void test_writer_open(void) {
+  zassert_ok(column_log_writer_open(&g_writer, &g_io, TEST_DATA_PATH, TEST_INDEX_PATH,
+                                    TEST_COLUMNS));
+}
+
+static int test_read_cb(uint32_t timestamp, const int32_t *values, uint32_t column_mask,
+                        void *user_data) {
+  struct test_read *read = user_data;
+
+  if (read->count >= TEST_MAX_READ) {
+    return -ENOMEM;
+  }
+
+  read->timestamps[read->count] = timestamp;
+  read->column_mask = column_mask;
+  for (int c = 0; c < TEST_COLUMNS; c++) {
+    read->values[read->count][c] = (column_mask & BIT(c)) ? values[c] : 0;
+  }
+  read->count++;
+
+  return 0;
+}
+
+static void test_read_range(uint32_t t_start, uint32_t t_end, uint32_t column_mask) {
+  memset(&g_read, 0, sizeof(g_read));
+
+  zassert_ok(column_log_reader_open(&g_reader, &g_io, TEST_DATA_PATH, TEST_INDEX_PATH));
+  zassert_ok(column_log_read_range(&g_reader, t_start, t_end, column_mask, test_read_cb,
+                                   &g_read));
+  zassert_ok(column_log_reader_close(&g_reader));
+}
+
+// Confere as amostras lidas contra first..first+count-1 nas colunas de column_mask
+static void test_verify(uint32_t first, uint32_t count, uint32_t column_mask) {
+  int32_t values[TEST_COLUMNS];
+
+  zassert_equal(g_read.count, count, "read %u samples, expected %u", g_read.count, count);
+
+  for (uint32_t i = 0; i < count; i++) {
+    test_values(first + i, values);
+    zassert_equal(g_read.timestamps[i], test_timestamp(first + i), "sample %u", first + i);
+    for (int c = 0; c < TEST_COLUMNS; c++) {
+      if (column_mask & BIT(c)) {
+        zassert_equal(g_read.values[i][c], values[c], "sample %u column %d", first + i, c);
+      }
+    }
+  }
+}
+
+static off_t test_file_size(const char *path) {
+  struct fs_dirent entry;
+
+  zassert_ok(fs_stat(path, &entry));
+
+  return entry.size;
+}
+
+static void *test_setup(void) {
+  zassert_ok(fs_mount(&g_mount));
+  zassert_ok(file_io_init(&g_io, "file_io"));
+
+  return NULL;
+}
+
+// Cada teste comeca com o log vazio
+static void test_before(void *fixture) {
+  ARG_UNUSED(fixture);
+
+  fs_unlink(TEST_DATA_PATH);
+  fs_unlink(TEST_INDEX_PATH);
+}
+
+ZTEST(column_log, test_write_read_range) {
+  uint32_t first = 300;
+  uint32_t count = 11;
+
+  test_writer_open();
+  test_write(0, TEST_SAMPLES);
+  zassert_ok(column_log_writer_close(&g_writer));
+
+  // Blocos inteiros e uma entrada de indice por bloco
+  zassert_equal(test_file_size(TEST_DATA_PATH) % COLUMN_LOG_BLOCK_SIZE, 0);
+  zassert_true(test_file_size(TEST_DATA_PATH) / COLUMN_LOG_BLOCK_SIZE >= 3);
+  zassert_equal(test_file_size(TEST_INDEX_PATH) / sizeof(struct column_log_index_entry),
+                test_file_size(TEST_DATA_PATH) / COLUMN_LOG_BLOCK_SIZE);
+
+  test_read_range(0, UINT32_MAX, TEST_ALL);
+  test_verify(0, TEST_SAMPLES, TEST_ALL);
+
+  // Intervalo no meio de um bloco, so uma coluna
+  test_read_range(test_timestamp(first), test_timestamp(first + count - 1), BIT(1));
+  test_verify(first, count, BIT(1));
+  zassert_equal(g_read.column_mask, BIT(1));
+
+  // Intervalo entre dois timestamps: nenhuma amostra
+  test_read_range(test_timestamp(TEST_SAMPLES) + 1, UINT32_MAX, TEST_ALL);
+  zassert_equal(g_read.count, 0);
+}
+
+ZTEST(column_log, test_resume) {
+  int32_t values[TEST_COLUMNS];
+
+  test_writer_open();
+  test_write(0, 300);
+  zassert_ok(column_log_writer_close(&g_writer));
+
+  // Reabrir continua depois da ultima amostra gravada
+  test_writer_open();
+  test_values(0, values);
+  zassert_equal(column_log_append(&g_writer, test_timestamp(299) - 1, values), -EINVAL);
+  test_write(300, 100);
+  zassert_ok(column_log_writer_close(&g_writer));
+
+  test_read_range(0, UINT32_MAX, TEST_ALL);
+  test_verify(0, 400, TEST_ALL);
+}
+
+ZTEST(column_log, test_index_rebuild) {
+  struct fs_file_t file;
+  uint8_t garbage[100];
+  off_t blocks;
+
+  test_writer_open();
+  test_write(0, TEST_SAMPLES);
+  zassert_ok(column_log_writer_close(&g_writer));
+  blocks = test_file_size(TEST_DATA_PATH) / COLUMN_LOG_BLOCK_SIZE;
+
+  // Queda no meio de uma gravacao: indice sem as ultimas entradas e bloco pela metade
+  fs_file_t_init(&file);
+  zassert_ok(fs_open(&file, TEST_INDEX_PATH, FS_O_RDWR));
+  zassert_ok(fs_truncate(&file, sizeof(struct column_log_index_entry)));
+  zassert_ok(fs_close(&file));
+
+  memset(garbage, 0xA5, sizeof(garbage));
+  fs_file_t_init(&file);
+  zassert_ok(fs_open(&file, TEST_DATA_PATH, FS_O_RDWR | FS_O_APPEND));
+  zassert_equal(fs_write(&file, garbage, sizeof(garbage)), sizeof(garbage));
+  zassert_ok(fs_close(&file));
+
+  // O resto do bloco vai embora e o indice e refeito dos headers; as amostras
+  // novas vao para um bloco proprio
+  test_writer_open();
+  test_write(TEST_SAMPLES, 10);
+  zassert_ok(column_log_writer_close(&g_writer));
+
+  zassert_equal(test_file_size(TEST_DATA_PATH), (blocks + 1) * COLUMN_LOG_BLOCK_SIZE);
+  zassert_equal(test_file_size(TEST_INDEX_PATH),
+                (blocks + 1) * sizeof(struct column_log_index_entry));
+
+  test_read_range(0, UINT32_MAX, TEST_ALL);
+  test_verify(0, TEST_SAMPLES + 10, TEST_ALL);
+}
+
+ZTEST_SUITE(column_log, NULL, test_setup, test_before, NULL, NULL);
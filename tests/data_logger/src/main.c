@@ -0,0 +1,206 @@
+#include <string.h>
+#include <ff.h>
+#include <zephyr/fs/fs.h>
+#include <zephyr/kernel.h>
+#include <zephyr/ztest.h>
+#include "data_logger.h"
+#include "file_io.h"
+
+#define TEST_MOUNT        "/RAM:"
+#define TEST_DIRECTORY    TEST_MOUNT "/LOG"
+#define TEST_BUFFER_SIZE  (2048)
+#define TEST_BUFFER_COUNT (2)
+#define TEST_FILE_SIZE    (8192)
+#define TEST_RECORDS      (600)
+#define TEST_BURST        (40)
+#define TEST_TYPE         (0x10)
+
+struct test_record {
+  uint32_t counter;
+  uint32_t inverse;
+  uint8_t fill[8];
+};
+
+static FATFS g_fat;
+static struct fs_mount_t g_mount = {
+  .type = FS_FATFS,
+  .fs_data = &g_fat,
+  .mnt_point = TEST_MOUNT,
+};
+
+static struct data_logger g_logger;
+static uint8_t g_storage[TEST_BUFFER_SIZE * TEST_BUFFER_COUNT];
+static struct file_io g_io;
+static uint8_t g_file[TEST_FILE_SIZE];
+
+static void test_logger_init(void) {
+  const struct data_logger_config config = {
+    .directory = TEST_DIRECTORY,
+    .storage = g_storage,
+    .buffer_size = TEST_BUFFER_SIZE,
+    .buffer_count = TEST_BUFFER_COUNT,
+    .file_size = TEST_FILE_SIZE,
+    .flush_interval_ms = 0,
+  };
+
+  zassert_ok(data_logger_init(&g_logger, &config));
+}
+
+// Grava em rajadas menores que um buffer, dando tempo ao escritor
+static void test_logger_fill(uint32_t first, uint32_t count) {
+  struct test_record record;
+
+  for (uint32_t i = 0; i < count; i++) {
+    record.counter = first + i;
+    record.inverse = ~record.counter;
+    memset(record.fill, (uint8_t)record.counter, sizeof(record.fill));
+    zassert_ok(data_logger_write(&g_logger, TEST_TYPE, &record, sizeof(record)));
+
+    if ((i % TEST_BURST) == (TEST_BURST - 1)) {
+      k_msleep(5);
+    }
+  }
+}
+
+// Le o arquivo inteiro pelo servico de I/O, como o resto da aplicacao
+static int test_read_file(uint32_t index) {
+  struct fs_file_t file;
+  struct k_poll_signal signal;
+  struct k_poll_event event = K_POLL_EVENT_INITIALIZER(K_POLL_TYPE_SIGNAL,
+                                                       K_POLL_MODE_NOTIFY_ONLY, &signal);
+  struct file_io_request request;
+  const enum file_io_op ops[] = { FILE_IO_OPEN, FILE_IO_READ, FILE_IO_CLOSE };
+  char path[DATA_LOGGER_PATH_MAX];
+  unsigned int signaled;
+  int read = -EIO;
+  int result;
+
+  snprintf(path, sizeof(path), "%s/L%07u.BIN", TEST_DIRECTORY, index);
+
+  for (size_t i = 0; i < ARRAY_SIZE(ops); i++) {
+    memset(&request, 0, sizeof(request));
+    request.op = ops[i];
+    request.file = &file;
+    request.path = path;
+    request.flags = FS_O_READ;
+    request.buffer = g_file;
+    request.length = sizeof(g_file);
+    request.offset = 0;
+    request.signal = &signal;
+
+    k_poll_signal_init(&signal);
+    event.state = K_POLL_STATE_NOT_READY;
+    zassert_ok(file_io_submit(&g_io, &request));
+    zassert_ok(k_poll(&event, 1, K_SECONDS(5)));
+    k_poll_signal_check(&signal, &signaled, &result);
+
+    if ((ops[i] == FILE_IO_OPEN) && (result < 0)) {
+      return result;
+    }
+    if (ops[i] == FILE_IO_READ) {
+      read = result;
+    }
+  }
+
+  return read;
+}
+
+// Confere os registros de um arquivo; devolve o proximo contador esperado
+static uint32_t test_parse_file(size_t size, uint32_t expected) {
+  struct data_logger_record_header header;
+  struct test_record record;
+  size_t pos = 0;
+
+  while (pos + sizeof(header) <= size) {
+    if (g_file[pos] == DATA_LOGGER_TYPE_END) {
+      break;
+    }
+
+    // Preenchimento vai ate o fim do setor
+    if (g_file[pos] == DATA_LOGGER_TYPE_PAD) {
+      pos = ROUND_UP(pos + 1, DATA_LOGGER_SECTOR_SIZE);
+      continue;
+    }
+
+    memcpy(&header, &g_file[pos], sizeof(header));
+    zassert_equal(header.type, TEST_TYPE, "type %02x at %zu", header.type, pos);
+    zassert_equal(header.length, sizeof(record));
+    zassert_true(pos + sizeof(header) + header.length <= size, "record past end");
+
+    memcpy(&record, &g_file[pos + sizeof(header)], sizeof(record));
+    zassert_equal(record.counter, expected, "counter %u, expected %u", record.counter,
+                  expected);
+    zassert_equal(record.inverse, ~expected);
+    zassert_equal(record.fill[sizeof(record.fill) - 1], (uint8_t)expected);
+
+    expected++;
+    pos += sizeof(header) + header.length;
+  }
+
+  return expected;
+}
+
+static uint32_t test_verify_all(uint32_t *files) {
+  uint32_t expected = 0;
+  uint32_t index;
+  int size;
+
+  for (index = 1;; index++) {
+    size = test_read_file(index);
+    if (size == -ENOENT) {
+      break;
+    }
+    // Sem pre-alocacao: o arquivo tem apenas os setores gravados
+    zassert_true((size > 0) && (size <= TEST_FILE_SIZE), "file %u read %d", index, size);
+    zassert_equal(size % DATA_LOGGER_SECTOR_SIZE, 0, "file %u size %d", index, size);
+    expected = test_parse_file(size, expected);
+  }
+
+  *files = index - 1;
+
+  return expected;
+}
+
+static void *test_setup(void) {
+  zassert_ok(fs_mount(&g_mount));
+  zassert_ok(file_io_init(&g_io, "file_io"));
+
+  return NULL;
+}
+
+ZTEST(data_logger, test_write_remount_read) {
+  struct data_logger_stats stats;
+  uint32_t files;
+
+  test_logger_init();
+  test_logger_fill(0, TEST_RECORDS);
+  zassert_ok(data_logger_deinit(&g_logger, K_SECONDS(5)));
+
+  zassert_ok(data_logger_get_stats(&g_logger, &stats));
+  zassert_equal(stats.records, TEST_RECORDS);
+  zassert_equal(stats.dropped, 0);
+  zassert_equal(stats.write_errors, 0);
+  zassert_true(stats.files > 1, "no file rotation (%u)", stats.files);
+
+  // Remontagem: tudo que foi aceito esta no cartao, em ordem
+  zassert_ok(fs_unmount(&g_mount));
+  zassert_ok(fs_mount(&g_mount));
+
+  zassert_equal(test_verify_all(&files), TEST_RECORDS);
+  zassert_equal(files, stats.files);
+
+  // Novo init continua a numeracao sem sobrescrever
+  test_logger_init();
+  test_logger_fill(TEST_RECORDS, TEST_BURST);
+  zassert_ok(data_logger_deinit(&g_logger, K_SECONDS(5)));
+
+  zassert_equal(test_verify_all(&files), TEST_RECORDS + TEST_BURST);
+  zassert_equal(files, stats.files + 1);
+
+  // Segundo init (ex.: sdcard_init apos deinit) nao recria a thread de I/O
+  zassert_ok(file_io_init(&g_io, "file_io"));
+  zassert_equal(test_verify_all(&files), TEST_RECORDS + TEST_BURST);
+  zassert_equal(file_io_get_rejected(&g_io), 0);
+}
+
+ZTEST_SUITE(data_logger, NULL, test_setup, NULL, NULL, NULL);
@@ -0,0 +1,662 @@
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <zephyr/kernel.h>
+#include <zephyr/net/socket.h>
+#include <zephyr/sys/byteorder.h>
+#include <zephyr/ztest.h>
+#include "database.h"
+#include "db_http.h"
+#include "json_stream.h"
+
+#define TEST_PORT           (18080)
+#define TEST_AUTH           "Bearer " CONFIG_APP_HTTP_WRITE_TOKEN
+#define TEST_GROUP_TYPES    (2)
+#define TEST_GROUP_MANY     (3)
+#define TEST_MANY_COUNT     (16)
+#define TEST_RESPONSE_SIZE  (4096)
+#define TEST_PIECE_ALL      (SIZE_MAX)
+
+// Exemplo da RFC 6455
+#define TEST_WS_KEY         "dGhlIHNhbXBsZSBub25jZQ=="
+#define TEST_WS_ACCEPT      "s3pPLMBiTxaQ9kYGJzo+xo4vJkQ="
+#define TEST_WS_FIN         BIT(7)
+#define TEST_WS_OP_CONT     (0x0)
+#define TEST_WS_OP_TEXT     (0x1)
+#define TEST_WS_OP_CLOSE    (0x8)
+#define TEST_WS_OP_PING     (0x9)
+#define TEST_WS_OP_PONG     (0xA)
+
+enum test_types_id {
+  TEST_U8 = 0,
+  TEST_S16,
+  TEST_U32,
+  TEST_F32,
+  TEST_STR,
+  TEST_PWD,
+};
+
+struct test_types {
+  uint8_t u8;
+  int16_t s16;
+  uint32_t u32;
+  float f32;
+  char str[24];
+  char pwd[16];
+};
+
+struct test_sink {
+  char out[256];
+  size_t len;
+  size_t largest;
+  int blocks;
+  int finals;
+  int fail_at;                  // Bloco em que o sink falha (0 nunca)
+};
+
+static struct test_types g_types;
+static int32_t g_many[TEST_MANY_COUNT];
+static char g_response[TEST_RESPONSE_SIZE];
+static char g_body[TEST_RESPONSE_SIZE];
+
+static const struct db_param g_types_params[] = {
+  DB_PARAMS_ADD_B08(TEST_U8,  ACC_LEVEL_USER, VAR_FIELD_NORMAL, "U8",  eU08, g_types.u8,        0,     200,    0),
+  DB_PARAMS_ADD_B16(TEST_S16, ACC_LEVEL_USER, VAR_FIELD_NORMAL, "S16", eS16, g_types.s16, MIN_S16, MAX_S16,    0),
+  DB_PARAMS_ADD_B32(TEST_U32, ACC_LEVEL_USER, VAR_FIELD_NORMAL, "U32", eU32, g_types.u32, MIN_U32, MAX_U32,    0),
+  DB_PARAMS_ADD_F32(TEST_F32, ACC_LEVEL_USER, VAR_FIELD_NORMAL, "F32", eF32, g_types.f32, -1000.0f, 1000.0f, 0.0f),
+  DB_PARAMS_ADD_STR(TEST_STR, ACC_LEVEL_USER, VAR_FIELD_NORMAL, "Str", eSTR, g_types.str,    NULL,    NULL,   ""),
+  DB_PARAMS_ADD_STR(TEST_PWD, ACC_LEVEL_USER, VAR_FIELD_PWD,    "Pwd", eSTR, g_types.pwd,    NULL,    NULL,   ""),
+};
+
+#define TEST_MANY(_n)                                                                          \
+  DB_PARAMS_ADD_B32(_n, ACC_LEVEL_USER, VAR_FIELD_NORMAL, "P" #_n, eS32, g_many[_n], MIN_S32, \
+                    MAX_S32, 0)
+
+// Grupo maior que um bloco e que um lote
+static const struct db_param g_many_params[] = {
+  TEST_MANY(0),  TEST_MANY(1),  TEST_MANY(2),  TEST_MANY(3),
+  TEST_MANY(4),  TEST_MANY(5),  TEST_MANY(6),  TEST_MANY(7),
+  TEST_MANY(8),  TEST_MANY(9),  TEST_MANY(10), TEST_MANY(11),
+  TEST_MANY(12), TEST_MANY(13), TEST_MANY(14), TEST_MANY(15),
+};
+
+static struct db_group g_grp_types = DATABASE_CREATE_GROUP(TEST_GROUP_TYPES, "Types", g_types_params);
+static struct db_group g_grp_many = DATABASE_CREATE_GROUP(TEST_GROUP_MANY, "Many", g_many_params);
+
+static int test_sink(void *ctx, uint8_t *data, size_t len, bool final) {
+  struct test_sink *sink = ctx;
+
+  sink->blocks++;
+  if (sink->blocks == sink->fail_at) {
+    return -EIO;
+  }
+
+  zassert_true((sink->len + len) < sizeof(sink->out));
+  memcpy(&sink->out[sink->len], data, len);
+  sink->len += len;
+  sink->out[sink->len] = '\0';
+  sink->largest = MAX(sink->largest, len);
+  sink->finals += final ? 1 : 0;
+
+  return 0;
+}
+
+static int test_count(const char *text, const char *needle) {
+  int count = 0;
+
+  for (text = strstr(text, needle); text; text = strstr(text + 1, needle)) {
+    count++;
+  }
+
+  return count;
+}
+
+static int test_connect(void) {
+  struct sockaddr_in addr = {.sin_family = AF_INET, .sin_port = htons(TEST_PORT)};
+  struct zsock_timeval tv = {.tv_sec = 2};
+  int fd;
+
+  zsock_inet_pton(AF_INET, "127.0.0.1", &addr.sin_addr);
+
+  fd = zsock_socket(AF_INET, SOCK_STREAM, IPPROTO_TCP);
+  zassert_true(fd >= 0, "socket: %d", errno);
+  zsock_setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, &tv, sizeof(tv));
+
+  if (zsock_connect(fd, (struct sockaddr *)&addr, sizeof(addr)) != 0) {
+    zsock_close(fd);
+    return -errno;
+  }
+
+  return fd;
+}
+
+// Envia em pedacos de piece bytes: o servidor recebe a mensagem em varios recv
+static void test_send(int fd, const void *data, size_t len, size_t piece) {
+  const uint8_t *pos = data;
+  size_t chunk;
+
+  while (len > 0) {
+    chunk = MIN(len, piece);
+    zassert_equal(zsock_send(fd, pos, chunk, 0), chunk);
+    pos += chunk;
+    len -= chunk;
+
+    if (len > 0) {
+      k_msleep(1);
+    }
+  }
+}
+
+static void test_recv_exact(int fd, void *data, size_t len) {
+  uint8_t *pos = data;
+  ssize_t ret;
+
+  while (len > 0) {
+    ret = zsock_recv(fd, pos, len, 0);
+    zassert_true(ret > 0, "recv: %d (%d)", (int)ret, errno);
+    pos += ret;
+    len -= ret;
+  }
+}
+
+// Cabecalho HTTP byte a byte, sem consumir os quadros WebSocket seguintes
+static void test_recv_head(int fd) {
+  size_t len = 0;
+
+  while ((len < 4) || (memcmp(&g_response[len - 4], "\r\n\r\n", 4) != 0)) {
+    zassert_true(len < (sizeof(g_response) - 1));
+    test_recv_exact(fd, &g_response[len++], 1);
+  }
+
+  g_response[len] = '\0';
+}
+
+// Corpo chunked de g_response para g_body; retorna o numero de blocos com dados
+static int test_dechunk(void) {
+  char *pos = strstr(g_response, "\r\n\r\n");
+  unsigned long size;
+  size_t out = 0;
+  char *end;
+  int count = 0;
+
+  g_body[0] = '\0';
+  zassert_not_null(pos, "no header end");
+  pos += 4;
+
+  if (!strstr(g_response, "Transfer-Encoding: chunked\r\n")) {
+    return 0;
+  }
+
+  while (true) {
+    size = strtoul(pos, &end, 16);
+    zassert_true((end != pos) && (strncmp(end, "\r\n", 2) == 0), "bad chunk header");
+    pos = end + 2;
+
+    if (size == 0) {
+      zassert_equal(strcmp(pos, "\r\n"), 0, "bad terminator");
+      break;
+    }
+
+    zassert_true(strlen(pos) >= (size + 2), "short chunk");
+    zassert_true((out + size) < sizeof(g_body));
+    memcpy(&g_body[out], pos, size);
+    out += size;
+    pos += size;
+    zassert_equal(strncmp(pos, "\r\n", 2), 0, "chunk without CRLF");
+    pos += 2;
+    count++;
+  }
+
+  g_body[out] = '\0';
+
+  return count;
+}
+
+/*
+ * Uma requisicao por conexao, como o servidor atende. Retorna o status; o
+ * corpo vai decodificado para g_body e *chunks (se nao NULL) recebe os blocos.
+ */
+static int test_request(const char *request, size_t piece, int *chunks) {
+  size_t len = 0;
+  ssize_t ret;
+  int status = 0;
+  int count;
+  int fd;
+
+  fd = test_connect();
+  zassert_true(fd >= 0, "connect: %d", fd);
+  test_send(fd, request, strlen(request), piece);
+
+  // Connection: close, a resposta termina com o fechamento
+  while (len < (sizeof(g_response) - 1)) {
+    ret = zsock_recv(fd, &g_response[len], sizeof(g_response) - 1 - len, 0);
+    if (ret <= 0) {
+      break;
+    }
+    len += ret;
+  }
+  g_response[len] = '\0';
+  zsock_close(fd);
+
+  zassert_equal(sscanf(g_response, "HTTP/1.1 %d", &status), 1, "no status: %s", g_response);
+
+  count = test_dechunk();
+  if (chunks) {
+    *chunks = count;
+  }
+
+  return status;
+}
+
+static int test_put(const char *path, const char *auth, const char *body) {
+  static char request[CONFIG_APP_HTTP_REQUEST_SIZE];
+
+  snprintf(request, sizeof(request),
+           "PUT %s HTTP/1.1\r\nHost: test\r\n%s%s%sContent-Length: %zu\r\n\r\n%s", path,
+           auth ? "Authorization: " : "", auth ? auth : "", auth ? "\r\n" : "", strlen(body),
+           body);
+
+  return test_request(request, TEST_PIECE_ALL, NULL);
+}
+
+// Quadro do cliente, sempre mascarado
+static size_t test_ws_frame(uint8_t *out, uint8_t opcode, const void *payload, size_t len) {
+  static const uint8_t mask[4] = {0x37, 0xFA, 0x21, 0x3D};
+  const uint8_t *data = payload;
+  size_t pos = 0;
+
+  out[pos++] = TEST_WS_FIN | opcode;
+  if (len < 126) {
+    out[pos++] = BIT(7) | len;
+  } else {
+    out[pos++] = BIT(7) | 126;
+    sys_put_be16(len, &out[pos]);
+    pos += 2;
+  }
+
+  memcpy(&out[pos], mask, sizeof(mask));
+  pos += sizeof(mask);
+
+  for (size_t i = 0; i < len; i++) {
+    out[pos + i] = data[i] ^ mask[i % 4];
+  }
+
+  return pos + len;
+}
+
+// Mensagem do servidor com os fragmentos juntados em g_body; retorna o opcode
+static int test_ws_message(int fd, int *fragments, size_t *length) {
+  uint8_t head[4];
+  size_t len = 0;
+  size_t size;
+  int opcode = -1;
+
+  *fragments = 0;
+
+  do {
+    test_recv_exact(fd, head, 2);
+    zassert_false(head[1] & BIT(7), "server frame masked");
+
+    size = head[1] & 0x7F;
+    zassert_not_equal(size, 127, "unexpected 64-bit length");
+    if (size == 126) {
+      test_recv_exact(fd, &head[2], 2);
+      size = sys_get_be16(&head[2]);
+    }
+
+    if (opcode < 0) {
+      opcode = head[0] & 0x0F;
+    } else {
+      zassert_equal(head[0] & 0x0F, TEST_WS_OP_CONT, "fragment is not a continuation");
+    }
+
+    zassert_true((len + size) < sizeof(g_body));
+    test_recv_exact(fd, &g_body[len], size);
+    len += size;
+    (*fragments)++;
+  } while (!(head[0] & TEST_WS_FIN));
+
+  g_body[len] = '\0';
+  *length = len;
+
+  return opcode;
+}
+
+// Mensagens de texto ate chegar um quadro com o opcode pedido
+static void test_ws_wait(int fd, int opcode) {
+  int fragments;
+  size_t len;
+
+  for (int i = 0; i < 20; i++) {
+    if (test_ws_message(fd, &fragments, &len) == opcode) {
+      return;
+    }
+  }
+
+  ztest_test_fail();
+}
+
+static int test_ws_open(const char *groups) {
+  char request[256];
+  int fd;
+
+  fd = test_connect();
+  zassert_true(fd >= 0, "connect: %d", fd);
+
+  snprintf(request, sizeof(request),
+           "GET /api/ws?groups=%s HTTP/1.1\r\nHost: test\r\nUpgrade: websocket\r\n"
+           "Connection: Upgrade\r\nSec-WebSocket-Key: %s\r\nSec-WebSocket-Version: 13\r\n\r\n",
+           groups, TEST_WS_KEY);
+  test_send(fd, request, strlen(request), 7);
+
+  test_recv_head(fd);
+  zassert_equal(strncmp(g_response, "HTTP/1.1 101 ", 13), 0, "%s", g_response);
+  zassert_not_null(strstr(g_response, "Sec-WebSocket-Accept: " TEST_WS_ACCEPT "\r\n"));
+
+  return fd;
+}
+
+static void *test_setup(void) {
+  int fd = -1;
+
+  db_init();
+  zassert_ok(db_group_add(&g_grp_types));
+  zassert_ok(db_group_add(&g_grp_many));
+  zassert_ok(db_http_init(TEST_PORT));
+
+  // O listener sobe em segundo plano
+  for (int i = 0; (i < 100) && (fd < 0); i++) {
+    k_msleep(20);
+    fd = test_connect();
+  }
+
+  zassert_true(fd >= 0, "server not listening");
+  zsock_close(fd);
+
+  return NULL;
+}
+
+static void test_before(void *fixture) {
+  ARG_UNUSED(fixture);
+
+  memset(&g_types, 0, sizeof(g_types));
+  memset(g_many, 0, sizeof(g_many));
+}
+
+ZTEST(db_http, test_json_stream_blocks) {
+  const char *expected = "{\"s\":\"a\\\"b\\\\c\\n\\u0001\",\"min\":-9223372036854775808,"
+                         "\"max\":18446744073709551615,\"nan\":null,\"f\":1.5,"
+                         "\"a\":[true,null,{}],\"cut\":\"abc\"}";
+  struct test_sink sink = {0};
+  struct json_stream js;
+  uint8_t buf[7];
+
+  // Buffer de 7 bytes: escapes, numeros e chaves cruzam a borda do bloco
+  json_stream_init(&js, buf, sizeof(buf), test_sink, &sink);
+  json_stream_obj_start(&js, NULL);
+  json_stream_str(&js, "s", "a\"b\\c\n\x01", SIZE_MAX);
+  json_stream_int(&js, "min", INT64_MIN);
+  json_stream_uint(&js, "max", UINT64_MAX);
+  json_stream_double(&js, "nan", NAN, 7);
+  json_stream_double(&js, "f", 1.5, 7);
+  json_stream_arr_start(&js, "a");
+  json_stream_bool(&js, NULL, true);
+  json_stream_null(&js, NULL);
+  json_stream_obj_start(&js, NULL);
+  json_stream_obj_end(&js);
+  json_stream_arr_end(&js);
+  json_stream_str(&js, "cut", "abcdef", 3);
+  json_stream_obj_end(&js);
+
+  zassert_ok(json_stream_end(&js));
+  zassert_str_equal(sink.out, expected);
+  zassert_equal(sink.blocks, DIV_ROUND_UP(strlen(expected) + 1, sizeof(buf)));
+  zassert_equal(sink.largest, sizeof(buf));
+  zassert_equal(sink.finals, 1);
+
+  // Depois do erro do sink nada mais e entregue
+  memset(&sink, 0, sizeof(sink));
+  sink.fail_at = 2;
+  json_stream_init(&js, buf, sizeof(buf), test_sink, &sink);
+  json_stream_str(&js, NULL, "0123456789abcdefghij", SIZE_MAX);
+  zassert_equal(json_stream_end(&js), -EIO);
+  zassert_equal(sink.blocks, 2);
+
+  // Aninhamento alem do limite
+  memset(&sink, 0, sizeof(sink));
+  json_stream_init(&js, buf, sizeof(buf), test_sink, &sink);
+  for (int i = 0; i < (JSON_STREAM_MAX_DEPTH + 1); i++) {
+    json_stream_arr_start(&js, NULL);
+  }
+  zassert_equal(json_stream_end(&js), -E2BIG);
+}
+
+ZTEST(db_http, test_get_chunked) {
+  int chunks;
+
+  for (int i = 0; i < TEST_MANY_COUNT; i++) {
+    g_many[i] = -100000 - i;
+  }
+
+  // Requisicao byte a byte; resposta em varios blocos e lotes
+  zassert_equal(test_request("GET /api/groups/3 HTTP/1.1\r\nHost: test\r\n\r\n", 1, &chunks),
+                200);
+  zassert_true(chunks > 1, "%d chunks", chunks);
+  zassert_equal(test_count(g_body, "\"name\":\"P"), TEST_MANY_COUNT);
+  zassert_not_null(strstr(g_body, "\"name\":\"P15\""));
+  zassert_not_null(strstr(g_body, "\"value\":-100015}"));
+  zassert_equal(g_body[strlen(g_body) - 1], '}');
+  zassert_not_null(strstr(g_response, "Content-Type: application/json\r\n"));
+  zassert_is_null(strstr(g_response, "Access-Control-"), "CORS without an origin");
+
+  zassert_equal(test_request("GET /api/groups HTTP/1.1\r\n\r\n", TEST_PIECE_ALL, NULL), 200);
+  zassert_not_null(strstr(g_body, "{\"id\":3,\"name\":\"Many\",\"count\":16}"));
+
+  // Senha fora da listagem e do acesso direto
+  zassert_equal(test_request("GET /api/groups/2 HTTP/1.1\r\n\r\n", TEST_PIECE_ALL, NULL), 200);
+  zassert_not_null(strstr(g_body, "\"name\":\"Str\""));
+  zassert_is_null(strstr(g_body, "Pwd"));
+  zassert_equal(test_request("GET /api/groups/2/5 HTTP/1.1\r\n\r\n", TEST_PIECE_ALL, NULL), 404);
+}
+
+ZTEST(db_http, test_put_strings) {
+  static const char *const rejected[] = {
+      "\"\\x41\"",                      // Escape desconhecido
+      "\"\\u12G4\"",                    // Hexa invalido
+      "\"\\u12\"",                      // Escape curto
+      "\"\\ud83d\"",                    // Surrogate alto sem o par
+      "\"\\ude00x\"",                   // Surrogate baixo solto
+      "\"\\u0000\"",                    // Terminador no meio
+      "\"a\tb\"",                       // Controle sem escape
+      "\"abc",                          // Sem fechar
+      "\"01234567890123456789abcd\"",   // Nao cabe com o terminador
+      "42",
+  };
+
+  zassert_equal(test_put("/api/groups/2/4", TEST_AUTH,
+                         "\"a\\\"b\\\\\\/\\n\\u00e9\\u20AC\\ud83d\\ude00\""),
+                200);
+  zassert_str_equal(g_types.str, "a\"b\\/\n\xc3\xa9\xe2\x82\xac\xf0\x9f\x98\x80");
+
+  for (size_t i = 0; i < ARRAY_SIZE(rejected); i++) {
+    zassert_equal(test_put("/api/groups/2/4", TEST_AUTH, rejected[i]), 400, "%s", rejected[i]);
+  }
+  zassert_str_equal(g_types.str, "a\"b\\/\n\xc3\xa9\xe2\x82\xac\xf0\x9f\x98\x80");
+
+  // Escapes na saida voltam ao mesmo texto
+  zassert_equal(test_request("GET /api/groups/2/4 HTTP/1.1\r\n\r\n", TEST_PIECE_ALL, NULL), 200);
+  zassert_not_null(strstr(g_body, "\"value\":\"a\\\"b\\\\/\\n\xc3\xa9"), "%s", g_body);
+}
+
+ZTEST(db_http, test_put_numbers) {
+  static const char *const rejected[] = {
+      "{\"U8\":201}",                   // Faixa da base
+      "{\"U8\":256}",                   // Faixa do tipo
+      "{\"U8\":-1}",
+      "{\"U8\":1.5}",
+      "{\"U8\":\"7\"}",
+      "{\"U8\":12abc}",
+      "{\"S16\":32768}",
+      "{\"S16\":-32769}",
+      "{\"U32\":4294967296}",
+      "{\"U32\":-1}",
+      "{\"U32\":99999999999999999999}",
+      "{\"F32\":1e39}",
+      "{\"F32\":2000}",
+      "{\"U8\":5,\"S16\":99999}",       // Tudo ou nada
+  };
+
+  zassert_equal(test_put("/api/groups/2", TEST_AUTH,
+                         "{\"U8\":200,\"S16\":-32768,\"U32\":4294967295,\"F32\":-1.5e2}"),
+                200);
+  zassert_equal(g_types.u8, 200);
+  zassert_equal(g_types.s16, INT16_MIN);
+  zassert_equal(g_types.u32, UINT32_MAX);
+  zassert_equal(g_types.f32, -150.0f);
+
+  // Chave por id
+  zassert_equal(test_put("/api/groups/2", TEST_AUTH, " { \"0\" : 7 } "), 200);
+  zassert_equal(g_types.u8, 7);
+
+  for (size_t i = 0; i < ARRAY_SIZE(rejected); i++) {
+    zassert_equal(test_put("/api/groups/2", TEST_AUTH, rejected[i]), 400, "%s", rejected[i]);
+  }
+
+  zassert_equal(g_types.u8, 7);
+  zassert_equal(g_types.s16, INT16_MIN);
+  zassert_equal(g_types.u32, UINT32_MAX);
+  zassert_equal(g_types.f32, -150.0f);
+
+  zassert_equal(test_put("/api/groups/2", TEST_AUTH, "{\"Nope\":1}"), 404);
+  zassert_equal(test_put("/api/groups/2", TEST_AUTH, "{\"Pwd\":\"x\"}"), 404);
+}
+
+ZTEST(db_http, test_write_auth) {
+  zassert_equal(test_put("/api/groups/2/0", NULL, "9"), 401);
+  zassert_not_null(strstr(g_response, "WWW-Authenticate: Bearer\r\n"));
+  zassert_equal(test_put("/api/groups/2/0", "Bearer wrong", "9"), 401);
+  zassert_equal(test_put("/api/groups/2/0", TEST_AUTH "x", "9"), 401);
+  zassert_equal(test_put("/api/groups/2/0", "Basic dGVzdDp0ZXN0", "9"), 401);
+  zassert_equal(g_types.u8, 0);
+
+  zassert_equal(test_put("/api/groups/2/0", "bearer " CONFIG_APP_HTTP_WRITE_TOKEN, "9"), 200);
+  zassert_equal(g_types.u8, 9);
+
+  // Preflight sem origem configurada: nenhum cabecalho CORS
+  zassert_equal(test_request("OPTIONS /api/groups/2 HTTP/1.1\r\n\r\n", TEST_PIECE_ALL, NULL),
+                204);
+  zassert_is_null(strstr(g_response, "Access-Control-"));
+}
+
+ZTEST(db_http, test_malformed) {
+  static char request[CONFIG_APP_HTTP_REQUEST_SIZE + 1];
+  struct db_http_stats start;
+  struct db_http_stats end;
+  size_t len;
+
+  db_http_get_stats(&start);
+
+  // Cabecalhos que enchem o buffer sem terminar
+  len = snprintf(request, sizeof(request), "GET /api/groups HTTP/1.1\r\nX-Fill: ");
+  memset(&request[len], 'A', CONFIG_APP_HTTP_REQUEST_SIZE - len);
+  request[CONFIG_APP_HTTP_REQUEST_SIZE] = '\0';
+  zassert_equal(test_request(request, 100, NULL), 413);
+
+  zassert_equal(test_request("PUT /api/groups/2/0 HTTP/1.1\r\nContent-Length: 5000\r\n\r\n",
+                             TEST_PIECE_ALL, NULL),
+                413);
+  zassert_equal(test_request("PUT /api/groups/2/0 HTTP/1.1\r\nContent-Length: abc\r\n\r\n",
+                             TEST_PIECE_ALL, NULL),
+                400);
+  zassert_equal(test_request("PUT /api/groups/2/0 HTTP/1.1\r\nContent-Length: -1\r\n\r\n",
+                             TEST_PIECE_ALL, NULL),
+                400);
+  zassert_equal(test_request("BREW /api/groups HTTP/1.1\r\n\r\n", TEST_PIECE_ALL, NULL), 405);
+  zassert_equal(test_request("GET /api/groups\r\n\r\n", TEST_PIECE_ALL, NULL), 400);
+  zassert_equal(test_request("GET /api/groups FTP/1.0\r\n\r\n", TEST_PIECE_ALL, NULL), 400);
+  zassert_equal(test_request("GARBAGE\r\n\r\n", TEST_PIECE_ALL, NULL), 400);
+
+  zassert_equal(test_request("GET /api/groups/99 HTTP/1.1\r\n\r\n", TEST_PIECE_ALL, NULL), 404);
+  zassert_equal(test_request("GET /api/groups/2/x HTTP/1.1\r\n\r\n", TEST_PIECE_ALL, NULL), 404);
+  zassert_equal(test_request("GET /api/other HTTP/1.1\r\n\r\n", TEST_PIECE_ALL, NULL), 404);
+  zassert_equal(test_put("/api/groups", TEST_AUTH, "{}"), 405);
+
+  zassert_equal(test_put("/api/groups/2", TEST_AUTH, "{\"U8\":}"), 400);
+  zassert_equal(test_put("/api/groups/2", TEST_AUTH, "{\"U8\":1"), 400);
+  zassert_equal(test_put("/api/groups/2", TEST_AUTH, "{}"), 400);
+  zassert_equal(test_put("/api/groups/2/0", TEST_AUTH, "1 2"), 400);
+  zassert_equal(test_put("/api/groups/2/0", TEST_AUTH, ""), 400);
+  zassert_equal(g_types.u8, 0);
+
+  // Corpo que chega depois da cabeca, em pedacos
+  snprintf(request, sizeof(request),
+           "PUT /api/groups/2 HTTP/1.1\r\nAuthorization: %s\r\nContent-Length: 10\r\n\r\n"
+           "{\"U8\":123}",
+           TEST_AUTH);
+  zassert_equal(test_request(request, 3, NULL), 200);
+  zassert_equal(g_types.u8, 123);
+
+  db_http_get_stats(&end);
+  zassert_true((end.errors - start.errors) >= 17, "%u errors", end.errors - start.errors);
+}
+
+ZTEST(db_http, test_websocket) {
+  static uint8_t frames[512];
+  uint8_t data[200];
+  struct db_http_stats stats;
+  uint32_t dropped;
+  size_t len;
+  size_t pos;
+  int fragments;
+  int fd;
+
+  fd = test_ws_open("3");
+
+  // Retrato completo maior que um bloco: TEXT e continuacoes
+  zassert_equal(test_ws_message(fd, &fragments, &len), TEST_WS_OP_TEXT);
+  zassert_true(fragments > 1, "%d fragments", fragments);
+  zassert_not_null(strstr(g_body, "\"full\":true"));
+  zassert_equal(test_count(g_body, "\"group\":3"), TEST_MANY_COUNT);
+
+  // Depois so o que mudou
+  zassert_equal(db_acc_set_s32(ACC_LEVEL_FACTORY, TEST_GROUP_MANY, 5, 777), DB_UPDATED);
+  zassert_equal(test_ws_message(fd, &fragments, &len), TEST_WS_OP_TEXT);
+  zassert_not_null(strstr(g_body, "\"full\":false"), "%s", g_body);
+  zassert_not_null(strstr(g_body, "{\"group\":3,\"id\":5,\"value\":777}"), "%s", g_body);
+  zassert_equal(test_count(g_body, "\"group\":"), 1);
+
+  // Dados (tamanho de 16 bits) e ping picados em pedacos de 5 bytes
+  memset(data, 'd', sizeof(data));
+  pos = test_ws_frame(frames, TEST_WS_OP_TEXT, data, sizeof(data));
+  pos += test_ws_frame(&frames[pos], TEST_WS_OP_PING, "ping-42", 7);
+  test_send(fd, frames, pos, 5);
+
+  test_ws_wait(fd, TEST_WS_OP_PONG);
+  zassert_mem_equal(g_body, "ping-42", 7);
+
+  // Close: o servidor responde com o mesmo codigo e fecha
+  pos = test_ws_frame(frames, TEST_WS_OP_CLOSE, "\x03\xe8", 2);
+  test_send(fd, frames, pos, TEST_PIECE_ALL);
+  test_ws_wait(fd, TEST_WS_OP_CLOSE);
+  zassert_mem_equal(g_body, "\x03\xe8", 2);
+  zassert_equal(zsock_recv(fd, data, sizeof(data), 0), 0);
+  zsock_close(fd);
+
+  // Quadro sem mascara derruba o assinante
+  db_http_get_stats(&stats);
+  dropped = stats.ws_dropped;
+
+  fd = test_ws_open("2");
+  zassert_equal(test_ws_message(fd, &fragments, &len), TEST_WS_OP_TEXT);
+  test_send(fd, "\x89\x00", 2, TEST_PIECE_ALL);
+  zassert_equal(zsock_recv(fd, data, sizeof(data), 0), 0);
+  zsock_close(fd);
+
+  k_msleep(2 * CONFIG_APP_HTTP_WS_PERIOD_MS);
+  db_http_get_stats(&stats);
+  zassert_equal(stats.ws_dropped, dropped + 1);
+  zassert_equal(stats.ws_clients, 0);
+}
+
+ZTEST_SUITE(db_http, NULL, test_setup, test_before, NULL, NULL);
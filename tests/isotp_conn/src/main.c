@@ -0,0 +1,132 @@
+#include <string.h>
+#include <zephyr/canbus/isotp.h>
+#include <zephyr/kernel.h>
+#include <zephyr/net_buf.h>
+#include <zephyr/ztest.h>
+#include "isotp_conn.h"
+
+// Par de IDs do UDS: requisicao do tester e resposta da aplicacao
+#define TEST_REQ_ADDR   (0x7E0)
+#define TEST_RESP_ADDR  (0x7E8)
+#define TEST_MSG_LEN    (100)           // Primeiro quadro + varios consecutivos
+#define TEST_TIMEOUT    K_SECONDS(2)
+
+static const struct device *g_can_dev = DEVICE_DT_GET(DT_CHOSEN(zephyr_canbus));
+static const struct isotp_fc_opts g_fc_opts = {.bs = 8, .stmin = 0};
+
+// Lado do tester: recebe no ID de resposta e manda flow control no de requisicao
+static struct isotp_recv_ctx g_tester_rx;
+static struct isotp_send_ctx g_tester_tx;
+static struct isotp_msg_id g_req_id = {.std_id = TEST_REQ_ADDR};
+static struct isotp_msg_id g_resp_id = {.std_id = TEST_RESP_ADDR};
+
+static K_SEM_DEFINE(g_tx_done, 0, 1);
+static K_SEM_DEFINE(g_rx_done, 0, 1);
+static int g_tx_error;
+static uint8_t g_rx_data[TEST_MSG_LEN];
+static size_t g_rx_len;
+
+static void test_tx_cb(int error, uint32_t addr, void *user_data) {
+  ARG_UNUSED(addr);
+  ARG_UNUSED(user_data);
+
+  g_tx_error = error;
+  k_sem_give(&g_tx_done);
+}
+
+static void test_rx_handler(uint32_t rx_addr, struct net_buf *buf, void *user_data) {
+  ARG_UNUSED(rx_addr);
+  ARG_UNUSED(user_data);
+
+  g_rx_len = net_buf_linearize(g_rx_data, sizeof(g_rx_data), buf, 0, net_buf_frags_len(buf));
+  k_sem_give(&g_rx_done);
+}
+
+static void test_fill(uint8_t *data, size_t len, uint8_t seed) {
+  for (size_t i = 0; i < len; i++) {
+    data[i] = (uint8_t)(seed + i);
+  }
+}
+
+// Resposta da aplicacao como o tester a ve
+static void test_tester_recv(uint8_t *data, size_t len) {
+  size_t total = 0;
+  int ret;
+
+  while (total < len) {
+    ret = isotp_recv(&g_tester_rx, data + total, len - total, TEST_TIMEOUT);
+    zassert_true(ret > 0, "tester recv: %d after %u bytes", ret, total);
+    total += ret;
+  }
+}
+
+static void *test_setup(void) {
+  zassert_true(device_is_ready(g_can_dev));
+  zassert_ok(isotp_conn_init());
+
+  zassert_ok(isotp_conn_bind(TEST_REQ_ADDR, TEST_RESP_ADDR));
+  zassert_ok(isotp_conn_rx_register(TEST_REQ_ADDR, ISOTP_CONN_ANY_SERVICE, test_rx_handler,
+                                    NULL));
+
+  zassert_equal(isotp_bind(&g_tester_rx, g_can_dev, &g_resp_id, &g_req_id, &g_fc_opts,
+                           K_FOREVER),
+                ISOTP_N_OK);
+
+  return NULL;
+}
+
+static void test_before(void *fixture) {
+  ARG_UNUSED(fixture);
+
+  k_sem_reset(&g_tx_done);
+  k_sem_reset(&g_rx_done);
+  g_tx_error = -1;
+  g_rx_len = 0;
+}
+
+// Resposta de varios quadros: o flow control chega no ID da requisicao, o mesmo
+// que a recepcao da aplicacao ja filtra
+ZTEST(isotp_conn, test_multi_frame_response) {
+  uint8_t sent[TEST_MSG_LEN];
+  uint8_t received[TEST_MSG_LEN];
+
+  test_fill(sent, sizeof(sent), 0x10);
+
+  zassert_ok(isotp_conn_send(TEST_RESP_ADDR, TEST_REQ_ADDR, sent, sizeof(sent),
+                             ISOTP_CONN_PRIO_URGENT, K_NO_WAIT, test_tx_cb, NULL));
+
+  test_tester_recv(received, sizeof(received));
+  zassert_mem_equal(received, sent, sizeof(sent));
+
+  zassert_ok(k_sem_take(&g_tx_done, TEST_TIMEOUT));
+  zassert_equal(g_tx_error, ISOTP_N_OK, "send error %d", g_tx_error);
+}
+
+// Requisicao longa do tester e resposta longa logo em seguida, como no UDS
+ZTEST(isotp_conn, test_request_response) {
+  uint8_t request[TEST_MSG_LEN];
+  uint8_t response[TEST_MSG_LEN];
+  uint8_t received[TEST_MSG_LEN];
+
+  test_fill(request, sizeof(request), 0x80);
+  test_fill(response, sizeof(response), 0x40);
+
+  zassert_equal(isotp_send(&g_tester_tx, g_can_dev, request, sizeof(request), &g_req_id,
+                           &g_resp_id, NULL, NULL),
+                ISOTP_N_OK);
+
+  zassert_ok(k_sem_take(&g_rx_done, TEST_TIMEOUT));
+  zassert_equal(g_rx_len, sizeof(request));
+  zassert_mem_equal(g_rx_data, request, sizeof(request));
+
+  zassert_ok(isotp_conn_send(TEST_RESP_ADDR, TEST_REQ_ADDR, response, sizeof(response),
+                             ISOTP_CONN_PRIO_URGENT, K_NO_WAIT, test_tx_cb, NULL));
+
+  test_tester_recv(received, sizeof(received));
+  zassert_mem_equal(received, response, sizeof(response));
+
+  zassert_ok(k_sem_take(&g_tx_done, TEST_TIMEOUT));
+  zassert_equal(g_tx_error, ISOTP_N_OK, "send error %d", g_tx_error);
+}
+
+ZTEST_SUITE(isotp_conn, NULL, test_setup, test_before, NULL, NULL);
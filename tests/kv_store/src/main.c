@@ -0,0 +1,172 @@
+#include <string.h>
+#include <zephyr/device.h>
+#include <zephyr/drivers/eeprom.h>
+#include <zephyr/kernel.h>
+#include <zephyr/ztest.h>
+#include "eeprom_lib.h"
+#include "kv_store.h"
+
+// Mesma regiao que o eeprom_lib usa no overlay de 4 KB
+#define TEST_BASE         (0)
+#define TEST_SECTOR_SIZE  (1024)
+#define TEST_SECTORS      (4)
+#define TEST_REGION       (TEST_SECTOR_SIZE * TEST_SECTORS)
+#define TEST_UPDATES      (500)
+#define TEST_PAGE         CONFIG_APP_EEPROM_CACHE_PAGE_SIZE
+#define TEST_CACHE_PAGES  (8)           // EEPROM_CACHE_PAGES
+
+static const struct device *const g_dev = DEVICE_DT_GET(DT_ALIAS(eeprom_0));
+static struct kv_store g_kv;
+static uint8_t g_raw[TEST_REGION];
+static uint8_t g_cached[TEST_REGION];
+
+// Remontagem: descarrega o cache e reconstroi o indice lendo os setores
+static void test_remount(struct kv_store *kv) {
+  zassert_ok(eeprom_lib_sync());
+  zassert_ok(kv_store_init(kv, TEST_BASE, TEST_SECTOR_SIZE, TEST_SECTORS));
+}
+
+static void test_check_u32(struct kv_store *kv, uint16_t key, uint32_t expected) {
+  uint32_t value = 0;
+
+  zassert_equal(kv_store_read(kv, key, &value, sizeof(value)), sizeof(value));
+  zassert_equal(value, expected, "key %u: %u, expected %u", key, value, expected);
+}
+
+static void *test_setup(void) {
+  zassert_true(device_is_ready(g_dev));
+  zassert_ok(eeprom_lib_init());
+
+  return NULL;
+}
+
+// Cada teste comeca com a regiao apagada
+static void test_before(void *fixture) {
+  ARG_UNUSED(fixture);
+
+  memset(g_raw, 0, sizeof(g_raw));
+  zassert_ok(eeprom_lib_write(TEST_BASE, g_raw, sizeof(g_raw)));
+  test_remount(&g_kv);
+}
+
+ZTEST(kv_store, test_write_remount_read) {
+  struct kv_store remounted;
+  struct kv_store_stats stats;
+  const uint8_t mask[4] = { 0x01, 0x00, 0x80, 0x10 };
+  uint8_t value[sizeof(mask)];
+
+  // Atualizacoes frequentes forcam varias voltas no anel
+  for (uint32_t i = 1; i <= TEST_UPDATES; i++) {
+    zassert_ok(kv_store_write(&g_kv, EEPROM_KV_RUN_HOURS, &i, sizeof(i)));
+    if ((i % 10) == 0) {
+      uint32_t cycles = i / 10;
+
+      zassert_ok(kv_store_write(&g_kv, EEPROM_KV_VALVE_CYCLES + 3, &cycles, sizeof(cycles)));
+    }
+  }
+  zassert_ok(kv_store_write(&g_kv, EEPROM_KV_ALARM_MEM_MASK, mask, sizeof(mask)));
+
+  zassert_ok(kv_store_get_stats(&g_kv, &stats));
+  zassert_true(stats.compactions >= TEST_SECTORS, "only %u compactions", stats.compactions);
+
+  test_remount(&remounted);
+  test_check_u32(&remounted, EEPROM_KV_RUN_HOURS, TEST_UPDATES);
+  test_check_u32(&remounted, EEPROM_KV_VALVE_CYCLES + 3, TEST_UPDATES / 10);
+  zassert_equal(kv_store_read(&remounted, EEPROM_KV_ALARM_MEM_MASK, value, sizeof(value)),
+                sizeof(value));
+  zassert_mem_equal(value, mask, sizeof(mask));
+  zassert_equal(kv_store_read(&remounted, EEPROM_KV_VALVE_CYCLES, value, sizeof(value)),
+                -ENOENT);
+
+  // Depois do sync o dispositivo tem o mesmo conteudo que o cache
+  zassert_ok(eeprom_read(g_dev, TEST_BASE, g_raw, sizeof(g_raw)));
+  zassert_ok(eeprom_lib_read(TEST_BASE, g_cached, sizeof(g_cached)));
+  zassert_mem_equal(g_raw, g_cached, sizeof(g_raw));
+}
+
+ZTEST(kv_store, test_unchanged_and_delete) {
+  struct kv_store remounted;
+  struct kv_store_stats stats;
+  uint32_t hours = 1234;
+
+  zassert_ok(kv_store_write(&g_kv, EEPROM_KV_RUN_HOURS, &hours, sizeof(hours)));
+  zassert_ok(kv_store_write(&g_kv, EEPROM_KV_RUN_HOURS, &hours, sizeof(hours)));
+  zassert_ok(kv_store_get_stats(&g_kv, &stats));
+  zassert_equal(stats.writes, 1);
+  zassert_equal(stats.unchanged, 1);
+
+  zassert_ok(kv_store_delete(&g_kv, EEPROM_KV_RUN_HOURS));
+  zassert_equal(kv_store_read(&g_kv, EEPROM_KV_RUN_HOURS, &hours, sizeof(hours)), -ENOENT);
+
+  // A exclusao sobrevive a remontagem
+  test_remount(&remounted);
+  zassert_equal(kv_store_read(&remounted, EEPROM_KV_RUN_HOURS, &hours, sizeof(hours)),
+                -ENOENT);
+}
+
+// Paginas longe dos headers de setor que o kv_store_init le e formata
+static size_t test_page_addr(uint32_t page) {
+  return TEST_BASE + (2 * TEST_SECTOR_SIZE) + ((page + 2) * TEST_PAGE);
+}
+
+static bool test_device_page_is(uint32_t page, uint8_t fill) {
+  uint8_t raw[TEST_PAGE];
+
+  zassert_ok(eeprom_read(g_dev, test_page_addr(page), raw, sizeof(raw)));
+  for (size_t i = 0; i < sizeof(raw); i++) {
+    if (raw[i] != fill) {
+      return false;
+    }
+  }
+
+  return true;
+}
+
+ZTEST(kv_store, test_cache_eviction) {
+  struct eeprom_lib_stats before;
+  struct eeprom_lib_stats stats;
+  uint8_t data[TEST_PAGE];
+  const uint32_t count = TEST_CACHE_PAGES + 2;
+
+  // Cache limpo: a formatacao do test_before ja esta no dispositivo
+  zassert_ok(eeprom_lib_sync());
+  zassert_ok(eeprom_lib_get_stats(&before));
+
+  // Escrita i vai para a pagina count - 1 - i (enderecos decrescentes) com 0x10 + i
+  for (uint32_t i = 0; i < TEST_CACHE_PAGES; i++) {
+    memset(data, 0x10 + i, sizeof(data));
+    zassert_ok(eeprom_lib_write(test_page_addr(count - 1 - i), data, sizeof(data)));
+  }
+
+  // Um acerto na primeira pagina a torna a mais recente
+  data[0] = 0xEE;
+  zassert_ok(eeprom_lib_write(test_page_addr(count - 1), data, 1));
+
+  // Duas paginas novas: saem as duas sujas menos usadas (escritas 1 e 2)
+  for (uint32_t i = TEST_CACHE_PAGES; i < count; i++) {
+    memset(data, 0x10 + i, sizeof(data));
+    zassert_ok(eeprom_lib_write(test_page_addr(count - 1 - i), data, sizeof(data)));
+  }
+
+  zassert_ok(eeprom_lib_get_stats(&stats));
+  zassert_equal(stats.page_flushes - before.page_flushes, 2);
+  zassert_true(test_device_page_is(count - 2, 0x11));
+  zassert_true(test_device_page_is(count - 3, 0x12));
+  zassert_true(test_device_page_is(count - 1, 0x00), "hit page evicted");
+  zassert_true(test_device_page_is(count - 4, 0x00), "page written before sync");
+
+  // O sync grava as demais, uma transferencia por pagina
+  zassert_ok(eeprom_lib_sync());
+  zassert_ok(eeprom_lib_get_stats(&stats));
+  zassert_equal(stats.page_flushes - before.page_flushes, count);
+  zassert_equal(stats.bus_writes - before.bus_writes, count);
+
+  zassert_ok(eeprom_read(g_dev, test_page_addr(count - 1), data, sizeof(data)));
+  zassert_equal(data[0], 0xEE);
+  zassert_equal(data[1], 0x10);
+  for (uint32_t i = 1; i < count; i++) {
+    zassert_true(test_device_page_is(count - 1 - i, 0x10 + i), "page %u", count - 1 - i);
+  }
+}
+
+ZTEST_SUITE(kv_store, NULL, test_setup, test_before, NULL, NULL);
@@ -0,0 +1,194 @@
+#!/usr/bin/env python3
+"""Recebe o streaming UDP do db_scope, confere a continuidade e grava CSV.
+
+Formato (little endian), igual a libraries/db_scope/db_scope.h:
+  cabecalho: versao u8, tipo u8, canais u8, flags u8, seq u32, amostra u32,
+             tempo_us u64, periodo_us u32, amostras u16, tamanho u16
+  dados    : amostras x tamanho bytes, canais na ordem do layout
+  layout   : canais x (did u16, tipo u8, tamanho u8)
+
+Sem o layout os quadros de dados sao ignorados; ele chega no start e a cada
+CONFIG_APP_SCOPE_LAYOUT_MS. Cada segundo sai uma linha com a taxa, as perdas
+e o maior desvio do tempo dos quadros sobre a grade nominal:
+
+  python3 tools/db_scope.py --port 5005 --csv scope.csv
+  python3 tools/db_scope.py --seconds 10 --check   # falha com perdas
+"""
+
+import argparse
+import csv
+import socket
+import struct
+import sys
+import time
+
+VERSION = 1
+TYPE_DATA = 0
+TYPE_LAYOUT = 1
+FLAG_START = 0x01
+HEADER = struct.Struct("<BBBBIIQIHH")
+CHANNEL = struct.Struct("<HBB")
+
+# enum variable_type (common/utils/typedefs.h)
+FORMATS = {
+    0: "?", 1: "B", 2: "H", 3: "I", 4: "b", 5: "h", 6: "i",
+    7: "f", 8: "d", 9: "q", 10: "Q",
+}
+
+
+class Stream:
+    def __init__(self, writer):
+        self.writer = writer
+        self.channels = None
+        self.sample = None
+        self.reset_counters()
+        self.total = {"frames": 0, "samples": 0, "lost_frames": 0,
+                      "lost_samples": 0, "reordered": 0, "jitter_us": 0}
+        self.seq = None
+        self.next_sample = None
+        self.origin = None
+
+    def reset_counters(self):
+        self.window = {"frames": 0, "samples": 0, "lost_frames": 0,
+                       "lost_samples": 0, "reordered": 0, "jitter_us": 0}
+
+    def count(self, key, value=1):
+        self.window[key] += value
+        self.total[key] += value
+
+    def jitter(self, value):
+        self.window["jitter_us"] = max(self.window["jitter_us"], value)
+        self.total["jitter_us"] = max(self.total["jitter_us"], value)
+
+    def layout(self, count, payload):
+        channels = []
+        for i in range(count):
+            did, kind, size = CHANNEL.unpack_from(payload, i * CHANNEL.size)
+            fmt = FORMATS.get(kind)
+            if fmt is None or struct.calcsize("<" + fmt) != size:
+                raise ValueError("channel %04x: unknown type %d" % (did, kind))
+            channels.append((did, fmt))
+
+        # Layout repetido nao muda nada; um novo abre outra tabela no CSV
+        if channels != self.channels:
+            self.sample = struct.Struct("<" + "".join(fmt for _, fmt in channels))
+            self.channels = channels
+            if self.writer:
+                self.writer.writerow(["sample", "time_us"] + [
+                    "%02x.%02x" % (did >> 8, did & 0xFF) for did, _ in channels])
+
+    def data(self, flags, seq, first, time_us, period, count, size, payload):
+        if self.channels is None or size != self.sample.size:
+            return False
+
+        # Start: sequencias e grade de tempo recomecam
+        if flags & FLAG_START or self.seq is None:
+            self.seq = seq
+            self.next_sample = first
+            self.origin = (first, time_us)
+
+        if seq < self.seq:
+            self.count("reordered")
+            return True
+        if seq > self.seq:
+            self.count("lost_frames", seq - self.seq)
+        if first > self.next_sample:
+            self.count("lost_samples", first - self.next_sample)
+
+        self.seq = seq + 1
+        self.next_sample = first + count
+
+        # Tempo do quadro contra a grade do start (atraso de agendamento)
+        nominal = self.origin[1] + (first - self.origin[0]) * period
+        self.jitter(abs(time_us - nominal))
+
+        self.count("frames")
+        self.count("samples", count)
+
+        if self.writer:
+            for i in range(count):
+                values = self.sample.unpack_from(payload, i * size)
+                self.writer.writerow([first + i, time_us + i * period] + list(values))
+
+        return True
+
+    def feed(self, datagram):
+        version, kind, channels, flags, seq, first, time_us, period, count, size = \
+            HEADER.unpack_from(datagram)
+        if version != VERSION:
+            raise ValueError("unknown version %d" % version)
+
+        payload = datagram[HEADER.size:]
+        if kind == TYPE_LAYOUT:
+            self.layout(channels, payload)
+            return True
+        if len(payload) < count * size:
+            raise ValueError("short frame %d" % seq)
+        return self.data(flags, seq, first, time_us, period, count, size, payload)
+
+
+def report(stream, elapsed):
+    w = stream.window
+    print("%6.0f samples/s, %4d frames, lost %d frames / %d samples, "
+          "reordered %d, jitter max %d us" % (
+              w["samples"] / elapsed, w["frames"], w["lost_frames"],
+              w["lost_samples"], w["reordered"], w["jitter_us"]))
+    sys.stdout.flush()
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__,
+                                     formatter_class=argparse.RawDescriptionHelpFormatter)
+    parser.add_argument("--bind", default="0.0.0.0", help="local address")
+    parser.add_argument("--port", type=int, default=5005, help="UDP port")
+    parser.add_argument("--csv", help="write every sample to this file")
+    parser.add_argument("--seconds", type=float, help="stop after this time")
+    parser.add_argument("--check", action="store_true",
+                        help="exit with 1 if any frame or sample was lost")
+    args = parser.parse_args()
+
+    sock = socket.socket(socket.AF_INET, socket.SOCK_DGRAM)
+    sock.setsockopt(socket.SOL_SOCKET, socket.SO_RCVBUF, 1 << 20)
+    sock.bind((args.bind, args.port))
+    sock.settimeout(0.2)
+
+    out = open(args.csv, "w", newline="") if args.csv else None
+    stream = Stream(csv.writer(out) if out else None)
+    skipped = 0
+
+    start = last = time.monotonic()
+    try:
+        while args.seconds is None or (time.monotonic() - start) < args.seconds:
+            try:
+                datagram = sock.recv(65535)
+                if not stream.feed(datagram):
+                    skipped += 1
+            except socket.timeout:
+                pass
+            except (ValueError, struct.error) as err:
+                print("invalid frame: %s" % err, file=sys.stderr)
+
+            now = time.monotonic()
+            if now - last >= 1.0:
+                report(stream, now - last)
+                stream.reset_counters()
+                last = now
+    except KeyboardInterrupt:
+        pass
+
+    if out:
+        out.close()
+
+    t = stream.total
+    print("total: %d samples in %d frames, lost %d frames / %d samples, reordered %d, "
+          "jitter max %d us, %d frames without layout" % (
+              t["samples"], t["frames"], t["lost_frames"], t["lost_samples"],
+              t["reordered"], t["jitter_us"], skipped))
+
+    if args.check and (t["lost_frames"] or t["lost_samples"] or t["reordered"] or
+                       not t["samples"]):
+        sys.exit(1)
+
+
+if __name__ == "__main__":
+    main()
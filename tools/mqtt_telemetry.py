@@ -0,0 +1,119 @@
+#!/usr/bin/env python3
+"""Decodifica registros da telemetria MQTT e monta escritas para a base.
+
+Formato (little endian), igual a libraries/mqtt_telemetry/mqtt_telemetry.h:
+  registro: versao u8, flags u8, seq u16, uptime_ms u32, itens u16
+  item    : did u16 (grupo << 8 | parametro), tamanho u8, valor
+
+Os valores sao crus: o tipo vem da base. Para ler, o mosquitto_sub imprime
+cada payload em hexadecimal, uma linha por mensagem:
+
+  mosquitto_sub -t 'linum/+/tele' -F '%x' | python3 tools/mqtt_telemetry.py decode
+
+Para escrever (tipos: u8 s8 u16 s16 u32 s32 f32 str):
+
+  python3 tools/mqtt_telemetry.py write 0x0200:u8=42 0x0100:str=fw.bin | \\
+      mosquitto_pub -t linum/<id>/set -s
+"""
+
+import argparse
+import struct
+import sys
+
+VERSION = 1
+FLAG_FULL = 0x01
+HEADER = struct.Struct("<BBHIH")
+ITEM = struct.Struct("<HB")
+TYPES = {
+    "u8": "<B", "s8": "<b", "u16": "<H", "s16": "<h",
+    "u32": "<I", "s32": "<i", "f32": "<f",
+}
+
+
+def decode(payload):
+    version, flags, seq, uptime, count = HEADER.unpack_from(payload)
+    if version != VERSION:
+        raise ValueError("unknown version %d" % version)
+
+    pos = HEADER.size
+    items = []
+    for _ in range(count):
+        did, size = ITEM.unpack_from(payload, pos)
+        pos += ITEM.size
+        items.append((did, payload[pos:pos + size]))
+        pos += size
+
+    return flags, seq, uptime, items
+
+
+def value_text(raw):
+    # Sem o tipo: inteiro little endian para 1/2/4/8 bytes, senao texto
+    if len(raw) in (1, 2, 4, 8):
+        return "%d (0x%s)" % (int.from_bytes(raw, "little"), raw[::-1].hex())
+    return repr(raw.decode(errors="replace"))
+
+
+def cmd_decode(args):
+    last_uptime = None
+    for line in sys.stdin:
+        line = line.strip()
+        if not line:
+            continue
+        try:
+            flags, seq, uptime, items = decode(bytes.fromhex(line))
+        except (ValueError, struct.error) as err:
+            print("invalid record: %s" % err, file=sys.stderr)
+            continue
+
+        # Registros do spool chegam em rajada: a idade vem do uptime
+        delta = "" if last_uptime is None else " (+%d ms)" % (uptime - last_uptime)
+        last_uptime = uptime
+        print("seq %5d uptime %10d%s%s, %d items" % (
+            seq, uptime, delta, " full" if flags & FLAG_FULL else "", len(items)))
+        for did, raw in items:
+            print("  %02x.%02x = %s" % (did >> 8, did & 0xFF, value_text(raw)))
+        sys.stdout.flush()
+
+
+def encode_item(spec):
+    did_text, rest = spec.split(":", 1)
+    kind, value = rest.split("=", 1)
+    did = int(did_text, 0)
+
+    if kind == "str":
+        raw = value.encode()
+    elif kind in TYPES:
+        number = float(value) if kind == "f32" else int(value, 0)
+        raw = struct.pack(TYPES[kind], number)
+    else:
+        raise ValueError("unknown type %s" % kind)
+
+    return ITEM.pack(did, len(raw)) + raw
+
+
+def cmd_write(args):
+    try:
+        items = b"".join(encode_item(spec) for spec in args.items)
+    except ValueError as err:
+        sys.exit("invalid item: %s" % err)
+
+    sys.stdout.buffer.write(HEADER.pack(VERSION, 0, 0, 0, len(args.items)) + items)
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__,
+                                     formatter_class=argparse.RawDescriptionHelpFormatter)
+    sub = parser.add_subparsers(dest="cmd", required=True)
+    sub.add_parser("decode", help="decode hex records from stdin")
+    write = sub.add_parser("write", help="encode a write to stdout")
+    write.add_argument("items", nargs="+", help="did:type=value")
+    args = parser.parse_args()
+
+    if args.cmd == "decode":
+        cmd_decode(args)
+    else:
+        cmd_write(args)
+
+
+if __name__ == "__main__":
+    main()
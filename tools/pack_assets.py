@@ -0,0 +1,84 @@
+#!/usr/bin/env python3
+"""Empacota fontes e imagens para o asset store da flash QSPI.
+
+Formato (little endian), igual a libraries/asset_store/asset_store.h:
+  header  : magic u32 "AST1", count u16, block_size u16, crc32 das entradas
+  entradas: name[24], offset u32, size u32, crc32 u32
+  dados   : cada asset alinhado a block_size
+
+Fontes: gerar com lv_font_conv --format bin; imagens: LVGLImage.py --ofmt BIN.
+Gravar o resultado com o loader externo (tools/linumExternalLoader.stldr) em
+0x90000000 + CONFIG_APP_ASSETS_FLASH_OFFSET, por exemplo:
+
+  python3 tools/pack_assets.py -o assets.bin assets/*
+  STM32_Programmer_CLI -c port=SWD -el tools/linumExternalLoader.stldr \\
+      -d assets.bin 0x90400000
+"""
+
+import argparse
+import os
+import struct
+import sys
+import zlib
+
+MAGIC = 0x31545341
+NAME_LEN = 24
+MAX_ENTRIES = 64
+HEADER = struct.Struct("<IHHI")
+ENTRY = struct.Struct("<%dsIII" % NAME_LEN)
+
+
+def align(value, block):
+    return (value + block - 1) // block * block
+
+
+def pack(files, block):
+    if len(files) > MAX_ENTRIES:
+        sys.exit("too many assets (max %d)" % MAX_ENTRIES)
+
+    blobs = []
+    for path in files:
+        name = os.path.basename(path).encode()
+        if len(name) >= NAME_LEN:
+            sys.exit("name too long: %s" % path)
+        with open(path, "rb") as f:
+            blobs.append((name, f.read()))
+
+    offset = align(HEADER.size + ENTRY.size * len(blobs), block)
+    entries = b""
+    data = b""
+    for name, blob in blobs:
+        entries += ENTRY.pack(name, offset, len(blob), zlib.crc32(blob))
+        padded = blob + b"\xff" * (align(len(blob), block) - len(blob))
+        data += padded
+        offset += len(padded)
+
+    header = HEADER.pack(MAGIC, len(blobs), block, zlib.crc32(entries))
+    directory = header + entries
+    directory += b"\xff" * (align(len(directory), block) - len(directory))
+
+    return directory + data
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.splitlines()[0])
+    parser.add_argument("files", nargs="+", help="asset files (.bin, .txt)")
+    parser.add_argument("-o", "--output", required=True)
+    parser.add_argument("--block", type=int, default=2048,
+                        help="CONFIG_APP_ASSETS_CACHE_BLOCK_SIZE")
+    parser.add_argument("--max-size", type=lambda v: int(v, 0), default=0x400000,
+                        help="CONFIG_APP_ASSETS_SIZE")
+    args = parser.parse_args()
+
+    image = pack(args.files, args.block)
+    if len(image) > args.max_size:
+        sys.exit("image too large: %d > %d" % (len(image), args.max_size))
+
+    with open(args.output, "wb") as f:
+        f.write(image)
+
+    print("%s: %d assets, %d bytes" % (args.output, len(args.files), len(image)))
+
+
+if __name__ == "__main__":
+    main()